@@ -25,6 +25,7 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <sys/time.h>
 
 #include "../weechat.h"
 #include "../wee-config.h"
@@ -324,6 +325,7 @@ int
 hook_command_exec (struct t_gui_buffer *buffer, int any_plugin,
                    struct t_weechat_plugin *plugin, const char *string)
 {
+    struct timeval tv_start;
     struct t_hook *ptr_hook, *next_hook;
     struct t_hook *hook_plugin, *hook_other_plugin, *hook_other_plugin2;
     struct t_hook *hook_incomplete_command;
@@ -455,6 +457,7 @@ hook_command_exec (struct t_gui_buffer *buffer, int any_plugin,
         else
         {
             /* execute the command! */
+            hook_callback_start (&tv_start);
             ptr_hook->running++;
             rc = (int) (HOOK_COMMAND(ptr_hook, callback))
                 (ptr_hook->callback_pointer,
@@ -464,6 +467,7 @@ hook_command_exec (struct t_gui_buffer *buffer, int any_plugin,
                  argv,
                  argv_eol);
             ptr_hook->running--;
+            hook_callback_end (ptr_hook, &tv_start);
             if (rc == WEECHAT_RC_ERROR)
                 rc = HOOK_COMMAND_EXEC_ERROR;
             else
@@ -24,9 +24,14 @@
 #endif
 
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 #include <poll.h>
 #include <fcntl.h>
 #include <errno.h>
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif
 
 #include "../weechat.h"
 #include "../wee-hook.h"
@@ -36,12 +41,22 @@
 #include "../../gui/gui-chat.h"
 
 
+struct t_hook **hook_fd_hooks = NULL;  /* fd hooks, indexed by fd           */
+int hook_fd_hooks_size = 0;            /* size of array hook_fd_hooks       */
+
 struct pollfd *hook_fd_pollfd = NULL;  /* file descriptors for poll()       */
+struct t_hook **hook_fd_pollfd_hooks = NULL; /* hooks of fds in pollfd      */
 int hook_fd_pollfd_count = 0;          /* number of file descriptors        */
 
+#ifdef HAVE_SYS_EPOLL_H
+int hook_fd_epoll_fd = -1;             /* epoll instance (-1 = poll() used) */
+int hook_fd_epoll_disabled = 0;        /* 1 if epoll can not be used        */
+struct epoll_event *hook_fd_epoll_events = NULL; /* events for epoll_wait   */
+#endif /* HAVE_SYS_EPOLL_H */
+
 
 /*
- * Searches for a fd hook in list.
+ * Searches for a fd hook in list (hooks marked as deleted are ignored).
  *
  * Returns pointer to hook found, NULL if not found.
  */
@@ -49,27 +64,72 @@ int hook_fd_pollfd_count = 0;          /* number of file descriptors        */
 struct t_hook *
 hook_fd_search (int fd)
 {
-    struct t_hook *ptr_hook;
+    if ((fd < 0) || (fd >= hook_fd_hooks_size))
+        return NULL;
 
-    for (ptr_hook = weechat_hooks[HOOK_TYPE_FD]; ptr_hook;
-         ptr_hook = ptr_hook->next_hook)
+    if (hook_fd_hooks[fd] && hook_fd_hooks[fd]->deleted)
+        return NULL;
+
+    return hook_fd_hooks[fd];
+}
+
+/*
+ * Sets the hook for a fd in the array of fd hooks (hook can be NULL to
+ * remove the fd).
+ *
+ * Returns:
+ *   1: OK
+ *   0: error
+ */
+
+int
+hook_fd_set_hook (int fd, struct t_hook *hook)
+{
+    struct t_hook **new_hooks;
+    int i, new_size;
+
+    if (fd < 0)
+        return 0;
+
+    if (fd >= hook_fd_hooks_size)
     {
-        if (!ptr_hook->deleted && (HOOK_FD(ptr_hook, fd) == fd))
-            return ptr_hook;
+        if (!hook)
+            return 1;
+        new_size = (hook_fd_hooks_size < 64) ? 64 : hook_fd_hooks_size;
+        while (new_size <= fd)
+        {
+            new_size *= 2;
+        }
+        new_hooks = realloc (hook_fd_hooks,
+                             new_size * sizeof (hook_fd_hooks[0]));
+        if (!new_hooks)
+            return 0;
+        for (i = hook_fd_hooks_size; i < new_size; i++)
+        {
+            new_hooks[i] = NULL;
+        }
+        hook_fd_hooks = new_hooks;
+        hook_fd_hooks_size = new_size;
     }
 
-    /* fd hook not found */
-    return NULL;
+    hook_fd_hooks[fd] = hook;
+
+    return 1;
 }
 
 /*
- * Reallocates the "struct pollfd" array for poll().
+ * Reallocates the "struct pollfd" array for poll() (and the array of events
+ * for epoll_wait()).
  */
 
 void
 hook_fd_realloc_pollfd ()
 {
     struct pollfd *ptr_pollfd;
+    struct t_hook **ptr_hooks;
+#ifdef HAVE_SYS_EPOLL_H
+    struct epoll_event *ptr_events;
+#endif /* HAVE_SYS_EPOLL_H */
     int count;
 
     if (hooks_count[HOOK_TYPE_FD] == hook_fd_pollfd_count)
@@ -84,6 +144,18 @@ hook_fd_realloc_pollfd ()
             free (hook_fd_pollfd);
             hook_fd_pollfd = NULL;
         }
+        if (hook_fd_pollfd_hooks)
+        {
+            free (hook_fd_pollfd_hooks);
+            hook_fd_pollfd_hooks = NULL;
+        }
+#ifdef HAVE_SYS_EPOLL_H
+        if (hook_fd_epoll_events)
+        {
+            free (hook_fd_epoll_events);
+            hook_fd_epoll_events = NULL;
+        }
+#endif /* HAVE_SYS_EPOLL_H */
     }
     else
     {
@@ -92,11 +164,105 @@ hook_fd_realloc_pollfd ()
         if (!ptr_pollfd)
             return;
         hook_fd_pollfd = ptr_pollfd;
+        ptr_hooks = realloc (hook_fd_pollfd_hooks,
+                             count * sizeof (struct t_hook *));
+        if (!ptr_hooks)
+            return;
+        hook_fd_pollfd_hooks = ptr_hooks;
+#ifdef HAVE_SYS_EPOLL_H
+        ptr_events = realloc (hook_fd_epoll_events,
+                              count * sizeof (struct epoll_event));
+        if (!ptr_events)
+            return;
+        hook_fd_epoll_events = ptr_events;
+#endif /* HAVE_SYS_EPOLL_H */
     }
 
     hook_fd_pollfd_count = count;
 }
 
+#ifdef HAVE_SYS_EPOLL_H
+/*
+ * Returns epoll events for flags of a fd hook.
+ */
+
+uint32_t
+hook_fd_epoll_get_events (int flags)
+{
+    uint32_t events;
+
+    events = 0;
+    if (flags & HOOK_FD_FLAG_READ)
+        events |= EPOLLIN;
+    if (flags & HOOK_FD_FLAG_WRITE)
+        events |= EPOLLOUT;
+
+    return events;
+}
+
+/*
+ * Stops use of epoll: poll() will be used for all fd hooks.
+ */
+
+void
+hook_fd_epoll_stop ()
+{
+    if (hook_fd_epoll_fd >= 0)
+    {
+        close (hook_fd_epoll_fd);
+        hook_fd_epoll_fd = -1;
+    }
+    hook_fd_epoll_disabled = 1;
+}
+
+/*
+ * Registers a fd hook in the epoll instance (which is created on first call).
+ *
+ * If the fd can not be watched with epoll (for example a regular file), the
+ * epoll instance is closed and poll() is used instead.
+ */
+
+void
+hook_fd_epoll_add (struct t_hook *hook)
+{
+    struct epoll_event event;
+
+    if (hook_fd_epoll_disabled)
+        return;
+
+    if (hook_fd_epoll_fd < 0)
+    {
+        hook_fd_epoll_fd = epoll_create1 (EPOLL_CLOEXEC);
+        if (hook_fd_epoll_fd < 0)
+        {
+            hook_fd_epoll_stop ();
+            return;
+        }
+    }
+
+    memset (&event, 0, sizeof (event));
+    event.events = hook_fd_epoll_get_events (HOOK_FD(hook, flags));
+    event.data.fd = HOOK_FD(hook, fd);
+    if (epoll_ctl (hook_fd_epoll_fd, EPOLL_CTL_ADD, HOOK_FD(hook, fd),
+                   &event) < 0)
+    {
+        if (errno == EBADF)
+        {
+            HOOK_FD(hook, error) = errno;
+            gui_chat_printf (NULL,
+                             _("%sError: bad file descriptor (%d) "
+                               "used in hook_fd"),
+                             gui_chat_prefix[GUI_CHAT_PREFIX_ERROR],
+                             HOOK_FD(hook, fd));
+        }
+        else
+        {
+            hook_fd_epoll_stop ();
+        }
+    }
+}
+#endif /* HAVE_SYS_EPOLL_H */
+
 /*
  * Callback called when a fd hook is added in the list of hooks.
  */
@@ -104,10 +270,13 @@ hook_fd_realloc_pollfd ()
 void
 hook_fd_add_cb (struct t_hook *hook)
 {
-    /* make C compiler happy */
-    (void) hook;
+    hook_fd_set_hook (HOOK_FD(hook, fd), hook);
 
     hook_fd_realloc_pollfd ();
+
+#ifdef HAVE_SYS_EPOLL_H
+    hook_fd_epoll_add (hook);
+#endif /* HAVE_SYS_EPOLL_H */
 }
 
 /*
@@ -173,19 +342,120 @@ hook_fd (struct t_weechat_plugin *plugin, int fd, int flag_read,
 }
 
 /*
- * Executes fd hooks:
- * - poll() on fie descriptors
- * - call of hook fd callbacks if needed.
+ * Changes flags of a fd hook (read, write, exception).
  */
 
 void
-hook_fd_exec ()
+hook_fd_set_flags (struct t_hook *hook, int flags)
 {
-    int i, num_fd, timeout, ready, found;
-    struct t_hook *ptr_hook, *next_hook;
+#ifdef HAVE_SYS_EPOLL_H
+    struct epoll_event event;
+#endif /* HAVE_SYS_EPOLL_H */
 
-    if (!weechat_hooks[HOOK_TYPE_FD])
+    if (!hook || hook->deleted || (hook->type != HOOK_TYPE_FD)
+        || (HOOK_FD(hook, flags) == flags))
+    {
         return;
+    }
+
+    HOOK_FD(hook, flags) = flags;
+
+#ifdef HAVE_SYS_EPOLL_H
+    if (hook_fd_epoll_fd >= 0)
+    {
+        memset (&event, 0, sizeof (event));
+        event.events = hook_fd_epoll_get_events (flags);
+        event.data.fd = HOOK_FD(hook, fd);
+        (void) epoll_ctl (hook_fd_epoll_fd, EPOLL_CTL_MOD, HOOK_FD(hook, fd),
+                          &event);
+    }
+#endif /* HAVE_SYS_EPOLL_H */
+}
+
+/*
+ * Calls callback of a fd hook.
+ */
+
+void
+hook_fd_run_callback (struct t_hook *hook)
+{
+    struct timeval tv_start;
+
+    if (!hook || hook->deleted || hook->running)
+        return;
+
+    hook_callback_start (&tv_start);
+    hook->running = 1;
+    (void) (HOOK_FD(hook, callback)) (
+        hook->callback_pointer,
+        hook->callback_data,
+        HOOK_FD(hook, fd));
+    hook->running = 0;
+    hook_callback_end (hook, &tv_start);
+}
+
+#ifdef HAVE_SYS_EPOLL_H
+/*
+ * Executes fd hooks with epoll: the file descriptors are registered when the
+ * hooks are created, so there's no array to build before waiting.
+ *
+ * Returns:
+ *   1: epoll has been used
+ *   0: epoll is not available, poll() must be used
+ */
+
+int
+hook_fd_exec_epoll (int timeout)
+{
+    struct t_hook *ptr_hook;
+    int i, ready, fd;
+
+    if ((hook_fd_epoll_fd < 0) || !hook_fd_epoll_events)
+        return 0;
+
+    ready = epoll_wait (hook_fd_epoll_fd, hook_fd_epoll_events,
+                        hook_fd_pollfd_count, timeout);
+    if (ready <= 0)
+        return 1;
+
+    /* execute callbacks for file descriptors with activity */
+    hook_exec_start ();
+
+    for (i = 0; i < ready; i++)
+    {
+        fd = hook_fd_epoll_events[i].data.fd;
+        ptr_hook = hook_fd_search (fd);
+        if (ptr_hook)
+        {
+            hook_fd_run_callback (ptr_hook);
+        }
+        else if (epoll_ctl (hook_fd_epoll_fd, EPOLL_CTL_DEL, fd, NULL) < 0)
+        {
+            /*
+             * fd closed but still registered (a copy of the fd is still
+             * open in a child process): this registration can not be
+             * removed any more, so switch to poll() for all fd hooks
+             */
+            hook_fd_epoll_stop ();
+            break;
+        }
+    }
+
+    hook_exec_end ();
+
+    return 1;
+}
+#endif /* HAVE_SYS_EPOLL_H */
+
+/*
+ * Executes fd hooks with poll().
+ */
+
+void
+hook_fd_exec_poll (int timeout)
+{
+    int i, num_fd, ready;
+    struct t_hook *ptr_hook;
 
     /* build an array of "struct pollfd" for poll() */
     num_fd = 0;
@@ -210,7 +480,7 @@ hook_fd_exec ()
             }
             else
             {
-                if (num_fd > hook_fd_pollfd_count)
+                if (num_fd >= hook_fd_pollfd_count)
                     break;
 
                 hook_fd_pollfd[num_fd].fd = HOOK_FD(ptr_hook, fd);
@@ -220,6 +490,7 @@ hook_fd_exec ()
                     hook_fd_pollfd[num_fd].events |= POLLIN;
                 if (HOOK_FD(ptr_hook, flags) & HOOK_FD_FLAG_WRITE)
                     hook_fd_pollfd[num_fd].events |= POLLOUT;
+                hook_fd_pollfd_hooks[num_fd] = ptr_hook;
 
                 num_fd++;
             }
@@ -227,9 +498,6 @@ hook_fd_exec ()
     }
 
     /* perform the poll() */
-    timeout = hook_timer_get_time_to_next ();
-    if (hook_process_pending)
-        timeout = 0;
     ready = poll (hook_fd_pollfd, num_fd, timeout);
     if (ready <= 0)
         return;
@@ -237,41 +505,42 @@ hook_fd_exec ()
     /* execute callbacks for file descriptors with activity */
     hook_exec_start ();
 
-    ptr_hook = weechat_hooks[HOOK_TYPE_FD];
-    while (ptr_hook)
+    for (i = 0; i < num_fd; i++)
     {
-        next_hook = ptr_hook->next_hook;
-
-        if (!ptr_hook->deleted
-            && !ptr_hook->running)
-        {
-            found = 0;
-            for (i = 0; i < num_fd; i++)
-            {
-                if (hook_fd_pollfd[i].fd == HOOK_FD(ptr_hook, fd)
-                    && hook_fd_pollfd[i].revents)
-                {
-                    found = 1;
-                    break;
-                }
-            }
-            if (found)
-            {
-                ptr_hook->running = 1;
-                (void) (HOOK_FD(ptr_hook, callback)) (
-                    ptr_hook->callback_pointer,
-                    ptr_hook->callback_data,
-                    HOOK_FD(ptr_hook, fd));
-                ptr_hook->running = 0;
-            }
-        }
-
-        ptr_hook = next_hook;
+        if (hook_fd_pollfd[i].revents)
+            hook_fd_run_callback (hook_fd_pollfd_hooks[i]);
     }
 
     hook_exec_end ();
 }
 
+/*
+ * Executes fd hooks:
+ * - wait for activity on file descriptors (with epoll if available,
+ *   otherwise with poll())
+ * - call of hook fd callbacks if needed.
+ */
+
+void
+hook_fd_exec ()
+{
+    int timeout;
+
+    if (!weechat_hooks[HOOK_TYPE_FD])
+        return;
+
+    timeout = hook_timer_get_time_to_next ();
+    if (hook_process_pending)
+        timeout = 0;
+
+#ifdef HAVE_SYS_EPOLL_H
+    if (hook_fd_exec_epoll (timeout))
+        return;
+#endif /* HAVE_SYS_EPOLL_H */
+
+    hook_fd_exec_poll (timeout);
+}
+
 /*
  * Frees data in a fd hook.
  */
@@ -282,6 +551,22 @@ hook_fd_free_data (struct t_hook *hook)
     if (!hook || !hook->hook_data)
         return;
 
+    /*
+     * the fd may already be used by another hook (if this hook was deleted
+     * and the fd reused): then the fd and its epoll registration are kept
+     */
+    if (hook_fd_search (HOOK_FD(hook, fd)) == hook)
+    {
+        hook_fd_set_hook (HOOK_FD(hook, fd), NULL);
+#ifdef HAVE_SYS_EPOLL_H
+        if (hook_fd_epoll_fd >= 0)
+        {
+            (void) epoll_ctl (hook_fd_epoll_fd, EPOLL_CTL_DEL,
+                              HOOK_FD(hook, fd), NULL);
+        }
+#endif /* HAVE_SYS_EPOLL_H */
+    }
+
     free (hook->hook_data);
     hook->hook_data = NULL;
 }
@@ -41,6 +41,7 @@ struct t_hook_fd
                                        /* with fd                           */
 };
 
+extern struct t_hook *hook_fd_search (int fd);
 extern void hook_fd_add_cb (struct t_hook *hook);
 extern void hook_fd_remove_cb (struct t_hook *hook);
 extern struct t_hook *hook_fd (struct t_weechat_plugin *plugin, int fd,
@@ -49,6 +50,7 @@ extern struct t_hook *hook_fd (struct t_weechat_plugin *plugin, int fd,
                                t_hook_callback_fd *callback,
                                const void *callback_pointer,
                                void *callback_data);
+extern void hook_fd_set_flags (struct t_hook *hook, int flags);
 extern void hook_fd_exec ();
 extern void hook_fd_free_data (struct t_hook *hook);
 extern int hook_fd_add_to_infolist (struct t_infolist_item *item,
@@ -25,6 +25,7 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <sys/time.h>
 
 #include "../weechat.h"
 #include "../wee-hook.h"
@@ -84,6 +85,7 @@ hook_hsignal (struct t_weechat_plugin *plugin, const char *signal,
 int
 hook_hsignal_send (const char *signal, struct t_hashtable *hashtable)
 {
+    struct timeval tv_start;
     struct t_hook *ptr_hook, *next_hook;
     int rc;
 
@@ -100,6 +102,7 @@ hook_hsignal_send (const char *signal, struct t_hashtable *hashtable)
             && !ptr_hook->running
             && (string_match (signal, HOOK_HSIGNAL(ptr_hook, signal), 0)))
         {
+            hook_callback_start (&tv_start);
             ptr_hook->running = 1;
             rc = (HOOK_HSIGNAL(ptr_hook, callback))
                 (ptr_hook->callback_pointer,
@@ -107,6 +110,7 @@ hook_hsignal_send (const char *signal, struct t_hashtable *hashtable)
                  signal,
                  hashtable);
             ptr_hook->running = 0;
+            hook_callback_end (ptr_hook, &tv_start);
 
             if (rc == WEECHAT_RC_OK_EAT)
                 break;
@@ -25,6 +25,7 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <sys/time.h>
 
 #include "../weechat.h"
 #include "../wee-hashtable.h"
@@ -81,6 +82,8 @@ hook_line (struct t_weechat_plugin *plugin, const char *buffer_type,
         ",", 0, 0, &new_hook_line->num_buffers);
     new_hook_line->tags_array = string_split_tags (tags,
                                                    &new_hook_line->tags_count);
+    new_hook_line->tags_match = gui_line_tags_match_new (
+        new_hook_line->tags_count, new_hook_line->tags_array);
 
     hook_add_to_list (new_hook);
 
@@ -94,9 +97,11 @@ hook_line (struct t_weechat_plugin *plugin, const char *buffer_type,
 void
 hook_line_exec (struct t_gui_line *line)
 {
+    struct timeval tv_start;
     struct t_hook *ptr_hook, *next_hook;
     struct t_hashtable *hashtable, *hashtable2;
     char str_value[128], *str_tags;
+    const char *ptr_str_time;
 
     if (!weechat_hooks[HOOK_TYPE_LINE])
         return;
@@ -117,9 +122,8 @@ hook_line_exec (struct t_gui_line *line)
                                   (const char **)HOOK_LINE(ptr_hook, buffers),
                                   0)
             && (!HOOK_LINE(ptr_hook, tags_array)
-                || gui_line_match_tags (line->data,
-                                        HOOK_LINE(ptr_hook, tags_count),
-                                        HOOK_LINE(ptr_hook, tags_array))))
+                || gui_line_match_tags_compiled (line->data,
+                                                 HOOK_LINE(ptr_hook, tags_match))))
         {
             /* create the hashtable that will be sent to callback */
             if (!hashtable)
@@ -138,7 +142,8 @@ hook_line_exec (struct t_gui_line *line)
             HASHTABLE_SET_INT("y", line->data->y);
             HASHTABLE_SET_TIME("date", line->data->date);
             HASHTABLE_SET_TIME("date_printed", line->data->date_printed);
-            HASHTABLE_SET_STR_NOT_NULL("str_time", line->data->str_time);
+            ptr_str_time = gui_line_get_str_time (line->data);
+            HASHTABLE_SET_STR_NOT_NULL("str_time", ptr_str_time);
             HASHTABLE_SET_INT("tags_count", line->data->tags_count);
             str_tags = string_build_with_split_string (
                 (const char **)line->data->tags_array, ",");
@@ -152,12 +157,14 @@ hook_line_exec (struct t_gui_line *line)
             HASHTABLE_SET_STR_NOT_NULL("message", line->data->message);
 
             /* run callback */
+            hook_callback_start (&tv_start);
             ptr_hook->running = 1;
             hashtable2 = (HOOK_LINE(ptr_hook, callback))
                 (ptr_hook->callback_pointer,
                  ptr_hook->callback_data,
                  hashtable);
             ptr_hook->running = 0;
+            hook_callback_end (ptr_hook, &tv_start);
 
             if (hashtable2)
             {
@@ -192,6 +199,11 @@ hook_line_free_data (struct t_hook *hook)
         string_free_split (HOOK_LINE(hook, buffers));
         HOOK_LINE(hook, buffers) = NULL;
     }
+    if (HOOK_LINE(hook, tags_match))
+    {
+        gui_line_tags_match_free (HOOK_LINE(hook, tags_match));
+        HOOK_LINE(hook, tags_match) = NULL;
+    }
     if (HOOK_LINE(hook, tags_array))
     {
         string_free_split_tags (HOOK_LINE(hook, tags_array));
@@ -257,6 +269,7 @@ hook_line_print_log (struct t_hook *hook)
     }
     log_printf ("    tags_count. . . . . . : %d", HOOK_LINE(hook, tags_count));
     log_printf ("    tags_array. . . . . . : 0x%lx", HOOK_LINE(hook, tags_array));
+    log_printf ("    tags_match. . . . . . : 0x%lx", HOOK_LINE(hook, tags_match));
     if (HOOK_LINE(hook, tags_array))
     {
         for (i = 0; i < HOOK_LINE(hook, tags_count); i++)
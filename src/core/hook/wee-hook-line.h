@@ -24,6 +24,7 @@ struct t_weechat_plugin;
 struct t_infolist_item;
 struct t_hashtable;
 struct t_gui_line;
+struct t_gui_line_tags_match;
 
 #define HOOK_LINE(hook, var) (((struct t_hook_line *)hook->hook_data)->var)
 
@@ -41,6 +42,7 @@ struct t_hook_line
     int num_buffers;                   /* number of buffers in list         */
     int tags_count;                    /* number of tags selected           */
     char ***tags_array;                /* tags selected (NULL = any)        */
+    struct t_gui_line_tags_match *tags_match; /* compiled tags selected     */
 };
 
 extern struct t_hook *hook_line (struct t_weechat_plugin *plugin,
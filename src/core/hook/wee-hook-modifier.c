@@ -25,6 +25,7 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <sys/time.h>
 
 #include "../weechat.h"
 #include "../wee-hook.h"
@@ -86,6 +87,7 @@ char *
 hook_modifier_exec (struct t_weechat_plugin *plugin, const char *modifier,
                     const char *modifier_data, const char *string)
 {
+    struct timeval tv_start;
     struct t_hook *ptr_hook, *next_hook;
     char *new_msg, *message_modified;
 
@@ -112,6 +114,7 @@ hook_modifier_exec (struct t_weechat_plugin *plugin, const char *modifier,
             && (string_strcasecmp (HOOK_MODIFIER(ptr_hook, modifier),
                                    modifier) == 0))
         {
+            hook_callback_start (&tv_start);
             ptr_hook->running = 1;
             new_msg = (HOOK_MODIFIER(ptr_hook, callback))
                 (ptr_hook->callback_pointer,
@@ -120,6 +123,7 @@ hook_modifier_exec (struct t_weechat_plugin *plugin, const char *modifier,
                  modifier_data,
                  message_modified);
             ptr_hook->running = 0;
+            hook_callback_end (ptr_hook, &tv_start);
 
             /* empty string returned => message dropped */
             if (new_msg && !new_msg[0])
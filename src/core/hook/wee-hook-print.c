@@ -25,13 +25,13 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <sys/time.h>
 
 #include "../weechat.h"
 #include "../wee-hook.h"
 #include "../wee-infolist.h"
 #include "../wee-log.h"
 #include "../wee-string.h"
-#include "../../gui/gui-color.h"
 #include "../../gui/gui-line.h"
 
 
@@ -72,6 +72,8 @@ hook_print (struct t_weechat_plugin *plugin, struct t_gui_buffer *buffer,
     new_hook_print->buffer = buffer;
     new_hook_print->tags_array = string_split_tags (tags,
                                                     &new_hook_print->tags_count);
+    new_hook_print->tags_match = gui_line_tags_match_new (
+        new_hook_print->tags_count, new_hook_print->tags_array);
     new_hook_print->message = (message) ? strdup (message) : NULL;
     new_hook_print->strip_colors = strip_colors;
 
@@ -87,8 +89,9 @@ hook_print (struct t_weechat_plugin *plugin, struct t_gui_buffer *buffer,
 void
 hook_print_exec (struct t_gui_buffer *buffer, struct t_gui_line *line)
 {
+    struct timeval tv_start;
     struct t_hook *ptr_hook, *next_hook;
-    char *prefix_no_color, *message_no_color;
+    const char *prefix_no_color, *message_no_color;
 
     if (!weechat_hooks[HOOK_TYPE_PRINT])
         return;
@@ -96,16 +99,11 @@ hook_print_exec (struct t_gui_buffer *buffer, struct t_gui_line *line)
     if (!line->data->message || !line->data->message[0])
         return;
 
-    prefix_no_color = (line->data->prefix) ?
-        gui_color_decode (line->data->prefix, NULL) : NULL;
-
-    message_no_color = gui_color_decode (line->data->message, NULL);
+    /* prefix and message without colors are computed in line */
+    prefix_no_color = line->data->prefix_no_color;
+    message_no_color = line->data->message_no_color;
     if (!message_no_color)
-    {
-        if (prefix_no_color)
-            free (prefix_no_color);
         return;
-    }
 
     hook_exec_start ();
 
@@ -123,11 +121,11 @@ hook_print_exec (struct t_gui_buffer *buffer, struct t_gui_line *line)
                 || string_strcasestr (prefix_no_color, HOOK_PRINT(ptr_hook, message))
                 || string_strcasestr (message_no_color, HOOK_PRINT(ptr_hook, message)))
             && (!HOOK_PRINT(ptr_hook, tags_array)
-                || gui_line_match_tags (line->data,
-                                        HOOK_PRINT(ptr_hook, tags_count),
-                                        HOOK_PRINT(ptr_hook, tags_array))))
+                || gui_line_match_tags_compiled (line->data,
+                                                 HOOK_PRINT(ptr_hook, tags_match))))
         {
             /* run callback */
+            hook_callback_start (&tv_start);
             ptr_hook->running = 1;
             (void) (HOOK_PRINT(ptr_hook, callback))
                 (ptr_hook->callback_pointer,
@@ -140,16 +138,12 @@ hook_print_exec (struct t_gui_buffer *buffer, struct t_gui_line *line)
                  (HOOK_PRINT(ptr_hook, strip_colors)) ? prefix_no_color : line->data->prefix,
                  (HOOK_PRINT(ptr_hook, strip_colors)) ? message_no_color : line->data->message);
             ptr_hook->running = 0;
+            hook_callback_end (ptr_hook, &tv_start);
         }
 
         ptr_hook = next_hook;
     }
 
-    if (prefix_no_color)
-        free (prefix_no_color);
-    if (message_no_color)
-        free (message_no_color);
-
     hook_exec_end ();
 }
 
@@ -163,6 +157,11 @@ hook_print_free_data (struct t_hook *hook)
     if (!hook || !hook->hook_data)
         return;
 
+    if (HOOK_PRINT(hook, tags_match))
+    {
+        gui_line_tags_match_free (HOOK_PRINT(hook, tags_match));
+        HOOK_PRINT(hook, tags_match) = NULL;
+    }
     if (HOOK_PRINT(hook, tags_array))
     {
         string_free_split_tags (HOOK_PRINT(hook, tags_array));
@@ -226,6 +225,7 @@ hook_print_print_log (struct t_hook *hook)
     log_printf ("    buffer. . . . . . . . : 0x%lx", HOOK_PRINT(hook, buffer));
     log_printf ("    tags_count. . . . . . : %d", HOOK_PRINT(hook, tags_count));
     log_printf ("    tags_array. . . . . . : 0x%lx", HOOK_PRINT(hook, tags_array));
+    log_printf ("    tags_match. . . . . . : 0x%lx", HOOK_PRINT(hook, tags_match));
     if (HOOK_PRINT(hook, tags_array))
     {
         for (i = 0; i < HOOK_PRINT(hook, tags_count); i++)
@@ -26,6 +26,7 @@ struct t_weechat_plugin;
 struct t_infolist_item;
 struct t_gui_buffer;
 struct t_gui_line;
+struct t_gui_line_tags_match;
 
 #define HOOK_PRINT(hook, var) (((struct t_hook_print *)hook->hook_data)->var)
 
@@ -42,6 +43,7 @@ struct t_hook_print
     struct t_gui_buffer *buffer;       /* buffer selected (NULL = all)      */
     int tags_count;                    /* number of tags selected           */
     char ***tags_array;                /* tags selected (NULL = any)        */
+    struct t_gui_line_tags_match *tags_match; /* compiled tags selected     */
     char *message;                     /* part of message (NULL/empty = all)*/
     int strip_colors;                  /* strip colors in msg for callback? */
 };
@@ -25,15 +25,190 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <sys/time.h>
 
 #include "../weechat.h"
 #include "../wee-hook.h"
+#include "../wee-arraylist.h"
+#include "../wee-hashtable.h"
 #include "../wee-infolist.h"
 #include "../wee-log.h"
 #include "../wee-string.h"
 #include "../../plugins/plugin.h"
 
 
+/*
+ * signal hooks with an exact name (no wildcard) are indexed by lower case
+ * name, other hooks (with a mask) are kept in a separate list; both are
+ * sorted like the list of hooks (priority, then order of creation)
+ */
+struct t_hashtable *hook_signal_index = NULL;
+struct t_arraylist *hook_signal_masks = NULL;
+long long hook_signal_sequence = 0;    /* order of creation of hooks        */
+
+
+/*
+ * Compares two signal hooks (to keep them sorted in arraylists).
+ */
+
+int
+hook_signal_cmp_cb (void *data, struct t_arraylist *arraylist,
+                    void *pointer1, void *pointer2)
+{
+    struct t_hook *hook1, *hook2;
+
+    /* make C compiler happy */
+    (void) data;
+    (void) arraylist;
+
+    hook1 = (struct t_hook *)pointer1;
+    hook2 = (struct t_hook *)pointer2;
+
+    if (hook1->priority != hook2->priority)
+        return (hook1->priority > hook2->priority) ? -1 : 1;
+    if (HOOK_SIGNAL(hook1, sequence) != HOOK_SIGNAL(hook2, sequence))
+        return (HOOK_SIGNAL(hook1, sequence) < HOOK_SIGNAL(hook2, sequence)) ?
+            -1 : 1;
+    return 0;
+}
+
+/*
+ * Frees an arraylist stored in the signal index.
+ */
+
+void
+hook_signal_index_free_value_cb (struct t_hashtable *hashtable,
+                                 const void *key, void *value)
+{
+    /* make C compiler happy */
+    (void) hashtable;
+    (void) key;
+
+    arraylist_free ((struct t_arraylist *)value);
+}
+
+/*
+ * Checks if a signal name can be used as key in the signal index: it must
+ * not contain any wildcard and must be ASCII only (the index is case
+ * insensitive on ASCII chars only).
+ *
+ * Returns:
+ *   1: signal can be indexed
+ *   0: signal can not be indexed
+ */
+
+int
+hook_signal_is_indexable (const char *signal)
+{
+    const unsigned char *ptr_signal;
+
+    for (ptr_signal = (const unsigned char *)signal; ptr_signal[0];
+         ptr_signal++)
+    {
+        if ((ptr_signal[0] == '*') || (ptr_signal[0] >= 0x80))
+            return 0;
+    }
+
+    return 1;
+}
+
+/*
+ * Returns the arraylist where a signal hook is stored (index or masks),
+ * creating it if needed and if "create" is 1.
+ */
+
+struct t_arraylist *
+hook_signal_get_list (struct t_hook *hook, int create)
+{
+    struct t_arraylist *list;
+    char *key;
+
+    if (!hook_signal_is_indexable (HOOK_SIGNAL(hook, signal)))
+    {
+        if (!hook_signal_masks && create)
+        {
+            hook_signal_masks = arraylist_new (16, 1, 1,
+                                               &hook_signal_cmp_cb, NULL,
+                                               NULL, NULL);
+        }
+        return hook_signal_masks;
+    }
+
+    if (!hook_signal_index)
+    {
+        if (!create)
+            return NULL;
+        hook_signal_index = hashtable_new (256,
+                                           WEECHAT_HASHTABLE_STRING,
+                                           WEECHAT_HASHTABLE_POINTER,
+                                           NULL, NULL);
+        if (!hook_signal_index)
+            return NULL;
+        hook_signal_index->callback_free_value = &hook_signal_index_free_value_cb;
+    }
+
+    key = strdup (HOOK_SIGNAL(hook, signal));
+    if (!key)
+        return NULL;
+    string_tolower (key);
+
+    list = hashtable_get (hook_signal_index, key);
+    if (!list && create)
+    {
+        list = arraylist_new (4, 1, 1, &hook_signal_cmp_cb, NULL, NULL, NULL);
+        if (list)
+            hashtable_set (hook_signal_index, key, list);
+    }
+
+    free (key);
+
+    return list;
+}
+
+/*
+ * Callback called when a signal hook is added in the list of hooks.
+ */
+
+void
+hook_signal_add_cb (struct t_hook *hook)
+{
+    struct t_arraylist *list;
+
+    list = hook_signal_get_list (hook, 1);
+    if (list)
+        arraylist_add (list, hook);
+}
+
+/*
+ * Removes a signal hook from the index (called before signal is freed).
+ */
+
+void
+hook_signal_remove_from_index (struct t_hook *hook)
+{
+    struct t_arraylist *list;
+    char *key;
+    int index;
+
+    list = hook_signal_get_list (hook, 0);
+    if (!list)
+        return;
+
+    if (arraylist_search (list, hook, &index, NULL))
+        arraylist_remove (list, index);
+
+    if ((list != hook_signal_masks) && (arraylist_size (list) == 0))
+    {
+        key = strdup (HOOK_SIGNAL(hook, signal));
+        if (key)
+        {
+            string_tolower (key);
+            hashtable_remove (hook_signal_index, key);
+            free (key);
+        }
+    }
+}
+
 /*
  * Hooks a signal.
  *
@@ -71,6 +246,7 @@ hook_signal (struct t_weechat_plugin *plugin, const char *signal,
     new_hook->hook_data = new_hook_signal;
     new_hook_signal->callback = callback;
     new_hook_signal->signal = strdup ((ptr_signal) ? ptr_signal : signal);
+    new_hook_signal->sequence = hook_signal_sequence++;
 
     hook_add_to_list (new_hook);
 
@@ -79,45 +255,132 @@ hook_signal (struct t_weechat_plugin *plugin, const char *signal,
 
 /*
  * Sends a signal.
+ *
+ * Hooks with exact signal name are read in the signal index, other hooks
+ * (with a mask) are checked with string_match; both lists are merged to call
+ * callbacks in the order of hooks (priority).
+ *
+ * The hooks to call are selected before calling the first callback, so that
+ * hooks added by a callback are not called for this signal.
  */
 
 int
 hook_signal_send (const char *signal, const char *type_data, void *signal_data)
 {
-    struct t_hook *ptr_hook, *next_hook;
-    int rc;
+    struct timeval tv_start;
+    struct t_hook *hooks_static[64], **hooks, *ptr_hook;
+    struct t_arraylist *list_exact;
+    char *key;
+    int rc, i, indexable, index_exact, index_masks, size_exact, size_masks;
+    int num_hooks;
 
     rc = WEECHAT_RC_OK;
 
-    hook_exec_start ();
+    if (!signal || !weechat_hooks[HOOK_TYPE_SIGNAL])
+        return rc;
+
+    indexable = hook_signal_is_indexable (signal);
 
-    ptr_hook = weechat_hooks[HOOK_TYPE_SIGNAL];
-    while (ptr_hook)
+    list_exact = NULL;
+    if (indexable && hook_signal_index)
+    {
+        key = strdup (signal);
+        if (!key)
+            return rc;
+        string_tolower (key);
+        list_exact = hashtable_get (hook_signal_index, key);
+        free (key);
+    }
+    size_exact = arraylist_size (list_exact);
+    size_masks = arraylist_size (hook_signal_masks);
+
+    /*
+     * a signal with non-ASCII chars (should not happen) is compared to
+     * all hooks with string_match
+     */
+    num_hooks = (indexable) ?
+        size_exact + size_masks : hooks_count[HOOK_TYPE_SIGNAL];
+    if (num_hooks <= 0)
+        return rc;
+
+    hooks = hooks_static;
+    if (num_hooks > (int)(sizeof (hooks_static) / sizeof (hooks_static[0])))
     {
-        next_hook = ptr_hook->next_hook;
+        hooks = malloc (num_hooks * sizeof (hooks[0]));
+        if (!hooks)
+            return rc;
+    }
+
+    hook_exec_start ();
 
-        if (!ptr_hook->deleted
-            && !ptr_hook->running
-            && (string_match (signal, HOOK_SIGNAL(ptr_hook, signal), 0)))
+    num_hooks = 0;
+    if (indexable)
+    {
+        /* merge hooks with exact name and matching masks (keep order) */
+        index_exact = 0;
+        index_masks = 0;
+        while ((index_exact < size_exact) || (index_masks < size_masks))
+        {
+            if ((index_masks >= size_masks)
+                || ((index_exact < size_exact)
+                    && (hook_signal_cmp_cb (
+                            NULL, NULL,
+                            arraylist_get (list_exact, index_exact),
+                            arraylist_get (hook_signal_masks,
+                                           index_masks)) < 0)))
+            {
+                hooks[num_hooks++] = arraylist_get (list_exact,
+                                                    index_exact++);
+            }
+            else
+            {
+                ptr_hook = arraylist_get (hook_signal_masks, index_masks++);
+                if (string_match (signal, HOOK_SIGNAL(ptr_hook, signal), 0))
+                    hooks[num_hooks++] = ptr_hook;
+            }
+        }
+    }
+    else
+    {
+        for (ptr_hook = weechat_hooks[HOOK_TYPE_SIGNAL]; ptr_hook;
+             ptr_hook = ptr_hook->next_hook)
         {
-            ptr_hook->running = 1;
-            rc = (HOOK_SIGNAL(ptr_hook, callback))
-                (ptr_hook->callback_pointer,
-                 ptr_hook->callback_data,
-                 signal,
-                 type_data,
-                 signal_data);
-            ptr_hook->running = 0;
-
-            if (rc == WEECHAT_RC_OK_EAT)
-                break;
+            if (!ptr_hook->deleted
+                && (string_match (signal, HOOK_SIGNAL(ptr_hook, signal), 0)))
+            {
+                hooks[num_hooks++] = ptr_hook;
+            }
         }
+    }
 
-        ptr_hook = next_hook;
+    for (i = 0; i < num_hooks; i++)
+    {
+        ptr_hook = hooks[i];
+
+        /* hook may have been deleted by a previous callback */
+        if (ptr_hook->deleted || ptr_hook->running)
+            continue;
+
+        hook_callback_start (&tv_start);
+        ptr_hook->running = 1;
+        rc = (HOOK_SIGNAL(ptr_hook, callback))
+            (ptr_hook->callback_pointer,
+             ptr_hook->callback_data,
+             signal,
+             type_data,
+             signal_data);
+        ptr_hook->running = 0;
+        hook_callback_end (ptr_hook, &tv_start);
+
+        if (rc == WEECHAT_RC_OK_EAT)
+            break;
     }
 
     hook_exec_end ();
 
+    if (hooks != hooks_static)
+        free (hooks);
+
     return rc;
 }
 
@@ -133,6 +396,7 @@ hook_signal_free_data (struct t_hook *hook)
 
     if (HOOK_SIGNAL(hook, signal))
     {
+        hook_signal_remove_from_index (hook);
         free (HOOK_SIGNAL(hook, signal));
         HOOK_SIGNAL(hook, signal) = NULL;
     }
@@ -34,8 +34,11 @@ struct t_hook_signal
     t_hook_callback_signal *callback;  /* signal callback                   */
     char *signal;                      /* signal selected (may begin or end */
                                        /* with "*", "*" == any signal)      */
+    long long sequence;                /* order of creation (to sort hooks  */
+                                       /* with same priority)               */
 };
 
+extern void hook_signal_add_cb (struct t_hook *hook);
 extern struct t_hook *hook_signal (struct t_weechat_plugin *plugin,
                                    const char *signal,
                                    t_hook_callback_signal *callback,
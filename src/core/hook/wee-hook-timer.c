@@ -25,6 +25,7 @@
 
 #include <stdlib.h>
 #include <time.h>
+#include <sys/time.h>
 
 #include "../weechat.h"
 #include "../wee-hook.h"
@@ -36,6 +37,206 @@
 
 time_t hook_last_system_time = 0;      /* used to detect system clock skew  */
 
+/*
+ * binary min-heap of timer hooks, sorted on next execution date (the first
+ * timer to run is hook_timer_heap[0])
+ */
+struct t_hook **hook_timer_heap = NULL;
+int hook_timer_heap_size = 0;
+int hook_timer_heap_size_alloc = 0;
+
+
+/*
+ * Compares next execution date of two timers in heap.
+ *
+ * Returns:
+ *   < 0: timer at index1 must run before timer at index2
+ *     0: timers run at same time
+ *   > 0: timer at index1 must run after timer at index2
+ */
+
+int
+hook_timer_heap_cmp (int index1, int index2)
+{
+    return util_timeval_cmp (&HOOK_TIMER(hook_timer_heap[index1], next_exec),
+                             &HOOK_TIMER(hook_timer_heap[index2], next_exec));
+}
+
+/*
+ * Swaps two timers in heap.
+ */
+
+void
+hook_timer_heap_swap (int index1, int index2)
+{
+    struct t_hook *ptr_hook;
+
+    ptr_hook = hook_timer_heap[index1];
+    hook_timer_heap[index1] = hook_timer_heap[index2];
+    hook_timer_heap[index2] = ptr_hook;
+    HOOK_TIMER(hook_timer_heap[index1], heap_index) = index1;
+    HOOK_TIMER(hook_timer_heap[index2], heap_index) = index2;
+}
+
+/*
+ * Moves a timer up in heap, until its parent runs before it.
+ */
+
+void
+hook_timer_heap_sift_up (int index)
+{
+    int parent;
+
+    while (index > 0)
+    {
+        parent = (index - 1) / 2;
+        if (hook_timer_heap_cmp (index, parent) >= 0)
+            break;
+        hook_timer_heap_swap (index, parent);
+        index = parent;
+    }
+}
+
+/*
+ * Moves a timer down in heap, until its children run after it.
+ */
+
+void
+hook_timer_heap_sift_down (int index)
+{
+    int child, smallest;
+
+    while (1)
+    {
+        smallest = index;
+        child = (2 * index) + 1;
+        if ((child < hook_timer_heap_size)
+            && (hook_timer_heap_cmp (child, smallest) < 0))
+        {
+            smallest = child;
+        }
+        child++;
+        if ((child < hook_timer_heap_size)
+            && (hook_timer_heap_cmp (child, smallest) < 0))
+        {
+            smallest = child;
+        }
+        if (smallest == index)
+            break;
+        hook_timer_heap_swap (index, smallest);
+        index = smallest;
+    }
+}
+
+/*
+ * Adds a timer in heap.
+ *
+ * Returns:
+ *   1: OK
+ *   0: error (not enough memory)
+ */
+
+int
+hook_timer_heap_add (struct t_hook *hook)
+{
+    struct t_hook **new_heap;
+    int new_size_alloc;
+
+    if (hook_timer_heap_size >= hook_timer_heap_size_alloc)
+    {
+        new_size_alloc = (hook_timer_heap_size_alloc < 32) ?
+            32 : hook_timer_heap_size_alloc * 2;
+        new_heap = realloc (hook_timer_heap,
+                            new_size_alloc * sizeof (hook_timer_heap[0]));
+        if (!new_heap)
+        {
+            HOOK_TIMER(hook, heap_index) = -1;
+            return 0;
+        }
+        hook_timer_heap = new_heap;
+        hook_timer_heap_size_alloc = new_size_alloc;
+    }
+
+    hook_timer_heap[hook_timer_heap_size] = hook;
+    HOOK_TIMER(hook, heap_index) = hook_timer_heap_size;
+    hook_timer_heap_size++;
+
+    hook_timer_heap_sift_up (hook_timer_heap_size - 1);
+
+    return 1;
+}
+
+/*
+ * Removes a timer from heap (if it is in heap).
+ */
+
+void
+hook_timer_heap_remove (struct t_hook *hook)
+{
+    int index;
+
+    index = HOOK_TIMER(hook, heap_index);
+    if ((index < 0) || (index >= hook_timer_heap_size)
+        || (hook_timer_heap[index] != hook))
+    {
+        return;
+    }
+
+    HOOK_TIMER(hook, heap_index) = -1;
+    hook_timer_heap_size--;
+
+    if (index < hook_timer_heap_size)
+    {
+        hook_timer_heap[index] = hook_timer_heap[hook_timer_heap_size];
+        HOOK_TIMER(hook_timer_heap[index], heap_index) = index;
+        hook_timer_heap_sift_up (index);
+        hook_timer_heap_sift_down (index);
+    }
+
+    if (hook_timer_heap_size == 0)
+    {
+        free (hook_timer_heap);
+        hook_timer_heap = NULL;
+        hook_timer_heap_size_alloc = 0;
+    }
+}
+
+/*
+ * Moves a timer in heap after a change of its next execution date (if it is
+ * in heap).
+ */
+
+void
+hook_timer_heap_update (struct t_hook *hook)
+{
+    int index;
+
+    index = HOOK_TIMER(hook, heap_index);
+    if ((index < 0) || (index >= hook_timer_heap_size)
+        || (hook_timer_heap[index] != hook))
+    {
+        return;
+    }
+
+    hook_timer_heap_sift_up (index);
+    hook_timer_heap_sift_down (HOOK_TIMER(hook, heap_index));
+}
+
+/*
+ * Rebuilds the heap (after a change of next execution date in all timers).
+ */
+
+void
+hook_timer_heap_build ()
+{
+    int i;
+
+    for (i = (hook_timer_heap_size / 2) - 1; i >= 0; i--)
+    {
+        hook_timer_heap_sift_down (i);
+    }
+}
+
 
 /*
  * Initializes a timer hook.
@@ -129,9 +330,17 @@ hook_timer (struct t_weechat_plugin *plugin, long interval, int align_second,
     new_hook_timer->interval = interval;
     new_hook_timer->align_second = align_second;
     new_hook_timer->remaining_calls = max_calls;
+    new_hook_timer->heap_index = -1;
 
     hook_timer_init (new_hook);
 
+    if (!hook_timer_heap_add (new_hook))
+    {
+        free (new_hook_timer);
+        free (new_hook);
+        return NULL;
+    }
+
     hook_add_to_list (new_hook);
 
     return new_hook;
@@ -174,6 +383,7 @@ hook_timer_check_system_clock ()
             if (!ptr_hook->deleted)
                 hook_timer_init (ptr_hook);
         }
+        hook_timer_heap_build ();
     }
 
     hook_last_system_time = now;
@@ -186,7 +396,6 @@ hook_timer_check_system_clock ()
 int
 hook_timer_get_time_to_next ()
 {
-    struct t_hook *ptr_hook;
     int found, timeout;
     struct timeval tv_now, tv_timeout;
     long diff_usec;
@@ -197,18 +406,12 @@ hook_timer_get_time_to_next ()
     tv_timeout.tv_sec = 0;
     tv_timeout.tv_usec = 0;
 
-    for (ptr_hook = weechat_hooks[HOOK_TYPE_TIMER]; ptr_hook;
-         ptr_hook = ptr_hook->next_hook)
+    /* the first timer in heap is the next one to run */
+    if (hook_timer_heap_size > 0)
     {
-        if (!ptr_hook->deleted
-            && (!found
-                || (util_timeval_cmp (&HOOK_TIMER(ptr_hook, next_exec),
-                                      &tv_timeout) < 0)))
-        {
-            found = 1;
-            tv_timeout.tv_sec = HOOK_TIMER(ptr_hook, next_exec).tv_sec;
-            tv_timeout.tv_usec = HOOK_TIMER(ptr_hook, next_exec).tv_usec;
-        }
+        found = 1;
+        tv_timeout.tv_sec = HOOK_TIMER(hook_timer_heap[0], next_exec).tv_sec;
+        tv_timeout.tv_usec = HOOK_TIMER(hook_timer_heap[0], next_exec).tv_usec;
     }
 
     /* no timeout found, return 2 seconds by default */
@@ -259,13 +462,17 @@ end:
 
 /*
  * Executes timer hooks.
+ *
+ * Timers to run are removed from heap before callbacks are called, then added
+ * again in heap with their new execution date.
  */
 
 void
 hook_timer_exec ()
 {
-    struct timeval tv_time;
-    struct t_hook *ptr_hook, *next_hook;
+    struct timeval tv_time, tv_start;
+    struct t_hook *ptr_hook, **hooks, **new_hooks;
+    int i, num_hooks, size_alloc;
 
     if (!weechat_hooks[HOOK_TYPE_TIMER])
         return;
@@ -274,18 +481,47 @@ hook_timer_exec ()
 
     gettimeofday (&tv_time, NULL);
 
+    if ((hook_timer_heap_size == 0)
+        || (util_timeval_cmp (&HOOK_TIMER(hook_timer_heap[0], next_exec),
+                              &tv_time) > 0))
+    {
+        return;
+    }
+
     hook_exec_start ();
 
-    ptr_hook = weechat_hooks[HOOK_TYPE_TIMER];
-    while (ptr_hook)
+    /* extract all timers to run from heap */
+    hooks = NULL;
+    num_hooks = 0;
+    size_alloc = 0;
+    while ((hook_timer_heap_size > 0)
+           && (util_timeval_cmp (&HOOK_TIMER(hook_timer_heap[0], next_exec),
+                                 &tv_time) <= 0))
     {
-        next_hook = ptr_hook->next_hook;
+        if (num_hooks >= size_alloc)
+        {
+            size_alloc = (size_alloc < 16) ? 16 : size_alloc * 2;
+            new_hooks = realloc (hooks, size_alloc * sizeof (hooks[0]));
+            if (!new_hooks)
+                break;
+            hooks = new_hooks;
+        }
+        ptr_hook = hook_timer_heap[0];
+        hook_timer_heap_remove (ptr_hook);
+        hooks[num_hooks++] = ptr_hook;
+    }
+
+    for (i = 0; i < num_hooks; i++)
+    {
+        ptr_hook = hooks[i];
 
-        if (!ptr_hook->deleted
-            && !ptr_hook->running
-            && (util_timeval_cmp (&HOOK_TIMER(ptr_hook, next_exec),
-                                  &tv_time) <= 0))
+        /* timer removed by a previous callback? */
+        if (ptr_hook->deleted)
+            continue;
+
+        if (!ptr_hook->running)
         {
+            hook_callback_start (&tv_start);
             ptr_hook->running = 1;
             (void) (HOOK_TIMER(ptr_hook, callback))
                 (ptr_hook->callback_pointer,
@@ -293,6 +529,7 @@ hook_timer_exec ()
                  (HOOK_TIMER(ptr_hook, remaining_calls) > 0) ?
                   HOOK_TIMER(ptr_hook, remaining_calls) - 1 : -1);
             ptr_hook->running = 0;
+            hook_callback_end (ptr_hook, &tv_start);
             if (!ptr_hook->deleted)
             {
                 HOOK_TIMER(ptr_hook, last_exec).tv_sec = tv_time.tv_sec;
@@ -311,9 +548,13 @@ hook_timer_exec ()
             }
         }
 
-        ptr_hook = next_hook;
+        if (!ptr_hook->deleted && !hook_timer_heap_add (ptr_hook))
+            unhook (ptr_hook);
     }
 
+    if (hooks)
+        free (hooks);
+
     hook_exec_end ();
 }
 
@@ -327,6 +568,8 @@ hook_timer_free_data (struct t_hook *hook)
     if (!hook || !hook->hook_data)
         return;
 
+    hook_timer_heap_remove (hook);
+
     free (hook->hook_data);
     hook->hook_data = NULL;
 }
@@ -414,4 +657,5 @@ hook_timer_print_log (struct t_hook *hook)
                 (long long)(HOOK_TIMER(hook, next_exec.tv_sec)),
                 text_time);
     log_printf ("    next_exec.tv_usec . . : %ld", HOOK_TIMER(hook, next_exec.tv_usec));
+    log_printf ("    heap_index. . . . . . : %d", HOOK_TIMER(hook, heap_index));
 }
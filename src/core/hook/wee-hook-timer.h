@@ -39,6 +39,8 @@ struct t_hook_timer
     int remaining_calls;               /* calls remaining (0 = unlimited)   */
     struct timeval last_exec;          /* last time hook was executed       */
     struct timeval next_exec;          /* next scheduled execution          */
+    int heap_index;                    /* index in heap of timers (-1 if    */
+                                       /* timer is not in heap)             */
 };
 
 extern time_t hook_last_system_time;
@@ -49,6 +51,7 @@ extern struct t_hook *hook_timer (struct t_weechat_plugin *plugin,
                                   t_hook_callback_timer *callback,
                                   const void *callback_pointer,
                                   void *callback_data);
+extern void hook_timer_heap_update (struct t_hook *hook);
 extern int hook_timer_get_time_to_next ();
 extern void hook_timer_exec ();
 extern void hook_timer_free_data (struct t_hook *hook);
@@ -1821,7 +1821,36 @@ COMMAND_CALLBACK(debug)
 
     if (string_strcasecmp (argv[1], "hooks") == 0)
     {
-        debug_hooks ();
+        if ((argc > 2) && (string_strcasecmp (argv[2], "stats") == 0))
+        {
+            if (argc > 3)
+            {
+                if (string_strcasecmp (argv[3], "on") == 0)
+                {
+                    hook_stats_enabled = 1;
+                    gui_chat_printf (NULL,
+                                     _("Statistics on hooks enabled"));
+                }
+                else if (string_strcasecmp (argv[3], "off") == 0)
+                {
+                    hook_stats_enabled = 0;
+                    gui_chat_printf (NULL,
+                                     _("Statistics on hooks disabled"));
+                }
+                else if (string_strcasecmp (argv[3], "reset") == 0)
+                {
+                    hook_stats_reset ();
+                    gui_chat_printf (NULL,
+                                     _("Statistics on hooks reset"));
+                }
+                else
+                    COMMAND_ERROR;
+            }
+            else
+                debug_hooks_stats ();
+        }
+        else
+            debug_hooks ();
         return WEECHAT_RC_OK;
     }
 
@@ -7328,6 +7357,7 @@ command_init ()
            " || buffer|color|infolists|memory|tags|term|windows"
            " || mouse|cursor [verbose]"
            " || hdata [free]"
+           " || hooks [stats [on|off|reset]]"
            " || time <command>"),
         N_("     list: list plugins with debug levels\n"
            "      set: set debug level for plugin\n"
@@ -7341,7 +7371,10 @@ command_init ()
            "     dirs: display directories\n"
            "    hdata: display infos about hdata (with free: remove all hdata "
            "in memory)\n"
-           "    hooks: display infos about hooks\n"
+           "    hooks: display infos about hooks (with stats: display time "
+           "spent in callbacks, most expensive hooks first; on/off: "
+           "enable/disable measure (disabled by default), reset: reset "
+           "statistics)\n"
            "infolists: display infos about infolists\n"
            "     libs: display infos about external libraries used\n"
            "   memory: display infos about memory usage\n"
@@ -7359,7 +7392,7 @@ command_init ()
         " || cursor verbose"
         " || dirs"
         " || hdata free"
-        " || hooks"
+        " || hooks stats on|off|reset"
         " || infolists"
         " || libs"
         " || memory"
@@ -48,6 +48,7 @@
 #include "wee-proxy.h"
 #include "wee-string.h"
 #include "wee-version.h"
+#include "wee-worker.h"
 #include "../gui/gui-bar.h"
 #include "../gui/gui-bar-item.h"
 #include "../gui/gui-buffer.h"
@@ -194,6 +195,7 @@ struct t_config_option *config_look_window_separator_vertical;
 struct t_config_option *config_look_window_title;
 struct t_config_option *config_look_word_chars_highlight;
 struct t_config_option *config_look_word_chars_input;
+struct t_config_option *config_look_worker_threads;
 
 /* config, colors section */
 
@@ -308,6 +310,7 @@ int config_emphasized_attributes = 0;
 regex_t *config_highlight_regex = NULL;
 char ***config_highlight_tags = NULL;
 int config_num_highlight_tags = 0;
+struct t_gui_line_tags_match *config_highlight_tags_match = NULL;
 char **config_plugin_extensions = NULL;
 int config_num_plugin_extensions = 0;
 char config_tab_spaces[TAB_MAX_WIDTH + 1];
@@ -546,6 +549,22 @@ config_change_word_chars_input (const void *pointer, void *data,
                            &config_word_chars_input_count);
 }
 
+/*
+ * Callback for changes on option "weechat.look.worker_threads".
+ */
+
+void
+config_change_worker_threads (const void *pointer, void *data,
+                              struct t_config_option *option)
+{
+    /* make C compiler happy */
+    (void) pointer;
+    (void) data;
+    (void) option;
+
+    worker_set_threads (CONFIG_INTEGER(config_look_worker_threads));
+}
+
 /*
  * Callback for changes on options that require a refresh of buffers.
  */
@@ -575,6 +594,8 @@ config_change_buffer_content (const void *pointer, void *data,
     (void) data;
     (void) option;
 
+    gui_chat_rows_invalidate ();
+
     if (gui_init_ok)
         gui_current_window->refresh_needed = 1;
 }
@@ -890,6 +911,11 @@ config_change_highlight_tags (const void *pointer, void *data,
     (void) data;
     (void) option;
 
+    if (config_highlight_tags_match)
+    {
+        gui_line_tags_match_free (config_highlight_tags_match);
+        config_highlight_tags_match = NULL;
+    }
     if (config_highlight_tags)
     {
         string_free_split_tags (config_highlight_tags);
@@ -903,6 +929,9 @@ config_change_highlight_tags (const void *pointer, void *data,
         config_highlight_tags = string_split_tags (
             CONFIG_STRING(config_look_highlight_tags),
             &config_num_highlight_tags);
+        config_highlight_tags_match = gui_line_tags_match_new (
+            config_num_highlight_tags,
+            config_highlight_tags);
     }
 }
 
@@ -3539,6 +3568,16 @@ config_weechat_init_options ()
         NULL, NULL, NULL,
         &config_change_word_chars_input, NULL, NULL,
         NULL, NULL, NULL);
+    config_look_worker_threads = config_file_new_option (
+        weechat_config_file, ptr_section,
+        "worker_threads", "integer",
+        N_("number of threads used to filter lines of buffers in background "
+           "(only for buffers with a lot of lines); 0 = do not use threads, "
+           "all lines are filtered in main thread"),
+        NULL, 0, WORKER_MAX_THREADS, "0", NULL, 0,
+        NULL, NULL, NULL,
+        &config_change_worker_threads, NULL, NULL,
+        NULL, NULL, NULL);
 
     /* palette */
     ptr_section = config_file_new_section (
@@ -4609,6 +4648,11 @@ config_weechat_free ()
         config_highlight_regex = NULL;
     }
 
+    if (config_highlight_tags_match)
+    {
+        gui_line_tags_match_free (config_highlight_tags_match);
+        config_highlight_tags_match = NULL;
+    }
     if (config_highlight_tags)
     {
         string_free_split_tags (config_highlight_tags);
@@ -27,6 +27,7 @@
 #include "wee-config-file.h"
 
 struct t_gui_buffer;
+struct t_gui_line_tags_match;
 
 #define WEECHAT_CONFIG_NAME "weechat"
 
@@ -245,6 +246,7 @@ extern struct t_config_option *config_look_window_separator_vertical;
 extern struct t_config_option *config_look_window_title;
 extern struct t_config_option *config_look_word_chars_highlight;
 extern struct t_config_option *config_look_word_chars_input;
+extern struct t_config_option *config_look_worker_threads;
 
 extern struct t_config_option *config_color_bar_more;
 extern struct t_config_option *config_color_chat;
@@ -345,6 +347,7 @@ extern int config_emphasized_attributes;
 extern regex_t *config_highlight_regex;
 extern char ***config_highlight_tags;
 extern int config_num_highlight_tags;
+extern struct t_gui_line_tags_match *config_highlight_tags_match;
 extern char **config_plugin_extensions;
 extern int config_num_plugin_extensions;
 extern char config_tab_spaces[];
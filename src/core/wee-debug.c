@@ -48,8 +48,10 @@
 #include "wee-list.h"
 #include "wee-log.h"
 #include "wee-proxy.h"
+#include "wee-slab.h"
 #include "wee-string.h"
 #include "wee-util.h"
+#include "wee-worker.h"
 #include "../gui/gui-bar.h"
 #include "../gui/gui-bar-item.h"
 #include "../gui/gui-buffer.h"
@@ -58,6 +60,7 @@
 #include "../gui/gui-hotlist.h"
 #include "../gui/gui-key.h"
 #include "../gui/gui-layout.h"
+#include "../gui/gui-line.h"
 #include "../gui/gui-main.h"
 #include "../gui/gui-window.h"
 #include "../plugins/plugin.h"
@@ -99,6 +102,10 @@ debug_dump (int crash)
     gui_bar_item_print_log ();
     gui_hotlist_print_log ();
 
+    slab_print_log ();
+
+    worker_print_log ();
+
     hdata_print_log ();
 
     infolist_print_log ();
@@ -248,6 +255,95 @@ debug_windows_tree ()
     debug_windows_tree_display (gui_windows_tree, 1);
 }
 
+/*
+ * Displays memory used by slabs.
+ */
+
+void
+debug_memory_slabs ()
+{
+    struct t_slab *ptr_slab;
+
+    if (!slabs)
+        return;
+
+    gui_chat_printf (NULL, "");
+    gui_chat_printf (NULL, _("Memory used by slabs:"));
+    gui_chat_printf (NULL,
+                     _("  slab              size    objects   chunks  "
+                       "used (bytes)  allocated (bytes)"));
+    for (ptr_slab = slabs; ptr_slab; ptr_slab = ptr_slab->next_slab)
+    {
+        gui_chat_printf (NULL,
+                         "  %-14s %7d %10ld %8d %13ld %18ld",
+                         ptr_slab->name,
+                         ptr_slab->object_size,
+                         ptr_slab->objects_count,
+                         ptr_slab->chunks_count,
+                         ptr_slab->objects_count * ptr_slab->object_size,
+                         (long)ptr_slab->chunks_count * SLAB_CHUNK_SIZE);
+    }
+}
+
+/*
+ * Displays memory used by lines of buffers.
+ */
+
+void
+debug_memory_lines ()
+{
+    struct t_gui_buffer *ptr_buffer;
+    struct t_gui_line *ptr_line;
+    long num_lines, num_mixed_lines, size_lines, size_lines_data;
+    long size_messages_tags, size_str_time;
+
+    num_lines = 0;
+    num_mixed_lines = 0;
+    size_messages_tags = 0;
+    size_str_time = 0;
+
+    for (ptr_buffer = gui_buffers; ptr_buffer;
+         ptr_buffer = ptr_buffer->next_buffer)
+    {
+        for (ptr_line = ptr_buffer->own_lines->first_line; ptr_line;
+             ptr_line = ptr_line->next_line)
+        {
+            num_lines++;
+            if (ptr_line->data->tags_array)
+            {
+                size_messages_tags += (ptr_line->data->tags_count + 1) *
+                    sizeof (ptr_line->data->tags_array[0]);
+            }
+            if (ptr_line->data->message)
+                size_messages_tags += strlen (ptr_line->data->message) + 1;
+            if (ptr_line->data->str_time)
+                size_str_time += strlen (ptr_line->data->str_time) + 1;
+        }
+        /* mixed lines are counted only once (on first buffer merged) */
+        if (ptr_buffer->mixed_lines
+            && ((ptr_buffer == gui_buffers)
+                || (ptr_buffer->prev_buffer->number != ptr_buffer->number)))
+        {
+            num_mixed_lines += ptr_buffer->mixed_lines->lines_count;
+        }
+    }
+
+    size_lines = (num_lines + num_mixed_lines) * sizeof (struct t_gui_line);
+    size_lines_data = num_lines * sizeof (struct t_gui_line_data);
+
+    gui_chat_printf (NULL, "");
+    gui_chat_printf (NULL, _("Memory used by lines (bytes):"));
+    gui_chat_printf (NULL, _("  lines            : %12ld (%ld lines, "
+                             "%ld mixed lines)"),
+                     size_lines, num_lines, num_mixed_lines);
+    gui_chat_printf (NULL, _("  lines data       : %12ld"), size_lines_data);
+    gui_chat_printf (NULL, _("  messages and tags: %12ld"), size_messages_tags);
+    gui_chat_printf (NULL, _("  time strings     : %12ld"), size_str_time);
+    gui_chat_printf (NULL, _("  total            : %12ld"),
+                     size_lines + size_lines_data + size_messages_tags
+                     + size_str_time);
+}
+
 /*
  * Displays information about dynamic memory allocation.
  */
@@ -277,6 +373,9 @@ debug_memory ()
                      _("Memory usage not available (function \"mallinfo\" not "
                        "found)"));
 #endif /* HAVE_MALLINFO */
+
+    debug_memory_slabs ();
+    debug_memory_lines ();
 }
 
 /*
@@ -413,6 +512,106 @@ debug_hooks ()
     gui_chat_printf (NULL, "%17s:%5d", "total", hooks_count_total);
 }
 
+/*
+ * Compares two hooks to sort them by total time spent in callback
+ * (descending order), then by number of calls (descending order).
+ */
+
+int
+debug_hooks_stats_cmp_cb (const void *hook1, const void *hook2)
+{
+    struct t_hook *ptr_hook1, *ptr_hook2;
+
+    ptr_hook1 = *((struct t_hook **)hook1);
+    ptr_hook2 = *((struct t_hook **)hook2);
+
+    if (ptr_hook1->stats_time_total != ptr_hook2->stats_time_total)
+        return (ptr_hook1->stats_time_total > ptr_hook2->stats_time_total) ?
+            -1 : 1;
+
+    if (ptr_hook1->stats_calls != ptr_hook2->stats_calls)
+        return (ptr_hook1->stats_calls > ptr_hook2->stats_calls) ? -1 : 1;
+
+    return 0;
+}
+
+/*
+ * Displays statistics on hooks callbacks (number of calls and time spent in
+ * callbacks), sorted by total time (most expensive hooks first).
+ */
+
+void
+debug_hooks_stats ()
+{
+    struct t_hook *ptr_hook, **hooks;
+    char description[256], plugin_name[512];
+    int type, i, count;
+
+    gui_chat_printf (NULL, "");
+    gui_chat_printf (NULL, "hooks statistics (%s):",
+                     (hook_stats_enabled) ? "enabled" : "disabled");
+
+    count = 0;
+    for (type = 0; type < HOOK_NUM_TYPES; type++)
+    {
+        for (ptr_hook = weechat_hooks[type]; ptr_hook;
+             ptr_hook = ptr_hook->next_hook)
+        {
+            if (!ptr_hook->deleted && (ptr_hook->stats_calls > 0))
+                count++;
+        }
+    }
+
+    if (count == 0)
+    {
+        gui_chat_printf (NULL, "  (no statistics)");
+        return;
+    }
+
+    hooks = malloc (count * sizeof (*hooks));
+    if (!hooks)
+        return;
+
+    i = 0;
+    for (type = 0; type < HOOK_NUM_TYPES; type++)
+    {
+        for (ptr_hook = weechat_hooks[type]; ptr_hook;
+             ptr_hook = ptr_hook->next_hook)
+        {
+            if (!ptr_hook->deleted && (ptr_hook->stats_calls > 0))
+                hooks[i++] = ptr_hook;
+        }
+    }
+
+    qsort (hooks, count, sizeof (*hooks), &debug_hooks_stats_cmp_cb);
+
+    gui_chat_printf (NULL,
+                     "  %12s %10s %10s %10s  %-12s %-16s %s",
+                     "total (ms)", "calls", "avg (us)", "max (us)",
+                     "type", "plugin", "description");
+    for (i = 0; i < count; i++)
+    {
+        ptr_hook = hooks[i];
+        hook_get_description (ptr_hook, description, sizeof (description));
+        snprintf (plugin_name, sizeof (plugin_name),
+                  "%s%s%s",
+                  plugin_get_name (ptr_hook->plugin),
+                  (ptr_hook->subplugin) ? "/" : "",
+                  (ptr_hook->subplugin) ? ptr_hook->subplugin : "");
+        gui_chat_printf (NULL,
+                         "  %12.3f %10llu %10llu %10llu  %-12s %-16s %s",
+                         ((double)ptr_hook->stats_time_total) / 1000,
+                         ptr_hook->stats_calls,
+                         ptr_hook->stats_time_total / ptr_hook->stats_calls,
+                         ptr_hook->stats_time_max,
+                         hook_type_string[ptr_hook->type],
+                         plugin_name,
+                         description);
+    }
+
+    free (hooks);
+}
+
 /*
  * Displays a list of infolists in memory.
  */
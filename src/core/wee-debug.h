@@ -27,6 +27,7 @@ extern void debug_windows_tree ();
 extern void debug_memory ();
 extern void debug_hdata ();
 extern void debug_hooks ();
+extern void debug_hooks_stats ();
 extern void debug_infolists ();
 extern void debug_directories ();
 extern void debug_display_time_elapsed (struct timeval *time1,
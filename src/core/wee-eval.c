@@ -49,6 +49,12 @@ char *logical_ops[EVAL_NUM_LOGICAL_OPS] =
 char *comparisons[EVAL_NUM_COMPARISONS] =
 { "=~", "!~", "=*", "!*", "==", "!=", "<=", "<", ">=", ">" };
 
+/* cache of compiled conditions (most recently used first) */
+struct t_hashtable *eval_cache = NULL;
+struct t_eval_compiled *eval_cache_first = NULL;
+struct t_eval_compiled *eval_cache_last = NULL;
+int eval_cache_count = 0;
+
 
 char *eval_replace_vars (const char *expr,
                          struct t_eval_context *eval_context);
@@ -1101,6 +1107,506 @@ end:
     return value;
 }
 
+/*
+ * Creates a new node for a compiled condition.
+ *
+ * Returns pointer to new node, NULL if error.
+ */
+
+struct t_eval_node *
+eval_node_new (enum t_eval_node_type type, int op, const char *text,
+               int length_text)
+{
+    struct t_eval_node *new_node;
+
+    new_node = malloc (sizeof (*new_node));
+    if (!new_node)
+        return NULL;
+
+    new_node->type = type;
+    new_node->op = op;
+    new_node->text = NULL;
+    new_node->left = NULL;
+    new_node->right = NULL;
+
+    if (text)
+    {
+        new_node->text = (length_text >= 0) ?
+            string_strndup (text, length_text) : strdup (text);
+        if (!new_node->text)
+        {
+            free (new_node);
+            return NULL;
+        }
+    }
+
+    return new_node;
+}
+
+/*
+ * Frees a node of a compiled condition (and its children).
+ */
+
+void
+eval_node_free (struct t_eval_node *node)
+{
+    if (!node)
+        return;
+
+    if (node->text)
+        free (node->text);
+    eval_node_free (node->left);
+    eval_node_free (node->right);
+
+    free (node);
+}
+
+/*
+ * Creates a leaf node with a text in which variables must be replaced: if the
+ * text does not contain any variable (and no escaped prefix), a node with
+ * static text is created, so that the text is just copied on evaluation.
+ *
+ * Returns pointer to new node, NULL if error.
+ */
+
+struct t_eval_node *
+eval_node_new_text (const char *text, int length_text, const char *prefix)
+{
+    struct t_eval_node *new_node;
+    const char *ptr_text;
+
+    new_node = eval_node_new (EVAL_NODE_TEXT, 0, text, length_text);
+    if (!new_node)
+        return NULL;
+
+    for (ptr_text = new_node->text; ptr_text[0]; ptr_text++)
+    {
+        if (((ptr_text[0] == '\\') && (ptr_text[1] == prefix[0]))
+            || (strncmp (ptr_text, prefix, strlen (prefix)) == 0))
+        {
+            new_node->type = EVAL_NODE_VARS;
+            break;
+        }
+    }
+
+    return new_node;
+}
+
+/*
+ * Creates a node with two operands (logical operator or comparison).
+ *
+ * The nodes "left" and "right" are freed if the node can not be created.
+ *
+ * Returns pointer to new node, NULL if error.
+ */
+
+struct t_eval_node *
+eval_node_new_operator (enum t_eval_node_type type, int op,
+                        struct t_eval_node *left, struct t_eval_node *right)
+{
+    struct t_eval_node *new_node;
+
+    new_node = (left && right) ? eval_node_new (type, op, NULL, 0) : NULL;
+    if (!new_node)
+    {
+        eval_node_free (left);
+        eval_node_free (right);
+        return NULL;
+    }
+
+    new_node->left = left;
+    new_node->right = right;
+
+    return new_node;
+}
+
+/*
+ * Compiles a condition: the expression is split on logical operators,
+ * comparisons and parentheses once, exactly like function
+ * eval_expression_condition() does on each evaluation, so that only the
+ * variables remain to be replaced when the condition is evaluated.
+ *
+ * The argument "prefix" is the prefix before variables (for example "${").
+ *
+ * Returns pointer to root node, NULL if error.
+ */
+
+struct t_eval_node *
+eval_compile_condition (const char *expr, const char *prefix)
+{
+    int logic, comp, level, length;
+    const char *pos, *pos_end;
+    char *expr2, *sub_expr;
+    struct t_eval_node *node, *left, *right;
+
+    if (!expr || !prefix || !prefix[0])
+        return NULL;
+
+    /* skip spaces at beginning of string */
+    while (expr[0] == ' ')
+    {
+        expr++;
+    }
+    if (!expr[0])
+        return eval_node_new (EVAL_NODE_TEXT, 0, "", -1);
+
+    /* skip spaces at end of string */
+    pos_end = expr + strlen (expr) - 1;
+    while ((pos_end > expr) && (pos_end[0] == ' '))
+    {
+        pos_end--;
+    }
+
+    expr2 = string_strndup (expr, pos_end + 1 - expr);
+    if (!expr2)
+        return NULL;
+
+    node = NULL;
+
+    /* logical operators */
+    for (logic = 0; logic < EVAL_NUM_LOGICAL_OPS; logic++)
+    {
+        pos = eval_strstr_level (expr2, logical_ops[logic], "(", ")", 0);
+        if (pos > expr2)
+        {
+            pos_end = pos - 1;
+            while ((pos_end > expr2) && (pos_end[0] == ' '))
+            {
+                pos_end--;
+            }
+            left = NULL;
+            sub_expr = string_strndup (expr2, pos_end + 1 - expr2);
+            if (sub_expr)
+            {
+                left = eval_compile_condition (sub_expr, prefix);
+                free (sub_expr);
+            }
+            pos += strlen (logical_ops[logic]);
+            while (pos[0] == ' ')
+            {
+                pos++;
+            }
+            right = eval_compile_condition (pos, prefix);
+            node = eval_node_new_operator (EVAL_NODE_LOGICAL, logic,
+                                           left, right);
+            goto end;
+        }
+    }
+
+    /* comparisons */
+    for (comp = 0; comp < EVAL_NUM_COMPARISONS; comp++)
+    {
+        pos = eval_strstr_level (expr2, comparisons[comp], "(", ")", 0);
+        if (pos >= expr2)
+        {
+            length = 0;
+            if (pos > expr2)
+            {
+                pos_end = pos - 1;
+                while ((pos_end > expr2) && (pos_end[0] == ' '))
+                {
+                    pos_end--;
+                }
+                length = pos_end + 1 - expr2;
+            }
+            pos += strlen (comparisons[comp]);
+            while (pos[0] == ' ')
+            {
+                pos++;
+            }
+            if ((comp == EVAL_COMPARE_REGEX_MATCHING)
+                || (comp == EVAL_COMPARE_REGEX_NOT_MATCHING))
+            {
+                /* for regex: just replace vars in both expressions */
+                left = eval_node_new_text (expr2, length, prefix);
+                right = eval_node_new_text (pos, -1, prefix);
+            }
+            else
+            {
+                /* other comparison: fully evaluate both expressions */
+                left = NULL;
+                sub_expr = string_strndup (expr2, length);
+                if (sub_expr)
+                {
+                    left = eval_compile_condition (sub_expr, prefix);
+                    free (sub_expr);
+                }
+                right = eval_compile_condition (pos, prefix);
+            }
+            node = eval_node_new_operator (EVAL_NODE_COMPARE, comp,
+                                           left, right);
+            goto end;
+        }
+    }
+
+    /* parentheses */
+    if (expr2[0] == '(')
+    {
+        level = 0;
+        pos = expr2 + 1;
+        while (pos[0])
+        {
+            if (pos[0] == '(')
+                level++;
+            else if (pos[0] == ')')
+            {
+                if (level == 0)
+                    break;
+                level--;
+            }
+            pos++;
+        }
+        if (pos[0] != ')')
+        {
+            /* closing parenthesis not found */
+            node = eval_node_new (EVAL_NODE_INVALID, 0, NULL, 0);
+        }
+        else if (!pos[1])
+        {
+            /* nothing around parentheses: compile sub-expression */
+            sub_expr = string_strndup (expr2 + 1, pos - expr2 - 1);
+            if (sub_expr)
+            {
+                node = eval_compile_condition (sub_expr, prefix);
+                free (sub_expr);
+            }
+        }
+        else
+        {
+            /*
+             * text after parentheses: the value of sub-expression is
+             * concatenated with this text and the result is parsed again,
+             * so it can not be compiled
+             */
+            node = eval_node_new (EVAL_NODE_DYNAMIC, 0, expr2, -1);
+        }
+        goto end;
+    }
+
+    /* no logical operator, comparison or parentheses: just replace vars */
+    node = eval_node_new_text (expr2, -1, prefix);
+
+end:
+    free (expr2);
+
+    return node;
+}
+
+/*
+ * Evaluates a compiled condition (this function must not be called directly).
+ *
+ * For return value, see function eval_expression().
+ *
+ * Note: result must be freed after use (if not NULL).
+ */
+
+char *
+eval_node_evaluate (struct t_eval_node *node,
+                    struct t_eval_context *eval_context)
+{
+    char *value, *value2, *result;
+    int rc;
+
+    switch (node->type)
+    {
+        case EVAL_NODE_LOGICAL:
+            value = eval_node_evaluate (node->left, eval_context);
+            rc = eval_is_true (value);
+            if (value)
+                free (value);
+            if ((rc && (node->op == EVAL_LOGICAL_OP_AND))
+                || (!rc && (node->op == EVAL_LOGICAL_OP_OR)))
+            {
+                value = eval_node_evaluate (node->right, eval_context);
+                rc = eval_is_true (value);
+                if (value)
+                    free (value);
+            }
+            return strdup ((rc) ? EVAL_STR_TRUE : EVAL_STR_FALSE);
+        case EVAL_NODE_COMPARE:
+            value = eval_node_evaluate (node->left, eval_context);
+            value2 = eval_node_evaluate (node->right, eval_context);
+            result = eval_compare (value, node->op, value2);
+            if (value)
+                free (value);
+            if (value2)
+                free (value2);
+            return result;
+        case EVAL_NODE_TEXT:
+            return strdup (node->text);
+        case EVAL_NODE_VARS:
+            return eval_replace_vars (node->text, eval_context);
+        case EVAL_NODE_DYNAMIC:
+            return eval_expression_condition (node->text, eval_context);
+        case EVAL_NODE_INVALID:
+        case EVAL_NUM_NODE_TYPES:
+            break;
+    }
+
+    return NULL;
+}
+
+/*
+ * Removes a compiled condition from the list of compiled conditions.
+ */
+
+void
+eval_cache_unlink (struct t_eval_compiled *compiled)
+{
+    if (compiled->prev_compiled)
+        (compiled->prev_compiled)->next_compiled = compiled->next_compiled;
+    if (compiled->next_compiled)
+        (compiled->next_compiled)->prev_compiled = compiled->prev_compiled;
+    if (eval_cache_first == compiled)
+        eval_cache_first = compiled->next_compiled;
+    if (eval_cache_last == compiled)
+        eval_cache_last = compiled->prev_compiled;
+    compiled->prev_compiled = NULL;
+    compiled->next_compiled = NULL;
+}
+
+/*
+ * Adds a compiled condition at the beginning of list (most recently used).
+ */
+
+void
+eval_cache_link_first (struct t_eval_compiled *compiled)
+{
+    compiled->prev_compiled = NULL;
+    compiled->next_compiled = eval_cache_first;
+    if (eval_cache_first)
+        eval_cache_first->prev_compiled = compiled;
+    else
+        eval_cache_last = compiled;
+    eval_cache_first = compiled;
+}
+
+/*
+ * Frees a compiled condition (it must have been removed from cache before).
+ */
+
+void
+eval_compiled_free (struct t_eval_compiled *compiled)
+{
+    if (!compiled)
+        return;
+
+    if (compiled->expr)
+        free (compiled->expr);
+    eval_node_free (compiled->root);
+
+    free (compiled);
+}
+
+/*
+ * Removes the least recently used compiled conditions, so that there is room
+ * for a new one in cache.
+ *
+ * Compiled conditions currently evaluated are not removed (so the cache can
+ * temporarily contain more than EVAL_CACHE_MAX entries).
+ */
+
+void
+eval_cache_purge ()
+{
+    struct t_eval_compiled *ptr_compiled, *prev_compiled;
+
+    ptr_compiled = eval_cache_last;
+    while (ptr_compiled && (eval_cache_count >= EVAL_CACHE_MAX))
+    {
+        prev_compiled = ptr_compiled->prev_compiled;
+        if (ptr_compiled->running == 0)
+        {
+            hashtable_remove (eval_cache, ptr_compiled->expr);
+            eval_cache_unlink (ptr_compiled);
+            eval_compiled_free (ptr_compiled);
+            eval_cache_count--;
+        }
+        ptr_compiled = prev_compiled;
+    }
+}
+
+/*
+ * Gets a compiled condition from cache, or compiles the condition and adds
+ * it in cache.
+ *
+ * Returns pointer to compiled condition, NULL if error.
+ */
+
+struct t_eval_compiled *
+eval_cache_get (const char *expr)
+{
+    struct t_eval_compiled *compiled;
+
+    if (!eval_cache)
+    {
+        eval_cache = hashtable_new (64,
+                                    WEECHAT_HASHTABLE_STRING,
+                                    WEECHAT_HASHTABLE_POINTER,
+                                    NULL, NULL);
+        if (!eval_cache)
+            return NULL;
+    }
+
+    compiled = (struct t_eval_compiled *)hashtable_get (eval_cache, expr);
+    if (compiled)
+    {
+        /* move compiled condition to the beginning of list */
+        if (compiled != eval_cache_first)
+        {
+            eval_cache_unlink (compiled);
+            eval_cache_link_first (compiled);
+        }
+        return compiled;
+    }
+
+    eval_cache_purge ();
+
+    compiled = malloc (sizeof (*compiled));
+    if (!compiled)
+        return NULL;
+    compiled->expr = strdup (expr);
+    compiled->root = eval_compile_condition (expr, EVAL_DEFAULT_PREFIX);
+    compiled->running = 0;
+    if (!compiled->expr || !compiled->root
+        || !hashtable_set (eval_cache, expr, compiled))
+    {
+        eval_compiled_free (compiled);
+        return NULL;
+    }
+    eval_cache_link_first (compiled);
+    eval_cache_count++;
+
+    return compiled;
+}
+
+/*
+ * Frees all compiled conditions in cache.
+ */
+
+void
+eval_cache_free_all ()
+{
+    struct t_eval_compiled *ptr_compiled, *next_compiled;
+
+    ptr_compiled = eval_cache_first;
+    while (ptr_compiled)
+    {
+        next_compiled = ptr_compiled->next_compiled;
+        eval_compiled_free (ptr_compiled);
+        ptr_compiled = next_compiled;
+    }
+    eval_cache_first = NULL;
+    eval_cache_last = NULL;
+    eval_cache_count = 0;
+
+    if (eval_cache)
+    {
+        hashtable_free (eval_cache);
+        eval_cache = NULL;
+    }
+}
+
 /*
  * Replaces text in a string using a regular expression and replacement text.
  *
@@ -1284,6 +1790,7 @@ eval_expression (const char *expr, struct t_hashtable *pointers,
     const char *default_suffix = EVAL_DEFAULT_SUFFIX;
     const char *ptr_value, *regex_replace;
     struct t_gui_window *window;
+    struct t_eval_compiled *compiled;
     regex_t *regex;
 
     if (!expr)
@@ -1395,8 +1902,23 @@ eval_expression (const char *expr, struct t_hashtable *pointers,
     /* evaluate expression */
     if (condition)
     {
-        /* evaluate as condition (return a boolean: "0" or "1") */
-        value = eval_expression_condition (expr, &eval_context);
+        /*
+         * evaluate as condition (return a boolean: "0" or "1");
+         * the condition is compiled once and kept in cache (only with
+         * default prefix, which is used to detect text without variables)
+         */
+        compiled = (strcmp (eval_context.prefix, default_prefix) == 0) ?
+            eval_cache_get (expr) : NULL;
+        if (compiled)
+        {
+            compiled->running++;
+            value = eval_node_evaluate (compiled->root, &eval_context);
+            compiled->running--;
+        }
+        else
+        {
+            value = eval_expression_condition (expr, &eval_context);
+        }
         rc = eval_is_true (value);
         if (value)
             free (value);
@@ -1436,3 +1958,13 @@ eval_expression (const char *expr, struct t_hashtable *pointers,
 
     return value;
 }
+
+/*
+ * Ends eval: frees compiled conditions.
+ */
+
+void
+eval_end ()
+{
+    eval_cache_free_all ();
+}
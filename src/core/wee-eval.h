@@ -30,6 +30,8 @@
 
 #define EVAL_RECURSION_MAX  32
 
+#define EVAL_CACHE_MAX      256
+
 struct t_hashtable;
 
 enum t_eval_logical_op
@@ -56,6 +58,36 @@ enum t_eval_comparison
     EVAL_NUM_COMPARISONS,
 };
 
+enum t_eval_node_type
+{
+    EVAL_NODE_INVALID = 0,             /* invalid condition (NULL value)    */
+    EVAL_NODE_LOGICAL,                 /* logical operator (&& or ||)       */
+    EVAL_NODE_COMPARE,                 /* comparison (==, !=, ...)          */
+    EVAL_NODE_TEXT,                    /* text without variables            */
+    EVAL_NODE_VARS,                    /* text with variables to replace    */
+    EVAL_NODE_DYNAMIC,                 /* text parsed on each evaluation    */
+    /* number of node types */
+    EVAL_NUM_NODE_TYPES,
+};
+
+struct t_eval_node
+{
+    enum t_eval_node_type type;        /* type of node                      */
+    int op;                            /* logical op or comparison          */
+    char *text;                        /* text (for text/vars/dynamic)      */
+    struct t_eval_node *left;          /* left operand (logical/compare)    */
+    struct t_eval_node *right;         /* right operand (logical/compare)   */
+};
+
+struct t_eval_compiled
+{
+    char *expr;                        /* expression (key in cache)         */
+    struct t_eval_node *root;          /* compiled condition                */
+    int running;                       /* > 0 if currently evaluated        */
+    struct t_eval_compiled *prev_compiled; /* link to previous (more recent)*/
+    struct t_eval_compiled *next_compiled; /* link to next (less recent)    */
+};
+
 struct t_eval_regex
 {
     const char *result;
@@ -74,10 +106,17 @@ struct t_eval_context
     int recursion_count;
 };
 
+extern int eval_cache_count;
+
 extern int eval_is_true (const char *value);
+extern struct t_eval_node *eval_compile_condition (const char *expr,
+                                                   const char *prefix);
+extern void eval_node_free (struct t_eval_node *node);
+extern void eval_cache_free_all ();
 extern char *eval_expression (const char *expr,
                               struct t_hashtable *pointers,
                               struct t_hashtable *extra_vars,
                               struct t_hashtable *options);
+extern void eval_end ();
 
 #endif /* WEECHAT_EVAL_H */
@@ -87,6 +87,49 @@ hashtable_hash_key_djb2 (const char *string)
     return hash;
 }
 
+/*
+ * Hashes a string using FNV-1a hash (64-bit).
+ *
+ * Returns the hash of the string.
+ */
+
+unsigned long long
+hashtable_hash_key_fnv1a (const char *string)
+{
+    unsigned long long hash;
+    const unsigned char *ptr_string;
+
+    hash = 14695981039346656037ULL;
+    for (ptr_string = (const unsigned char *)string; ptr_string[0];
+         ptr_string++)
+    {
+        hash ^= ptr_string[0];
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+/*
+ * Mixes bits of an integer (finalizer of "splitmix64"), so that integers or
+ * pointers with low bits always equal (like aligned pointers) are spread in
+ * all entries of htable.
+ *
+ * Returns the mixed integer.
+ */
+
+unsigned long long
+hashtable_hash_key_mix (unsigned long long value)
+{
+    value ^= value >> 30;
+    value *= 0xbf58476d1ce4e5b9ULL;
+    value ^= value >> 27;
+    value *= 0x94d049bb133111ebULL;
+    value ^= value >> 31;
+
+    return value;
+}
+
 /*
  * Hashes a key (default callback).
  *
@@ -103,18 +146,21 @@ hashtable_hash_key_default_cb (struct t_hashtable *hashtable, const void *key)
     switch (hashtable->type_keys)
     {
         case HASHTABLE_INTEGER:
-            hash = (unsigned long long)(*((int *)key));
+            hash = hashtable_hash_key_mix (
+                (unsigned long long)(*((int *)key)));
             break;
         case HASHTABLE_STRING:
-            hash = hashtable_hash_key_djb2 ((const char *)key);
+            hash = hashtable_hash_key_fnv1a ((const char *)key);
             break;
         case HASHTABLE_POINTER:
-            hash = (unsigned long long)((unsigned long)((void *)key));
+            hash = hashtable_hash_key_mix (
+                (unsigned long long)((unsigned long)((void *)key)));
             break;
         case HASHTABLE_BUFFER:
             break;
         case HASHTABLE_TIME:
-            hash = (unsigned long long)(*((time_t *)key));
+            hash = hashtable_hash_key_mix (
+                (unsigned long long)(*((time_t *)key)));
             break;
         case HASHTABLE_NUM_TYPES:
             break;
@@ -178,10 +224,13 @@ hashtable_keycmp_default_cb (struct t_hashtable *hashtable,
 /*
  * Creates a new hashtable.
  *
- * The size is NOT a limit for number of items in hashtable. It is the size of
- * internal array to store hashed keys: a high value uses more memory, but has
- * better performance because this reduces the collisions of hashed keys and
- * then reduces length of linked lists.
+ * The size is NOT a limit for number of items in hashtable. It is the initial
+ * size of internal array to store hashed keys: a high value uses more memory,
+ * but has better performance because this reduces the collisions of hashed
+ * keys and then reduces length of linked lists.
+ *
+ * The internal array is automatically enlarged when the number of items is
+ * greater than HASHTABLE_MAX_LOAD_FACTOR * size.
  *
  * Returns pointer to new hashtable, NULL if error.
  */
@@ -227,6 +276,7 @@ hashtable_new (int size,
             new_hashtable->htable[i] = NULL;
         }
         new_hashtable->items_count = 0;
+        new_hashtable->map_running = 0;
 
         new_hashtable->callback_hash_key = (callback_hash_key) ?
             callback_hash_key : &hashtable_hash_key_default_cb;
@@ -361,6 +411,74 @@ hashtable_free_value (struct t_hashtable *hashtable,
     }
 }
 
+/*
+ * Resizes the internal array of hashtable: all items are moved to their new
+ * position in array (items are not reallocated, so pointers to items remain
+ * valid).
+ *
+ * Returns:
+ *   1: OK
+ *   0: error (hashtable is unchanged)
+ */
+
+int
+hashtable_resize (struct t_hashtable *hashtable, int new_size)
+{
+    struct t_hashtable_item **new_htable, *ptr_item, *next_item, *pos_item;
+    struct t_hashtable_item *ptr_item2;
+    unsigned long long hash;
+    int i;
+
+    if (!hashtable || (new_size <= 0) || (new_size == hashtable->size))
+        return 0;
+
+    new_htable = malloc (new_size * sizeof (*new_htable));
+    if (!new_htable)
+        return 0;
+    for (i = 0; i < new_size; i++)
+    {
+        new_htable[i] = NULL;
+    }
+
+    for (i = 0; i < hashtable->size; i++)
+    {
+        ptr_item = hashtable->htable[i];
+        while (ptr_item)
+        {
+            next_item = ptr_item->next_item;
+
+            /* insert item in new array (keep linked lists sorted) */
+            hash = hashtable->callback_hash_key (hashtable,
+                                                 ptr_item->key) % new_size;
+            pos_item = NULL;
+            for (ptr_item2 = new_htable[hash];
+                 ptr_item2
+                     && ((int)(hashtable->callback_keycmp) (
+                             hashtable, ptr_item->key, ptr_item2->key) > 0);
+                 ptr_item2 = ptr_item2->next_item)
+            {
+                pos_item = ptr_item2;
+            }
+            ptr_item->prev_item = pos_item;
+            ptr_item->next_item = ptr_item2;
+            if (ptr_item2)
+                ptr_item2->prev_item = ptr_item;
+            if (pos_item)
+                pos_item->next_item = ptr_item;
+            else
+                new_htable[hash] = ptr_item;
+
+            ptr_item = next_item;
+        }
+    }
+
+    free (hashtable->htable);
+    hashtable->htable = new_htable;
+    hashtable->size = new_size;
+
+    return 1;
+}
+
 /*
  * Sets value for a key in hashtable.
  *
@@ -440,6 +558,18 @@ hashtable_set_with_size (struct t_hashtable *hashtable,
 
     hashtable->items_count++;
 
+    /*
+     * enlarge the internal array if there are too many items (not while
+     * a map is running on hashtable: the order of items would change)
+     */
+    if (!hashtable->map_running
+        && (hashtable->items_count >
+            hashtable->size * HASHTABLE_MAX_LOAD_FACTOR)
+        && (hashtable->size <= HASHTABLE_MAX_SIZE / 2))
+    {
+        hashtable_resize (hashtable, hashtable->size * 2);
+    }
+
     return new_item;
 }
 
@@ -579,6 +709,8 @@ hashtable_map (struct t_hashtable *hashtable,
     if (!hashtable)
         return;
 
+    hashtable->map_running++;
+
     for (i = 0; i < hashtable->size; i++)
     {
         ptr_item = hashtable->htable[i];
@@ -594,6 +726,8 @@ hashtable_map (struct t_hashtable *hashtable,
             ptr_item = ptr_next_item;
         }
     }
+
+    hashtable->map_running--;
 }
 
 /*
@@ -613,6 +747,8 @@ hashtable_map_string (struct t_hashtable *hashtable,
     if (!hashtable)
         return;
 
+    hashtable->map_running++;
+
     for (i = 0; i < hashtable->size; i++)
     {
         ptr_item = hashtable->htable[i];
@@ -641,6 +777,8 @@ hashtable_map_string (struct t_hashtable *hashtable,
             ptr_item = ptr_next_item;
         }
     }
+
+    hashtable->map_running--;
 }
 
 /*
@@ -1286,6 +1424,7 @@ hashtable_print_log (struct t_hashtable *hashtable, const char *name)
     log_printf ("  size . . . . . . . . . : %d",    hashtable->size);
     log_printf ("  htable . . . . . . . . : 0x%lx", hashtable->htable);
     log_printf ("  items_count. . . . . . : %d",    hashtable->items_count);
+    log_printf ("  map_running. . . . . . : %d",    hashtable->map_running);
     log_printf ("  type_keys. . . . . . . : %d (%s)",
                 hashtable->type_keys,
                 hashtable_type_string[hashtable->type_keys]);
@@ -20,6 +20,12 @@
 #ifndef WEECHAT_HASHTABLE_H
 #define WEECHAT_HASHTABLE_H
 
+/* max average number of items by entry in htable (before resize) */
+#define HASHTABLE_MAX_LOAD_FACTOR 1
+
+/* max size of htable (it is not enlarged beyond this size) */
+#define HASHTABLE_MAX_SIZE        (1 << 24)
+
 struct t_hashtable;
 struct t_infolist;
 struct t_infolist_item;
@@ -84,18 +90,22 @@ typedef void (t_hashtable_map_string)(void *data,
  * +-----+
  * |   1 |
  * +-----+
- * |   2 | --> "extensible"
+ * |   2 | --> "weechat"
  * +-----+
- * |   3 | --> "fast" --> "light"
+ * |   3 | --> "chat"
  * +-----+
- * |   4 |
+ * |   4 | --> "extensible"
  * +-----+
- * |   5 | --> "chat"
+ * |   5 |
  * +-----+
  * |   6 | --> "client"
  * +-----+
- * |   7 | --> "weechat"
+ * |   7 | --> "fast" --> "light"
  * +-----+
+ *
+ * When the number of items becomes greater than the size multiplied by
+ * HASHTABLE_MAX_LOAD_FACTOR, the size of htable is doubled and all items are
+ * moved to their new linked list.
  */
 
 enum t_hashtable_type
@@ -125,6 +135,8 @@ struct t_hashtable
     struct t_hashtable_item **htable;  /* table to map hashes with linked   */
                                        /* lists                             */
     int items_count;                   /* number of items in hashtable      */
+    int map_running;                   /* > 0 if hashtable_map is running   */
+                                       /* (htable is not resized)           */
 
     /* type for keys and values */
     enum t_hashtable_type type_keys;   /* type for keys: int/str/pointer    */
@@ -142,11 +154,13 @@ struct t_hashtable
 };
 
 extern unsigned long long hashtable_hash_key_djb2 (const char *string);
+extern unsigned long long hashtable_hash_key_fnv1a (const char *string);
 extern struct t_hashtable *hashtable_new (int size,
                                           const char *type_keys,
                                           const char *type_values,
                                           t_hashtable_hash_key *hash_key_cb,
                                           t_hashtable_keycmp *keycmp_cb);
+extern int hashtable_resize (struct t_hashtable *hashtable, int new_size);
 extern struct t_hashtable_item *hashtable_set_with_size (struct t_hashtable *hashtable,
                                                          const void *key,
                                                          int key_size,
@@ -160,10 +160,33 @@ hdata_new_var (struct t_hdata *hdata, const char *name, int offset, int type,
         var->update_allowed = update_allowed;
         var->array_size = (array_size && array_size[0]) ? strdup (array_size) : NULL;
         var->hdata_name = (hdata_name && hdata_name[0]) ? strdup (hdata_name) : NULL;
+        var->callback_string = NULL;
         hashtable_set (hdata->hash_var, name, var);
     }
 }
 
+/*
+ * Sets a callback to get value of a string variable in hdata (used when the
+ * string is built on demand and may be NULL in the structure).
+ *
+ * The string returned by callback must not be freed, and is used only until
+ * the next call to the callback.
+ */
+
+void
+hdata_set_var_callback_string (struct t_hdata *hdata, const char *name,
+                               const char *(*callback)(void *pointer))
+{
+    struct t_hdata_var *var;
+
+    if (!hdata || !name)
+        return;
+
+    var = hashtable_get (hdata->hash_var, name);
+    if (var && (var->type == WEECHAT_HDATA_STRING) && !var->array_size)
+        var->callback_string = callback;
+}
+
 /*
  * Adds a new list pointer in a hdata.
  */
@@ -788,6 +811,8 @@ hdata_string (struct t_hdata *hdata, void *pointer, const char *name)
     {
         if (var->array_size && (index >= 0))
             return (*((char ***)(pointer + var->offset)))[index];
+        else if (var->callback_string)
+            return (var->callback_string) (pointer);
         else
             return *((char **)(pointer + var->offset));
     }
@@ -893,10 +918,11 @@ hdata_compare (struct t_hdata *hdata, void *pointer1, void *pointer2,
 {
     int rc, int_value1, int_value2;
     long long_value1, long_value2;
-    char char_value1, char_value2;
+    char char_value1, char_value2, *str_copy1;
     const char *ptr_name, *str_value1, *str_value2;
     void *ptr_value1, *ptr_value2;
     time_t time_value1, time_value2;
+    struct t_hdata_var *var;
 
     if (!pointer1 && pointer2)
         return -1;
@@ -930,7 +956,15 @@ hdata_compare (struct t_hdata *hdata, void *pointer1, void *pointer2,
             break;
         case WEECHAT_HDATA_STRING:
         case WEECHAT_HDATA_SHARED_STRING:
+            str_copy1 = NULL;
             str_value1 = hdata_string (hdata, pointer1, name);
+            var = hashtable_get (hdata->hash_var, ptr_name);
+            if (str_value1 && var && var->callback_string)
+            {
+                /* value may be overwritten by next call to callback */
+                str_copy1 = strdup (str_value1);
+                str_value1 = str_copy1;
+            }
             str_value2 = hdata_string (hdata, pointer2, name);
             if (!str_value1 && !str_value2)
                 rc = 0;
@@ -949,6 +983,8 @@ hdata_compare (struct t_hdata *hdata, void *pointer1, void *pointer2,
                 else if (rc > 0)
                     rc = 1;
             }
+            if (str_copy1)
+                free (str_copy1);
             break;
         case WEECHAT_HDATA_POINTER:
             ptr_value1 = hdata_pointer (hdata, pointer1, name);
@@ -1260,6 +1296,7 @@ hdata_print_log_var_map_cb (void *data, struct t_hashtable *hashtable,
     log_printf ("    update_allowed . . . . : %d",   (int)var->update_allowed);
     log_printf ("    array_size . . . . . . : '%s'", var->array_size);
     log_printf ("    hdata_name . . . . . . : '%s'", var->hdata_name);
+    log_printf ("    callback_string. . . . : 0x%lx", var->callback_string);
 }
 
 /*
@@ -37,6 +37,8 @@ struct t_hdata_var
     char update_allowed;               /* update allowed?                   */
     char *array_size;                  /* array size                        */
     char *hdata_name;                  /* hdata name                        */
+    const char *(*callback_string)     /* callback to get value of a string */
+    (void *pointer);                   /* (NULL = read string at offset)    */
 };
 
 struct t_hdata_list
@@ -87,6 +89,9 @@ extern struct t_hdata *hdata_new (struct t_weechat_plugin *plugin,
 extern void hdata_new_var (struct t_hdata *hdata, const char *name, int offset,
                            int type, int update_allowed, const char *array_size,
                            const char *hdata_name);
+extern void hdata_set_var_callback_string (struct t_hdata *hdata,
+                                           const char *name,
+                                           const char *(*callback)(void *pointer));
 extern void hdata_new_list (struct t_hdata *hdata, const char *name,
                             void *pointer, int flags);
 extern int hdata_get_var_offset (struct t_hdata *hdata, const char *name);
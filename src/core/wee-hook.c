@@ -27,6 +27,7 @@
 #include <unistd.h>
 #include <string.h>
 #include <time.h>
+#include <sys/time.h>
 #include <sys/socket.h>
 #include <errno.h>
 
@@ -37,6 +38,7 @@
 #include "wee-log.h"
 #include "wee-string.h"
 #include "wee-util.h"
+#include "../gui/gui-buffer.h"
 #include "../gui/gui-chat.h"
 #include "../plugins/plugin.h"
 
@@ -54,9 +56,12 @@ int real_delete_pending = 0;           /* 1 if some hooks must be deleted   */
 
 int hook_socketpair_ok = 0;            /* 1 if socketpair() is OK           */
 
+int hook_stats_enabled = 0;            /* 1 to measure time in callbacks    */
+
 /* hook callbacks */
 t_callback_hook *hook_callback_add[HOOK_NUM_TYPES] =
-{ NULL, NULL, NULL, &hook_fd_add_cb, NULL, NULL, NULL, NULL, NULL, NULL,
+{ NULL, NULL, NULL, &hook_fd_add_cb, NULL, NULL, NULL, NULL,
+  &hook_signal_add_cb, NULL,
   NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL };
 t_callback_hook *hook_callback_remove[HOOK_NUM_TYPES] =
 { NULL, NULL, NULL, &hook_fd_remove_cb, NULL, NULL, NULL, NULL, NULL, NULL,
@@ -389,6 +394,9 @@ hook_init_data (struct t_hook *hook, struct t_weechat_plugin *plugin,
     hook->priority = priority;
     hook->callback_pointer = callback_pointer;
     hook->callback_data = callback_data;
+    hook->stats_calls = 0;
+    hook->stats_time_total = 0;
+    hook->stats_time_max = 0;
     hook->hook_data = NULL;
 
     if (weechat_debug_core >= 2)
@@ -458,6 +466,160 @@ hook_exec_end ()
         hook_remove_deleted ();
 }
 
+/*
+ * Starts measure of time spent in a hook callback (only if statistics on
+ * hooks are enabled).
+ */
+
+void
+hook_callback_start (struct timeval *tv_start)
+{
+    if (hook_stats_enabled)
+    {
+        gettimeofday (tv_start, NULL);
+    }
+    else
+    {
+        tv_start->tv_sec = 0;
+        tv_start->tv_usec = 0;
+    }
+}
+
+/*
+ * Ends measure of time spent in a hook callback: updates statistics of hook
+ * (number of calls, total and max time).
+ *
+ * The hook must still be allocated (hook_exec_start must have been called
+ * before the callback, so that a hook removed by its callback is not freed).
+ */
+
+void
+hook_callback_end (struct t_hook *hook, struct timeval *tv_start)
+{
+    struct timeval tv_end;
+    long long diff;
+
+    if (!hook_stats_enabled
+        || ((tv_start->tv_sec == 0) && (tv_start->tv_usec == 0)))
+    {
+        return;
+    }
+
+    gettimeofday (&tv_end, NULL);
+    diff = util_timeval_diff (tv_start, &tv_end);
+    if (diff < 0)
+        diff = 0;
+
+    hook->stats_calls++;
+    hook->stats_time_total += diff;
+    if ((unsigned long long)diff > hook->stats_time_max)
+        hook->stats_time_max = diff;
+}
+
+/*
+ * Resets statistics of all hooks.
+ */
+
+void
+hook_stats_reset ()
+{
+    int type;
+    struct t_hook *ptr_hook;
+
+    for (type = 0; type < HOOK_NUM_TYPES; type++)
+    {
+        for (ptr_hook = weechat_hooks[type]; ptr_hook;
+             ptr_hook = ptr_hook->next_hook)
+        {
+            ptr_hook->stats_calls = 0;
+            ptr_hook->stats_time_total = 0;
+            ptr_hook->stats_time_max = 0;
+        }
+    }
+}
+
+/*
+ * Builds a short description of a hook (for example signal name or command).
+ */
+
+void
+hook_get_description (struct t_hook *hook, char *description, int size)
+{
+    if (!description || (size <= 0))
+        return;
+
+    description[0] = '\0';
+
+    if (!hook || hook->deleted || !hook->hook_data)
+        return;
+
+    switch (hook->type)
+    {
+        case HOOK_TYPE_COMMAND:
+            snprintf (description, size, "/%s", HOOK_COMMAND(hook, command));
+            break;
+        case HOOK_TYPE_COMMAND_RUN:
+            snprintf (description, size, "%s", HOOK_COMMAND_RUN(hook, command));
+            break;
+        case HOOK_TYPE_TIMER:
+            snprintf (description, size, "%ld ms", HOOK_TIMER(hook, interval));
+            break;
+        case HOOK_TYPE_FD:
+            snprintf (description, size, "fd %d", HOOK_FD(hook, fd));
+            break;
+        case HOOK_TYPE_PROCESS:
+            snprintf (description, size, "%s", HOOK_PROCESS(hook, command));
+            break;
+        case HOOK_TYPE_LINE:
+            snprintf (description, size, "%s",
+                      (HOOK_LINE(hook, buffer_type) < 0) ?
+                      "*" : gui_buffer_type_string[HOOK_LINE(hook, buffer_type)]);
+            break;
+        case HOOK_TYPE_PRINT:
+            snprintf (description, size, "%s",
+                      (HOOK_PRINT(hook, message)) ?
+                      HOOK_PRINT(hook, message) : "");
+            break;
+        case HOOK_TYPE_SIGNAL:
+            snprintf (description, size, "%s", HOOK_SIGNAL(hook, signal));
+            break;
+        case HOOK_TYPE_HSIGNAL:
+            snprintf (description, size, "%s", HOOK_HSIGNAL(hook, signal));
+            break;
+        case HOOK_TYPE_CONFIG:
+            snprintf (description, size, "%s",
+                      (HOOK_CONFIG(hook, option)) ?
+                      HOOK_CONFIG(hook, option) : "");
+            break;
+        case HOOK_TYPE_COMPLETION:
+            snprintf (description, size, "%s",
+                      HOOK_COMPLETION(hook, completion_item));
+            break;
+        case HOOK_TYPE_MODIFIER:
+            snprintf (description, size, "%s", HOOK_MODIFIER(hook, modifier));
+            break;
+        case HOOK_TYPE_INFO:
+            snprintf (description, size, "%s", HOOK_INFO(hook, info_name));
+            break;
+        case HOOK_TYPE_INFO_HASHTABLE:
+            snprintf (description, size, "%s",
+                      HOOK_INFO_HASHTABLE(hook, info_name));
+            break;
+        case HOOK_TYPE_INFOLIST:
+            snprintf (description, size, "%s",
+                      HOOK_INFOLIST(hook, infolist_name));
+            break;
+        case HOOK_TYPE_HDATA:
+            snprintf (description, size, "%s", HOOK_HDATA(hook, hdata_name));
+            break;
+        case HOOK_TYPE_FOCUS:
+            snprintf (description, size, "%s", HOOK_FOCUS(hook, area));
+            break;
+        default:
+            break;
+    }
+}
+
 /*
  * Sets a hook property (string).
  */
@@ -649,6 +811,7 @@ int
 hook_add_to_infolist_pointer (struct t_infolist *infolist, struct t_hook *hook)
 {
     struct t_infolist_item *ptr_item;
+    char value[64];
 
     ptr_item = infolist_new_item (infolist);
     if (!ptr_item)
@@ -676,6 +839,15 @@ hook_add_to_infolist_pointer (struct t_infolist *infolist, struct t_hook *hook)
         return 0;
     if (!infolist_new_var_pointer (ptr_item, "callback_data", (void *)hook->callback_data))
         return 0;
+    snprintf (value, sizeof (value), "%llu", hook->stats_calls);
+    if (!infolist_new_var_string (ptr_item, "stats_calls", value))
+        return 0;
+    snprintf (value, sizeof (value), "%llu", hook->stats_time_total);
+    if (!infolist_new_var_string (ptr_item, "stats_time_total", value))
+        return 0;
+    snprintf (value, sizeof (value), "%llu", hook->stats_time_max);
+    if (!infolist_new_var_string (ptr_item, "stats_time_max", value))
+        return 0;
 
     /* hook deleted? return only hook info above */
     if (hook->deleted)
@@ -808,6 +980,9 @@ hook_print_log ()
             log_printf ("  priority. . . . . . . . : %d",    ptr_hook->priority);
             log_printf ("  callback_pointer. . . . : 0x%lx", ptr_hook->callback_pointer);
             log_printf ("  callback_data . . . . . : 0x%lx", ptr_hook->callback_data);
+            log_printf ("  stats_calls . . . . . . : %llu", ptr_hook->stats_calls);
+            log_printf ("  stats_time_total. . . . : %llu", ptr_hook->stats_time_total);
+            log_printf ("  stats_time_max. . . . . : %llu", ptr_hook->stats_time_max);
             if (ptr_hook->deleted)
                 continue;
 
@@ -39,6 +39,7 @@
 #include "hook/wee-hook-signal.h"
 #include "hook/wee-hook-timer.h"
 
+struct timeval;
 struct t_hook;
 struct t_gui_bar;
 struct t_gui_buffer;
@@ -102,6 +103,12 @@ struct t_hook
     const void *callback_pointer;      /* pointer sent to callback          */
     void *callback_data;               /* data sent to callback             */
 
+    /* statistics on callback (only if hook_stats_enabled == 1) */
+    unsigned long long stats_calls;    /* number of calls to callback       */
+    unsigned long long stats_time_total; /* total time in callback (in      */
+                                       /* microseconds)                     */
+    unsigned long long stats_time_max; /* max time of one call (in µs)      */
+
     /* hook data (depends on hook type) */
     void *hook_data;                   /* hook specific data                */
     struct t_hook *prev_hook;          /* link to previous hook             */
@@ -116,6 +123,7 @@ extern struct t_hook *last_weechat_hook[];
 extern int hooks_count[];
 extern int hooks_count_total;
 extern int hook_socketpair_ok;
+extern int hook_stats_enabled;
 
 /* hook functions */
 
@@ -130,6 +138,11 @@ extern void hook_init_data (struct t_hook *hook,
 extern int hook_valid (struct t_hook *hook);
 extern void hook_exec_start ();
 extern void hook_exec_end ();
+extern void hook_callback_start (struct timeval *tv_start);
+extern void hook_callback_end (struct t_hook *hook, struct timeval *tv_start);
+extern void hook_stats_reset ();
+extern void hook_get_description (struct t_hook *hook, char *description,
+                                  int size);
 extern void hook_set (struct t_hook *hook, const char *property,
                       const char *value);
 extern void unhook (struct t_hook *hook);
@@ -0,0 +1,336 @@
+/*
+ * wee-slab.c - slab allocator for small objects with fixed size
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This file is part of WeeChat, the extensible chat client.
+ *
+ * WeeChat is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WeeChat is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WeeChat.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Objects are allocated in chunks of SLAB_CHUNK_SIZE bytes, aligned on this
+ * size: the chunk of an object is found by masking the object address, so
+ * there is no memory used per object (except the object itself).
+ *
+ * The chunk header is at beginning of chunk, followed by objects.
+ * Freed objects are reused (list of free objects in each chunk), and a chunk
+ * is freed when all its objects are freed (if it is not the last chunk with
+ * free objects).
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "weechat.h"
+#include "wee-slab.h"
+#include "wee-log.h"
+
+
+/* alignment of objects in chunks */
+#define SLAB_ALIGN 8
+#define SLAB_ALIGN_SIZE(__size)                                         \
+    (((__size) + SLAB_ALIGN - 1) & ~(SLAB_ALIGN - 1))
+
+/* size of chunk header (objects are stored after the header) */
+#define SLAB_CHUNK_HEADER_SIZE                                          \
+    SLAB_ALIGN_SIZE((int)sizeof (struct t_slab_chunk))
+
+/* get chunk of an object */
+#define SLAB_OBJECT_CHUNK(__object)                                     \
+    ((struct t_slab_chunk *)((uintptr_t)(__object)                      \
+                             & ~((uintptr_t)SLAB_CHUNK_SIZE - 1)))
+
+struct t_slab *slabs = NULL;           /* list of slabs                     */
+struct t_slab *last_slab = NULL;       /* last slab                         */
+
+
+/*
+ * Creates a new slab for objects of size "object_size" bytes.
+ *
+ * Returns pointer to new slab, NULL if error.
+ */
+
+struct t_slab *
+slab_new (const char *name, int object_size)
+{
+    struct t_slab *new_slab;
+
+    if (!name || (object_size <= 0))
+        return NULL;
+
+    /* object must be large enough to store the link to next free object */
+    if (object_size < (int)sizeof (void *))
+        object_size = sizeof (void *);
+    object_size = SLAB_ALIGN_SIZE(object_size);
+
+    if (object_size > SLAB_CHUNK_SIZE - SLAB_CHUNK_HEADER_SIZE)
+        return NULL;
+
+    new_slab = malloc (sizeof (*new_slab));
+    if (!new_slab)
+        return NULL;
+
+    new_slab->name = strdup (name);
+    new_slab->object_size = object_size;
+    new_slab->objects_per_chunk = (SLAB_CHUNK_SIZE - SLAB_CHUNK_HEADER_SIZE) /
+        object_size;
+    new_slab->chunks_count = 0;
+    new_slab->objects_count = 0;
+    new_slab->chunks_avail = NULL;
+    new_slab->chunks_full = NULL;
+
+    new_slab->prev_slab = last_slab;
+    new_slab->next_slab = NULL;
+    if (last_slab)
+        last_slab->next_slab = new_slab;
+    else
+        slabs = new_slab;
+    last_slab = new_slab;
+
+    return new_slab;
+}
+
+/*
+ * Adds a chunk at beginning of a list of chunks.
+ */
+
+void
+slab_chunk_list_add (struct t_slab_chunk **list, struct t_slab_chunk *chunk)
+{
+    chunk->prev_chunk = NULL;
+    chunk->next_chunk = *list;
+    if (*list)
+        (*list)->prev_chunk = chunk;
+    *list = chunk;
+}
+
+/*
+ * Removes a chunk from a list of chunks.
+ */
+
+void
+slab_chunk_list_remove (struct t_slab_chunk **list, struct t_slab_chunk *chunk)
+{
+    if (chunk->prev_chunk)
+        (chunk->prev_chunk)->next_chunk = chunk->next_chunk;
+    if (chunk->next_chunk)
+        (chunk->next_chunk)->prev_chunk = chunk->prev_chunk;
+    if (*list == chunk)
+        *list = chunk->next_chunk;
+    chunk->prev_chunk = NULL;
+    chunk->next_chunk = NULL;
+}
+
+/*
+ * Allocates a new chunk in a slab (added to the list of chunks with free
+ * objects).
+ *
+ * Returns pointer to new chunk, NULL if error.
+ */
+
+struct t_slab_chunk *
+slab_chunk_new (struct t_slab *slab)
+{
+    struct t_slab_chunk *new_chunk;
+    void *ptr;
+
+    if (posix_memalign (&ptr, SLAB_CHUNK_SIZE, SLAB_CHUNK_SIZE) != 0)
+        return NULL;
+
+    new_chunk = (struct t_slab_chunk *)ptr;
+    new_chunk->slab = slab;
+    new_chunk->objects_count = 0;
+    new_chunk->objects_unused = 0;
+    new_chunk->free_objects = NULL;
+
+    slab_chunk_list_add (&slab->chunks_avail, new_chunk);
+    slab->chunks_count++;
+
+    return new_chunk;
+}
+
+/*
+ * Allocates an object in a slab.
+ *
+ * Returns pointer to object (not initialized), NULL if error.
+ */
+
+void *
+slab_alloc (struct t_slab *slab)
+{
+    struct t_slab_chunk *ptr_chunk;
+    void *object;
+
+    if (!slab)
+        return NULL;
+
+    ptr_chunk = slab->chunks_avail;
+    if (!ptr_chunk)
+    {
+        ptr_chunk = slab_chunk_new (slab);
+        if (!ptr_chunk)
+            return NULL;
+    }
+
+    if (ptr_chunk->free_objects)
+    {
+        /* reuse a freed object */
+        object = ptr_chunk->free_objects;
+        ptr_chunk->free_objects = *((void **)object);
+    }
+    else
+    {
+        /* use first never used object */
+        object = (char *)ptr_chunk + SLAB_CHUNK_HEADER_SIZE +
+            (ptr_chunk->objects_unused * slab->object_size);
+        ptr_chunk->objects_unused++;
+    }
+
+    ptr_chunk->objects_count++;
+    slab->objects_count++;
+
+    /* move chunk in list of full chunks if there is no more free object */
+    if (ptr_chunk->objects_count >= slab->objects_per_chunk)
+    {
+        slab_chunk_list_remove (&slab->chunks_avail, ptr_chunk);
+        slab_chunk_list_add (&slab->chunks_full, ptr_chunk);
+    }
+
+    return object;
+}
+
+/*
+ * Releases an object allocated with slab_alloc.
+ *
+ * The chunk containing the object is freed if there is no more object
+ * allocated in this chunk (except if it's the only chunk with free objects).
+ */
+
+void
+slab_release (void *object)
+{
+    struct t_slab *ptr_slab;
+    struct t_slab_chunk *ptr_chunk;
+
+    if (!object)
+        return;
+
+    ptr_chunk = SLAB_OBJECT_CHUNK(object);
+    ptr_slab = ptr_chunk->slab;
+
+    /* chunk was full: move it in list of chunks with free objects */
+    if (ptr_chunk->objects_count >= ptr_slab->objects_per_chunk)
+    {
+        slab_chunk_list_remove (&ptr_slab->chunks_full, ptr_chunk);
+        slab_chunk_list_add (&ptr_slab->chunks_avail, ptr_chunk);
+    }
+
+    *((void **)object) = ptr_chunk->free_objects;
+    ptr_chunk->free_objects = object;
+    ptr_chunk->objects_count--;
+    ptr_slab->objects_count--;
+
+    /* free chunk if it is empty and not the only chunk with free objects */
+    if ((ptr_chunk->objects_count == 0)
+        && ((ptr_slab->chunks_avail != ptr_chunk) || ptr_chunk->next_chunk))
+    {
+        slab_chunk_list_remove (&ptr_slab->chunks_avail, ptr_chunk);
+        free (ptr_chunk);
+        ptr_slab->chunks_count--;
+    }
+}
+
+/*
+ * Frees a slab and all its objects.
+ */
+
+void
+slab_free (struct t_slab *slab)
+{
+    struct t_slab_chunk *ptr_next_chunk;
+
+    if (!slab)
+        return;
+
+    while (slab->chunks_avail)
+    {
+        ptr_next_chunk = slab->chunks_avail->next_chunk;
+        free (slab->chunks_avail);
+        slab->chunks_avail = ptr_next_chunk;
+    }
+    while (slab->chunks_full)
+    {
+        ptr_next_chunk = slab->chunks_full->next_chunk;
+        free (slab->chunks_full);
+        slab->chunks_full = ptr_next_chunk;
+    }
+
+    /* remove slab from list */
+    if (slab->prev_slab)
+        (slab->prev_slab)->next_slab = slab->next_slab;
+    if (slab->next_slab)
+        (slab->next_slab)->prev_slab = slab->prev_slab;
+    if (slabs == slab)
+        slabs = slab->next_slab;
+    if (last_slab == slab)
+        last_slab = slab->prev_slab;
+
+    if (slab->name)
+        free (slab->name);
+
+    free (slab);
+}
+
+/*
+ * Frees all slabs.
+ */
+
+void
+slab_free_all ()
+{
+    while (slabs)
+    {
+        slab_free (slabs);
+    }
+}
+
+/*
+ * Prints slabs in WeeChat log file (usually for crash dump).
+ */
+
+void
+slab_print_log ()
+{
+    struct t_slab *ptr_slab;
+
+    for (ptr_slab = slabs; ptr_slab; ptr_slab = ptr_slab->next_slab)
+    {
+        log_printf ("");
+        log_printf ("[slab %s (addr:0x%lx)]", ptr_slab->name, ptr_slab);
+        log_printf ("  object_size. . . . . . : %d", ptr_slab->object_size);
+        log_printf ("  objects_per_chunk. . . : %d", ptr_slab->objects_per_chunk);
+        log_printf ("  chunks_count . . . . . : %d", ptr_slab->chunks_count);
+        log_printf ("  objects_count. . . . . : %ld", ptr_slab->objects_count);
+        log_printf ("  chunks_avail . . . . . : 0x%lx", ptr_slab->chunks_avail);
+        log_printf ("  chunks_full. . . . . . : 0x%lx", ptr_slab->chunks_full);
+        log_printf ("  prev_slab. . . . . . . : 0x%lx", ptr_slab->prev_slab);
+        log_printf ("  next_slab. . . . . . . : 0x%lx", ptr_slab->next_slab);
+    }
+}
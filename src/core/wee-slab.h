@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This file is part of WeeChat, the extensible chat client.
+ *
+ * WeeChat is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WeeChat is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WeeChat.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef WEECHAT_SLAB_H
+#define WEECHAT_SLAB_H
+
+/* size of a chunk (must be a power of 2, chunks are aligned on this size) */
+#define SLAB_CHUNK_SIZE (64 * 1024)
+
+struct t_slab_chunk;
+
+struct t_slab
+{
+    char *name;                        /* slab name (for debug)             */
+    int object_size;                   /* size of an object (bytes)         */
+    int objects_per_chunk;             /* number of objects in a chunk      */
+    int chunks_count;                  /* number of chunks allocated        */
+    long objects_count;                /* number of objects allocated       */
+    struct t_slab_chunk *chunks_avail; /* chunks with free objects          */
+    struct t_slab_chunk *chunks_full;  /* chunks without free objects       */
+    struct t_slab *prev_slab;          /* link to previous slab             */
+    struct t_slab *next_slab;          /* link to next slab                 */
+};
+
+struct t_slab_chunk
+{
+    struct t_slab *slab;               /* slab containing this chunk        */
+    int objects_count;                 /* number of objects allocated       */
+    int objects_unused;                /* index of first never used object  */
+    void *free_objects;                /* list of freed objects (reusable)  */
+    struct t_slab_chunk *prev_chunk;   /* link to previous chunk            */
+    struct t_slab_chunk *next_chunk;   /* link to next chunk                */
+};
+
+extern struct t_slab *slabs;
+extern struct t_slab *last_slab;
+
+extern struct t_slab *slab_new (const char *name, int object_size);
+extern void *slab_alloc (struct t_slab *slab);
+extern void slab_release (void *object);
+extern void slab_free (struct t_slab *slab);
+extern void slab_free_all ();
+extern void slab_print_log ();
+
+#endif /* WEECHAT_SLAB_H */
@@ -1253,40 +1253,53 @@ string_regcomp (void *preg, const char *regex, int default_flags)
 }
 
 /*
- * Checks if a string has a highlight (using list of words to highlight).
+ * Compiles a list of words to highlight (separated by commas).
  *
- * Returns:
- *   1: string has a highlight
- *   0: string has no highlight
+ * Each word can start with flags (for example "(?-i)" for a case sensitive
+ * word, the default is case insensitive) and can start and/or end with a
+ * wildcard ("*"). The words are indexed by their first byte, so that the
+ * string is scanned only once by function string_has_highlight_compiled(),
+ * whatever the number of words.
+ *
+ * Returns pointer to compiled highlight words, NULL if error.
+ *
+ * Note: result must be freed after use with function string_highlight_free().
  */
 
-int
-string_has_highlight (const char *string, const char *highlight_words)
+struct t_string_highlight *
+string_highlight_compile (const char *highlight_words)
 {
-    const char *match, *match_pre, *match_post, *msg_pos;
-    char *msg, *highlight, *pos, *pos_end;
-    int end, length, startswith, endswith, wildcard_start, wildcard_end, flags;
+    struct t_string_highlight *new_highlight;
+    struct t_string_highlight_word *ptr_word;
+    const char *pos, *pos_end;
+    int end, length, flags, wildcard_start, wildcard_end, i, c;
+    int index[257];
 
-    if (!string || !string[0] || !highlight_words || !highlight_words[0])
-        return 0;
+    if (!highlight_words)
+        return NULL;
 
-    msg = strdup (string);
-    if (!msg)
-        return 0;
+    new_highlight = malloc (sizeof (*new_highlight));
+    if (!new_highlight)
+        return NULL;
 
-    highlight = strdup (highlight_words);
-    if (!highlight)
+    new_highlight->highlight_words = strdup (highlight_words);
+    new_highlight->num_words = 0;
+    new_highlight->words = malloc (
+        (strlen (highlight_words) + 1) * sizeof (*new_highlight->words));
+    new_highlight->index_words = NULL;
+    if (!new_highlight->highlight_words || !new_highlight->words)
     {
-        free (msg);
-        return 0;
+        string_highlight_free (new_highlight);
+        return NULL;
     }
 
-    pos = highlight;
+    /* split words, with same rules as function string_has_highlight() */
+    pos = highlight_words;
     end = 0;
     while (!end)
     {
         flags = 0;
-        pos = (char *)string_regex_flags (pos, REG_ICASE, &flags);
+        pos = string_regex_flags (pos, REG_ICASE, &flags);
 
         pos_end = strchr (pos, ',');
         if (!pos_end)
@@ -1294,69 +1307,264 @@ string_has_highlight (const char *string, const char *highlight_words)
             pos_end = strchr (pos, '\0');
             end = 1;
         }
-        /* error parsing string! */
-        if (!pos_end)
-        {
-            free (msg);
-            free (highlight);
-            return 0;
-        }
 
         length = pos_end - pos;
-        pos_end[0] = '\0';
+        wildcard_start = 0;
+        wildcard_end = 0;
         if (length > 0)
         {
             if ((wildcard_start = (pos[0] == '*')))
-            {
-                pos++;
                 length--;
-            }
             if ((wildcard_end = (*(pos_end - 1) == '*')))
-            {
-                *(pos_end - 1) = '\0';
                 length--;
-            }
         }
 
         if (length > 0)
         {
-            msg_pos = msg;
-            while (1)
+            ptr_word = &new_highlight->words[new_highlight->num_words];
+            ptr_word->word = string_strndup (pos + wildcard_start, length);
+            if (!ptr_word->word)
             {
-                match = (flags & REG_ICASE) ?
-                    string_strcasestr (msg_pos, pos) : strstr (msg_pos, pos);
-                if (!match)
-                    break;
-                match_pre = utf8_prev_char (msg, match);
-                if (!match_pre)
-                    match_pre = match - 1;
-                match_post = match + length;
-                startswith = ((match == msg) || (!string_is_word_char_highlight (match_pre)));
-                endswith = ((!match_post[0]) || (!string_is_word_char_highlight (match_post)));
-                if ((wildcard_start && wildcard_end) ||
-                    (!wildcard_start && !wildcard_end &&
-                     startswith && endswith) ||
-                    (wildcard_start && endswith) ||
-                    (wildcard_end && startswith))
-                {
-                    /* highlight found! */
-                    free (msg);
-                    free (highlight);
-                    return 1;
-                }
-                msg_pos = match_post;
+                string_highlight_free (new_highlight);
+                return NULL;
             }
+            ptr_word->length = length;
+            ptr_word->case_insensitive = (flags & REG_ICASE) ? 1 : 0;
+            ptr_word->wildcard_start = wildcard_start;
+            ptr_word->wildcard_end = wildcard_end;
+            if (ptr_word->case_insensitive)
+                string_tolower (ptr_word->word);
+            new_highlight->num_words++;
         }
 
         if (!end)
             pos = pos_end + 1;
     }
 
-    free (msg);
+    /*
+     * index words by first byte: a case insensitive word starting with a
+     * letter is added for the lower and upper case letter
+     */
+    memset (index, 0, sizeof (index));
+    for (i = 0; i < new_highlight->num_words; i++)
+    {
+        c = (unsigned char)new_highlight->words[i].word[0];
+        index[c]++;
+        if (new_highlight->words[i].case_insensitive
+            && (c >= 'a') && (c <= 'z'))
+        {
+            index[c - ('a' - 'A')]++;
+        }
+    }
+    new_highlight->index_first[0] = 0;
+    for (c = 0; c < 256; c++)
+    {
+        new_highlight->index_first[c + 1] =
+            new_highlight->index_first[c] + index[c];
+    }
+    if (new_highlight->index_first[256] > 0)
+    {
+        new_highlight->index_words = malloc (
+            new_highlight->index_first[256] *
+            sizeof (*new_highlight->index_words));
+        if (!new_highlight->index_words)
+        {
+            string_highlight_free (new_highlight);
+            return NULL;
+        }
+        memcpy (index, new_highlight->index_first, sizeof (index));
+        for (i = 0; i < new_highlight->num_words; i++)
+        {
+            c = (unsigned char)new_highlight->words[i].word[0];
+            new_highlight->index_words[index[c]++] = i;
+            if (new_highlight->words[i].case_insensitive
+                && (c >= 'a') && (c <= 'z'))
+            {
+                new_highlight->index_words[index[c - ('a' - 'A')]++] = i;
+            }
+        }
+    }
+
+    return new_highlight;
+}
+
+/*
+ * Frees compiled highlight words.
+ */
+
+void
+string_highlight_free (struct t_string_highlight *highlight)
+{
+    int i;
+
+    if (!highlight)
+        return;
+
+    if (highlight->highlight_words)
+        free (highlight->highlight_words);
+    if (highlight->words)
+    {
+        for (i = 0; i < highlight->num_words; i++)
+        {
+            free (highlight->words[i].word);
+        }
+        free (highlight->words);
+    }
+    if (highlight->index_words)
+        free (highlight->index_words);
+
     free (highlight);
+}
 
-    /* no highlight found */
-    return 0;
+/*
+ * Checks if a compiled highlight word matches at beginning of string.
+ *
+ * Returns:
+ *   1: word matches
+ *   0: word does not match
+ */
+
+int
+string_highlight_word_match (const char *string,
+                             struct t_string_highlight_word *word)
+{
+    int i;
+    char c;
+
+    for (i = 0; i < word->length; i++)
+    {
+        c = string[i];
+        if (!c)
+            return 0;
+        if (word->case_insensitive && (c >= 'A') && (c <= 'Z'))
+            c += ('a' - 'A');
+        if (c != word->word[i])
+            return 0;
+    }
+
+    /*
+     * case insensitive comparison is made on whole chars: a word ending with
+     * an incomplete UTF-8 char does not match the beginning of a char
+     */
+    if (word->case_insensitive && ((string[i] & 0xC0) == 0x80))
+        return 0;
+
+    return 1;
+}
+
+/*
+ * Checks if a string has a highlight using compiled highlight words (see
+ * function string_highlight_compile()).
+ *
+ * The string is read only once: on each char, only the words starting with
+ * this char are compared. Like function string_has_highlight(), the matches
+ * of a word do not overlap: after a match which is not a highlight (word not
+ * surrounded by delimiters), the search for this word continues after the
+ * match.
+ *
+ * Returns:
+ *   1: string has a highlight
+ *   0: string has no highlight
+ */
+
+int
+string_has_highlight_compiled (const char *string,
+                               struct t_string_highlight *highlight)
+{
+    struct t_string_highlight_word *ptr_word;
+    const char *ptr_string, *match_pre, *match_post;
+    int next_offset_static[32], *next_offset;
+    int i, c, offset, startswith, endswith, rc;
+
+    if (!string || !string[0] || !highlight || (highlight->num_words == 0))
+        return 0;
+
+    if (highlight->num_words <= 32)
+    {
+        next_offset = next_offset_static;
+    }
+    else
+    {
+        next_offset = malloc (highlight->num_words * sizeof (*next_offset));
+        if (!next_offset)
+            return 0;
+    }
+    memset (next_offset, 0, highlight->num_words * sizeof (*next_offset));
+
+    rc = 0;
+
+    for (ptr_string = string; ptr_string[0];
+         ptr_string = utf8_next_char (ptr_string))
+    {
+        c = (unsigned char)ptr_string[0];
+        if (highlight->index_first[c] == highlight->index_first[c + 1])
+            continue;
+        offset = ptr_string - string;
+        startswith = -1;
+        for (i = highlight->index_first[c]; i < highlight->index_first[c + 1];
+             i++)
+        {
+            if (offset < next_offset[highlight->index_words[i]])
+                continue;
+            ptr_word = &highlight->words[highlight->index_words[i]];
+            if (!string_highlight_word_match (ptr_string, ptr_word))
+                continue;
+            if (startswith < 0)
+            {
+                match_pre = utf8_prev_char (string, ptr_string);
+                startswith = ((ptr_string == string)
+                              || !string_is_word_char_highlight (match_pre));
+            }
+            match_post = ptr_string + ptr_word->length;
+            endswith = ((!match_post[0])
+                        || (!string_is_word_char_highlight (match_post)));
+            if ((ptr_word->wildcard_start && ptr_word->wildcard_end)
+                || (!ptr_word->wildcard_start && !ptr_word->wildcard_end
+                    && startswith && endswith)
+                || (ptr_word->wildcard_start && endswith)
+                || (ptr_word->wildcard_end && startswith))
+            {
+                /* highlight found! */
+                rc = 1;
+                goto end;
+            }
+            next_offset[highlight->index_words[i]] = offset + ptr_word->length;
+        }
+    }
+
+end:
+    if (next_offset != next_offset_static)
+        free (next_offset);
+
+    return rc;
+}
+
+/*
+ * Checks if a string has a highlight (using list of words to highlight).
+ *
+ * Returns:
+ *   1: string has a highlight
+ *   0: string has no highlight
+ */
+
+int
+string_has_highlight (const char *string, const char *highlight_words)
+{
+    struct t_string_highlight *highlight;
+    int rc;
+
+    if (!string || !string[0] || !highlight_words || !highlight_words[0])
+        return 0;
+
+    highlight = string_highlight_compile (highlight_words);
+    if (!highlight)
+        return 0;
+
+    rc = string_has_highlight_compiled (string, highlight);
+
+    string_highlight_free (highlight);
+
+    return rc;
 }
 
 /*
@@ -3512,7 +3720,7 @@ string_replace_with_callback (const char *string,
  * Hashes a shared string.
  * The string starts after the reference count, which is skipped.
  *
- * Returns the hash of the shared string (variant of djb2).
+ * Returns the hash of the shared string (FNV-1a).
  */
 
 unsigned long long
@@ -3522,7 +3730,7 @@ string_shared_hash_key (struct t_hashtable *hashtable,
     /* make C compiler happy */
     (void) hashtable;
 
-    return hashtable_hash_key_djb2 (((const char *)key) + sizeof (string_shared_count_t));
+    return hashtable_hash_key_fnv1a (((const char *)key) + sizeof (string_shared_count_t));
 }
 
 /*
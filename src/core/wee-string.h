@@ -34,6 +34,26 @@ struct t_string_dyn
     string_dyn_size_t size;            /* size of string (including '\0')   */
 };
 
+struct t_string_highlight_word
+{
+    char *word;                        /* word (lower case if case          */
+                                       /* insensitive), without wildcards   */
+    int length;                        /* length of word (in bytes)         */
+    int case_insensitive;              /* 1 if case is ignored              */
+    int wildcard_start;                /* 1 if word starts with "*"         */
+    int wildcard_end;                  /* 1 if word ends with "*"           */
+};
+
+struct t_string_highlight
+{
+    char *highlight_words;             /* words, as given to compile them   */
+    int num_words;                     /* number of words                   */
+    struct t_string_highlight_word *words; /* words                         */
+    int index_first[257];              /* for each byte: first index in     */
+                                       /* "index_words" (last: [byte+1] - 1)*/
+    int *index_words;                  /* words indexed by first byte       */
+};
+
 struct t_hashtable;
 
 extern char *string_strndup (const char *string, int length);
@@ -76,6 +96,10 @@ extern char *string_mask_to_regex (const char *mask);
 extern const char *string_regex_flags (const char *regex, int default_flags,
                                        int *flags);
 extern int string_regcomp (void *preg, const char *regex, int default_flags);
+extern struct t_string_highlight *string_highlight_compile (const char *highlight_words);
+extern void string_highlight_free (struct t_string_highlight *highlight);
+extern int string_has_highlight_compiled (const char *string,
+                                          struct t_string_highlight *highlight);
 extern int string_has_highlight (const char *string,
                                  const char *highlight_words);
 extern int string_has_highlight_regex_compiled (const char *string,
@@ -25,6 +25,7 @@
 #endif
 
 #include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
 #include <wctype.h>
 
@@ -36,6 +37,9 @@
 
 int local_utf8 = 0;
 
+/* mask to check if a block of 8 bytes has some 8-bit chars */
+#define UTF8_BLOCK_8BITS_MASK 0x8080808080808080ULL
+
 
 /*
  * Initializes UTF-8 in WeeChat.
@@ -47,6 +51,41 @@ utf8_init ()
     local_utf8 = (string_strcasecmp (weechat_local_charset, "UTF-8") == 0);
 }
 
+/*
+ * Gets number of 7-bit chars at beginning of a string, reading at most
+ * "bytes" bytes.
+ *
+ * The string is read by blocks of 8 bytes, so this is much faster than
+ * reading chars one by one on strings with long runs of ASCII chars.
+ *
+ * Returns number of 7-bit chars (between 0 and "bytes").
+ */
+
+int
+utf8_ascii_length (const char *string, int bytes)
+{
+    uint64_t block;
+    int i;
+
+    if (!string || (bytes <= 0))
+        return 0;
+
+    i = 0;
+    while (i + (int)sizeof (block) <= bytes)
+    {
+        memcpy (&block, string + i, sizeof (block));
+        if (block & UTF8_BLOCK_8BITS_MASK)
+            break;
+        i += sizeof (block);
+    }
+    while ((i < bytes) && !((unsigned char)(string[i]) & 0x80))
+    {
+        i++;
+    }
+
+    return i;
+}
+
 /*
  * Checks if a string has some 8-bit chars.
  *
@@ -58,13 +97,14 @@ utf8_init ()
 int
 utf8_has_8bits (const char *string)
 {
-    while (string && string[0])
-    {
-        if (string[0] & 0x80)
-            return 1;
-        string++;
-    }
-    return 0;
+    int bytes;
+
+    if (!string)
+        return 0;
+
+    bytes = strlen (string);
+
+    return (utf8_ascii_length (string, bytes) < bytes) ? 1 : 0;
 }
 
 /*
@@ -83,12 +123,22 @@ int
 utf8_is_valid (const char *string, int length, char **error)
 {
     int code_point, current_char;
+    const char *ptr_end;
 
     current_char = 0;
 
+    /* end of string, to skip 7-bit chars by blocks if whole string is checked */
+    ptr_end = (string && (length <= 0)) ? string + strlen (string) : NULL;
+
     while (string && string[0]
            && ((length <= 0) || (current_char < length)))
     {
+        if (ptr_end)
+        {
+            string += utf8_ascii_length (string, ptr_end - string);
+            if (!string[0])
+                break;
+        }
         /*
          * UTF-8, 2 bytes, should be: 110vvvvv 10vvvvvv
          * and in range: U+0080 - U+07FF
@@ -235,6 +285,10 @@ utf8_next_char (const char *string)
     if (!string)
         return NULL;
 
+    /* UTF-8, 1 byte: 0vvvvvvv */
+    if (!((unsigned char)(string[0]) & 0x80))
+        return (char *)string + 1;
+
     /* UTF-8, 2 bytes: 110vvvvv 10vvvvvv */
     if (((unsigned char)(string[0]) & 0xE0) == 0xC0)
     {
@@ -262,7 +316,7 @@ utf8_next_char (const char *string)
             return (char *)string + 3;
         return (char *)string + 4;
     }
-    /* UTF-8, 1 byte: 0vvvvvvv */
+    /* invalid UTF-8 char */
     return (char *)string + 1;
 }
 
@@ -441,14 +495,25 @@ utf8_char_size (const char *string)
 int
 utf8_strlen (const char *string)
 {
-    int length;
+    int length, ascii_length;
+    const char *ptr_end;
 
     if (!string)
         return 0;
 
+    ptr_end = string + strlen (string);
+
     length = 0;
     while (string && string[0])
     {
+        /* count 7-bit chars by blocks */
+        ascii_length = utf8_ascii_length (string, ptr_end - string);
+        if (ascii_length > 0)
+        {
+            string += ascii_length;
+            length += ascii_length;
+            continue;
+        }
         string = utf8_next_char (string);
         length++;
     }
@@ -496,6 +561,16 @@ utf8_strlen_screen (const char *string)
     if (!string || !string[0])
         return 0;
 
+    /* only printable 7-bit chars: one char on screen for each byte */
+    ptr_string = string;
+    while (((unsigned char)(ptr_string[0]) >= 32)
+           && ((unsigned char)(ptr_string[0]) < 127))
+    {
+        ptr_string++;
+    }
+    if (!ptr_string[0])
+        return ptr_string - string;
+
     if (!local_utf8)
         return utf8_strlen (string);
 
@@ -664,6 +739,13 @@ utf8_char_size_screen (const char *string)
     if (!string)
         return 0;
 
+    /* printable 7-bit char: one char on screen */
+    if (((unsigned char)(string[0]) >= 32)
+        && ((unsigned char)(string[0]) < 127))
+    {
+        return 1;
+    }
+
     char_size = utf8_char_size (string);
     if (char_size == 0)
         return 0;
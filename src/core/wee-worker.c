@@ -0,0 +1,520 @@
+/*
+ * wee-worker.c - pool of threads to run jobs in background
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This file is part of WeeChat, the extensible chat client.
+ *
+ * WeeChat is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WeeChat is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WeeChat.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Jobs are run in worker threads, then the "done" callback of each job is
+ * called in main thread: a byte is written in a pipe when a job is done,
+ * and the read side of pipe is watched by a fd hook in main loop.
+ *
+ * The "run" callback of a job must not call any WeeChat function that is not
+ * thread-safe (for example printing messages, sending signals or changing
+ * buffers): it must only read data that is not changed by the main thread
+ * while the job is running, and store its results in job data.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <pthread.h>
+
+#include "weechat.h"
+#include "wee-worker.h"
+#include "wee-hook.h"
+#include "wee-log.h"
+#include "../plugins/plugin.h"
+
+
+int worker_threads_count = 0;          /* number of threads running         */
+
+pthread_t worker_threads[WORKER_MAX_THREADS]; /* worker threads             */
+pthread_mutex_t worker_mutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t worker_cond_queue = PTHREAD_COND_INITIALIZER;
+pthread_cond_t worker_cond_done = PTHREAD_COND_INITIALIZER;
+int worker_stop = 0;                   /* 1 if threads must stop            */
+int worker_jobs_running = 0;           /* number of jobs running            */
+
+struct t_worker_job *worker_jobs_queued = NULL;  /* jobs waiting for thread */
+struct t_worker_job *last_worker_job_queued = NULL;
+struct t_worker_job *worker_jobs_done = NULL;    /* jobs done               */
+struct t_worker_job *last_worker_job_done = NULL;
+
+int worker_pipe[2] = { -1, -1 };       /* pipe to wake up main thread       */
+struct t_hook *worker_hook_pipe = NULL; /* fd hook on read side of pipe     */
+
+
+/*
+ * Adds a job at the end of a list of jobs (mutex must be locked).
+ */
+
+void
+worker_job_list_add (struct t_worker_job **jobs,
+                     struct t_worker_job **last_job,
+                     struct t_worker_job *job)
+{
+    job->prev_job = *last_job;
+    job->next_job = NULL;
+    if (*last_job)
+        (*last_job)->next_job = job;
+    else
+        *jobs = job;
+    *last_job = job;
+}
+
+/*
+ * Removes a job from a list of jobs (mutex must be locked).
+ */
+
+void
+worker_job_list_remove (struct t_worker_job **jobs,
+                        struct t_worker_job **last_job,
+                        struct t_worker_job *job)
+{
+    if (job->prev_job)
+        (job->prev_job)->next_job = job->next_job;
+    if (job->next_job)
+        (job->next_job)->prev_job = job->prev_job;
+    if (*jobs == job)
+        *jobs = job->next_job;
+    if (*last_job == job)
+        *last_job = job->prev_job;
+    job->prev_job = NULL;
+    job->next_job = NULL;
+}
+
+/*
+ * Main function of a worker thread: runs jobs of queue until the threads are
+ * asked to stop.
+ */
+
+void *
+worker_thread_main (void *arg)
+{
+    struct t_worker_job *ptr_job;
+    char byte;
+
+    /* make C compiler happy */
+    (void) arg;
+
+    byte = 0;
+
+    pthread_mutex_lock (&worker_mutex);
+
+    while (1)
+    {
+        while (!worker_stop && !worker_jobs_queued)
+        {
+            pthread_cond_wait (&worker_cond_queue, &worker_mutex);
+        }
+        if (worker_stop)
+            break;
+
+        ptr_job = worker_jobs_queued;
+        worker_job_list_remove (&worker_jobs_queued, &last_worker_job_queued,
+                                ptr_job);
+        ptr_job->status = WORKER_JOB_RUNNING;
+        worker_jobs_running++;
+
+        pthread_mutex_unlock (&worker_mutex);
+
+        (ptr_job->callback_run) (ptr_job, ptr_job->data);
+
+        pthread_mutex_lock (&worker_mutex);
+
+        ptr_job->status = WORKER_JOB_DONE;
+        worker_jobs_running--;
+        worker_job_list_add (&worker_jobs_done, &last_worker_job_done,
+                             ptr_job);
+        pthread_cond_broadcast (&worker_cond_done);
+
+        /* wake up main thread (if pipe is full, a wake up is pending anyway) */
+        if (write (worker_pipe[1], &byte, 1) < 0)
+        {
+            /* ignore error */
+        }
+    }
+
+    pthread_mutex_unlock (&worker_mutex);
+
+    return NULL;
+}
+
+/*
+ * Callback for fd hook on pipe: calls "done" callback of jobs done.
+ */
+
+int
+worker_pipe_read_cb (const void *pointer, void *data, int fd)
+{
+    char buffer[256];
+
+    /* make C compiler happy */
+    (void) pointer;
+    (void) data;
+
+    while (read (fd, buffer, sizeof (buffer)) > 0)
+    {
+    }
+
+    worker_process_done ();
+
+    return WEECHAT_RC_OK;
+}
+
+/*
+ * Creates the pipe used to wake up main thread and hooks its read side.
+ *
+ * Returns:
+ *   1: OK
+ *   0: error
+ */
+
+int
+worker_pipe_create ()
+{
+    int i;
+
+    if (worker_hook_pipe)
+        return 1;
+
+    if (pipe (worker_pipe) < 0)
+    {
+        worker_pipe[0] = -1;
+        worker_pipe[1] = -1;
+        return 0;
+    }
+
+    for (i = 0; i < 2; i++)
+    {
+        fcntl (worker_pipe[i], F_SETFD, FD_CLOEXEC);
+        fcntl (worker_pipe[i], F_SETFL,
+               fcntl (worker_pipe[i], F_GETFL) | O_NONBLOCK);
+    }
+
+    worker_hook_pipe = hook_fd (NULL, worker_pipe[0], 1, 0, 0,
+                                &worker_pipe_read_cb, NULL, NULL);
+    if (!worker_hook_pipe)
+    {
+        close (worker_pipe[0]);
+        close (worker_pipe[1]);
+        worker_pipe[0] = -1;
+        worker_pipe[1] = -1;
+        return 0;
+    }
+
+    return 1;
+}
+
+/*
+ * Removes the pipe used to wake up main thread.
+ */
+
+void
+worker_pipe_free ()
+{
+    if (worker_hook_pipe)
+    {
+        unhook (worker_hook_pipe);
+        worker_hook_pipe = NULL;
+    }
+    if (worker_pipe[0] >= 0)
+    {
+        close (worker_pipe[0]);
+        worker_pipe[0] = -1;
+    }
+    if (worker_pipe[1] >= 0)
+    {
+        close (worker_pipe[1]);
+        worker_pipe[1] = -1;
+    }
+}
+
+/*
+ * Stops all worker threads (jobs running are completed, queued jobs are kept
+ * in queue).
+ */
+
+void
+worker_stop_threads ()
+{
+    int i;
+
+    if (worker_threads_count == 0)
+        return;
+
+    pthread_mutex_lock (&worker_mutex);
+    worker_stop = 1;
+    pthread_cond_broadcast (&worker_cond_queue);
+    pthread_mutex_unlock (&worker_mutex);
+
+    for (i = 0; i < worker_threads_count; i++)
+    {
+        pthread_join (worker_threads[i], NULL);
+    }
+
+    worker_stop = 0;
+    worker_threads_count = 0;
+}
+
+/*
+ * Sets number of worker threads (0 = no threads).
+ *
+ * If the number of threads is 0, the jobs still in queue are run in main
+ * thread, so that the "done" callback is called for all jobs.
+ */
+
+void
+worker_set_threads (int count)
+{
+    struct t_worker_job *ptr_job;
+    sigset_t signals, old_signals;
+
+    if (count < 0)
+        count = 0;
+    if (count > WORKER_MAX_THREADS)
+        count = WORKER_MAX_THREADS;
+
+    if (count == worker_threads_count)
+        return;
+
+    worker_stop_threads ();
+
+    if ((count > 0) && worker_pipe_create ())
+    {
+        /* signals are received by main thread only */
+        sigfillset (&signals);
+        pthread_sigmask (SIG_SETMASK, &signals, &old_signals);
+        while (worker_threads_count < count)
+        {
+            if (pthread_create (&worker_threads[worker_threads_count], NULL,
+                                &worker_thread_main, NULL) != 0)
+            {
+                break;
+            }
+            worker_threads_count++;
+        }
+        pthread_sigmask (SIG_SETMASK, &old_signals, NULL);
+        if (worker_threads_count > 0)
+            return;
+    }
+
+    /* no threads: run jobs still in queue */
+    while (worker_jobs_queued)
+    {
+        ptr_job = worker_jobs_queued;
+        worker_job_list_remove (&worker_jobs_queued, &last_worker_job_queued,
+                                ptr_job);
+        ptr_job->status = WORKER_JOB_RUNNING;
+        (ptr_job->callback_run) (ptr_job, ptr_job->data);
+        ptr_job->status = WORKER_JOB_DONE;
+        worker_job_list_add (&worker_jobs_done, &last_worker_job_done,
+                             ptr_job);
+    }
+    worker_process_done ();
+
+    worker_pipe_free ();
+}
+
+/*
+ * Submits a job: callback_run is called in a worker thread, then
+ * callback_done is called in main thread.
+ *
+ * Returns pointer to new job, NULL if error (or if there are no worker
+ * threads).
+ */
+
+struct t_worker_job *
+worker_job_submit (t_worker_job_run *callback_run,
+                   t_worker_job_done *callback_done,
+                   void *data)
+{
+    struct t_worker_job *new_job;
+
+    if (!callback_run || !callback_done || (worker_threads_count == 0))
+        return NULL;
+
+    new_job = malloc (sizeof (*new_job));
+    if (!new_job)
+        return NULL;
+
+    new_job->callback_run = callback_run;
+    new_job->callback_done = callback_done;
+    new_job->data = data;
+    new_job->status = WORKER_JOB_QUEUED;
+    new_job->canceled = 0;
+
+    pthread_mutex_lock (&worker_mutex);
+    worker_job_list_add (&worker_jobs_queued, &last_worker_job_queued,
+                         new_job);
+    pthread_cond_signal (&worker_cond_queue);
+    pthread_mutex_unlock (&worker_mutex);
+
+    return new_job;
+}
+
+/*
+ * Checks if a job has been canceled (this function can be called by the "run"
+ * callback, to stop as soon as possible a job that has been canceled).
+ *
+ * Returns:
+ *   1: job canceled
+ *   0: job not canceled
+ */
+
+int
+worker_job_is_canceled (struct t_worker_job *job)
+{
+    int canceled;
+
+    pthread_mutex_lock (&worker_mutex);
+    canceled = job->canceled;
+    pthread_mutex_unlock (&worker_mutex);
+
+    return canceled;
+}
+
+/*
+ * Cancels a job: if the job is running, waits until the end of job.
+ *
+ * The job is freed and its "done" callback is not called: the data of job
+ * must be freed by the caller.
+ */
+
+void
+worker_job_cancel (struct t_worker_job *job)
+{
+    if (!job)
+        return;
+
+    pthread_mutex_lock (&worker_mutex);
+
+    if (job->status == WORKER_JOB_QUEUED)
+    {
+        worker_job_list_remove (&worker_jobs_queued, &last_worker_job_queued,
+                                job);
+    }
+    else
+    {
+        job->canceled = 1;
+        while (job->status == WORKER_JOB_RUNNING)
+        {
+            pthread_cond_wait (&worker_cond_done, &worker_mutex);
+        }
+        worker_job_list_remove (&worker_jobs_done, &last_worker_job_done,
+                                job);
+    }
+
+    pthread_mutex_unlock (&worker_mutex);
+
+    free (job);
+}
+
+/*
+ * Calls "done" callback of all jobs done and frees them.
+ */
+
+void
+worker_process_done ()
+{
+    struct t_worker_job *ptr_job;
+
+    while (1)
+    {
+        pthread_mutex_lock (&worker_mutex);
+        ptr_job = worker_jobs_done;
+        if (ptr_job)
+        {
+            worker_job_list_remove (&worker_jobs_done, &last_worker_job_done,
+                                    ptr_job);
+        }
+        pthread_mutex_unlock (&worker_mutex);
+
+        if (!ptr_job)
+            break;
+
+        (ptr_job->callback_done) (ptr_job, ptr_job->data);
+        free (ptr_job);
+    }
+}
+
+/*
+ * Waits until all jobs are done, then calls their "done" callback.
+ */
+
+void
+worker_wait ()
+{
+    pthread_mutex_lock (&worker_mutex);
+    while ((worker_threads_count > 0)
+           && (worker_jobs_queued || (worker_jobs_running > 0)))
+    {
+        pthread_cond_wait (&worker_cond_done, &worker_mutex);
+    }
+    pthread_mutex_unlock (&worker_mutex);
+
+    worker_process_done ();
+}
+
+/*
+ * Stops all worker threads (jobs not yet done are run in main thread).
+ */
+
+void
+worker_end ()
+{
+    worker_set_threads (0);
+}
+
+/*
+ * Prints worker threads and jobs in WeeChat log file (usually for crash dump).
+ */
+
+void
+worker_print_log ()
+{
+    struct t_worker_job *ptr_job;
+    int jobs_queued, jobs_done;
+
+    jobs_queued = 0;
+    for (ptr_job = worker_jobs_queued; ptr_job; ptr_job = ptr_job->next_job)
+    {
+        jobs_queued++;
+    }
+    jobs_done = 0;
+    for (ptr_job = worker_jobs_done; ptr_job; ptr_job = ptr_job->next_job)
+    {
+        jobs_done++;
+    }
+
+    log_printf ("");
+    log_printf ("[workers]");
+    log_printf ("  worker_threads_count . : %d", worker_threads_count);
+    log_printf ("  worker_jobs_queued . . : %d", jobs_queued);
+    log_printf ("  worker_jobs_running. . : %d", worker_jobs_running);
+    log_printf ("  worker_jobs_done . . . : %d", jobs_done);
+    log_printf ("  worker_pipe. . . . . . : %d, %d",
+                worker_pipe[0], worker_pipe[1]);
+    log_printf ("  worker_hook_pipe . . . : 0x%lx", worker_hook_pipe);
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This file is part of WeeChat, the extensible chat client.
+ *
+ * WeeChat is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WeeChat is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WeeChat.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef WEECHAT_WORKER_H
+#define WEECHAT_WORKER_H
+
+#define WORKER_MAX_THREADS 64
+
+enum t_worker_job_status
+{
+    WORKER_JOB_QUEUED = 0,             /* job waiting for a thread          */
+    WORKER_JOB_RUNNING,                /* job running in a thread           */
+    WORKER_JOB_DONE,                   /* job done, waiting for main thread */
+    /* number of job statuses */
+    WORKER_NUM_JOB_STATUSES,
+};
+
+struct t_worker_job;
+
+typedef void (t_worker_job_run)(struct t_worker_job *job, void *data);
+typedef void (t_worker_job_done)(struct t_worker_job *job, void *data);
+
+struct t_worker_job
+{
+    t_worker_job_run *callback_run;    /* called in a worker thread         */
+    t_worker_job_done *callback_done;  /* called in main thread after run   */
+    void *data;                        /* data sent to callbacks            */
+    int status;                        /* job status (see enum above)       */
+    int canceled;                      /* 1 if job has been canceled        */
+    struct t_worker_job *prev_job;     /* link to previous job (in queue)   */
+    struct t_worker_job *next_job;     /* link to next job (in queue)       */
+};
+
+extern int worker_threads_count;
+
+extern void worker_set_threads (int count);
+extern struct t_worker_job *worker_job_submit (t_worker_job_run *callback_run,
+                                               t_worker_job_done *callback_done,
+                                               void *data);
+extern int worker_job_is_canceled (struct t_worker_job *job);
+extern void worker_job_cancel (struct t_worker_job *job);
+extern void worker_process_done ();
+extern void worker_wait ();
+extern void worker_end ();
+extern void worker_print_log ();
+
+#endif /* WEECHAT_WORKER_H */
@@ -67,11 +67,13 @@
 #include "wee-proxy.h"
 #include "wee-secure.h"
 #include "wee-secure-config.h"
+#include "wee-slab.h"
 #include "wee-string.h"
 #include "wee-upgrade.h"
 #include "wee-utf8.h"
 #include "wee-util.h"
 #include "wee-version.h"
+#include "wee-worker.h"
 #include "../gui/gui-chat.h"
 #include "../gui/gui-color.h"
 #include "../gui/gui-completion.h"
@@ -831,6 +833,7 @@ weechat_end (void (*gui_end_cb)(int clean_exit))
 
     if (gui_end_cb)
         (*gui_end_cb) (1);              /* shut down WeeChat GUI            */
+    worker_end ();                      /* stop worker threads              */
 
     proxy_free_all ();                  /* free all proxies                 */
     config_weechat_free ();             /* free WeeChat options             */
@@ -840,6 +843,8 @@ weechat_end (void (*gui_end_cb)(int clean_exit))
     unhook_all ();                      /* remove all hooks                 */
     hdata_end ();                       /* end hdata                        */
     secure_end ();                      /* end secured data                 */
+    eval_end ();                        /* end eval (free compiled exprs)   */
+    slab_free_all ();                   /* free all slabs                   */
     string_end ();                      /* end string                       */
     weechat_shutdown (-1, 0);           /* end other things                 */
 }
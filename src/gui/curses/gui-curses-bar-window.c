@@ -803,7 +803,7 @@ gui_bar_window_draw (struct t_gui_bar_window *bar_window,
         wnoutrefresh (GUI_BAR_WINDOW_OBJECTS(bar_window)->win_separator);
     }
 
-    refresh ();
+    gui_window_doupdate ();
 }
 
 /*
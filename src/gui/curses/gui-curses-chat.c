@@ -697,6 +697,7 @@ gui_chat_display_time_to_prefix (struct t_gui_window *window,
     char *prefix_no_color, *prefix_highlighted, *ptr_prefix, *ptr_prefix2;
     char *ptr_prefix_color;
     const char *short_name, *str_color, *ptr_nick_prefix, *ptr_nick_suffix;
+    const char *ptr_str_time;
     int i, length, length_allowed, num_spaces, prefix_length, extra_spaces;
     int chars_displayed, nick_offline, prefix_is_nick, length_nick_prefix_suffix;
     int chars_to_display;
@@ -714,12 +715,13 @@ gui_chat_display_time_to_prefix (struct t_gui_window *window,
     }
 
     /* display time */
-    if (window->buffer->time_for_each_line
-        && line->data->str_time && line->data->str_time[0])
+    ptr_str_time = (window->buffer->time_for_each_line) ?
+        gui_line_get_str_time (line->data) : NULL;
+    if (ptr_str_time && ptr_str_time[0])
     {
         if (window->win_chat_cursor_y < window->coords_size)
             window->coords[window->win_chat_cursor_y].time_x1 = window->win_chat_cursor_x;
-        gui_chat_display_word (window, line, line->data->str_time,
+        gui_chat_display_word (window, line, ptr_str_time,
                                NULL, 1, num_lines, count,
                                pre_lines_displayed, lines_displayed,
                                simulate,
@@ -1226,100 +1228,120 @@ gui_chat_display_time_to_prefix (struct t_gui_window *window,
 }
 
 /*
- * Displays a line in the chat window.
+ * Checks if two windows have the same layout for lines.
  *
- * If count == 0, display whole line.
- * If count > 0, display 'count' lines (beginning from the end).
- * If simulate == 1, nothing is displayed (for counting how many lines would
- * have been displayed).
+ * Returns:
+ *   1: same layout
+ *   0: different layout
+ */
+
+int
+gui_chat_rows_same_layout (struct t_gui_window *window1,
+                           struct t_gui_window *window2)
+{
+    return ((window1->chat_rows_version == window2->chat_rows_version)
+            && (window1->chat_rows_buffer == window2->chat_rows_buffer)
+            && (window1->chat_rows_width == window2->chat_rows_width)
+            && (window1->chat_rows_zoomed == window2->chat_rows_zoomed)
+            && (window1->chat_rows_time_for_each_line == window2->chat_rows_time_for_each_line)
+            && (window1->chat_rows_prefix_max_length == window2->chat_rows_prefix_max_length)
+            && (window1->chat_rows_buffer_max_length == window2->chat_rows_buffer_max_length)) ?
+        1 : 0;
+}
+
+/*
+ * Gets id of layout used to display lines in a window: the number of rows
+ * of a line (time, prefix and message) is cached in the line with this id.
  *
- * Returns number of lines displayed (or simulated).
+ * A new id is used when the chat width, the prefix/buffer max lengths or any
+ * option used to display lines is changed; windows with the same layout
+ * share the same id.
+ *
+ * Returns id of layout, 0 if the number of rows must not be cached.
  */
 
 int
-gui_chat_display_line (struct t_gui_window *window, struct t_gui_line *line,
-                       int count, int simulate)
+gui_chat_get_rows_id (struct t_gui_window *window)
 {
-    int num_lines, x, y, pre_lines_displayed, lines_displayed, line_align;
-    int read_marker_x, read_marker_y;
-    int word_start_offset, word_end_offset;
-    int word_length_with_spaces, word_length;
-    char *message_with_tags, *message_with_search;
-    const char *ptr_data, *ptr_end_offset, *ptr_style, *next_char;
-    struct t_gui_line *ptr_prev_line, *ptr_next_line;
-    struct tm local_time, local_time2;
-    struct timeval tv_time;
-    time_t seconds, *ptr_time;
+    struct t_gui_window *ptr_win;
+    int width, zoomed;
 
-    if (!line)
+    if (gui_chat_display_tags)
         return 0;
 
-    if (simulate)
+    /*
+     * without prefix alignment, the alignment of a line depends on the
+     * previous line (prefix displayed or not, if same nick)
+     */
+    if ((CONFIG_INTEGER(config_look_prefix_align) == CONFIG_LOOK_PREFIX_ALIGN_NONE)
+        && CONFIG_STRING(config_look_prefix_same_nick)
+        && CONFIG_STRING(config_look_prefix_same_nick)[0])
     {
-        x = window->win_chat_cursor_x;
-        y = window->win_chat_cursor_y;
-        window->win_chat_cursor_x = 0;
-        window->win_chat_cursor_y = 0;
-        num_lines = 0;
+        return 0;
     }
-    else
+
+    width = gui_chat_get_real_width (window);
+    zoomed = (window->buffer->active == 2) ? 1 : 0;
+
+    if (window->chat_rows_id
+        && (window->chat_rows_version == gui_chat_rows_version)
+        && (window->chat_rows_buffer == window->buffer)
+        && (window->chat_rows_width == width)
+        && (window->chat_rows_zoomed == zoomed)
+        && (window->chat_rows_time_for_each_line == window->buffer->time_for_each_line)
+        && (window->chat_rows_prefix_max_length == window->buffer->lines->prefix_max_length)
+        && (window->chat_rows_buffer_max_length == window->buffer->lines->buffer_max_length))
     {
-        if (window->win_chat_cursor_y > window->win_chat_height - 1)
-            return 0;
-        x = window->win_chat_cursor_x;
-        y = window->win_chat_cursor_y;
-        num_lines = gui_chat_display_line (window, line, 0, 1);
-        window->win_chat_cursor_x = x;
-        window->win_chat_cursor_y = y;
-        gui_window_current_emphasis = 0;
+        return window->chat_rows_id;
     }
 
-    pre_lines_displayed = 0;
-    lines_displayed = 0;
+    window->chat_rows_version = gui_chat_rows_version;
+    window->chat_rows_buffer = window->buffer;
+    window->chat_rows_width = width;
+    window->chat_rows_zoomed = zoomed;
+    window->chat_rows_time_for_each_line = window->buffer->time_for_each_line;
+    window->chat_rows_prefix_max_length = window->buffer->lines->prefix_max_length;
+    window->chat_rows_buffer_max_length = window->buffer->lines->buffer_max_length;
 
-    /* display message before first line of buffer if date is not today */
-    if ((line->data->date != 0)
-        && CONFIG_BOOLEAN(config_look_day_change)
-        && window->buffer->day_change)
+    /* use id of another window with same layout (if found) */
+    for (ptr_win = gui_windows; ptr_win; ptr_win = ptr_win->next_window)
     {
-        ptr_time = NULL;
-        ptr_prev_line = gui_line_get_prev_displayed (line);
-        if (ptr_prev_line)
+        if ((ptr_win != window) && ptr_win->chat_rows_id
+            && gui_chat_rows_same_layout (ptr_win, window))
         {
-            while (ptr_prev_line && (ptr_prev_line->data->date == 0))
-            {
-                ptr_prev_line = gui_line_get_prev_displayed (ptr_prev_line);
-            }
-        }
-        if (!ptr_prev_line)
-        {
-            gettimeofday (&tv_time, NULL);
-            seconds = tv_time.tv_sec;
-            localtime_r (&seconds, &local_time);
-            localtime_r (&line->data->date, &local_time2);
-            if ((local_time.tm_mday != local_time2.tm_mday)
-                || (local_time.tm_mon != local_time2.tm_mon)
-                || (local_time.tm_year != local_time2.tm_year))
-            {
-                gui_chat_display_day_changed (window, NULL, &local_time2,
-                                              simulate);
-                gui_chat_display_new_line (window, num_lines, count,
-                                           &lines_displayed, simulate);
-                pre_lines_displayed++;
-            }
+            window->chat_rows_id = ptr_win->chat_rows_id;
+            return window->chat_rows_id;
         }
     }
 
-    /* calculate marker position (maybe not used for this line!) */
-    if (window->buffer->time_for_each_line && line->data->str_time)
-        read_marker_x = x + gui_chat_strlen_screen (line->data->str_time);
-    else
-        read_marker_x = x;
-    read_marker_y = y;
+    gui_chat_rows_last_id++;
+    if (gui_chat_rows_last_id <= 0)
+        gui_chat_rows_last_id = 1;
+    window->chat_rows_id = gui_chat_rows_last_id;
+
+    return window->chat_rows_id;
+}
+
+/*
+ * Displays time, prefix and message of a line (without the day change
+ * messages and the read marker).
+ */
+
+void
+gui_chat_display_line_content (struct t_gui_window *window,
+                               struct t_gui_line *line,
+                               int num_lines, int count,
+                               int pre_lines_displayed, int *lines_displayed,
+                               int simulate)
+{
+    int word_start_offset, word_end_offset;
+    int word_length_with_spaces, word_length, line_align;
+    char *message_with_tags, *message_with_search;
+    const char *ptr_data, *ptr_end_offset, *ptr_style, *next_char;
 
     /* display time and prefix */
     gui_chat_display_time_to_prefix (window, line, num_lines, count,
-                                     pre_lines_displayed, &lines_displayed,
+                                     pre_lines_displayed, lines_displayed,
                                      simulate);
     if (!simulate && !gui_chat_display_tags)
     {
@@ -1395,13 +1417,13 @@ gui_chat_display_line (struct t_gui_window *window, struct t_gui_line *line,
             if (word_length >= 0)
             {
                 line_align = gui_line_get_align (window->buffer, line, 1,
-                                                 (lines_displayed == 0) ? 1 : 0);
+                                                 (*lines_displayed == 0) ? 1 : 0);
                 if ((window->win_chat_cursor_x + word_length_with_spaces > gui_chat_get_real_width (window))
                     && (word_length <= gui_chat_get_real_width (window) - line_align))
                 {
                     /* spaces + word too long for current line but OK for next line */
                     gui_chat_display_new_line (window, num_lines, count,
-                                               &lines_displayed, simulate);
+                                               lines_displayed, simulate);
                     /* apply styles before jumping to start of word */
                     if (!simulate && (word_start_offset > 0))
                     {
@@ -1427,7 +1449,7 @@ gui_chat_display_line (struct t_gui_window *window, struct t_gui_line *line,
                 gui_chat_display_word (window, line, ptr_data,
                                        ptr_end_offset + 1,
                                        0, num_lines, count,
-                                       pre_lines_displayed, &lines_displayed,
+                                       pre_lines_displayed, lines_displayed,
                                        simulate,
                                        CONFIG_BOOLEAN(config_look_color_inactive_message),
                                        0);
@@ -1460,7 +1482,7 @@ gui_chat_display_line (struct t_gui_window *window, struct t_gui_line *line,
             else
             {
                 gui_chat_display_new_line (window, num_lines, count,
-                                           &lines_displayed, simulate);
+                                           lines_displayed, simulate);
                 ptr_data = NULL;
             }
         }
@@ -1469,13 +1491,130 @@ gui_chat_display_line (struct t_gui_window *window, struct t_gui_line *line,
     {
         /* no message */
         gui_chat_display_new_line (window, num_lines, count,
-                                   &lines_displayed, simulate);
+                                   lines_displayed, simulate);
     }
 
     if (message_with_tags)
         free (message_with_tags);
     if (message_with_search)
         free (message_with_search);
+}
+
+/*
+ * Displays a line in the chat window.
+ *
+ * If count == 0, display whole line.
+ * If count > 0, display 'count' lines (beginning from the end).
+ * If simulate == 1, nothing is displayed (for counting how many lines would
+ * have been displayed).
+ *
+ * Returns number of lines displayed (or simulated).
+ */
+
+int
+gui_chat_display_line (struct t_gui_window *window, struct t_gui_line *line,
+                       int count, int simulate)
+{
+    int num_lines, x, y, pre_lines_displayed, lines_displayed;
+    int read_marker_x, read_marker_y, rows_id;
+    const char *ptr_str_time;
+    struct t_gui_line *ptr_prev_line, *ptr_next_line;
+    struct tm local_time, local_time2;
+    struct timeval tv_time;
+    time_t seconds, *ptr_time;
+
+    if (!line)
+        return 0;
+
+    if (simulate)
+    {
+        x = window->win_chat_cursor_x;
+        y = window->win_chat_cursor_y;
+        window->win_chat_cursor_x = 0;
+        window->win_chat_cursor_y = 0;
+        num_lines = 0;
+    }
+    else
+    {
+        if (window->win_chat_cursor_y > window->win_chat_height - 1)
+            return 0;
+        x = window->win_chat_cursor_x;
+        y = window->win_chat_cursor_y;
+        num_lines = gui_chat_display_line (window, line, 0, 1);
+        window->win_chat_cursor_x = x;
+        window->win_chat_cursor_y = y;
+        gui_window_current_emphasis = 0;
+    }
+
+    pre_lines_displayed = 0;
+    lines_displayed = 0;
+
+    /* display message before first line of buffer if date is not today */
+    if ((line->data->date != 0)
+        && CONFIG_BOOLEAN(config_look_day_change)
+        && window->buffer->day_change)
+    {
+        ptr_time = NULL;
+        ptr_prev_line = gui_line_get_prev_displayed (line);
+        if (ptr_prev_line)
+        {
+            while (ptr_prev_line && (ptr_prev_line->data->date == 0))
+            {
+                ptr_prev_line = gui_line_get_prev_displayed (ptr_prev_line);
+            }
+        }
+        if (!ptr_prev_line)
+        {
+            gettimeofday (&tv_time, NULL);
+            seconds = tv_time.tv_sec;
+            localtime_r (&seconds, &local_time);
+            localtime_r (&line->data->date, &local_time2);
+            if ((local_time.tm_mday != local_time2.tm_mday)
+                || (local_time.tm_mon != local_time2.tm_mon)
+                || (local_time.tm_year != local_time2.tm_year))
+            {
+                gui_chat_display_day_changed (window, NULL, &local_time2,
+                                              simulate);
+                gui_chat_display_new_line (window, num_lines, count,
+                                           &lines_displayed, simulate);
+                pre_lines_displayed++;
+            }
+        }
+    }
+
+    /* calculate marker position (maybe not used for this line!) */
+    ptr_str_time = (window->buffer->time_for_each_line) ?
+        gui_line_get_str_time (line->data) : NULL;
+    if (ptr_str_time)
+        read_marker_x = x + gui_chat_strlen_screen (ptr_str_time);
+    else
+        read_marker_x = x;
+    read_marker_y = y;
+
+    /*
+     * display time, prefix and message; when simulating, the number of rows
+     * is cached in the line (it depends only on the layout of window if no
+     * day change message has been displayed before)
+     */
+    rows_id = (simulate && (pre_lines_displayed == 0)) ?
+        gui_chat_get_rows_id (window) : 0;
+    if (rows_id && (line->data->rows_id == rows_id))
+    {
+        window->win_chat_cursor_x = 0;
+        window->win_chat_cursor_y += line->data->rows;
+        lines_displayed += line->data->rows;
+    }
+    else
+    {
+        gui_chat_display_line_content (window, line, num_lines, count,
+                                       pre_lines_displayed, &lines_displayed,
+                                       simulate);
+        if (rows_id)
+        {
+            line->data->rows_id = rows_id;
+            line->data->rows = lines_displayed;
+        }
+    }
 
     /* display message if day has changed after this line */
     if ((line->data->date != 0)
@@ -1732,6 +1871,8 @@ gui_chat_draw_formatted_buffer (struct t_gui_window *window)
     int auto_search_first_line, line_pos, line_pos2, count;
     int old_scrolling, old_lines_after;
 
+    window->chat_last_line = NULL;
+
     /* display at position of scrolling */
     auto_search_first_line = 1;
     ptr_line = NULL;
@@ -1844,6 +1985,21 @@ gui_chat_draw_formatted_buffer (struct t_gui_window *window)
                                  WEECHAT_HOOK_SIGNAL_POINTER, window);
     }
 
+    /*
+     * if the end of buffer is displayed and the chat area is full, save the
+     * last line displayed: lines added later can be displayed by scrolling
+     * the chat area (see function gui_chat_draw_formatted_buffer_lines_added)
+     */
+    if (!window->scroll->start_line
+        && (window->win_chat_cursor_y >= window->win_chat_height))
+    {
+        window->chat_last_line = gui_line_get_last_displayed (window->buffer);
+        window->chat_last_prefix_max_length =
+            window->buffer->lines->prefix_max_length;
+        window->chat_last_buffer_max_length =
+            window->buffer->lines->buffer_max_length;
+    }
+
     /* cursor is below end line of chat window? */
     if (window->win_chat_cursor_y > window->win_chat_height - 1)
     {
@@ -1852,6 +2008,141 @@ gui_chat_draw_formatted_buffer (struct t_gui_window *window)
     }
 }
 
+/*
+ * Checks if a date is in the same day as a local time.
+ *
+ * Returns:
+ *   1: date is in the same day
+ *   0: date is in another day
+ */
+
+int
+gui_chat_date_is_same_day (time_t date, struct tm *local_time)
+{
+    struct tm local_time2;
+
+    localtime_r (&date, &local_time2);
+
+    return ((local_time->tm_mday == local_time2.tm_mday)
+            && (local_time->tm_mon == local_time2.tm_mon)
+            && (local_time->tm_year == local_time2.tm_year)) ? 1 : 0;
+}
+
+/*
+ * Draws lines added at the end of a formatted buffer, if the end of buffer
+ * was displayed in the window (full chat area) on last draw: the chat area is
+ * scrolled up and only the new lines are drawn at bottom.
+ *
+ * Returns:
+ *   1: new lines drawn (or nothing to draw)
+ *   0: new lines can not be drawn this way (a full draw is needed)
+ */
+
+int
+gui_chat_draw_formatted_buffer_lines_added (struct t_gui_window *window)
+{
+    struct t_gui_line *ptr_line, *ptr_first_line;
+    struct tm local_time;
+    time_t current_time;
+    int day_change, rows;
+
+    if (!window->chat_last_line
+        || window->scroll->start_line
+        || (window->win_chat_height < 2)
+        || !window->coords
+        || (window->coords_size != window->win_chat_height)
+        || (window->buffer->lines->prefix_max_length != window->chat_last_prefix_max_length)
+        || (window->buffer->lines->buffer_max_length != window->chat_last_buffer_max_length)
+        || (window->buffer->text_search != GUI_TEXT_SEARCH_DISABLED)
+        || gui_chat_display_tags
+        || !gui_line_is_displayed (window->chat_last_line))
+    {
+        return 0;
+    }
+
+    /*
+     * the read marker must not be displayed after the last line or the new
+     * lines (the last line would have to be drawn again)
+     */
+    if (window->buffer->lines->last_read_line == window->chat_last_line)
+        return 0;
+
+    /*
+     * the day change message must not be displayed between the last line and
+     * the new lines, or between the new lines
+     */
+    day_change = (CONFIG_BOOLEAN(config_look_day_change)
+                  && window->buffer->day_change) ? 1 : 0;
+    if (day_change)
+    {
+        current_time = time (NULL);
+        localtime_r (&current_time, &local_time);
+        if ((window->chat_last_line->data->date != 0)
+            && !gui_chat_date_is_same_day (window->chat_last_line->data->date,
+                                           &local_time))
+        {
+            return 0;
+        }
+    }
+
+    /* count number of rows needed for new lines */
+    ptr_first_line = NULL;
+    rows = 0;
+    for (ptr_line = window->chat_last_line->next_line; ptr_line;
+         ptr_line = ptr_line->next_line)
+    {
+        if (ptr_line == window->buffer->lines->last_read_line)
+            return 0;
+        if (!gui_line_is_displayed (ptr_line))
+            continue;
+        if (day_change
+            && (ptr_line->data->date != 0)
+            && !gui_chat_date_is_same_day (ptr_line->data->date, &local_time))
+        {
+            return 0;
+        }
+        if (!ptr_first_line)
+            ptr_first_line = ptr_line;
+        rows += gui_chat_display_line (window, ptr_line, 0, 1);
+        if (rows >= window->win_chat_height)
+            return 0;
+    }
+
+    if (!ptr_first_line)
+        return 1;
+
+    /* scroll chat area and coordinates */
+    scrollok (GUI_WINDOW_OBJECTS(window)->win_chat, TRUE);
+    wscrl (GUI_WINDOW_OBJECTS(window)->win_chat, rows);
+    scrollok (GUI_WINDOW_OBJECTS(window)->win_chat, FALSE);
+    gui_window_coords_scroll (window, rows);
+    window->scroll->first_line_displayed = 0;
+
+    /* draw new lines at bottom */
+    gui_chat_reset_style (window, NULL, 0, 1,
+                          GUI_COLOR_CHAT_INACTIVE_WINDOW,
+                          GUI_COLOR_CHAT_INACTIVE_BUFFER,
+                          GUI_COLOR_CHAT);
+    window->win_chat_cursor_x = 0;
+    window->win_chat_cursor_y = window->win_chat_height - rows;
+    for (ptr_line = ptr_first_line; ptr_line;
+         ptr_line = gui_line_get_next_displayed (ptr_line))
+    {
+        gui_chat_display_line (window, ptr_line, 0, 0);
+    }
+
+    window->chat_last_line = gui_line_get_last_displayed (window->buffer);
+
+    /* cursor is below end line of chat window? */
+    if (window->win_chat_cursor_y > window->win_chat_height - 1)
+    {
+        window->win_chat_cursor_x = 0;
+        window->win_chat_cursor_y = window->win_chat_height - 1;
+    }
+
+    return 1;
+}
+
 /*
  * Draws chat window for a free buffer.
  */
@@ -1908,23 +2199,14 @@ gui_chat_draw_free_buffer (struct t_gui_window *window, int clear_chat)
 char *
 gui_chat_get_bare_line (struct t_gui_line *line)
 {
-    char *prefix, *message, str_time[256], *str_line;
-    const char *tag_prefix_nick;
+    char str_time[256], *str_line;
+    const char *prefix, *message, *tag_prefix_nick;
     struct tm *local_time;
     int length;
 
-    prefix = NULL;
-    message = NULL;
-    str_line = NULL;
-
-    prefix = (line->data->prefix) ?
-        gui_color_decode (line->data->prefix, NULL) : strdup ("");
-    if (!prefix)
-        goto end;
-    message = (line->data->message) ?
-        gui_color_decode (line->data->message, NULL) : strdup ("");
-    if (!message)
-        goto end;
+    prefix = (line->data->prefix_no_color) ? line->data->prefix_no_color : "";
+    message = (line->data->message_no_color) ?
+        line->data->message_no_color : "";
 
     str_time[0] = '\0';
     if (line->data->buffer->time_for_each_line
@@ -1956,12 +2238,6 @@ gui_chat_get_bare_line (struct t_gui_line *line)
                   message);
     }
 
-end:
-    if (prefix)
-        free (prefix);
-    if (message)
-        free (message);
-
     return str_line;
 }
 
@@ -2041,6 +2317,73 @@ gui_chat_draw_bare (struct t_gui_window *window)
     fflush (stdout);
 }
 
+/*
+ * Checks if chat area of a window can be drawn for a buffer.
+ *
+ * Returns:
+ *   1: chat area displays the buffer (or a buffer merged with it)
+ *   0: chat area does not display the buffer, or can not be drawn
+ */
+
+int
+gui_chat_window_displays_buffer (struct t_gui_window *window,
+                                 struct t_gui_buffer *buffer)
+{
+    return ((window->buffer->number == buffer->number)
+            && (window->win_chat_x >= 0) && (window->win_chat_y >= 0)
+            && (GUI_WINDOW_OBJECTS(window)->win_chat)) ? 1 : 0;
+}
+
+/*
+ * Draws chat area of a window.
+ */
+
+void
+gui_chat_draw_window (struct t_gui_window *window, int clear_chat)
+{
+    char format_empty[32];
+    int i;
+
+    gui_window_coords_alloc (window);
+
+    gui_chat_reset_style (window, NULL, 0, 1,
+                          GUI_COLOR_CHAT_INACTIVE_WINDOW,
+                          GUI_COLOR_CHAT_INACTIVE_BUFFER,
+                          GUI_COLOR_CHAT);
+
+    if (clear_chat)
+    {
+        snprintf (format_empty, sizeof (format_empty),
+                  "%%-%ds", window->win_chat_width);
+        for (i = 0; i < window->win_chat_height; i++)
+        {
+            mvwprintw (GUI_WINDOW_OBJECTS(window)->win_chat, i, 0,
+                       format_empty, " ");
+        }
+    }
+
+    window->win_chat_cursor_x = 0;
+    window->win_chat_cursor_y = 0;
+    window->chat_last_line = NULL;
+
+    switch (window->buffer->type)
+    {
+        case GUI_BUFFER_TYPE_FORMATTED:
+            /* min 2 lines for chat area */
+            if (window->win_chat_height < 2)
+                mvwaddstr (GUI_WINDOW_OBJECTS(window)->win_chat, 0, 0, "...");
+            else
+                gui_chat_draw_formatted_buffer (window);
+            break;
+        case GUI_BUFFER_TYPE_FREE:
+            gui_chat_draw_free_buffer (window, clear_chat);
+            break;
+        case GUI_BUFFER_NUM_TYPES:
+            break;
+    }
+    wnoutrefresh (GUI_WINDOW_OBJECTS(window)->win_chat);
+}
+
 /*
  * Draws chat window for a buffer.
  */
@@ -2050,8 +2393,6 @@ gui_chat_draw (struct t_gui_buffer *buffer, int clear_chat)
 {
     struct t_gui_window *ptr_win;
     struct t_gui_line *ptr_line;
-    char format_empty[32];
-    int i;
 
     if (!gui_init_ok)
         return;
@@ -2065,51 +2406,11 @@ gui_chat_draw (struct t_gui_buffer *buffer, int clear_chat)
 
     for (ptr_win = gui_windows; ptr_win; ptr_win = ptr_win->next_window)
     {
-        if ((ptr_win->buffer->number == buffer->number)
-            && (ptr_win->win_chat_x >= 0) && (ptr_win->win_chat_y >= 0)
-            && (GUI_WINDOW_OBJECTS(ptr_win)->win_chat))
-        {
-            gui_window_coords_alloc (ptr_win);
-
-            gui_chat_reset_style (ptr_win, NULL, 0, 1,
-                                  GUI_COLOR_CHAT_INACTIVE_WINDOW,
-                                  GUI_COLOR_CHAT_INACTIVE_BUFFER,
-                                  GUI_COLOR_CHAT);
-
-            if (clear_chat)
-            {
-                snprintf (format_empty, sizeof (format_empty),
-                          "%%-%ds", ptr_win->win_chat_width);
-                for (i = 0; i < ptr_win->win_chat_height; i++)
-                {
-                    mvwprintw (GUI_WINDOW_OBJECTS(ptr_win)->win_chat, i, 0,
-                               format_empty, " ");
-                }
-            }
-
-            ptr_win->win_chat_cursor_x = 0;
-            ptr_win->win_chat_cursor_y = 0;
-
-            switch (ptr_win->buffer->type)
-            {
-                case GUI_BUFFER_TYPE_FORMATTED:
-                    /* min 2 lines for chat area */
-                    if (ptr_win->win_chat_height < 2)
-                        mvwaddstr (GUI_WINDOW_OBJECTS(ptr_win)->win_chat, 0, 0, "...");
-                    else
-                        gui_chat_draw_formatted_buffer (ptr_win);
-                    break;
-                case GUI_BUFFER_TYPE_FREE:
-                    gui_chat_draw_free_buffer (ptr_win, clear_chat);
-                    break;
-                case GUI_BUFFER_NUM_TYPES:
-                    break;
-            }
-            wnoutrefresh (GUI_WINDOW_OBJECTS(ptr_win)->win_chat);
-        }
+        if (gui_chat_window_displays_buffer (ptr_win, buffer))
+            gui_chat_draw_window (ptr_win, clear_chat);
     }
 
-    refresh ();
+    gui_window_doupdate ();
 
     if (buffer->type == GUI_BUFFER_TYPE_FREE)
     {
@@ -2122,4 +2423,40 @@ gui_chat_draw (struct t_gui_buffer *buffer, int clear_chat)
 
 end:
     buffer->chat_refresh_needed = 0;
+    buffer->chat_refresh_lines_added = 0;
+}
+
+/*
+ * Draws lines added at the end of a buffer: in windows displaying the end of
+ * buffer, only new lines are drawn (other windows are fully drawn).
+ */
+
+void
+gui_chat_draw_lines_added (struct t_gui_buffer *buffer)
+{
+    struct t_gui_window *ptr_win;
+
+    if (!gui_init_ok)
+        return;
+
+    if (gui_window_bare_display
+        || (buffer->type != GUI_BUFFER_TYPE_FORMATTED))
+    {
+        gui_chat_draw (buffer, 0);
+        return;
+    }
+
+    for (ptr_win = gui_windows; ptr_win; ptr_win = ptr_win->next_window)
+    {
+        if (!gui_chat_window_displays_buffer (ptr_win, buffer))
+            continue;
+        if (gui_chat_draw_formatted_buffer_lines_added (ptr_win))
+            wnoutrefresh (GUI_WINDOW_OBJECTS(ptr_win)->win_chat);
+        else
+            gui_chat_draw_window (ptr_win, 0);
+    }
+
+    gui_window_doupdate ();
+
+    buffer->chat_refresh_lines_added = 0;
 }
@@ -345,6 +345,9 @@ gui_main_refreshes ()
     struct t_gui_buffer *ptr_buffer;
     struct t_gui_bar *ptr_bar;
 
+    /* update terminal only once, after all refreshes */
+    gui_window_doupdate_start ();
+
     /* refresh color buffer if needed */
     if (gui_color_buffer_refresh_needed)
     {
@@ -402,18 +405,24 @@ gui_main_refreshes ()
         gui_window_refresh_needed = 0;
     }
 
-    /* refresh windows if needed */
+    /*
+     * refresh windows if needed (chat is drawn below, only once for windows
+     * displaying the same buffer)
+     */
     for (ptr_win = gui_windows; ptr_win; ptr_win = ptr_win->next_window)
     {
         if (ptr_win->refresh_needed)
         {
             gui_window_switch_to_buffer (ptr_win, ptr_win->buffer, 0);
-            gui_chat_draw (ptr_win->buffer, 1);
+            gui_buffer_ask_chat_refresh (ptr_win->buffer, 2);
             ptr_win->refresh_needed = 0;
         }
     }
 
-    /* refresh chat buffers if needed */
+    /*
+     * refresh chat buffers if needed (if lines were only added at the end of
+     * buffer, only the new lines are drawn when possible)
+     */
     for (ptr_buffer = gui_buffers; ptr_buffer;
          ptr_buffer = ptr_buffer->next_buffer)
     {
@@ -422,6 +431,10 @@ gui_main_refreshes ()
             gui_chat_draw (ptr_buffer,
                            (ptr_buffer->chat_refresh_needed) > 1 ? 1 : 0);
         }
+        else if (ptr_buffer->chat_refresh_lines_added)
+        {
+            gui_chat_draw_lines_added (ptr_buffer);
+        }
     }
 
     if (!gui_window_bare_display)
@@ -439,6 +452,8 @@ gui_main_refreshes ()
         if (gui_cursor_mode)
             gui_window_move_cursor ();
     }
+
+    gui_window_doupdate_end ();
 }
 
 /*
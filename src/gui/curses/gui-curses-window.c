@@ -68,6 +68,9 @@ int gui_window_current_emphasis;       /* 1 if text emphasis is enabled     */
 struct t_gui_window_saved_style gui_window_saved_style[GUI_WINDOW_MAX_SAVED_STYLES];
                                        /* circular list of saved styles     */
 int gui_window_saved_style_index = 0;  /* index in list of savec styles     */
+int gui_window_doupdate_delayed = 0;   /* 1 if update of terminal is delayed*/
+int gui_window_doupdate_needed = 0;    /* 1 if terminal must be updated     */
+                                       /* (when update is delayed)          */
 
 
 /*
@@ -90,6 +93,50 @@ gui_window_get_height ()
     return gui_term_lines;
 }
 
+/*
+ * Updates the terminal with the windows refreshed (with wnoutrefresh).
+ *
+ * During refreshes in main loop, the update is delayed: the terminal is
+ * updated only once, after all windows and bars have been drawn (see function
+ * gui_window_doupdate_end).
+ */
+
+void
+gui_window_doupdate ()
+{
+    if (gui_window_doupdate_delayed)
+        gui_window_doupdate_needed = 1;
+    else
+        refresh ();
+}
+
+/*
+ * Delays updates of terminal (until function gui_window_doupdate_end is
+ * called).
+ */
+
+void
+gui_window_doupdate_start ()
+{
+    gui_window_doupdate_delayed = 1;
+    gui_window_doupdate_needed = 0;
+}
+
+/*
+ * Updates the terminal if an update was delayed.
+ */
+
+void
+gui_window_doupdate_end ()
+{
+    gui_window_doupdate_delayed = 0;
+    if (gui_window_doupdate_needed)
+    {
+        gui_window_doupdate_needed = 0;
+        refresh ();
+    }
+}
+
 /*
  * Reads terminal size.
  */
@@ -1245,6 +1292,9 @@ gui_window_switch_to_buffer (struct t_gui_window *window,
                                                        window->win_chat_width,
                                                        window->win_chat_y,
                                                        window->win_chat_x);
+        /* allow use of insert/delete line of terminal when chat is scrolled */
+        if (GUI_WINDOW_OBJECTS(window)->win_chat)
+            idlok (GUI_WINDOW_OBJECTS(window)->win_chat, TRUE);
     }
     gui_window_draw_separators (window);
     gui_buffer_ask_chat_refresh (window->buffer, 2);
@@ -105,6 +105,9 @@ extern void gui_key_default_bindings (int context);
 extern int gui_key_read_cb (const void *pointer, void *data, int fd);
 
 /* window functions */
+extern void gui_window_doupdate ();
+extern void gui_window_doupdate_start ();
+extern void gui_window_doupdate_end ();
 extern void gui_window_read_terminal_size ();
 extern void gui_window_clear (WINDOW *window, int fg, int bg);
 extern void gui_window_clrtoeol (WINDOW *window);
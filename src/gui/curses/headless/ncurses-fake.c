@@ -299,6 +299,33 @@ nodelay (WINDOW *win, bool bf)
     return OK;
 }
 
+int
+idlok (WINDOW *win, bool bf)
+{
+    (void) win;
+    (void) bf;
+
+    return OK;
+}
+
+int
+scrollok (WINDOW *win, bool bf)
+{
+    (void) win;
+    (void) bf;
+
+    return OK;
+}
+
+int
+wscrl (WINDOW *win, int n)
+{
+    (void) win;
+    (void) n;
+
+    return OK;
+}
+
 int
 werase (WINDOW *win)
 {
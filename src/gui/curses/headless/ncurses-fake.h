@@ -105,6 +105,9 @@ extern int wclear (WINDOW *win);
 extern bool can_change_color ();
 extern int curs_set (int visibility);
 extern int nodelay (WINDOW *win, bool bf);
+extern int idlok (WINDOW *win, bool bf);
+extern int scrollok (WINDOW *win, bool bf);
+extern int wscrl (WINDOW *win, int n);
 extern int werase (WINDOW *win);
 extern int wbkgdset (WINDOW *win, chtype ch);
 extern void wchgat (WINDOW *win, int n, attr_t attr, short color,
@@ -92,9 +92,10 @@ char *gui_buffer_properties_get_integer[] =
   "prefix_max_length", "time_for_each_line", "nicklist",
   "nicklist_case_sensitive", "nicklist_max_length", "nicklist_display_groups",
   "nicklist_count", "nicklist_groups_count", "nicklist_nicks_count",
-  "nicklist_visible_count", "input", "input_get_unknown_commands",
-  "input_get_empty", "input_size", "input_length", "input_pos",
-  "input_1st_display", "num_history", "text_search", "text_search_exact",
+  "nicklist_visible_count", "nicklist_batch", "input",
+  "input_get_unknown_commands", "input_get_empty", "input_size",
+  "input_length", "input_pos", "input_1st_display", "num_history",
+  "text_search", "text_search_exact",
   "text_search_regex", "text_search_where", "text_search_found",
   NULL
 };
@@ -112,10 +113,11 @@ char *gui_buffer_properties_set[] =
 { "hotlist", "unread", "display", "hidden", "print_hooks_enabled", "day_change",
   "clear", "filter", "number", "name", "short_name", "type", "notify", "title",
   "time_for_each_line", "nicklist", "nicklist_case_sensitive",
-  "nicklist_display_groups", "highlight_words", "highlight_words_add",
-  "highlight_words_del", "highlight_regex", "highlight_tags_restrict",
-  "highlight_tags", "hotlist_max_level_nicks", "hotlist_max_level_nicks_add",
-  "hotlist_max_level_nicks_del", "input", "input_pos",
+  "nicklist_display_groups", "nicklist_batch", "highlight_words",
+  "highlight_words_add", "highlight_words_del", "highlight_regex",
+  "highlight_tags_restrict", "highlight_tags", "hotlist_max_level_nicks",
+  "hotlist_max_level_nicks_add", "hotlist_max_level_nicks_del", "input",
+  "input_pos",
   "input_get_unknown_commands", "input_get_empty",
   NULL
 };
@@ -198,6 +200,9 @@ gui_buffer_build_full_name (struct t_gui_buffer *buffer)
         snprintf (buffer->full_name, length, "%s.%s",
                   gui_buffer_get_plugin_name (buffer), buffer->name);
     }
+
+    /* filters matching buffer name must be searched again */
+    buffer->filters_version = -1;
 }
 
 /*
@@ -677,6 +682,8 @@ gui_buffer_new (struct t_weechat_plugin *plugin,
     new_buffer->day_change = 1;
     new_buffer->clear = 1;
     new_buffer->filter = 1;
+    new_buffer->filters = NULL;
+    new_buffer->filters_version = -1;
 
     /* close callback */
     new_buffer->close_callback = close_callback;
@@ -693,6 +700,7 @@ gui_buffer_new (struct t_weechat_plugin *plugin,
     new_buffer->lines = new_buffer->own_lines;
     new_buffer->time_for_each_line = 1;
     new_buffer->chat_refresh_needed = 2;
+    new_buffer->chat_refresh_lines_added = 0;
 
     /* nicklist */
     new_buffer->nicklist = 0;
@@ -704,7 +712,19 @@ gui_buffer_new (struct t_weechat_plugin *plugin,
     new_buffer->nicklist_groups_count = 0;
     new_buffer->nicklist_nicks_count = 0;
     new_buffer->nicklist_visible_count = 0;
+    new_buffer->nicklist_batch = 0;
+    new_buffer->nicklist_nicks_index = hashtable_new (
+        32,
+        WEECHAT_HASHTABLE_STRING,
+        WEECHAT_HASHTABLE_POINTER,
+        NULL, NULL);
+    new_buffer->nicklist_groups_index = hashtable_new (
+        32,
+        WEECHAT_HASHTABLE_STRING,
+        WEECHAT_HASHTABLE_POINTER,
+        NULL, NULL);
     new_buffer->nickcmp_callback = NULL;
+    new_buffer->nickcmp_key_callback = NULL;
     new_buffer->nickcmp_callback_pointer = NULL;
     new_buffer->nickcmp_callback_data = NULL;
     gui_nicklist_add_group (new_buffer, NULL, "root", NULL, 0);
@@ -754,14 +774,18 @@ gui_buffer_new (struct t_weechat_plugin *plugin,
 
     /* highlight */
     new_buffer->highlight_words = NULL;
+    new_buffer->highlight_words_compiled = NULL;
+    new_buffer->highlight_global_compiled = NULL;
     new_buffer->highlight_regex = NULL;
     new_buffer->highlight_regex_compiled = NULL;
     new_buffer->highlight_tags_restrict = NULL;
     new_buffer->highlight_tags_restrict_count = 0;
     new_buffer->highlight_tags_restrict_array = NULL;
+    new_buffer->highlight_tags_restrict_match = NULL;
     new_buffer->highlight_tags = NULL;
     new_buffer->highlight_tags_count = 0;
     new_buffer->highlight_tags_array = NULL;
+    new_buffer->highlight_tags_match = NULL;
 
     /* hotlist */
     new_buffer->hotlist = NULL;
@@ -1143,6 +1167,8 @@ gui_buffer_get_integer (struct t_gui_buffer *buffer, const char *property)
         return buffer->nicklist_nicks_count;
     else if (string_strcasecmp (property, "nicklist_visible_count") == 0)
         return buffer->nicklist_visible_count;
+    else if (string_strcasecmp (property, "nicklist_batch") == 0)
+        return buffer->nicklist_batch;
     else if (string_strcasecmp (property, "input") == 0)
         return buffer->input;
     else if (string_strcasecmp (property, "input_get_unknown_commands") == 0)
@@ -1254,6 +1280,22 @@ gui_buffer_ask_chat_refresh (struct t_gui_buffer *buffer, int refresh)
         buffer->chat_refresh_needed = refresh;
 }
 
+/*
+ * Sets flag "chat_refresh_lines_added": lines have been added at the end of
+ * buffer, so only these lines have to be drawn in windows displaying the
+ * bottom of buffer (a full refresh is done anyway if it was asked with
+ * function gui_buffer_ask_chat_refresh).
+ */
+
+void
+gui_buffer_ask_chat_refresh_lines_added (struct t_gui_buffer *buffer)
+{
+    if (!buffer)
+        return;
+
+    buffer->chat_refresh_lines_added = 1;
+}
+
 /*
  * Sets name for a buffer.
  */
@@ -1269,6 +1311,10 @@ gui_buffer_set_name (struct t_gui_buffer *buffer, const char *name)
     buffer->name = strdup (name);
     gui_buffer_build_full_name (buffer);
 
+    /* apply filters matching the new name on lines */
+    if (buffer->own_lines && buffer->own_lines->first_line)
+        gui_filter_buffer (buffer, NULL);
+
     gui_buffer_local_var_add (buffer, "name", name);
 
     (void) hook_signal_send ("buffer_renamed",
@@ -1294,7 +1340,10 @@ gui_buffer_set_short_name (struct t_gui_buffer *buffer, const char *short_name)
         strdup (short_name) : NULL;
 
     if (buffer->mixed_lines)
+    {
         buffer->mixed_lines->buffer_max_length_refresh = 1;
+        gui_chat_rows_invalidate ();
+    }
     gui_buffer_ask_chat_refresh (buffer, 1);
 
     (void) hook_signal_send ("buffer_renamed",
@@ -1401,6 +1450,28 @@ gui_buffer_set_nicklist_display_groups (struct t_gui_buffer *buffer,
     gui_window_ask_refresh (1);
 }
 
+/*
+ * Sets flag "nicklist_batch" for a buffer: when the flag is set, nicks added
+ * are not sorted and no signal is sent for each nick; when the flag is reset,
+ * nicks are sorted and a single signal is sent for all nicks added.
+ */
+
+void
+gui_buffer_set_nicklist_batch (struct t_gui_buffer *buffer, int batch)
+{
+    if (!buffer)
+        return;
+
+    batch = (batch) ? 1 : 0;
+    if (batch == buffer->nicklist_batch)
+        return;
+
+    buffer->nicklist_batch = batch;
+
+    if (!batch)
+        gui_nicklist_end_batch (buffer);
+}
+
 /*
  * Sets highlight words for a buffer.
  */
@@ -1624,6 +1695,11 @@ gui_buffer_set_highlight_tags_restrict (struct t_gui_buffer *buffer,
         free (buffer->highlight_tags_restrict);
         buffer->highlight_tags_restrict = NULL;
     }
+    if (buffer->highlight_tags_restrict_match)
+    {
+        gui_line_tags_match_free (buffer->highlight_tags_restrict_match);
+        buffer->highlight_tags_restrict_match = NULL;
+    }
     if (buffer->highlight_tags_restrict_array)
     {
         string_free_split_tags (buffer->highlight_tags_restrict_array);
@@ -1641,6 +1717,9 @@ gui_buffer_set_highlight_tags_restrict (struct t_gui_buffer *buffer,
     buffer->highlight_tags_restrict_array = string_split_tags (
         buffer->highlight_tags_restrict,
         &buffer->highlight_tags_restrict_count);
+    buffer->highlight_tags_restrict_match = gui_line_tags_match_new (
+        buffer->highlight_tags_restrict_count,
+        buffer->highlight_tags_restrict_array);
 }
 
 /*
@@ -1659,6 +1738,11 @@ gui_buffer_set_highlight_tags (struct t_gui_buffer *buffer,
         free (buffer->highlight_tags);
         buffer->highlight_tags = NULL;
     }
+    if (buffer->highlight_tags_match)
+    {
+        gui_line_tags_match_free (buffer->highlight_tags_match);
+        buffer->highlight_tags_match = NULL;
+    }
     if (buffer->highlight_tags_array)
     {
         string_free_split_tags (buffer->highlight_tags_array);
@@ -1676,6 +1760,9 @@ gui_buffer_set_highlight_tags (struct t_gui_buffer *buffer,
     buffer->highlight_tags_array = string_split_tags (
         buffer->highlight_tags,
         &buffer->highlight_tags_count);
+    buffer->highlight_tags_match = gui_line_tags_match_new (
+        buffer->highlight_tags_count,
+        buffer->highlight_tags_array);
 }
 
 /*
@@ -2009,6 +2096,13 @@ gui_buffer_set (struct t_gui_buffer *buffer, const char *property,
         if (error && !error[0])
             gui_buffer_set_nicklist_display_groups (buffer, number);
     }
+    else if (string_strcasecmp (property, "nicklist_batch") == 0)
+    {
+        error = NULL;
+        number = strtol (value, &error, 10);
+        if (error && !error[0])
+            gui_buffer_set_nicklist_batch (buffer, number);
+    }
     else if (string_strcasecmp (property, "highlight_words") == 0)
     {
         gui_buffer_set_highlight_words (buffer, value);
@@ -2126,6 +2220,11 @@ gui_buffer_set_pointer (struct t_gui_buffer *buffer, const char *property,
     {
         buffer->nickcmp_callback = pointer;
     }
+    else if (string_strcasecmp (property, "nickcmp_key_callback") == 0)
+    {
+        buffer->nickcmp_key_callback = pointer;
+        gui_nicklist_nick_index_build (buffer);
+    }
     else if (string_strcasecmp (property, "nickcmp_callback_pointer") == 0)
     {
         buffer->nickcmp_callback_pointer = pointer;
@@ -2781,6 +2880,12 @@ gui_buffer_close (struct t_gui_buffer *buffer)
         gui_completion_free (buffer->completion);
     gui_nicklist_remove_all (buffer);
     gui_nicklist_remove_group (buffer, buffer->nicklist_root);
+    if (buffer->nicklist_nicks_index)
+        hashtable_free (buffer->nicklist_nicks_index);
+    if (buffer->nicklist_groups_index)
+        hashtable_free (buffer->nicklist_groups_index);
+    if (buffer->filters)
+        free (buffer->filters);
     if (buffer->hotlist_max_level_nicks)
         hashtable_free (buffer->hotlist_max_level_nicks);
     gui_key_free_all (&buffer->keys, &buffer->last_key,
@@ -2810,6 +2915,8 @@ gui_buffer_close (struct t_gui_buffer *buffer)
     }
     if (buffer->highlight_words)
         free (buffer->highlight_words);
+    string_highlight_free (buffer->highlight_words_compiled);
+    string_highlight_free (buffer->highlight_global_compiled);
     if (buffer->highlight_regex)
         free (buffer->highlight_regex);
     if (buffer->highlight_regex_compiled)
@@ -2821,10 +2928,12 @@ gui_buffer_close (struct t_gui_buffer *buffer)
         free (buffer->highlight_tags_restrict);
     if (buffer->highlight_tags_restrict_array)
         string_free_split_tags (buffer->highlight_tags_restrict_array);
+    gui_line_tags_match_free (buffer->highlight_tags_restrict_match);
     if (buffer->highlight_tags)
         free (buffer->highlight_tags);
     if (buffer->highlight_tags_array)
         string_free_split_tags (buffer->highlight_tags_array);
+    gui_line_tags_match_free (buffer->highlight_tags_match);
     if (buffer->input_callback_data)
         free (buffer->input_callback_data);
     if (buffer->close_callback_data)
@@ -4168,7 +4277,9 @@ gui_buffer_hdata_buffer_cb (const void *pointer, void *data,
         HDATA_VAR(struct t_gui_buffer, nicklist_groups_count, INTEGER, 0, NULL, NULL);
         HDATA_VAR(struct t_gui_buffer, nicklist_nicks_count, INTEGER, 0, NULL, NULL);
         HDATA_VAR(struct t_gui_buffer, nicklist_visible_count, INTEGER, 0, NULL, NULL);
+        HDATA_VAR(struct t_gui_buffer, nicklist_batch, INTEGER, 0, NULL, NULL);
         HDATA_VAR(struct t_gui_buffer, nickcmp_callback, POINTER, 0, NULL, NULL);
+        HDATA_VAR(struct t_gui_buffer, nickcmp_key_callback, POINTER, 0, NULL, NULL);
         HDATA_VAR(struct t_gui_buffer, nickcmp_callback_pointer, POINTER, 0, NULL, NULL);
         HDATA_VAR(struct t_gui_buffer, nickcmp_callback_data, POINTER, 0, NULL, NULL);
         HDATA_VAR(struct t_gui_buffer, input, INTEGER, 0, NULL, NULL);
@@ -4367,6 +4478,8 @@ gui_buffer_add_to_infolist (struct t_infolist *infolist,
         return 0;
     if (!infolist_new_var_integer (ptr_item, "nicklist_visible_count", buffer->nicklist_visible_count))
         return 0;
+    if (!infolist_new_var_integer (ptr_item, "nicklist_batch", buffer->nicklist_batch))
+        return 0;
     if (!infolist_new_var_string (ptr_item, "title", buffer->title))
         return 0;
     if (!infolist_new_var_integer (ptr_item, "input", buffer->input))
@@ -4559,6 +4672,8 @@ gui_buffer_print_log ()
         log_printf ("  day_change. . . . . . . : %d",    ptr_buffer->day_change);
         log_printf ("  clear . . . . . . . . . : %d",    ptr_buffer->clear);
         log_printf ("  filter. . . . . . . . . : %d",    ptr_buffer->filter);
+        log_printf ("  filters . . . . . . . . : 0x%lx", ptr_buffer->filters);
+        log_printf ("  filters_version . . . . : %ld",   ptr_buffer->filters_version);
         log_printf ("  close_callback. . . . . : 0x%lx", ptr_buffer->close_callback);
         log_printf ("  close_callback_pointer. : 0x%lx", ptr_buffer->close_callback_pointer);
         log_printf ("  close_callback_data . . : 0x%lx", ptr_buffer->close_callback_data);
@@ -4571,6 +4686,7 @@ gui_buffer_print_log ()
         log_printf ("  lines . . . . . . . . . : 0x%lx", ptr_buffer->lines);
         log_printf ("  time_for_each_line. . . : %d",    ptr_buffer->time_for_each_line);
         log_printf ("  chat_refresh_needed . . : %d",    ptr_buffer->chat_refresh_needed);
+        log_printf ("  chat_refresh_lines_added: %d",    ptr_buffer->chat_refresh_lines_added);
         log_printf ("  nicklist. . . . . . . . : %d",    ptr_buffer->nicklist);
         log_printf ("  nicklist_case_sensitive : %d",    ptr_buffer->nicklist_case_sensitive);
         log_printf ("  nicklist_root . . . . . : 0x%lx", ptr_buffer->nicklist_root);
@@ -4580,7 +4696,11 @@ gui_buffer_print_log ()
         log_printf ("  nicklist_groups_count . : %d",    ptr_buffer->nicklist_groups_count);
         log_printf ("  nicklist_nicks_count. . : %d",    ptr_buffer->nicklist_nicks_count);
         log_printf ("  nicklist_visible_count. : %d",    ptr_buffer->nicklist_visible_count);
+        log_printf ("  nicklist_batch. . . . . : %d",    ptr_buffer->nicklist_batch);
+        log_printf ("  nicklist_nicks_index. . : 0x%lx", ptr_buffer->nicklist_nicks_index);
+        log_printf ("  nicklist_groups_index . : 0x%lx", ptr_buffer->nicklist_groups_index);
         log_printf ("  nickcmp_callback. . . . : 0x%lx", ptr_buffer->nickcmp_callback);
+        log_printf ("  nickcmp_key_callback. . : 0x%lx", ptr_buffer->nickcmp_key_callback);
         log_printf ("  nickcmp_callback_pointer: 0x%lx", ptr_buffer->nickcmp_callback_pointer);
         log_printf ("  nickcmp_callback_data . : 0x%lx", ptr_buffer->nickcmp_callback_data);
         log_printf ("  input . . . . . . . . . : %d",    ptr_buffer->input);
@@ -4622,14 +4742,18 @@ gui_buffer_print_log ()
         log_printf ("  text_search_found . . . : %d",    ptr_buffer->text_search_found);
         log_printf ("  text_search_input . . . : '%s'",  ptr_buffer->text_search_input);
         log_printf ("  highlight_words . . . . : '%s'",  ptr_buffer->highlight_words);
+        log_printf ("  highlight_words_compiled: 0x%lx", ptr_buffer->highlight_words_compiled);
+        log_printf ("  highlight_global_compiled: 0x%lx", ptr_buffer->highlight_global_compiled);
         log_printf ("  highlight_regex . . . . : '%s'",  ptr_buffer->highlight_regex);
         log_printf ("  highlight_regex_compiled: 0x%lx", ptr_buffer->highlight_regex_compiled);
         log_printf ("  highlight_tags_restrict. . . : '%s'",  ptr_buffer->highlight_tags_restrict);
         log_printf ("  highlight_tags_restrict_count: %d",    ptr_buffer->highlight_tags_restrict_count);
         log_printf ("  highlight_tags_restrict_array: 0x%lx", ptr_buffer->highlight_tags_restrict_array);
+        log_printf ("  highlight_tags_restrict_match: 0x%lx", ptr_buffer->highlight_tags_restrict_match);
         log_printf ("  highlight_tags. . . . . : '%s'",  ptr_buffer->highlight_tags);
         log_printf ("  highlight_tags_count. . : %d",    ptr_buffer->highlight_tags_count);
         log_printf ("  highlight_tags_array. . : 0x%lx", ptr_buffer->highlight_tags_array);
+        log_printf ("  highlight_tags_match. . : 0x%lx", ptr_buffer->highlight_tags_match);
         log_printf ("  hotlist . . . . . . . . : 0x%lx", ptr_buffer->hotlist);
         log_printf ("  keys. . . . . . . . . . : 0x%lx", ptr_buffer->keys);
         log_printf ("  last_key. . . . . . . . : 0x%lx", ptr_buffer->last_key);
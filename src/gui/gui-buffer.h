@@ -25,7 +25,10 @@
 
 struct t_hashtable;
 struct t_gui_window;
+struct t_gui_filter;
 struct t_infolist;
+struct t_gui_line_tags_match;
+struct t_string_highlight;
 
 enum t_gui_buffer_type
 {
@@ -104,6 +107,10 @@ struct t_gui_buffer
     int clear;                         /* 1 if clear of buffer is allowed   */
                                        /* with command /buffer clear        */
     int filter;                        /* 1 if filters enabled for buffer   */
+    struct t_gui_filter **filters;     /* filters matching buffer name      */
+                                       /* (NULL-terminated array)           */
+    long filters_version;              /* version of filters used to build  */
+                                       /* list "filters" (-1 = rebuild it)  */
 
     /* close callback */
     int (*close_callback)(const void *pointer, /* called when buffer is     */
@@ -124,6 +131,9 @@ struct t_gui_buffer
     int time_for_each_line;            /* time is displayed for each line?  */
     int chat_refresh_needed;           /* refresh for chat is needed ?      */
                                        /* (1=refresh, 2=erase+refresh)      */
+    int chat_refresh_lines_added;      /* 1 if lines were added at end of   */
+                                       /* buffer (only new lines are drawn  */
+                                       /* if no other refresh is needed)    */
 
     /* nicklist */
     int nicklist;                      /* = 1 if nicklist is enabled        */
@@ -135,13 +145,22 @@ struct t_gui_buffer
     int nicklist_groups_count;         /* number of groups                  */
     int nicklist_nicks_count;          /* number of nicks                   */
     int nicklist_visible_count;        /* number of nicks/groups to display */
+    int nicklist_batch;                /* = 1 if nicks are added in a batch */
+                                       /* (not sorted, no signal sent)      */
+    struct t_hashtable *nicklist_nicks_index;  /* nicks by name              */
+    struct t_hashtable *nicklist_groups_index; /* groups by name (no digits)*/
     int (*nickcmp_callback)(const void *pointer, /* called to compare nicks */
                             void *data,          /* (search in nicklist)    */
                             struct t_gui_buffer *buffer,
                             const char *nick1,
                             const char *nick2);
-    const void *nickcmp_callback_pointer; /* pointer for callback           */
-    void *nickcmp_callback_data;       /* data for callback                 */
+    void (*nickcmp_key_callback)(const void *pointer, /* key of a nick    */
+                                 void *data,     /* in index of nicks       */
+                                 struct t_gui_buffer *buffer,
+                                 const char *nick,
+                                 char *key);
+    const void *nickcmp_callback_pointer; /* pointer for callbacks          */
+    void *nickcmp_callback_data;       /* data for callbacks                */
 
     /* input */
     int input;                         /* = 1 if input is enabled           */
@@ -190,14 +209,23 @@ struct t_gui_buffer
 
     /* highlight settings for buffer */
     char *highlight_words;             /* list of words to highlight        */
+    struct t_string_highlight *highlight_words_compiled;
+                                       /* compiled highlight words          */
+    struct t_string_highlight *highlight_global_compiled;
+                                       /* compiled words of option          */
+                                       /* weechat.look.highlight            */
     char *highlight_regex;             /* regex for highlight               */
     regex_t *highlight_regex_compiled; /* compiled regex                    */
     char *highlight_tags_restrict;     /* restrict highlight to these tags  */
     int highlight_tags_restrict_count; /* number of restricted tags         */
     char ***highlight_tags_restrict_array; /* array with restricted tags    */
+    struct t_gui_line_tags_match *highlight_tags_restrict_match;
+                                       /* compiled restricted tags          */
     char *highlight_tags;              /* force highlight on these tags     */
     int highlight_tags_count;          /* number of highlight tags          */
     char ***highlight_tags_array;      /* array with highlight tags         */
+    struct t_gui_line_tags_match *highlight_tags_match;
+                                       /* compiled highlight tags           */
 
     /* hotlist */
     struct t_gui_hotlist *hotlist;     /* hotlist entry for buffer          */
@@ -283,6 +311,7 @@ extern void *gui_buffer_get_pointer (struct t_gui_buffer *buffer,
                                      const char *property);
 extern void gui_buffer_ask_chat_refresh (struct t_gui_buffer *buffer,
                                          int refresh);
+extern void gui_buffer_ask_chat_refresh_lines_added (struct t_gui_buffer *buffer);
 extern void gui_buffer_set_title (struct t_gui_buffer *buffer,
                                   const char *new_title);
 extern void gui_buffer_set_highlight_words (struct t_gui_buffer *buffer,
@@ -55,8 +55,13 @@ int gui_chat_time_length = 0;    /* length of time for each line (in chars) */
 int gui_chat_mute = GUI_CHAT_MUTE_DISABLED;     /* mute mode                */
 struct t_gui_buffer *gui_chat_mute_buffer = NULL; /* mute buffer            */
 int gui_chat_display_tags = 0;                  /* display tags?            */
+int gui_chat_rows_version = 0;                  /* version of layout for    */
+                                                /* rows cached in lines     */
+int gui_chat_rows_last_id = 0;                  /* last id of rows layout   */
 char **gui_chat_lines_waiting_buffer = NULL;    /* lines waiting for core   */
                                                 /* buffer                   */
+time_t gui_chat_time_cache_date[GUI_CHAT_TIME_CACHE_SIZE]; /* cached dates  */
+char *gui_chat_time_cache_string[GUI_CHAT_TIME_CACHE_SIZE]; /* time strings */
 
 
 /*
@@ -494,6 +499,66 @@ gui_chat_get_time_string (time_t date)
     return strdup (text_time2);
 }
 
+/*
+ * Gets time string, for display (with colors), using a cache of time strings
+ * (one entry per second, indexed by date).
+ *
+ * Note: result must NOT be freed, and is valid until next call to this
+ * function.
+ */
+
+const char *
+gui_chat_get_time_string_cached (time_t date)
+{
+    int index;
+
+    if (date == 0)
+        return NULL;
+
+    index = (int)((unsigned long)date & (GUI_CHAT_TIME_CACHE_SIZE - 1));
+
+    if (gui_chat_time_cache_date[index] != date)
+    {
+        if (gui_chat_time_cache_string[index])
+            free (gui_chat_time_cache_string[index]);
+        gui_chat_time_cache_string[index] = gui_chat_get_time_string (date);
+        gui_chat_time_cache_date[index] = date;
+    }
+
+    return gui_chat_time_cache_string[index];
+}
+
+/*
+ * Frees all time strings in cache.
+ */
+
+void
+gui_chat_time_cache_free ()
+{
+    int i;
+
+    for (i = 0; i < GUI_CHAT_TIME_CACHE_SIZE; i++)
+    {
+        if (gui_chat_time_cache_string[i])
+        {
+            free (gui_chat_time_cache_string[i]);
+            gui_chat_time_cache_string[i] = NULL;
+        }
+        gui_chat_time_cache_date[i] = 0;
+    }
+}
+
+/*
+ * Invalidates the number of rows cached in lines for all windows (called
+ * when an option or a size used to display lines is changed).
+ */
+
+void
+gui_chat_rows_invalidate ()
+{
+    gui_chat_rows_version++;
+}
+
 /*
  * Calculates time length with a time format (format can include color codes
  * with format ${name}).
@@ -525,28 +590,15 @@ gui_chat_get_time_length ()
 
 /*
  * Changes time format for all lines of all buffers.
+ *
+ * Time strings are built when lines are displayed, so only the cache of time
+ * strings is cleared (lines with a custom time string are not changed).
  */
 
 void
 gui_chat_change_time_format ()
 {
-    struct t_gui_buffer *ptr_buffer;
-    struct t_gui_line *ptr_line;
-
-    for (ptr_buffer = gui_buffers; ptr_buffer;
-         ptr_buffer = ptr_buffer->next_buffer)
-    {
-        for (ptr_line = ptr_buffer->lines->first_line; ptr_line;
-             ptr_line = ptr_line->next_line)
-        {
-            if (ptr_line->data->date != 0)
-            {
-                if (ptr_line->data->str_time)
-                    free (ptr_line->data->str_time);
-                ptr_line->data->str_time = gui_chat_get_time_string (ptr_line->data->date);
-            }
-        }
-    }
+    gui_chat_time_cache_free ();
 }
 
 /*
@@ -818,22 +870,17 @@ gui_chat_printf_date_tags_internal (struct t_gui_buffer *buffer,
                 }
                 if ((new_line->data->date == 0) && display_time)
                     new_line->data->date = new_line->data->date_printed;
-                if (new_line->data->prefix)
-                    string_shared_free (new_line->data->prefix);
                 if (pos_prefix)
                 {
-                    new_line->data->prefix = (char *)string_shared_get (pos_prefix);
+                    gui_line_set_prefix (new_line->data, pos_prefix);
                 }
                 else
                 {
-                    new_line->data->prefix = (new_line->data->date != 0) ?
-                        (char *)string_shared_get ("") : NULL;
+                    gui_line_set_prefix (
+                        new_line->data,
+                        (new_line->data->date != 0) ? "" : NULL);
                 }
-                new_line->data->prefix_length = gui_chat_strlen_screen (
-                    new_line->data->prefix);
-                if (new_line->data->message)
-                    free (new_line->data->message);
-                new_line->data->message = strdup (ptr_msg);
+                gui_line_set_message (new_line->data, ptr_msg);
             }
         }
     }
@@ -845,7 +892,7 @@ gui_chat_printf_date_tags_internal (struct t_gui_buffer *buffer,
     if (new_line->data->buffer && new_line->data->buffer->print_hooks_enabled)
         hook_print_exec (new_line->data->buffer, new_line);
 
-    gui_buffer_ask_chat_refresh (new_line->data->buffer, 1);
+    gui_buffer_ask_chat_refresh_lines_added (new_line->data->buffer);
 
     if (string)
         free (string);
@@ -860,7 +907,7 @@ no_print:
     if (new_line)
     {
         gui_line_free_data (new_line);
-        free (new_line);
+        gui_line_release (new_line);
     }
     if (string)
         free (string);
@@ -1032,7 +1079,7 @@ gui_chat_printf_y (struct t_gui_buffer *buffer, int y, const char *message, ...)
     if (!new_line->data->buffer)
     {
         gui_line_free_data (new_line);
-        free (new_line);
+        gui_line_release (new_line);
         goto end;
     }
 
@@ -1071,7 +1118,7 @@ gui_chat_printf_y (struct t_gui_buffer *buffer, int y, const char *message, ...)
         {
             string_fprintf (stdout, "%s\n", new_line->data->message);
             gui_line_free_data (new_line);
-            free (new_line);
+            gui_line_release (new_line);
         }
     }
     else if (gui_init_ok)
@@ -1228,6 +1275,9 @@ gui_chat_end ()
         }
     }
 
+    /* free time strings */
+    gui_chat_time_cache_free ();
+
     /* free lines waiting for buffer (should always be NULL here) */
     if (gui_chat_lines_waiting_buffer)
     {
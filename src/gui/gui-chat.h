@@ -33,6 +33,9 @@ struct t_gui_line;
 
 #define GUI_CHAT_TAG_NO_HIGHLIGHT "no_highlight"
 
+/* number of time strings kept in cache (must be a power of 2) */
+#define GUI_CHAT_TIME_CACHE_SIZE 64
+
 #define GUI_CHAT_PREFIX_ERROR_DEFAULT   "=!="
 #define GUI_CHAT_PREFIX_NETWORK_DEFAULT "--"
 #define GUI_CHAT_PREFIX_ACTION_DEFAULT  " *"
@@ -63,6 +66,8 @@ extern int gui_chat_time_length;
 extern int gui_chat_mute;
 extern struct t_gui_buffer *gui_chat_mute_buffer;
 extern int gui_chat_display_tags;
+extern int gui_chat_rows_version;
+extern int gui_chat_rows_last_id;
 
 /* chat functions */
 
@@ -82,6 +87,9 @@ extern void gui_chat_get_word_info (struct t_gui_window *window,
                                     int *word_length_with_spaces,
                                     int *word_length);
 extern char *gui_chat_get_time_string (time_t date);
+extern const char *gui_chat_get_time_string_cached (time_t date);
+extern void gui_chat_time_cache_free ();
+extern void gui_chat_rows_invalidate ();
 extern int gui_chat_get_time_length ();
 extern void gui_chat_change_time_format ();
 extern char *gui_chat_build_string_prefix_message (struct t_gui_line *line);
@@ -108,5 +116,6 @@ extern const char *gui_chat_string_next_char (struct t_gui_window *window,
                                               int apply_style_inactive,
                                               int nick_offline);
 extern void gui_chat_draw (struct t_gui_buffer *buffer, int clear_chat);
+extern void gui_chat_draw_lines_added (struct t_gui_buffer *buffer);
 
 #endif /* WEECHAT_GUI_CHAT_H */
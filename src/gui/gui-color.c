@@ -557,6 +557,26 @@ gui_color_convert_rgb_to_term (int rgb, int limit)
     return best_color;
 }
 
+/*
+ * Searches first WeeChat color code in a string.
+ *
+ * Returns pointer to first color code in string, NULL if the string has no
+ * color codes.
+ */
+
+const char *
+gui_color_search_code (const char *string)
+{
+    static const char color_chars[] = {
+        GUI_COLOR_COLOR_CHAR, GUI_COLOR_SET_ATTR_CHAR,
+        GUI_COLOR_REMOVE_ATTR_CHAR, GUI_COLOR_RESET_CHAR, '\0' };
+
+    if (!string)
+        return NULL;
+
+    return strpbrk (string, color_chars);
+}
+
 /*
  * Removes WeeChat color codes from a message.
  *
@@ -572,19 +592,29 @@ char *
 gui_color_decode (const char *string, const char *replacement)
 {
     const unsigned char *ptr_string;
+    const char *ptr_code;
     unsigned char *out;
     int out_length, out_pos, length;
 
     if (!string)
         return NULL;
 
-    out_length = (strlen ((char *)string) * 2) + 1;
+    /* no color codes: return a copy of string */
+    ptr_code = gui_color_search_code (string);
+    if (!ptr_code)
+        return strdup (string);
+
+    /* each color code is removed or replaced by one char: string can not grow */
+    out_length = strlen ((char *)string) + 1;
     out = malloc (out_length);
     if (!out)
         return NULL;
 
-    ptr_string = (unsigned char *)string;
-    out_pos = 0;
+    /* copy chars before the first color code */
+    out_pos = ptr_code - string;
+    memcpy (out, string, out_pos);
+
+    ptr_string = (unsigned char *)ptr_code;
     while (ptr_string && ptr_string[0] && (out_pos < out_length - 1))
     {
         switch (ptr_string[0])
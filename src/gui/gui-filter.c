@@ -35,6 +35,7 @@
 #include "../core/wee-infolist.h"
 #include "../core/wee-log.h"
 #include "../core/wee-string.h"
+#include "../core/wee-worker.h"
 #include "../plugins/plugin.h"
 #include "gui-filter.h"
 #include "gui-buffer.h"
@@ -46,11 +47,100 @@
 struct t_gui_filter *gui_filters = NULL;           /* first filter          */
 struct t_gui_filter *last_gui_filter = NULL;       /* last filter           */
 int gui_filters_enabled = 1;                       /* filters enabled?      */
+long gui_filters_version = 0;                      /* changed when filters  */
+                                                   /* are added/removed     */
+struct t_gui_filter_job *gui_filter_jobs = NULL;   /* filter jobs running   */
 
 
+/*
+ * Gets filters matching name of a buffer (enabled or not): the list is built
+ * again if filters have been added/removed or if the buffer has been renamed.
+ *
+ * Returns NULL-terminated array of filters, NULL if no filters match the
+ * buffer (or if error).
+ */
+
+struct t_gui_filter **
+gui_filter_get_buffer_filters (struct t_gui_buffer *buffer)
+{
+    struct t_gui_filter *ptr_filter, **new_filters;
+    int count;
+
+    if (buffer->filters_version == gui_filters_version)
+        return buffer->filters;
+
+    if (buffer->filters)
+    {
+        free (buffer->filters);
+        buffer->filters = NULL;
+    }
+
+    count = 0;
+    for (ptr_filter = gui_filters; ptr_filter;
+         ptr_filter = ptr_filter->next_filter)
+    {
+        if (string_match_list (buffer->full_name,
+                               (const char **)ptr_filter->buffers, 0))
+        {
+            new_filters = realloc (buffer->filters,
+                                   (count + 2) * sizeof (*new_filters));
+            if (!new_filters)
+                break;
+            buffer->filters = new_filters;
+            buffer->filters[count++] = ptr_filter;
+            buffer->filters[count] = NULL;
+        }
+    }
+
+    buffer->filters_version = gui_filters_version;
+
+    return buffer->filters;
+}
+
+/*
+ * Checks if a filter hides a line (the buffer of line is not checked, and the
+ * filter is used even if it is disabled).
+ *
+ * Returns:
+ *   1: filter hides the line
+ *   0: filter does not hide the line
+ */
+
+int
+gui_filter_hides_line (struct t_gui_filter *filter,
+                       struct t_gui_line_data *line_data)
+{
+    int rc;
+
+    if ((strcmp (filter->tags, "*") != 0)
+        && !gui_line_match_tags_compiled (line_data, filter->tags_match))
+    {
+        return 0;
+    }
+
+    /* check line with regex */
+    rc = 1;
+    if (!filter->regex_prefix && !filter->regex_message)
+        rc = 0;
+    if (gui_line_match_regex (line_data,
+                              filter->regex_prefix,
+                              filter->regex_message))
+    {
+        rc = 0;
+    }
+    if (filter->regex && (filter->regex[0] == '!'))
+        rc ^= 1;
+
+    return (rc == 0) ? 1 : 0;
+}
+
 /*
  * Checks if a line must be displayed or not (filtered).
  *
+ * The number of filters hiding the line is stored in the line data (only if
+ * filters are enabled, globally and in buffer), so that a single filter can be
+ * applied later on the line (see function gui_filter_buffer_apply_filter).
+ *
  * Returns:
  *   1: line must be displayed (not filtered)
  *   0: line must be hidden (filtered)
@@ -59,8 +149,10 @@ int gui_filters_enabled = 1;                       /* filters enabled?      */
 int
 gui_filter_check_line (struct t_gui_line_data *line_data)
 {
-    struct t_gui_filter *ptr_filter;
-    int rc;
+    struct t_gui_filter **ptr_filters;
+    int i;
+
+    line_data->filters_hiding = 0;
 
     /* line is always displayed if filters are disabled (globally or in buffer) */
     if (!gui_filters_enabled || !line_data->buffer->filter)
@@ -69,58 +161,98 @@ gui_filter_check_line (struct t_gui_line_data *line_data)
     if (gui_line_has_tag_no_filter (line_data))
         return 1;
 
-    for (ptr_filter = gui_filters; ptr_filter;
-         ptr_filter = ptr_filter->next_filter)
+    ptr_filters = gui_filter_get_buffer_filters (line_data->buffer);
+    if (ptr_filters)
     {
-        if (ptr_filter->enabled)
+        for (i = 0; ptr_filters[i]; i++)
         {
-            /* check buffer */
-            if (string_match_list (line_data->buffer->full_name,
-                                   (const char **)ptr_filter->buffers,
-                                   0))
+            if (ptr_filters[i]->applied
+                && gui_filter_hides_line (ptr_filters[i], line_data))
             {
-                if ((strcmp (ptr_filter->tags, "*") == 0)
-                    || (gui_line_match_tags (line_data,
-                                             ptr_filter->tags_count,
-                                             ptr_filter->tags_array)))
-                {
-                    /* check line with regex */
-                    rc = 1;
-                    if (!ptr_filter->regex_prefix && !ptr_filter->regex_message)
-                        rc = 0;
-                    if (gui_line_match_regex (line_data,
-                                              ptr_filter->regex_prefix,
-                                              ptr_filter->regex_message))
-                    {
-                        rc = 0;
-                    }
-                    if (ptr_filter->regex && (ptr_filter->regex[0] == '!'))
-                        rc ^= 1;
-                    if (rc == 0)
-                        return 0;
-                }
+                line_data->filters_hiding++;
             }
         }
     }
 
-    /* no tag or regex matching, then line is displayed */
-    return 1;
+    /* line is displayed if no filter is hiding it */
+    return (line_data->filters_hiding == 0) ? 1 : 0;
 }
 
 /*
- * Filters a buffer, using message filters.
+ * Refreshes windows after lines of a buffer have been hidden or unhidden by
+ * filters.
+ */
+
+void
+gui_filter_buffer_lines_changed (struct t_gui_buffer *buffer)
+{
+    struct t_gui_window *ptr_window;
+
+    /* counters of lines displayed in blocks must be computed again */
+    gui_line_blocks_invalidate (buffer);
+
+    /* force a full refresh of buffer */
+    gui_buffer_ask_chat_refresh (buffer, 2);
+
+    /*
+     * check that a scroll in a window displaying this buffer is not on a
+     * hidden line (if this happens, use the previous displayed line as
+     * scroll)
+     */
+    for (ptr_window = gui_windows; ptr_window;
+         ptr_window = ptr_window->next_window)
+    {
+        if ((ptr_window->buffer == buffer)
+            && ptr_window->scroll->start_line
+            && !ptr_window->scroll->start_line->data->displayed)
+        {
+            ptr_window->scroll->start_line =
+                gui_line_get_prev_displayed (ptr_window->scroll->start_line);
+            ptr_window->scroll->start_line_pos = 0;
+        }
+    }
+}
+
+/*
+ * Adds a number of hidden lines (can be negative) in lines of a buffer, after
+ * some lines have been hidden or unhidden.
+ */
+
+void
+gui_filter_buffer_add_lines_hidden (struct t_gui_buffer *buffer,
+                                    int lines_hidden)
+{
+    buffer->own_lines->lines_hidden += lines_hidden;
+    if (buffer->own_lines->lines_hidden < 0)
+        buffer->own_lines->lines_hidden = 0;
+    if (buffer->mixed_lines)
+    {
+        buffer->mixed_lines->lines_hidden += lines_hidden;
+        if (buffer->mixed_lines->lines_hidden < 0)
+            buffer->mixed_lines->lines_hidden = 0;
+    }
+    buffer->lines->prefix_max_length_refresh = 1;
+
+    if (lines_hidden != 0)
+    {
+        (void) hook_signal_send ("buffer_lines_hidden",
+                                 WEECHAT_HOOK_SIGNAL_POINTER, buffer);
+    }
+}
+
+/*
+ * Filters a buffer in main thread, using message filters.
  *
  * If line_data is NULL, filters all lines in buffer.
  * If line_data is not NULL, filters only this line_data.
  */
 
 void
-gui_filter_buffer (struct t_gui_buffer *buffer,
-                   struct t_gui_line_data *line_data)
+gui_filter_buffer_sync (struct t_gui_buffer *buffer,
+                        struct t_gui_line_data *line_data)
 {
     struct t_gui_line *ptr_line;
     struct t_gui_line_data *ptr_line_data;
-    struct t_gui_window *ptr_window;
     int lines_changed, line_displayed, lines_hidden;
 
     lines_changed = 0;
@@ -160,48 +292,496 @@ gui_filter_buffer (struct t_gui_buffer *buffer,
     }
 
     if (lines_changed)
+        gui_filter_buffer_lines_changed (buffer);
+}
+
+/*
+ * Filters a chunk of lines of a filter job (called in a worker thread).
+ *
+ * Each chunk compiles its own copy of regex, so that worker threads do not
+ * share the same regex (regexec may lock the regex).
+ */
+
+void
+gui_filter_job_chunk_run (struct t_worker_job *worker_job, void *data)
+{
+    struct t_gui_filter_job_chunk *chunk;
+    struct t_gui_filter_job *job;
+    struct t_gui_filter *filters;
+    struct t_gui_line_data *ptr_line_data;
+    int i, j, count;
+
+    chunk = (struct t_gui_filter_job_chunk *)data;
+    job = chunk->job;
+
+    filters = malloc (job->filters_count * sizeof (*filters));
+    if (filters)
     {
-        /* force a full refresh of buffer */
-        gui_buffer_ask_chat_refresh (buffer, 2);
+        memcpy (filters, job->filters, job->filters_count * sizeof (*filters));
+        for (j = 0; j < job->filters_count; j++)
+        {
+            if (!gui_filter_regex_compile (job->filters[j].regex,
+                                           &filters[j].regex_prefix,
+                                           &filters[j].regex_message,
+                                           NULL, 0))
+            {
+                /* should not happen: use the regex of filter */
+                filters[j].regex_prefix = NULL;
+                filters[j].regex_message = NULL;
+            }
+        }
+    }
 
-        /*
-         * check that a scroll in a window displaying this buffer is not on a
-         * hidden line (if this happens, use the previous displayed line as
-         * scroll)
-         */
-        for (ptr_window = gui_windows; ptr_window;
-             ptr_window = ptr_window->next_window)
+    for (i = chunk->start; i < chunk->end; i++)
+    {
+        if (((i - chunk->start) % 256 == 0)
+            && worker_job_is_canceled (worker_job))
+        {
+            break;
+        }
+        ptr_line_data = job->lines[i];
+        count = 0;
+        if (!gui_line_has_tag_no_filter (ptr_line_data))
         {
-            if ((ptr_window->buffer == buffer)
-                && ptr_window->scroll->start_line
-                && !ptr_window->scroll->start_line->data->displayed)
+            for (j = 0; j < job->filters_count; j++)
             {
-                ptr_window->scroll->start_line =
-                    gui_line_get_prev_displayed (ptr_window->scroll->start_line);
-                ptr_window->scroll->start_line_pos = 0;
+                if (gui_filter_hides_line (
+                        (filters && (filters[j].regex_prefix
+                                     || filters[j].regex_message)) ?
+                        &filters[j] : &job->filters[j],
+                        ptr_line_data))
+                {
+                    count++;
+                }
             }
         }
+        job->filters_hiding[i] = count;
+    }
+
+    if (filters)
+    {
+        for (j = 0; j < job->filters_count; j++)
+        {
+            gui_filter_regex_free (filters[j].regex_prefix);
+            gui_filter_regex_free (filters[j].regex_message);
+        }
+        free (filters);
+    }
+}
+
+/*
+ * Frees a filter job: chunks still running are canceled and the data of lines
+ * removed from buffer during the job is freed.
+ */
+
+void
+gui_filter_job_free (struct t_gui_filter_job *job)
+{
+    int i;
+
+    for (i = 0; i < job->chunks_count; i++)
+    {
+        if (job->chunks[i].worker_job)
+            worker_job_cancel (job->chunks[i].worker_job);
+    }
+
+    for (i = 0; i < job->lines_removed; i++)
+    {
+        gui_line_data_free (job->lines[i]);
+    }
+
+    /* remove job from list */
+    if (job->prev_job)
+        (job->prev_job)->next_job = job->next_job;
+    if (job->next_job)
+        (job->next_job)->prev_job = job->prev_job;
+    if (gui_filter_jobs == job)
+        gui_filter_jobs = job->next_job;
+
+    free (job->lines);
+    free (job->filters_hiding);
+    free (job->filters);
+    free (job->chunks);
+    free (job);
+}
+
+/*
+ * Applies result of a filter job on lines of buffer.
+ */
+
+void
+gui_filter_job_apply (struct t_gui_filter_job *job)
+{
+    struct t_gui_line_data *ptr_line_data;
+    int i, lines_changed, line_displayed, lines_hidden;
+
+    lines_changed = 0;
+    lines_hidden = 0;
+
+    /* lines removed from buffer are skipped */
+    for (i = job->lines_removed; i < job->lines_count; i++)
+    {
+        ptr_line_data = job->lines[i];
+        ptr_line_data->filters_hiding = job->filters_hiding[i];
+        line_displayed = (ptr_line_data->filters_hiding == 0) ? 1 : 0;
+        if (ptr_line_data->displayed != line_displayed)
+        {
+            lines_changed = 1;
+            lines_hidden += (line_displayed) ? -1 : 1;
+            ptr_line_data->displayed = line_displayed;
+        }
+    }
+
+    if (lines_changed)
+    {
+        gui_filter_buffer_add_lines_hidden (job->buffer, lines_hidden);
+        gui_filter_buffer_lines_changed (job->buffer);
+    }
+}
+
+/*
+ * Callback called in main thread when a chunk of a filter job is done: when
+ * all chunks are done, the result is applied on lines of buffer.
+ */
+
+void
+gui_filter_job_chunk_done (struct t_worker_job *worker_job, void *data)
+{
+    struct t_gui_filter_job_chunk *chunk;
+    struct t_gui_filter_job *job;
+
+    /* make C compiler happy */
+    (void) worker_job;
+
+    chunk = (struct t_gui_filter_job_chunk *)data;
+    job = chunk->job;
+
+    chunk->worker_job = NULL;
+    job->chunks_running--;
+
+    if (job->chunks_running == 0)
+    {
+        gui_filter_job_apply (job);
+        gui_filter_job_free (job);
+    }
+}
+
+/*
+ * Searches filter job running for a buffer.
+ *
+ * Returns pointer to filter job found, NULL if not found.
+ */
+
+struct t_gui_filter_job *
+gui_filter_job_search (struct t_gui_buffer *buffer)
+{
+    struct t_gui_filter_job *ptr_job;
+
+    for (ptr_job = gui_filter_jobs; ptr_job; ptr_job = ptr_job->next_job)
+    {
+        if (ptr_job->buffer == buffer)
+            return ptr_job;
+    }
+
+    /* filter job not found */
+    return NULL;
+}
+
+/*
+ * Cancels filter jobs running for a buffer (if buffer is NULL, cancels all
+ * filter jobs).
+ *
+ * If filter_buffer is 1, the buffers are filtered again in main thread.
+ */
+
+void
+gui_filter_job_cancel_buffer (struct t_gui_buffer *buffer, int filter_buffer)
+{
+    struct t_gui_filter_job *ptr_job, *ptr_next_job;
+    struct t_gui_buffer *ptr_buffer;
+
+    ptr_job = gui_filter_jobs;
+    while (ptr_job)
+    {
+        ptr_next_job = ptr_job->next_job;
+
+        if (!buffer || (ptr_job->buffer == buffer))
+        {
+            ptr_buffer = ptr_job->buffer;
+            gui_filter_job_free (ptr_job);
+            if (filter_buffer)
+                gui_filter_buffer_sync (ptr_buffer, NULL);
+        }
+
+        ptr_job = ptr_next_job;
+    }
+}
+
+/*
+ * Checks if data of a line which is removed from a buffer is used by a filter
+ * job running for this buffer: in this case the line data is freed at the end
+ * of the job.
+ *
+ * Only the oldest line of the job can be kept (lines are usually removed from
+ * the beginning of buffer); if another line of the job is removed, the job is
+ * canceled and the buffer is filtered again in main thread.
+ *
+ * Returns:
+ *   1: line data is kept by a filter job (it must not be freed by caller)
+ *   0: line data is not used by a filter job
+ */
+
+int
+gui_filter_job_keep_line_data (struct t_gui_buffer *buffer,
+                               struct t_gui_line_data *line_data)
+{
+    struct t_gui_filter_job *ptr_job;
+
+    if (!gui_filter_jobs)
+        return 0;
+
+    ptr_job = gui_filter_job_search (buffer);
+    if (!ptr_job || (ptr_job->lines_removed >= ptr_job->lines_count))
+        return 0;
+
+    if (ptr_job->lines[ptr_job->lines_removed] == line_data)
+    {
+        ptr_job->lines_removed++;
+        return 1;
+    }
+
+    gui_filter_job_cancel_buffer (buffer, 1);
+
+    return 0;
+}
+
+/*
+ * Starts a filter job to filter all lines of a buffer in worker threads.
+ *
+ * Returns:
+ *   1: filter job started
+ *   0: filter job not started (buffer must be filtered in main thread)
+ */
+
+int
+gui_filter_job_start (struct t_gui_buffer *buffer)
+{
+    struct t_gui_filter_job *new_job;
+    struct t_gui_filter **ptr_filters;
+    struct t_gui_line *ptr_line;
+    int i, count, lines_per_chunk;
+
+    if ((worker_threads_count == 0) || !gui_filters_enabled || !buffer->filter
+        || (buffer->own_lines->lines_count < GUI_FILTER_JOB_MIN_LINES))
+    {
+        return 0;
+    }
+
+    /* count filters applied on buffer */
+    ptr_filters = gui_filter_get_buffer_filters (buffer);
+    count = 0;
+    for (i = 0; ptr_filters && ptr_filters[i]; i++)
+    {
+        if (ptr_filters[i]->applied)
+            count++;
+    }
+    if (count == 0)
+        return 0;
+
+    new_job = calloc (1, sizeof (*new_job));
+    if (!new_job)
+        return 0;
+
+    new_job->buffer = buffer;
+    new_job->lines_count = buffer->own_lines->lines_count;
+    new_job->lines = malloc (new_job->lines_count * sizeof (*new_job->lines));
+    new_job->filters_hiding = calloc (new_job->lines_count,
+                                      sizeof (*new_job->filters_hiding));
+    new_job->filters = malloc (count * sizeof (*new_job->filters));
+    new_job->chunks_count = worker_threads_count;
+    new_job->chunks = calloc (new_job->chunks_count,
+                              sizeof (*new_job->chunks));
+
+    /* add job in list (so that it is freed with other jobs if needed) */
+    new_job->prev_job = NULL;
+    new_job->next_job = gui_filter_jobs;
+    if (gui_filter_jobs)
+        gui_filter_jobs->prev_job = new_job;
+    gui_filter_jobs = new_job;
+
+    if (!new_job->lines || !new_job->filters_hiding || !new_job->filters
+        || !new_job->chunks)
+    {
+        gui_filter_job_free (new_job);
+        return 0;
+    }
+
+    for (i = 0; ptr_filters[i]; i++)
+    {
+        if (ptr_filters[i]->applied)
+        {
+            memcpy (&new_job->filters[new_job->filters_count],
+                    ptr_filters[i], sizeof (*new_job->filters));
+            new_job->filters_count++;
+        }
+    }
+
+    i = 0;
+    for (ptr_line = buffer->own_lines->first_line; ptr_line;
+         ptr_line = ptr_line->next_line)
+    {
+        new_job->lines[i++] = ptr_line->data;
+    }
+
+    lines_per_chunk = (new_job->lines_count + new_job->chunks_count - 1) /
+        new_job->chunks_count;
+    for (i = 0; i < new_job->chunks_count; i++)
+    {
+        new_job->chunks[i].job = new_job;
+        new_job->chunks[i].start = i * lines_per_chunk;
+        new_job->chunks[i].end = (i + 1) * lines_per_chunk;
+        if (new_job->chunks[i].end > new_job->lines_count)
+            new_job->chunks[i].end = new_job->lines_count;
+    }
+
+    new_job->chunks_running = new_job->chunks_count;
+    for (i = 0; i < new_job->chunks_count; i++)
+    {
+        new_job->chunks[i].worker_job = worker_job_submit (
+            &gui_filter_job_chunk_run,
+            &gui_filter_job_chunk_done,
+            &new_job->chunks[i]);
+        if (!new_job->chunks[i].worker_job)
+        {
+            gui_filter_job_free (new_job);
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/*
+ * Filters a buffer, using message filters.
+ *
+ * If line_data is NULL, filters all lines in buffer: if the buffer has a lot
+ * of lines and if worker threads are enabled, the lines are filtered in
+ * background (the result is applied when all lines have been filtered).
+ * If line_data is not NULL, filters only this line_data.
+ */
+
+void
+gui_filter_buffer (struct t_gui_buffer *buffer,
+                   struct t_gui_line_data *line_data)
+{
+    if (!line_data)
+    {
+        /* filter job running for this buffer is replaced by a new one */
+        if (gui_filter_jobs)
+            gui_filter_job_cancel_buffer (buffer, 0);
+        if (gui_filter_job_start (buffer))
+            return;
+    }
+
+    gui_filter_buffer_sync (buffer, line_data);
+}
+
+/*
+ * Applies a filter on lines of a buffer, after the filter has been enabled or
+ * disabled (according to the flag "applied" in filter): only this filter is
+ * checked on lines, other filters are not checked again.
+ */
+
+void
+gui_filter_buffer_apply_filter (struct t_gui_buffer *buffer,
+                                struct t_gui_filter *filter)
+{
+    struct t_gui_line *ptr_line;
+    int lines_changed, line_displayed, lines_hidden;
+
+    /* number of filters hiding lines is not computed if filters are disabled */
+    if (!gui_filters_enabled || !buffer->filter)
+        return;
+
+    /* a filter job is running: filter again all lines of buffer */
+    if (gui_filter_jobs && gui_filter_job_search (buffer))
+    {
+        gui_filter_buffer (buffer, NULL);
+        return;
+    }
+
+    lines_changed = 0;
+    lines_hidden = 0;
+
+    for (ptr_line = buffer->own_lines->first_line; ptr_line;
+         ptr_line = ptr_line->next_line)
+    {
+        if (gui_line_has_tag_no_filter (ptr_line->data)
+            || !gui_filter_hides_line (filter, ptr_line->data))
+        {
+            continue;
+        }
+
+        if (filter->applied)
+            ptr_line->data->filters_hiding++;
+        else if (ptr_line->data->filters_hiding > 0)
+            ptr_line->data->filters_hiding--;
+
+        line_displayed = (ptr_line->data->filters_hiding == 0) ? 1 : 0;
+        if (ptr_line->data->displayed != line_displayed)
+        {
+            lines_changed = 1;
+            lines_hidden += (line_displayed) ? -1 : 1;
+            ptr_line->data->displayed = line_displayed;
+        }
+    }
+
+    if (lines_changed)
+    {
+        gui_filter_buffer_add_lines_hidden (buffer, lines_hidden);
+        gui_filter_buffer_lines_changed (buffer);
     }
 }
 
 /*
  * Filters all buffers, using message filters.
  *
- * If filter is NULL, filters all buffers.
- * If filter is not NULL, filters only buffers matched by this filter.
+ * If filter is NULL, filters all buffers (all filters are checked on all
+ * lines).
+ * If filter is not NULL, applies only this filter on buffers matched by this
+ * filter (this must be called after the filter has been enabled or disabled).
  */
 
 void
 gui_filter_all_buffers (struct t_gui_filter *filter)
 {
     struct t_gui_buffer *ptr_buffer;
+    struct t_gui_filter *ptr_filter;
 
-    for (ptr_buffer = gui_buffers; ptr_buffer;
-         ptr_buffer = ptr_buffer->next_buffer)
+    if (filter)
+    {
+        if (filter->applied == filter->enabled)
+            return;
+        filter->applied = filter->enabled;
+        for (ptr_buffer = gui_buffers; ptr_buffer;
+             ptr_buffer = ptr_buffer->next_buffer)
+        {
+            if (string_match_list (ptr_buffer->full_name,
+                                   (const char **)filter->buffers, 0))
+            {
+                gui_filter_buffer_apply_filter (ptr_buffer, filter);
+            }
+        }
+    }
+    else
     {
-        if (!filter
-            || string_match_list (ptr_buffer->full_name,
-                                  (const char **)filter->buffers, 0))
+        for (ptr_filter = gui_filters; ptr_filter;
+             ptr_filter = ptr_filter->next_filter)
+        {
+            ptr_filter->applied = ptr_filter->enabled;
+        }
+        for (ptr_buffer = gui_buffers; ptr_buffer;
+             ptr_buffer = ptr_buffer->next_buffer)
         {
             gui_filter_buffer (ptr_buffer, NULL);
         }
@@ -278,35 +858,31 @@ gui_filter_new_error (const char *name, const char *error)
 }
 
 /*
- * Creates a new filter.
+ * Compiles regex of a filter: the regex for prefix and message are returned in
+ * regex_prefix and regex_message (they are set to NULL if there is no regex
+ * for prefix/message).
  *
- * Returns pointer to new filter, NULL if error.
+ * In case of error, the error is stored in "error" (if not NULL).
+ *
+ * Note: this function can be called by worker threads.
+ *
+ * Returns:
+ *   1: OK
+ *   0: error
  */
 
-struct t_gui_filter *
-gui_filter_new (int enabled, const char *name, const char *buffer_name,
-                const char *tags, const char *regex)
+int
+gui_filter_regex_compile (const char *regex,
+                          regex_t **regex_prefix, regex_t **regex_message,
+                          char *error, int error_size)
 {
-    struct t_gui_filter *new_filter;
     regex_t *regex1, *regex2;
-    char *pos_tab, *regex_prefix, buf[512], str_error[512];
+    char *pos_tab, *regex_prefix_str, buf[512];
     const char *ptr_start_regex, *pos_regex_message;
     int rc;
 
-    if (!name || !buffer_name || !tags || !regex)
-    {
-        gui_filter_new_error (name, _("not enough arguments"));
-        return NULL;
-    }
-
-    if (gui_filter_search_by_name (name))
-    {
-        gui_filter_new_error (name,
-                              _("a filter with same name already exists "
-                                "(choose another name or use option "
-                                "\"addreplace\" to overwrite it)"));
-        return NULL;
-    }
+    *regex_prefix = NULL;
+    *regex_message = NULL;
 
     ptr_start_regex = regex;
     if ((ptr_start_regex[0] == '!')
@@ -323,34 +899,36 @@ gui_filter_new (int enabled, const char *name, const char *buffer_name,
         pos_tab = strstr (ptr_start_regex, "\\t");
         if (pos_tab)
         {
-            regex_prefix = string_strndup (ptr_start_regex,
-                                           pos_tab - ptr_start_regex);
+            regex_prefix_str = string_strndup (ptr_start_regex,
+                                               pos_tab - ptr_start_regex);
             pos_regex_message = pos_tab + 2;
         }
         else
         {
-            regex_prefix = NULL;
+            regex_prefix_str = NULL;
             pos_regex_message = ptr_start_regex;
         }
 
-        if (regex_prefix && regex_prefix[0])
+        if (regex_prefix_str && regex_prefix_str[0])
         {
             regex1 = malloc (sizeof (*regex1));
             if (regex1)
             {
-                rc = string_regcomp (regex1, regex_prefix,
+                rc = string_regcomp (regex1, regex_prefix_str,
                                      REG_EXTENDED | REG_ICASE | REG_NOSUB);
                 if (rc != 0)
                 {
-                    regerror (rc, regex1, buf, sizeof (buf));
-                    snprintf (str_error, sizeof (str_error),
-                              /* TRANSLATORS: %s is the error returned by regerror */
-                              _("invalid regular expression (%s)"),
-                              buf);
-                    gui_filter_new_error (name, str_error);
-                    free (regex_prefix);
+                    if (error)
+                    {
+                        regerror (rc, regex1, buf, sizeof (buf));
+                        snprintf (error, error_size,
+                                  /* TRANSLATORS: %s is the error returned by regerror */
+                                  _("invalid regular expression (%s)"),
+                                  buf);
+                    }
+                    free (regex_prefix_str);
                     free (regex1);
-                    return NULL;
+                    return 0;
                 }
             }
         }
@@ -364,27 +942,81 @@ gui_filter_new (int enabled, const char *name, const char *buffer_name,
                                      REG_EXTENDED | REG_ICASE | REG_NOSUB);
                 if (rc != 0)
                 {
-                    regerror (rc, regex2, buf, sizeof (buf));
-                    snprintf (str_error, sizeof (str_error),
-                              /* TRANSLATORS: %s is the error returned by regerror */
-                              _("invalid regular expression (%s)"),
-                              buf);
-                    gui_filter_new_error (name, str_error);
-                    if (regex_prefix)
-                        free (regex_prefix);
-                    if (regex1)
+                    if (error)
                     {
-                        regfree (regex1);
-                        free (regex1);
+                        regerror (rc, regex2, buf, sizeof (buf));
+                        snprintf (error, error_size,
+                                  /* TRANSLATORS: %s is the error returned by regerror */
+                                  _("invalid regular expression (%s)"),
+                                  buf);
                     }
+                    if (regex_prefix_str)
+                        free (regex_prefix_str);
+                    gui_filter_regex_free (regex1);
                     free (regex2);
-                    return NULL;
+                    return 0;
                 }
             }
         }
 
-        if (regex_prefix)
-            free (regex_prefix);
+        if (regex_prefix_str)
+            free (regex_prefix_str);
+    }
+
+    *regex_prefix = regex1;
+    *regex_message = regex2;
+
+    return 1;
+}
+
+/*
+ * Frees a regex compiled by function gui_filter_regex_compile.
+ */
+
+void
+gui_filter_regex_free (regex_t *regex)
+{
+    if (!regex)
+        return;
+
+    regfree (regex);
+    free (regex);
+}
+
+/*
+ * Creates a new filter.
+ *
+ * Returns pointer to new filter, NULL if error.
+ */
+
+struct t_gui_filter *
+gui_filter_new (int enabled, const char *name, const char *buffer_name,
+                const char *tags, const char *regex)
+{
+    struct t_gui_filter *new_filter;
+    regex_t *regex1, *regex2;
+    char str_error[512];
+
+    if (!name || !buffer_name || !tags || !regex)
+    {
+        gui_filter_new_error (name, _("not enough arguments"));
+        return NULL;
+    }
+
+    if (gui_filter_search_by_name (name))
+    {
+        gui_filter_new_error (name,
+                              _("a filter with same name already exists "
+                                "(choose another name or use option "
+                                "\"addreplace\" to overwrite it)"));
+        return NULL;
+    }
+
+    if (!gui_filter_regex_compile (regex, &regex1, &regex2,
+                                   str_error, sizeof (str_error)))
+    {
+        gui_filter_new_error (name, str_error);
+        return NULL;
     }
 
     /* create new filter */
@@ -401,9 +1033,12 @@ gui_filter_new (int enabled, const char *name, const char *buffer_name,
         new_filter->tags = (tags) ? strdup (tags) : NULL;
         new_filter->tags_array = string_split_tags (new_filter->tags,
                                                     &new_filter->tags_count);
+        new_filter->tags_match = gui_line_tags_match_new (
+            new_filter->tags_count, new_filter->tags_array);
         new_filter->regex = strdup (regex);
         new_filter->regex_prefix = regex1;
         new_filter->regex_message = regex2;
+        new_filter->applied = 0;
 
         /* add filter to filters list */
         new_filter->prev_filter = last_gui_filter;
@@ -414,6 +1049,8 @@ gui_filter_new (int enabled, const char *name, const char *buffer_name,
         last_gui_filter = new_filter;
         new_filter->next_filter = NULL;
 
+        gui_filters_version++;
+
         (void) hook_signal_send ("filter_added",
                                  WEECHAT_HOOK_SIGNAL_POINTER, new_filter);
     }
@@ -461,6 +1098,10 @@ gui_filter_free (struct t_gui_filter *filter)
     (void) hook_signal_send ("filter_removing",
                              WEECHAT_HOOK_SIGNAL_POINTER, filter);
 
+    /* filter jobs may use this filter */
+    if (gui_filter_jobs)
+        gui_filter_job_cancel_buffer (NULL, 1);
+
     /* free data */
     if (filter->name)
         free (filter->name);
@@ -472,6 +1113,7 @@ gui_filter_free (struct t_gui_filter *filter)
         free (filter->tags);
     if (filter->tags_array)
         string_free_split_tags (filter->tags_array);
+    gui_line_tags_match_free (filter->tags_match);
     if (filter->regex)
         free (filter->regex);
     if (filter->regex_prefix)
@@ -497,6 +1139,8 @@ gui_filter_free (struct t_gui_filter *filter)
 
     free (filter);
 
+    gui_filters_version++;
+
     (void) hook_signal_send ("filter_removed", WEECHAT_HOOK_SIGNAL_STRING, NULL);
 }
 
@@ -635,6 +1279,7 @@ gui_filter_print_log ()
         log_printf ("  regex. . . . . . . . . : '%s'",  ptr_filter->regex);
         log_printf ("  regex_prefix . . . . . : 0x%lx", ptr_filter->regex_prefix);
         log_printf ("  regex_message. . . . . : 0x%lx", ptr_filter->regex_message);
+        log_printf ("  applied. . . . . . . . : %d", ptr_filter->applied);
         log_printf ("  prev_filter. . . . . . : 0x%lx", ptr_filter->prev_filter);
         log_printf ("  next_filter. . . . . . : 0x%lx", ptr_filter->next_filter);
     }
@@ -24,9 +24,15 @@
 
 #define GUI_FILTER_TAG_NO_FILTER "no_filter"
 
+/* min number of lines in buffer to filter lines in worker threads */
+#define GUI_FILTER_JOB_MIN_LINES 4096
+
 /* filter structures */
 
+struct t_gui_buffer;
 struct t_gui_line_data;
+struct t_gui_line_tags_match;
+struct t_worker_job;
 
 struct t_gui_filter
 {
@@ -38,28 +44,77 @@ struct t_gui_filter
     char *tags;                        /* tags                              */
     int tags_count;                    /* number of tags                    */
     char ***tags_array;                /* array of tags                     */
+    struct t_gui_line_tags_match *tags_match; /* compiled tags              */
     char *regex;                       /* regex                             */
     regex_t *regex_prefix;             /* regex for line prefix             */
     regex_t *regex_message;            /* regex for line message            */
+    int applied;                       /* 1 if filter is counted in lines   */
+                                       /* (see "filters_hiding" in lines)   */
     struct t_gui_filter *prev_filter;  /* link to previous filter           */
     struct t_gui_filter *next_filter;  /* link to next filter               */
 };
 
+/* filter job: lines of a buffer filtered in worker threads */
+
+struct t_gui_filter_job_chunk
+{
+    struct t_gui_filter_job *job;      /* filter job                        */
+    int start;                         /* index of first line of chunk      */
+    int end;                           /* index of last line + 1            */
+    struct t_worker_job *worker_job;   /* worker job (NULL if done)         */
+};
+
+struct t_gui_filter_job
+{
+    struct t_gui_buffer *buffer;       /* buffer filtered                   */
+    int lines_count;                   /* number of lines to filter         */
+    struct t_gui_line_data **lines;    /* lines of buffer (when job started)*/
+    int *filters_hiding;               /* result: number of filters hiding  */
+                                       /* each line                         */
+    int lines_removed;                 /* number of lines removed from      */
+                                       /* buffer since the job started      */
+                                       /* (data is freed at end of job)     */
+    int filters_count;                 /* number of filters applied         */
+    struct t_gui_filter *filters;      /* copy of filters applied           */
+    int chunks_count;                  /* number of chunks (worker jobs)    */
+    int chunks_running;                /* number of chunks not yet done     */
+    struct t_gui_filter_job_chunk *chunks; /* chunks of lines               */
+    struct t_gui_filter_job *prev_job; /* link to previous filter job       */
+    struct t_gui_filter_job *next_job; /* link to next filter job           */
+};
+
 /* filter variables */
 
 extern struct t_gui_filter *gui_filters;
 extern struct t_gui_filter *last_gui_filter;
 extern int gui_filters_enabled;
+extern long gui_filters_version;
+extern struct t_gui_filter_job *gui_filter_jobs;
 
 /* filter functions */
 
+extern struct t_gui_filter **gui_filter_get_buffer_filters (struct t_gui_buffer *buffer);
+extern int gui_filter_hides_line (struct t_gui_filter *filter,
+                                  struct t_gui_line_data *line_data);
 extern int gui_filter_check_line (struct t_gui_line_data *line_data);
+extern void gui_filter_job_cancel_buffer (struct t_gui_buffer *buffer,
+                                          int filter_buffer);
+extern int gui_filter_job_keep_line_data (struct t_gui_buffer *buffer,
+                                          struct t_gui_line_data *line_data);
 extern void gui_filter_buffer (struct t_gui_buffer *buffer,
                                struct t_gui_line_data *line_data);
+extern void gui_filter_buffer_lines_changed (struct t_gui_buffer *buffer);
+extern void gui_filter_buffer_apply_filter (struct t_gui_buffer *buffer,
+                                            struct t_gui_filter *filter);
 extern void gui_filter_all_buffers (struct t_gui_filter *filter);
 extern void gui_filter_global_enable ();
 extern void gui_filter_global_disable ();
 extern struct t_gui_filter *gui_filter_search_by_name (const char *name);
+extern int gui_filter_regex_compile (const char *regex,
+                                     regex_t **regex_prefix,
+                                     regex_t **regex_message,
+                                     char *error, int error_size);
+extern void gui_filter_regex_free (regex_t *regex);
 extern struct t_gui_filter *gui_filter_new (int enabled,
                                             const char *name,
                                             const char *buffer_name,
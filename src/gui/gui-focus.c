@@ -143,8 +143,8 @@ struct t_hashtable *
 gui_focus_to_hashtable (struct t_gui_focus_info *focus_info, const char *key)
 {
     struct t_hashtable *hashtable;
-    char str_value[128], *str_time, *str_prefix, *str_tags, *str_message;
-    const char *nick;
+    char str_value[128], *str_time, *str_tags;
+    const char *str_prefix, *str_message, *nick;
 
     hashtable = hashtable_new (32,
                                WEECHAT_HASHTABLE_STRING,
@@ -197,10 +197,11 @@ gui_focus_to_hashtable (struct t_gui_focus_info *focus_info, const char *key)
     str_prefix = NULL;
     if (focus_info->chat_line)
     {
-        str_time = gui_color_decode (((focus_info->chat_line)->data)->str_time, NULL);
-        str_prefix = gui_color_decode (((focus_info->chat_line)->data)->prefix, NULL);
+        str_time = gui_color_decode (
+            gui_line_get_str_time ((focus_info->chat_line)->data), NULL);
+        str_prefix = ((focus_info->chat_line)->data)->prefix_no_color;
         str_tags = string_build_with_split_string ((const char **)((focus_info->chat_line)->data)->tags_array, ",");
-        str_message = gui_color_decode (((focus_info->chat_line)->data)->message, NULL);
+        str_message = ((focus_info->chat_line)->data)->message_no_color;
         nick = gui_line_get_nick_tag (focus_info->chat_line);
         HASHTABLE_SET_POINTER("_chat_line", focus_info->chat_line);
         HASHTABLE_SET_INT("_chat_line_x", focus_info->chat_line_x);
@@ -214,12 +215,8 @@ gui_focus_to_hashtable (struct t_gui_focus_info *focus_info, const char *key)
         HASHTABLE_SET_STR_NOT_NULL("_chat_line_message", str_message);
         if (str_time)
             free (str_time);
-        if (str_prefix)
-            free (str_prefix);
         if (str_tags)
             free (str_tags);
-        if (str_message)
-            free (str_message);
     }
     else
     {
@@ -35,6 +35,7 @@
 #include "../core/wee-hook.h"
 #include "../core/wee-infolist.h"
 #include "../core/wee-log.h"
+#include "../core/wee-slab.h"
 #include "../core/wee-string.h"
 #include "../plugins/plugin.h"
 #include "gui-line.h"
@@ -47,6 +48,17 @@
 #include "gui-window.h"
 
 
+struct t_slab *gui_line_slab_lines = NULL;      /* slab for lines           */
+struct t_slab *gui_line_slab_lines_data = NULL; /* slab for lines data      */
+
+char *gui_line_tag_flags[] =           /* tags with a flag (GUI_LINE_TAG_   */
+{ GUI_FILTER_TAG_NO_FILTER,            /* FLAG_XXX, in the same order)      */
+  GUI_CHAT_TAG_NO_HIGHLIGHT,
+  "notify_none", "notify_highlight", "notify_private", "notify_message",
+  NULL,
+};
+
+
 /*
  * Allocates structure "t_gui_lines" and initializes it.
  *
@@ -71,6 +83,10 @@ gui_lines_alloc ()
         new_lines->buffer_max_length_refresh = 0;
         new_lines->prefix_max_length = CONFIG_INTEGER(config_look_prefix_align_min);
         new_lines->prefix_max_length_refresh = 0;
+        new_lines->first_block = NULL;
+        new_lines->last_block = NULL;
+        new_lines->blocks_count = 0;
+        new_lines->blocks_refresh = 0;
     }
 
     return new_lines;
@@ -90,39 +106,728 @@ gui_lines_free (struct t_gui_lines *lines)
 }
 
 /*
- * Allocates array with tags in a line_data.
+ * Allocates a line (structure "t_gui_line"), in the slab of lines.
+ *
+ * Returns pointer to new line (not initialized), NULL if error.
+ */
+
+struct t_gui_line *
+gui_line_alloc ()
+{
+    if (!gui_line_slab_lines)
+    {
+        gui_line_slab_lines = slab_new ("lines", sizeof (struct t_gui_line));
+        if (!gui_line_slab_lines)
+            return NULL;
+    }
+
+    return slab_alloc (gui_line_slab_lines);
+}
+
+/*
+ * Releases a line allocated by function gui_line_alloc (line data is not
+ * freed, see function gui_line_free_data).
  */
 
 void
-gui_line_tags_alloc (struct t_gui_line_data *line_data, const char *tags)
+gui_line_release (struct t_gui_line *line)
 {
-    if (tags)
+    slab_release (line);
+}
+
+/*
+ * Invalidates counters in blocks of own lines and mixed lines of a buffer
+ * (they will be computed again on next use, see function
+ * gui_lines_blocks_refresh).
+ *
+ * This function must be called when flags of lines data used in counters
+ * (displayed, highlight) or dates of lines data are changed after lines have
+ * been added in a buffer.
+ */
+
+void
+gui_line_blocks_invalidate (struct t_gui_buffer *buffer)
+{
+    if (!buffer)
+        return;
+
+    if (buffer->own_lines)
+        buffer->own_lines->blocks_refresh = 1;
+    if (buffer->mixed_lines)
+        buffer->mixed_lines->blocks_refresh = 1;
+}
+
+/*
+ * Updates counters in a block for a line added in block (inc = 1) or
+ * removed from block (inc = -1).
+ */
+
+void
+gui_line_block_count_line (struct t_gui_line_block *block,
+                           struct t_gui_line *line, int inc)
+{
+    block->lines_count += inc;
+    if (line->data->displayed)
+        block->lines_displayed += inc;
+    if (line->data->date == 0)
+        block->lines_no_date += inc;
+    if (line->data->highlight)
+        block->lines_highlight += inc;
+    if ((inc > 0) && (line->data->date != 0))
+    {
+        if ((block->date_min == 0) || (line->data->date < block->date_min))
+            block->date_min = line->data->date;
+        if ((block->date_max == 0) || (line->data->date > block->date_max))
+            block->date_max = line->data->date;
+    }
+}
+
+/*
+ * Computes counters of a block with all its lines.
+ */
+
+void
+gui_line_block_count_all (struct t_gui_line_block *block)
+{
+    struct t_gui_line *ptr_line;
+
+    block->lines_count = 0;
+    block->lines_displayed = 0;
+    block->lines_no_date = 0;
+    block->lines_highlight = 0;
+    block->date_min = 0;
+    block->date_max = 0;
+
+    for (ptr_line = block->first_line; ptr_line;
+         ptr_line = ptr_line->next_line)
+    {
+        gui_line_block_count_line (block, ptr_line, 1);
+        if (ptr_line == block->last_line)
+            break;
+    }
+}
+
+/*
+ * Computes counters of all blocks in a "t_gui_lines" structure, if blocks
+ * have been invalidated since last computation.
+ */
+
+void
+gui_lines_blocks_refresh (struct t_gui_lines *lines)
+{
+    struct t_gui_line_block *ptr_block;
+
+    if (!lines || !lines->blocks_refresh)
+        return;
+
+    for (ptr_block = lines->first_block; ptr_block;
+         ptr_block = ptr_block->next_block)
+    {
+        gui_line_block_count_all (ptr_block);
+    }
+
+    lines->blocks_refresh = 0;
+}
+
+/*
+ * Creates a new block of lines after a block (or at beginning of blocks if
+ * prev_block is NULL).
+ *
+ * Returns pointer to new block, NULL if error.
+ */
+
+struct t_gui_line_block *
+gui_line_block_new (struct t_gui_lines *lines,
+                    struct t_gui_line_block *prev_block)
+{
+    struct t_gui_line_block *new_block;
+
+    new_block = malloc (sizeof (*new_block));
+    if (!new_block)
+        return NULL;
+
+    new_block->lines = lines;
+    new_block->first_line = NULL;
+    new_block->last_line = NULL;
+    new_block->lines_count = 0;
+    new_block->lines_displayed = 0;
+    new_block->lines_no_date = 0;
+    new_block->lines_highlight = 0;
+    new_block->date_min = 0;
+    new_block->date_max = 0;
+
+    new_block->prev_block = prev_block;
+    new_block->next_block = (prev_block) ?
+        prev_block->next_block : lines->first_block;
+    if (new_block->prev_block)
+        (new_block->prev_block)->next_block = new_block;
+    else
+        lines->first_block = new_block;
+    if (new_block->next_block)
+        (new_block->next_block)->prev_block = new_block;
+    else
+        lines->last_block = new_block;
+
+    lines->blocks_count++;
+
+    return new_block;
+}
+
+/*
+ * Frees a block of lines (the block must not contain lines any more).
+ */
+
+void
+gui_line_block_free (struct t_gui_lines *lines,
+                     struct t_gui_line_block *block)
+{
+    if (block->prev_block)
+        (block->prev_block)->next_block = block->next_block;
+    if (block->next_block)
+        (block->next_block)->prev_block = block->prev_block;
+    if (lines->first_block == block)
+        lines->first_block = block->next_block;
+    if (lines->last_block == block)
+        lines->last_block = block->prev_block;
+
+    lines->blocks_count--;
+
+    free (block);
+}
+
+/*
+ * Splits a block in two blocks with the same number of lines.
+ */
+
+void
+gui_line_block_split (struct t_gui_lines *lines,
+                      struct t_gui_line_block *block)
+{
+    struct t_gui_line_block *new_block;
+    struct t_gui_line *ptr_line;
+    int i;
+
+    new_block = gui_line_block_new (lines, block);
+    if (!new_block)
+        return;
+
+    ptr_line = block->first_line;
+    for (i = 0; i < block->lines_count / 2; i++)
+    {
+        ptr_line = ptr_line->next_line;
+    }
+
+    new_block->first_line = ptr_line;
+    new_block->last_line = block->last_line;
+    block->last_line = ptr_line->prev_line;
+
+    for (; ptr_line; ptr_line = ptr_line->next_line)
+    {
+        ptr_line->block = new_block;
+        if (ptr_line == new_block->last_line)
+            break;
+    }
+
+    /*
+     * count lines again in both blocks (the min/max dates of first block can
+     * not be updated when lines are removed from it)
+     */
+    gui_line_block_count_all (block);
+    gui_line_block_count_all (new_block);
+}
+
+/*
+ * Adds a line in blocks of a "t_gui_lines" structure (the line must already
+ * be linked with previous/next lines).
+ */
+
+void
+gui_line_block_add_line (struct t_gui_lines *lines, struct t_gui_line *line)
+{
+    struct t_gui_line_block *ptr_block;
+
+    line->block = NULL;
+
+    if (line->prev_line
+        && ((line->prev_line->block->lines_count < GUI_LINE_BLOCK_SIZE)
+            || (line->prev_line != line->prev_line->block->last_line)))
+    {
+        /* add line in block of previous line */
+        ptr_block = line->prev_line->block;
+        if (ptr_block->last_line == line->prev_line)
+            ptr_block->last_line = line;
+    }
+    else if (line->next_line
+             && (line->next_line->block->lines_count < GUI_LINE_BLOCK_SIZE))
+    {
+        /* add line at beginning of block of next line */
+        ptr_block = line->next_line->block;
+        ptr_block->first_line = line;
+    }
+    else
+    {
+        /* add line in a new block */
+        ptr_block = gui_line_block_new (
+            lines, (line->prev_line) ? line->prev_line->block : NULL);
+        if (!ptr_block)
+            return;
+        ptr_block->first_line = line;
+        ptr_block->last_line = line;
+    }
+
+    line->block = ptr_block;
+    gui_line_block_count_line (ptr_block, line, 1);
+
+    if (ptr_block->lines_count > GUI_LINE_BLOCK_SIZE * 2)
+        gui_line_block_split (lines, ptr_block);
+}
+
+/*
+ * Removes a line from blocks of a "t_gui_lines" structure (the line must
+ * still be linked with previous/next lines).
+ */
+
+void
+gui_line_block_remove_line (struct t_gui_lines *lines,
+                            struct t_gui_line *line)
+{
+    struct t_gui_line_block *ptr_block;
+
+    ptr_block = line->block;
+    if (!ptr_block)
+        return;
+
+    gui_line_block_count_line (ptr_block, line, -1);
+
+    if (ptr_block->lines_count <= 0)
+    {
+        gui_line_block_free (lines, ptr_block);
+    }
+    else
+    {
+        if (ptr_block->first_line == line)
+            ptr_block->first_line = line->next_line;
+        if (ptr_block->last_line == line)
+            ptr_block->last_line = line->prev_line;
+    }
+
+    line->block = NULL;
+}
+
+/*
+ * Returns number of lines displayed in a block (all lines if filters are
+ * disabled).
+ */
+
+int
+gui_line_block_displayed (struct t_gui_line_block *block)
+{
+    gui_lines_blocks_refresh (block->lines);
+
+    return (gui_filters_enabled) ?
+        block->lines_displayed : block->lines_count;
+}
+
+/*
+ * Gets the block which starts just after a line (direction > 0) or ends just
+ * before a line (direction < 0).
+ *
+ * Returns pointer to block found, NULL if the next/previous line is in the
+ * same block as line or if there is no next/previous line.
+ */
+
+struct t_gui_line_block *
+gui_line_get_adjacent_block (struct t_gui_line *line, int direction)
+{
+    struct t_gui_line *ptr_line;
+
+    if (!line)
+        return NULL;
+
+    ptr_line = (direction < 0) ? line->prev_line : line->next_line;
+    if (!ptr_line || !ptr_line->block || (ptr_line->block == line->block))
+        return NULL;
+
+    gui_lines_blocks_refresh (ptr_line->block->lines);
+
+    return ptr_line->block;
+}
+
+/*
+ * Allocates a line data (structure "t_gui_line_data"), in the slab of lines
+ * data.
+ *
+ * Returns pointer to new line data (not initialized), NULL if error.
+ */
+
+struct t_gui_line_data *
+gui_line_data_alloc ()
+{
+    if (!gui_line_slab_lines_data)
     {
-        line_data->tags_array = string_split_shared (tags, ",", 0, 0,
-                                                     &line_data->tags_count);
+        gui_line_slab_lines_data = slab_new ("lines_data",
+                                             sizeof (struct t_gui_line_data));
+        if (!gui_line_slab_lines_data)
+            return NULL;
+    }
+
+    return slab_alloc (gui_line_slab_lines_data);
+}
+
+/*
+ * Gets flag for a tag (case insensitive comparison, except for tags
+ * "no_filter" and "no_highlight" which are case sensitive).
+ *
+ * Returns flag (GUI_LINE_TAG_FLAG_XXX), 0 if the tag has no flag.
+ */
+
+int
+gui_line_tag_get_flag (const char *tag)
+{
+    int i, flag;
+
+    if (!tag)
+        return 0;
+
+    for (i = 0; gui_line_tag_flags[i]; i++)
+    {
+        flag = 1 << i;
+        if (flag & GUI_LINE_TAG_FLAGS_CASE)
+        {
+            if (strcmp (tag, gui_line_tag_flags[i]) == 0)
+                return flag;
+        }
+        else
+        {
+            if (string_strcasecmp (tag, gui_line_tag_flags[i]) == 0)
+                return flag;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Gets flag set in a line for a tag of this line: flag of the tag, or
+ * GUI_LINE_TAG_FLAG_NICK for a tag "nick_xxx", or GUI_LINE_TAG_FLAG_ACTION for
+ * a tag "xxx_action" (for example "irc_action").
+ *
+ * Returns flag (GUI_LINE_TAG_FLAG_XXX), 0 if the tag has no flag.
+ */
+
+int
+gui_line_tag_get_line_flag (const char *tag)
+{
+    int flag, length;
+
+    flag = gui_line_tag_get_flag (tag);
+    if (flag)
+        return flag;
+
+    if (strncmp (tag, "nick_", 5) == 0)
+        return GUI_LINE_TAG_FLAG_NICK;
+
+    length = strlen (tag);
+    if ((length >= 7) && (strcmp (tag + length - 7, "_action") == 0))
+        return GUI_LINE_TAG_FLAG_ACTION;
+
+    return 0;
+}
+
+/*
+ * Removes color codes from a string (prefix or message of a line).
+ *
+ * Returns the string itself if it has no color codes (nothing is allocated),
+ * otherwise a new string without colors (must be freed after use).
+ */
+
+char *
+gui_line_string_no_color (const char *string)
+{
+    if (!string)
+        return NULL;
+
+    return (gui_color_search_code (string)) ?
+        gui_color_decode (string, NULL) : (char *)string;
+}
+
+/*
+ * Stores message and tags of a line data in a single memory block: the array
+ * of tags (NULL-terminated) followed by the message.
+ *
+ * If there are no tags, the block contains only the message (and tags_array
+ * is NULL), so the block is always "tags_array" if not NULL, otherwise
+ * "message".
+ *
+ * Tags in "tags_array" (shared strings) are moved to the new block, and the
+ * previous block is freed; "message" and "tags_array" can point to the
+ * current block.
+ *
+ * The flags of tags (see function gui_line_tag_get_line_flag) are computed
+ * again if the tags have changed, and the message without colors is computed
+ * again if the message has changed.
+ */
+
+void
+gui_line_data_set_message_tags (struct t_gui_line_data *line_data,
+                                const char *message,
+                                int tags_count, char **tags_array)
+{
+    void *old_block, *new_block;
+    char **new_tags_array, *new_message, *message_no_color;
+    int i, size_tags, size_message;
+
+    old_block = (line_data->tags_array) ?
+        (void *)line_data->tags_array : (void *)line_data->message;
+
+    /*
+     * message without colors (if allocated) is kept only if the message
+     * is the same (only tags are changed)
+     */
+    message_no_color = (line_data->message_no_color != line_data->message) ?
+        line_data->message_no_color : NULL;
+    if (message_no_color && (message != line_data->message))
+    {
+        free (message_no_color);
+        message_no_color = NULL;
+    }
+
+    if (!tags_array)
+        tags_count = 0;
+    size_tags = (tags_count > 0) ?
+        (tags_count + 1) * (int)sizeof (*new_tags_array) : 0;
+    size_message = (message) ? strlen (message) + 1 : 0;
+
+    new_tags_array = NULL;
+    new_message = NULL;
+    new_block = (size_tags + size_message > 0) ?
+        malloc (size_tags + size_message) : NULL;
+    if (new_block)
+    {
+        if (size_tags > 0)
+        {
+            new_tags_array = (char **)new_block;
+            for (i = 0; i < tags_count; i++)
+            {
+                new_tags_array[i] = tags_array[i];
+            }
+            new_tags_array[tags_count] = NULL;
+        }
+        if (size_message > 0)
+        {
+            new_message = (char *)new_block + size_tags;
+            memcpy (new_message, message, size_message);
+        }
     }
     else
     {
-        line_data->tags_count = 0;
-        line_data->tags_array = NULL;
+        /* not enough memory: tags are lost */
+        for (i = 0; i < tags_count; i++)
+        {
+            string_shared_free (tags_array[i]);
+        }
+        tags_count = 0;
+    }
+
+    /* flags are computed again only if tags have changed */
+    if (!new_tags_array || (tags_array != line_data->tags_array))
+    {
+        line_data->tags_flags = 0;
+        for (i = 0; new_tags_array && (i < tags_count); i++)
+        {
+            line_data->tags_flags |= gui_line_tag_get_line_flag (
+                new_tags_array[i]);
+        }
     }
+
+    if (old_block)
+        free (old_block);
+
+    line_data->tags_count = (new_tags_array) ? tags_count : 0;
+    line_data->tags_array = new_tags_array;
+    line_data->message = new_message;
+    line_data->message_no_color = (message_no_color) ?
+        message_no_color : gui_line_string_no_color (new_message);
+    line_data->rows_id = 0;
+}
+
+/*
+ * Sets prefix in a line data: the prefix length on screen and the prefix
+ * without colors are computed.
+ */
+
+void
+gui_line_set_prefix (struct t_gui_line_data *line_data, const char *prefix)
+{
+    char *new_prefix, *new_prefix_no_color, *prefix_no_color;
+
+    if (!line_data)
+        return;
+
+    new_prefix = NULL;
+    new_prefix_no_color = NULL;
+    if (prefix)
+    {
+        new_prefix = (char *)string_shared_get (prefix);
+        prefix_no_color = gui_line_string_no_color (prefix);
+        if (prefix_no_color)
+        {
+            new_prefix_no_color = (char *)string_shared_get (prefix_no_color);
+            if (prefix_no_color != prefix)
+                free (prefix_no_color);
+        }
+    }
+
+    /* free old prefix after getting the new one (it can be the same) */
+    if (line_data->prefix)
+        string_shared_free (line_data->prefix);
+    if (line_data->prefix_no_color)
+        string_shared_free (line_data->prefix_no_color);
+
+    line_data->prefix = new_prefix;
+    line_data->prefix_length = (new_prefix) ?
+        gui_chat_strlen_screen (new_prefix) : 0;
+    line_data->prefix_no_color = new_prefix_no_color;
+    line_data->rows_id = 0;
+}
+
+/*
+ * Sets message in a line data (tags are kept).
+ */
+
+void
+gui_line_set_message (struct t_gui_line_data *line_data, const char *message)
+{
+    if (!line_data)
+        return;
+
+    gui_line_data_set_message_tags (line_data, message,
+                                    line_data->tags_count,
+                                    line_data->tags_array);
+}
+
+/*
+ * Sets message and tags (comma-separated list) in a line data (the line data
+ * must not have tags, they must be freed before with function
+ * gui_line_tags_free).
+ */
+
+void
+gui_line_data_set_message_tags_string (struct t_gui_line_data *line_data,
+                                       const char *message, const char *tags)
+{
+    char **tags_array;
+    int tags_count;
+
+    tags_array = NULL;
+    tags_count = 0;
+    if (tags)
+        tags_array = string_split_shared (tags, ",", 0, 0, &tags_count);
+
+    gui_line_data_set_message_tags (line_data, message,
+                                    tags_count, tags_array);
+
+    /* shared strings are now in line data, free only the array */
+    if (tags_array)
+        free (tags_array);
+}
+
+/*
+ * Gets time string of a line, for display (with colors).
+ *
+ * If the line has no custom time string, the time string is built with the
+ * date of line and option weechat.look.buffer_time_format (a cache is used,
+ * so the result is valid until next call to this function).
+ *
+ * Note: result must NOT be freed.
+ */
+
+const char *
+gui_line_get_str_time (struct t_gui_line_data *line_data)
+{
+    if (!line_data)
+        return NULL;
+
+    if (line_data->str_time)
+        return line_data->str_time;
+
+    return gui_chat_get_time_string_cached (line_data->date);
+}
+
+/*
+ * Sets a custom time string in a line data.
+ *
+ * If str_time is NULL or is the same as the default time string for the date
+ * of line, the custom time string is removed (and the default one is used).
+ */
+
+void
+gui_line_set_str_time (struct t_gui_line_data *line_data,
+                       const char *str_time)
+{
+    const char *ptr_default;
+
+    if (!line_data)
+        return;
+
+    line_data->rows_id = 0;
+
+    if (line_data->str_time)
+    {
+        free (line_data->str_time);
+        line_data->str_time = NULL;
+    }
+
+    if (!str_time)
+        return;
+
+    ptr_default = gui_chat_get_time_string_cached (line_data->date);
+    if (ptr_default && (strcmp (ptr_default, str_time) == 0))
+        return;
+    if (!ptr_default && !str_time[0])
+        return;
+
+    line_data->str_time = strdup (str_time);
+}
+
+/*
+ * Allocates array with tags in a line_data (the line data must not have
+ * tags, they must be freed before with function gui_line_tags_free).
+ *
+ * The tags are stored in the same memory block as the message, see function
+ * gui_line_data_set_message_tags.
+ */
+
+void
+gui_line_tags_alloc (struct t_gui_line_data *line_data, const char *tags)
+{
+    if (!line_data)
+        return;
+
+    gui_line_data_set_message_tags_string (line_data, line_data->message,
+                                           tags);
 }
 
 /*
- * Frees array with tags in a line_data.
+ * Frees array with tags in a line_data (the message is kept).
  */
 
 void
 gui_line_tags_free (struct t_gui_line_data *line_data)
 {
+    int i;
+
     if (!line_data)
         return;
 
     if (line_data->tags_array)
     {
-        string_free_split_shared (line_data->tags_array);
-        line_data->tags_count = 0;
-        line_data->tags_array = NULL;
+        for (i = 0; line_data->tags_array[i]; i++)
+        {
+            string_shared_free (line_data->tags_array[i]);
+        }
+        gui_line_data_set_message_tags (line_data, line_data->message,
+                                        0, NULL);
     }
 }
 
@@ -361,10 +1066,8 @@ gui_line_get_first_displayed (struct t_gui_buffer *buffer)
     struct t_gui_line *ptr_line;
 
     ptr_line = buffer->lines->first_line;
-    while (ptr_line && !gui_line_is_displayed (ptr_line))
-    {
-        ptr_line = ptr_line->next_line;
-    }
+    if (ptr_line && !gui_line_is_displayed (ptr_line))
+        ptr_line = gui_line_get_next_displayed (ptr_line);
 
     return ptr_line;
 }
@@ -381,10 +1084,8 @@ gui_line_get_last_displayed (struct t_gui_buffer *buffer)
     struct t_gui_line *ptr_line;
 
     ptr_line = buffer->lines->last_line;
-    while (ptr_line && !gui_line_is_displayed (ptr_line))
-    {
-        ptr_line = ptr_line->prev_line;
-    }
+    if (ptr_line && !gui_line_is_displayed (ptr_line))
+        ptr_line = gui_line_get_prev_displayed (ptr_line);
 
     return ptr_line;
 }
@@ -392,17 +1093,31 @@ gui_line_get_last_displayed (struct t_gui_buffer *buffer)
 /*
  * Gets previous line displayed.
  *
+ * Blocks of lines without any line displayed are skipped.
+ *
  * Returns pointer to previous line displayed, NULL if not found.
  */
 
 struct t_gui_line *
 gui_line_get_prev_displayed (struct t_gui_line *line)
 {
+    struct t_gui_line_block *ptr_block;
+
     if (line)
     {
+        while ((ptr_block = gui_line_get_adjacent_block (line, -1))
+               && (gui_line_block_displayed (ptr_block) == 0))
+        {
+            line = ptr_block->first_line;
+        }
         line = line->prev_line;
         while (line && !gui_line_is_displayed (line))
         {
+            while ((ptr_block = gui_line_get_adjacent_block (line, -1))
+                   && (gui_line_block_displayed (ptr_block) == 0))
+            {
+                line = ptr_block->first_line;
+            }
             line = line->prev_line;
         }
     }
@@ -412,23 +1127,97 @@ gui_line_get_prev_displayed (struct t_gui_line *line)
 /*
  * Gets next line displayed.
  *
+ * Blocks of lines without any line displayed are skipped.
+ *
  * Returns pointer to next line displayed, NULL if not found.
  */
 
 struct t_gui_line *
 gui_line_get_next_displayed (struct t_gui_line *line)
 {
+    struct t_gui_line_block *ptr_block;
+
     if (line)
     {
+        while ((ptr_block = gui_line_get_adjacent_block (line, 1))
+               && (gui_line_block_displayed (ptr_block) == 0))
+        {
+            line = ptr_block->last_line;
+        }
         line = line->next_line;
         while (line && !gui_line_is_displayed (line))
         {
+            while ((ptr_block = gui_line_get_adjacent_block (line, 1))
+                   && (gui_line_block_displayed (ptr_block) == 0))
+            {
+                line = ptr_block->last_line;
+            }
             line = line->next_line;
         }
     }
     return line;
 }
 
+/*
+ * Moves from a line to another line displayed, "count" lines displayed before
+ * (if count < 0) or after (if count > 0) this line.
+ *
+ * If only_with_date == 1, lines without date are skipped (they are not
+ * counted and can not be returned).
+ *
+ * Whole blocks of lines are skipped when the number of lines to move is
+ * greater than the number of lines displayed in block.
+ *
+ * Returns pointer to line found, NULL if beginning/end of lines is reached
+ * before moving "count" lines.
+ */
+
+struct t_gui_line *
+gui_line_move_displayed (struct t_gui_line *line, long count,
+                         int only_with_date)
+{
+    struct t_gui_line_block *ptr_block;
+    int direction, lines_in_block;
+
+    if (!line || (count == 0))
+        return line;
+
+    direction = (count < 0) ? -1 : 1;
+    if (count < 0)
+        count = -count;
+
+    while (line)
+    {
+        /* skip next blocks if the target line is not inside */
+        while ((ptr_block = gui_line_get_adjacent_block (line, direction)))
+        {
+            lines_in_block = gui_line_block_displayed (ptr_block);
+            if ((lines_in_block > 0)
+                && (only_with_date && (ptr_block->lines_no_date > 0)))
+            {
+                break;
+            }
+            if (lines_in_block >= count)
+                break;
+            count -= lines_in_block;
+            line = (direction < 0) ?
+                ptr_block->first_line : ptr_block->last_line;
+        }
+
+        line = (direction < 0) ? line->prev_line : line->next_line;
+        if (line
+            && gui_line_is_displayed (line)
+            && (!only_with_date || (line->data->date != 0)))
+        {
+            count--;
+            if (count == 0)
+                return line;
+        }
+    }
+
+    return NULL;
+}
+
 /*
  * Searches for text in a line.
  *
@@ -440,7 +1229,7 @@ gui_line_get_next_displayed (struct t_gui_line *line)
 int
 gui_line_search_text (struct t_gui_buffer *buffer, struct t_gui_line *line)
 {
-    char *prefix, *message;
+    const char *prefix, *message;
     int rc;
 
     if (!line || !line->data->message
@@ -454,7 +1243,7 @@ gui_line_search_text (struct t_gui_buffer *buffer, struct t_gui_line *line)
     if ((buffer->text_search_where & GUI_TEXT_SEARCH_IN_PREFIX)
         && line->data->prefix)
     {
-        prefix = gui_color_decode (line->data->prefix, NULL);
+        prefix = line->data->prefix_no_color;
         if (prefix)
         {
             if (buffer->text_search_regex)
@@ -475,13 +1264,12 @@ gui_line_search_text (struct t_gui_buffer *buffer, struct t_gui_line *line)
             {
                 rc = 1;
             }
-            free (prefix);
         }
     }
 
     if (!rc && (buffer->text_search_where & GUI_TEXT_SEARCH_IN_MESSAGE))
     {
-        message = gui_color_decode (line->data->message, NULL);
+        message = line->data->message_no_color;
         if (message)
         {
             if (buffer->text_search_regex)
@@ -502,7 +1290,6 @@ gui_line_search_text (struct t_gui_buffer *buffer, struct t_gui_line *line)
             {
                 rc = 1;
             }
-            free (message);
         }
     }
 
@@ -521,21 +1308,18 @@ int
 gui_line_match_regex (struct t_gui_line_data *line_data, regex_t *regex_prefix,
                       regex_t *regex_message)
 {
-    char *prefix, *message;
+    const char *prefix, *message;
     int match_prefix, match_message;
 
     if (!line_data || (!regex_prefix && !regex_message))
         return 0;
 
-    prefix = NULL;
-    message = NULL;
-
     match_prefix = 1;
     match_message = 1;
 
     if (line_data->prefix)
     {
-        prefix = gui_color_decode (line_data->prefix, NULL);
+        prefix = line_data->prefix_no_color;
         if (!prefix
             || (regex_prefix && (regexec (regex_prefix, prefix, 0, NULL, 0) != 0)))
             match_prefix = 0;
@@ -548,7 +1332,7 @@ gui_line_match_regex (struct t_gui_line_data *line_data, regex_t *regex_prefix,
 
     if (line_data->message)
     {
-        message = gui_color_decode (line_data->message, NULL);
+        message = line_data->message_no_color;
         if (!message
             || (regex_message && (regexec (regex_message, message, 0, NULL, 0) != 0)))
             match_message = 0;
@@ -559,11 +1343,6 @@ gui_line_match_regex (struct t_gui_line_data *line_data, regex_t *regex_prefix,
             match_message = 0;
     }
 
-    if (prefix)
-        free (prefix);
-    if (message)
-        free (message);
-
     return (match_prefix && match_message);
 }
 
@@ -578,22 +1357,203 @@ gui_line_match_regex (struct t_gui_line_data *line_data, regex_t *regex_prefix,
 
 int
 gui_line_has_tag_no_filter (struct t_gui_line_data *line_data)
+{
+    return (line_data->tags_flags & GUI_LINE_TAG_FLAG_NO_FILTER) ? 1 : 0;
+}
+
+/*
+ * Initializes a tag mask with a tag (which can start with "!" and contain
+ * wildcards).
+ *
+ * Note: the tag is not duplicated, it must be kept while the mask is used.
+ */
+
+void
+gui_line_tag_mask_init (struct t_gui_line_tag_mask *mask, const char *tag)
+{
+    mask->negated = 0;
+
+    /* check if tag is negated (prefixed with a '!') */
+    if ((tag[0] == '!') && tag[1])
+    {
+        tag++;
+        mask->negated = 1;
+    }
+
+    mask->tag = tag;
+    mask->any = (strcmp (tag, "*") == 0) ? 1 : 0;
+    mask->wildcard = (strchr (tag, '*')) ? 1 : 0;
+    mask->flag = (mask->wildcard) ? 0 : gui_line_tag_get_flag (tag);
+    /* tags in masks are case insensitive: compare strings for these tags */
+    if (mask->flag & GUI_LINE_TAG_FLAGS_CASE)
+        mask->flag = 0;
+    mask->last = 0;
+}
+
+/*
+ * Checks if a line has a tag matching a tag mask (the negation of mask is
+ * ignored).
+ *
+ * Returns:
+ *   1: line has a tag matching the mask
+ *   0: line has no tag matching the mask
+ */
+
+int
+gui_line_match_tag_mask (struct t_gui_line_data *line_data,
+                         struct t_gui_line_tag_mask *mask)
 {
     int i;
 
+    if (mask->any)
+        return 1;
+
+    if (mask->flag)
+        return (line_data->tags_flags & mask->flag) ? 1 : 0;
+
+    if (!mask->tag[0])
+        return 0;
+
     for (i = 0; i < line_data->tags_count; i++)
     {
-        if (strcmp (line_data->tags_array[i], GUI_FILTER_TAG_NO_FILTER) == 0)
-            return 1;
+        if (mask->wildcard)
+        {
+            if (string_match (line_data->tags_array[i], mask->tag, 0))
+                return 1;
+        }
+        else
+        {
+            if (string_strcasecmp (line_data->tags_array[i], mask->tag) == 0)
+                return 1;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Compiles tags to match in lines (format of tags is the one returned by
+ * function string_split_tags).
+ *
+ * Note: the tags are not duplicated, "tags_array" must be kept while the
+ * compiled tags are used.
+ *
+ * Returns pointer to compiled tags, NULL if error or if there are no tags.
+ *
+ * Note: result must be freed after use with function gui_line_tags_match_free.
+ */
+
+struct t_gui_line_tags_match *
+gui_line_tags_match_new (int tags_count, char ***tags_array)
+{
+    struct t_gui_line_tags_match *new_tags_match;
+    int i, j, count;
+
+    if (!tags_array || (tags_count <= 0))
+        return NULL;
+
+    count = 0;
+    for (i = 0; i < tags_count; i++)
+    {
+        for (j = 0; tags_array[i][j]; j++)
+        {
+            count++;
+        }
+    }
+    if (count == 0)
+        return NULL;
+
+    new_tags_match = malloc (sizeof (*new_tags_match));
+    if (!new_tags_match)
+        return NULL;
+    new_tags_match->masks = malloc (count * sizeof (*new_tags_match->masks));
+    if (!new_tags_match->masks)
+    {
+        free (new_tags_match);
+        return NULL;
+    }
+
+    count = 0;
+    for (i = 0; i < tags_count; i++)
+    {
+        for (j = 0; tags_array[i][j]; j++)
+        {
+            gui_line_tag_mask_init (&new_tags_match->masks[count],
+                                    tags_array[i][j]);
+            count++;
+        }
+        if (j > 0)
+            new_tags_match->masks[count - 1].last = 1;
+    }
+    new_tags_match->masks_count = count;
+
+    return new_tags_match;
+}
+
+/*
+ * Frees compiled tags.
+ */
+
+void
+gui_line_tags_match_free (struct t_gui_line_tags_match *tags_match)
+{
+    if (!tags_match)
+        return;
+
+    if (tags_match->masks)
+        free (tags_match->masks);
+
+    free (tags_match);
+}
+
+/*
+ * Checks if line matches compiled tags (see function gui_line_tags_match_new).
+ *
+ * Returns:
+ *   1: line matches tags
+ *   0: line does not match tags
+ */
+
+int
+gui_line_match_tags_compiled (struct t_gui_line_data *line_data,
+                              struct t_gui_line_tags_match *tags_match)
+{
+    struct t_gui_line_tag_mask *ptr_mask;
+    int i, match, tag_found;
+
+    if (!line_data || !tags_match)
+        return 0;
+
+    match = 1;
+    for (i = 0; i < tags_match->masks_count; i++)
+    {
+        ptr_mask = &tags_match->masks[i];
+        if (match)
+        {
+            tag_found = gui_line_match_tag_mask (line_data, ptr_mask);
+            if (tag_found && ptr_mask->negated)
+                return 0;
+            if (!tag_found && !ptr_mask->negated)
+                match = 0;
+        }
+        if (ptr_mask->last)
+        {
+            if (match)
+                return 1;
+            match = 1;
+        }
     }
 
-    /* tag not found, line may be filtered */
     return 0;
 }
 
 /*
  * Checks if line matches tags.
  *
+ * If the same tags are checked on many lines, it is faster to compile them
+ * with function gui_line_tags_match_new and use function
+ * gui_line_match_tags_compiled.
+ *
  * Returns:
  *   1: line matches tags
  *   0: line does not match tags
@@ -603,8 +1563,8 @@ int
 gui_line_match_tags (struct t_gui_line_data *line_data,
                      int tags_count, char ***tags_array)
 {
-    int i, j, k, match, tag_found, tag_negated;
-    const char *ptr_tag;
+    struct t_gui_line_tag_mask mask;
+    int i, j, match, tag_found;
 
     if (!line_data)
         return 0;
@@ -614,35 +1574,11 @@ gui_line_match_tags (struct t_gui_line_data *line_data,
         match = 1;
         for (j = 0; tags_array[i][j]; j++)
         {
-            ptr_tag = tags_array[i][j];
-            tag_found = 0;
-            tag_negated = 0;
-
-            /* check if tag is negated (prefixed with a '!') */
-            if ((ptr_tag[0] == '!') && ptr_tag[1])
-            {
-                ptr_tag++;
-                tag_negated = 1;
-            }
-
-            if (strcmp (ptr_tag, "*") == 0)
-            {
-                tag_found = 1;
-            }
-            else
-            {
-                for (k = 0; k < line_data->tags_count; k++)
-                {
-                    if (string_match (line_data->tags_array[k], ptr_tag, 0))
-                    {
-                        tag_found = 1;
-                        break;
-                    }
-                }
-            }
-            if (tag_found && tag_negated)
+            gui_line_tag_mask_init (&mask, tags_array[i][j]);
+            tag_found = gui_line_match_tag_mask (line_data, &mask);
+            if (tag_found && mask.negated)
                 return 0;
-            if ((!tag_found && !tag_negated) || (tag_found && tag_negated))
+            if (!tag_found && !mask.negated)
             {
                 match = 0;
                 break;
@@ -688,6 +1624,9 @@ gui_line_get_nick_tag (struct t_gui_line *line)
 {
     const char *tag;
 
+    if (!line || !(line->data->tags_flags & GUI_LINE_TAG_FLAG_NICK))
+        return NULL;
+
     tag = gui_line_search_tag_starting_with (line, "nick_");
     if (!tag)
         return NULL;
@@ -695,6 +1634,52 @@ gui_line_get_nick_tag (struct t_gui_line *line)
     return tag + 5;
 }
 
+/*
+ * Gets compiled highlight words for a buffer, after replacement of buffer
+ * local variables in words.
+ *
+ * The words are compiled again only if they have changed since last call
+ * (option or buffer property changed, or local variable changed), otherwise
+ * the compiled words stored in "compiled" are returned.
+ *
+ * Returns pointer to compiled highlight words, NULL if there are no words.
+ */
+
+struct t_string_highlight *
+gui_line_get_highlight_compiled (struct t_gui_buffer *buffer,
+                                 const char *highlight_words,
+                                 struct t_string_highlight **compiled)
+{
+    char *words;
+    const char *ptr_words;
+
+    if (!highlight_words || !highlight_words[0])
+    {
+        if (*compiled)
+        {
+            string_highlight_free (*compiled);
+            *compiled = NULL;
+        }
+        return NULL;
+    }
+
+    words = (strchr (highlight_words, '$')) ?
+        gui_buffer_string_replace_local_var (buffer, highlight_words) : NULL;
+    ptr_words = (words) ? words : highlight_words;
+
+    if (!*compiled
+        || (strcmp ((*compiled)->highlight_words, ptr_words) != 0))
+    {
+        string_highlight_free (*compiled);
+        *compiled = string_highlight_compile (ptr_words);
+    }
+
+    if (words)
+        free (words);
+
+    return *compiled;
+}
+
 /*
  * Checks if a line has highlight (with a string in global highlight or buffer
  * highlight).
@@ -707,9 +1692,8 @@ gui_line_get_nick_tag (struct t_gui_line *line)
 int
 gui_line_has_highlight (struct t_gui_line *line)
 {
-    int rc, i, no_highlight, action, length;
-    char *msg_no_color, *ptr_msg_no_color, *highlight_words;
-    const char *ptr_nick;
+    int rc, length, i;
+    const char *ptr_msg_no_color, *ptr_nick;
 
     /*
      * highlights are disabled on this buffer? (special value "-" means that
@@ -719,41 +1703,17 @@ gui_line_has_highlight (struct t_gui_line *line)
         && (strcmp (line->data->buffer->highlight_words, "-") == 0))
         return 0;
 
-    /*
-     * check if highlight is disabled for line; also check if the line is an
-     * action message (for example tag "irc_action") and get pointer on the nick
-     * (tag "nick_xxx"), these info will be used later (see below)
-     */
-    no_highlight = 0;
-    action = 0;
-    ptr_nick = NULL;
-    for (i = 0; i < line->data->tags_count; i++)
-    {
-        if (strcmp (line->data->tags_array[i], GUI_CHAT_TAG_NO_HIGHLIGHT) == 0)
-            no_highlight = 1;
-        else if (strncmp (line->data->tags_array[i], "nick_", 5) == 0)
-            ptr_nick = line->data->tags_array[i] + 5;
-        else
-        {
-            length = strlen (line->data->tags_array[i]);
-            if ((length >= 7)
-                && (strcmp (line->data->tags_array[i] + length - 7, "_action") == 0))
-            {
-                action = 1;
-            }
-        }
-    }
-    if (no_highlight)
+    /* check if highlight is disabled for line */
+    if (line->data->tags_flags & GUI_LINE_TAG_FLAG_NO_HIGHLIGHT)
         return 0;
 
     /*
      * check if highlight is forced by a tag
      * (with global option "weechat.look.highlight_tags")
      */
-    if (config_highlight_tags
-        && gui_line_match_tags (line->data,
-                                config_num_highlight_tags,
-                                config_highlight_tags))
+    if (config_highlight_tags_match
+        && gui_line_match_tags_compiled (line->data,
+                                         config_highlight_tags_match))
     {
         return 1;
     }
@@ -762,10 +1722,9 @@ gui_line_has_highlight (struct t_gui_line *line)
      * check if highlight is forced by a tag
      * (with buffer property "highlight_tags")
      */
-    if (line->data->buffer->highlight_tags
-        && gui_line_match_tags (line->data,
-                                line->data->buffer->highlight_tags_count,
-                                line->data->buffer->highlight_tags_array))
+    if (line->data->buffer->highlight_tags_match
+        && gui_line_match_tags_compiled (line->data,
+                                         line->data->buffer->highlight_tags_match))
     {
         return 1;
     }
@@ -774,26 +1733,38 @@ gui_line_has_highlight (struct t_gui_line *line)
      * check that line matches highlight tags, if any (if no tag is specified,
      * then any tag is allowed)
      */
-    if (line->data->buffer->highlight_tags_restrict_count > 0)
+    if (line->data->buffer->highlight_tags_restrict_match)
     {
-        if (!gui_line_match_tags (line->data,
-                                  line->data->buffer->highlight_tags_restrict_count,
-                                  line->data->buffer->highlight_tags_restrict_array))
+        if (!gui_line_match_tags_compiled (line->data,
+                                           line->data->buffer->highlight_tags_restrict_match))
             return 0;
     }
 
-    /* remove color codes from line message */
-    msg_no_color = gui_color_decode (line->data->message, NULL);
-    if (!msg_no_color)
+    /* message without color codes (computed when message is set) */
+    ptr_msg_no_color = line->data->message_no_color;
+    if (!ptr_msg_no_color)
         return 0;
-    ptr_msg_no_color = msg_no_color;
 
     /*
-     * if the line is an action message and that we know the nick, we skip
-     * the nick if it is at beginning of message (to not highlight an action
-     * from another user if his nick is in our highlight settings)
+     * if the line is an action message (for example tag "irc_action") and that
+     * we know the nick (tag "nick_xxx"), we skip the nick if it is at
+     * beginning of message (to not highlight an action from another user if
+     * his nick is in our highlight settings)
      */
-    if (action && ptr_nick)
+    ptr_nick = NULL;
+    if (line->data->tags_flags & GUI_LINE_TAG_FLAG_ACTION)
+    {
+        /* if there are many tags "nick_xxx", the last one is used */
+        for (i = line->data->tags_count - 1; i >= 0; i--)
+        {
+            if (strncmp (line->data->tags_array[i], "nick_", 5) == 0)
+            {
+                ptr_nick = line->data->tags_array[i] + 5;
+                break;
+            }
+        }
+    }
+    if (ptr_nick)
     {
         length = strlen (ptr_nick);
         if (strncmp (ptr_msg_no_color, ptr_nick, length) == 0)
@@ -813,23 +1784,21 @@ gui_line_has_highlight (struct t_gui_line *line)
      * there is highlight on line if one of buffer highlight words matches line
      * or one of global highlight words matches line
      */
-    highlight_words = gui_buffer_string_replace_local_var (line->data->buffer,
-                                                           line->data->buffer->highlight_words);
-    rc = string_has_highlight (ptr_msg_no_color,
-                               (highlight_words) ?
-                               highlight_words : line->data->buffer->highlight_words);
-    if (highlight_words)
-        free (highlight_words);
+    rc = string_has_highlight_compiled (
+        ptr_msg_no_color,
+        gui_line_get_highlight_compiled (
+            line->data->buffer,
+            line->data->buffer->highlight_words,
+            &line->data->buffer->highlight_words_compiled));
 
     if (!rc)
     {
-        highlight_words = gui_buffer_string_replace_local_var (line->data->buffer,
-                                                               CONFIG_STRING(config_look_highlight));
-        rc = string_has_highlight (ptr_msg_no_color,
-                                   (highlight_words) ?
-                                   highlight_words : CONFIG_STRING(config_look_highlight));
-        if (highlight_words)
-            free (highlight_words);
+        rc = string_has_highlight_compiled (
+            ptr_msg_no_color,
+            gui_line_get_highlight_compiled (
+                line->data->buffer,
+                CONFIG_STRING(config_look_highlight),
+                &line->data->buffer->highlight_global_compiled));
     }
 
     if (!rc && config_highlight_regex)
@@ -844,8 +1813,6 @@ gui_line_has_highlight (struct t_gui_line *line)
                                                   line->data->buffer->highlight_regex_compiled);
     }
 
-    free (msg_no_color);
-
     return rc;
 }
 
@@ -954,6 +1921,8 @@ gui_line_add_to_list (struct t_gui_lines *lines,
     line->next_line = NULL;
     lines->last_line = line;
 
+    gui_line_block_add_line (lines, line);
+
     /*
      * adjust "prefix_max_length" if this prefix length is > max
      * (only if the line is displayed
@@ -976,6 +1945,42 @@ gui_line_add_to_list (struct t_gui_lines *lines,
     lines->lines_count++;
 }
 
+/*
+ * Frees a line data.
+ */
+
+void
+gui_line_data_free (struct t_gui_line_data *line_data)
+{
+    int i;
+
+    if (line_data->str_time)
+        free (line_data->str_time);
+    if (line_data->message_no_color
+        && (line_data->message_no_color != line_data->message))
+    {
+        free (line_data->message_no_color);
+    }
+    if (line_data->tags_array)
+    {
+        for (i = 0; line_data->tags_array[i]; i++)
+        {
+            string_shared_free (line_data->tags_array[i]);
+        }
+        /* message is in the same memory block as tags */
+        free (line_data->tags_array);
+    }
+    else if (line_data->message)
+    {
+        free (line_data->message);
+    }
+    if (line_data->prefix)
+        string_shared_free (line_data->prefix);
+    if (line_data->prefix_no_color)
+        string_shared_free (line_data->prefix_no_color);
+    slab_release (line_data);
+}
+
 /*
  * Frees data in a line.
  */
@@ -983,14 +1988,7 @@ gui_line_add_to_list (struct t_gui_lines *lines,
 void
 gui_line_free_data (struct t_gui_line *line)
 {
-    if (line->data->str_time)
-        free (line->data->str_time);
-    gui_line_tags_free (line->data);
-    if (line->data->prefix)
-        string_shared_free (line->data->prefix);
-    if (line->data->message)
-        free (line->data->message);
-    free (line->data);
+    gui_line_data_free (line->data);
 
     line->data = NULL;
 }
@@ -1035,8 +2033,10 @@ gui_line_remove_from_list (struct t_gui_buffer *buffer,
             if (ptr_scroll->text_search_start_line == line)
                 ptr_scroll->text_search_start_line = NULL;
         }
-        /* remove line from coords */
+        /* remove line from coords and last line displayed */
         gui_window_coords_remove_line (ptr_win, line);
+        if (ptr_win->chat_last_line == line)
+            ptr_win->chat_last_line = NULL;
     }
 
     gui_line_get_prefix_for_display (line, NULL, &prefix_length, NULL,
@@ -1058,6 +2058,9 @@ gui_line_remove_from_list (struct t_gui_buffer *buffer,
     if (!line->data->displayed && (lines->lines_hidden > 0))
         (lines->lines_hidden)--;
 
+    /* remove line from blocks (before data is freed) */
+    gui_line_block_remove_line (lines, line);
+
     /* free data */
     if (free_data)
         gui_line_free_data (line);
@@ -1074,7 +2077,7 @@ gui_line_remove_from_list (struct t_gui_buffer *buffer,
 
     lines->lines_count--;
 
-    free (line);
+    gui_line_release (line);
 }
 
 /*
@@ -1087,7 +2090,7 @@ gui_line_mixed_add (struct t_gui_lines *lines,
 {
     struct t_gui_line *new_line;
 
-    new_line = malloc (sizeof (*new_line));
+    new_line = gui_line_alloc ();
     if (new_line)
     {
         new_line->data = line_data;
@@ -1172,8 +2175,13 @@ gui_line_free (struct t_gui_buffer *buffer, struct t_gui_line *line)
         }
     }
 
-    /* remove line from lines list */
-    gui_line_remove_from_list (buffer, buffer->own_lines, line, 1);
+    /*
+     * remove line from lines list (the line data is not freed if it is still
+     * used by a filter job running in background)
+     */
+    gui_line_remove_from_list (
+        buffer, buffer->own_lines, line,
+        (gui_filter_job_keep_line_data (buffer, line->data)) ? 0 : 1);
 }
 
 /*
@@ -1183,6 +2191,9 @@ gui_line_free (struct t_gui_buffer *buffer, struct t_gui_line *line)
 void
 gui_line_free_all (struct t_gui_buffer *buffer)
 {
+    if (gui_filter_jobs)
+        gui_filter_job_cancel_buffer (buffer, 0);
+
     while (buffer->own_lines->first_line)
     {
         gui_line_free (buffer, buffer->own_lines->first_line);
@@ -1199,21 +2210,39 @@ gui_line_free_all (struct t_gui_buffer *buffer)
 int
 gui_line_get_notify_level (struct t_gui_line *line)
 {
-    int i, notify_level, *max_notify_level;
+    int i, notify_flag, notify_level, *max_notify_level;
     const char *nick;
 
-    notify_level = GUI_HOTLIST_LOW;
+    /* if the line has many notify tags, the last one is used */
+    notify_flag = line->data->tags_flags & GUI_LINE_TAG_FLAGS_NOTIFY;
+    if (notify_flag & (notify_flag - 1))
+    {
+        for (i = line->data->tags_count - 1; i >= 0; i--)
+        {
+            notify_flag = gui_line_tag_get_flag (line->data->tags_array[i])
+                & GUI_LINE_TAG_FLAGS_NOTIFY;
+            if (notify_flag)
+                break;
+        }
+    }
 
-    for (i = 0; i < line->data->tags_count; i++)
+    switch (notify_flag)
     {
-        if (string_strcasecmp (line->data->tags_array[i], "notify_none") == 0)
+        case GUI_LINE_TAG_FLAG_NOTIFY_NONE:
             notify_level = -1;
-        if (string_strcasecmp (line->data->tags_array[i], "notify_highlight") == 0)
+            break;
+        case GUI_LINE_TAG_FLAG_NOTIFY_HIGHLIGHT:
             notify_level = GUI_HOTLIST_HIGHLIGHT;
-        if (string_strcasecmp (line->data->tags_array[i], "notify_private") == 0)
+            break;
+        case GUI_LINE_TAG_FLAG_NOTIFY_PRIVATE:
             notify_level = GUI_HOTLIST_PRIVATE;
-        if (string_strcasecmp (line->data->tags_array[i], "notify_message") == 0)
+            break;
+        case GUI_LINE_TAG_FLAG_NOTIFY_MESSAGE:
             notify_level = GUI_HOTLIST_MESSAGE;
+            break;
+        default:
+            notify_level = GUI_HOTLIST_LOW;
+            break;
     }
 
     max_notify_level = NULL;
@@ -1276,35 +2305,43 @@ gui_line_new (struct t_gui_buffer *buffer, int y, time_t date,
     struct t_gui_line_data *new_line_data;
 
     /* create new line */
-    new_line = malloc (sizeof (*new_line));
+    new_line = gui_line_alloc ();
     if (!new_line)
         return NULL;
 
     /* create data for line */
-    new_line_data = malloc (sizeof (*new_line_data));
+    new_line_data = gui_line_data_alloc ();
     if (!new_line_data)
     {
-        free (new_line);
+        gui_line_release (new_line);
         return NULL;
     }
     new_line->data = new_line_data;
 
     /* fill data in new line */
     new_line->data->buffer = buffer;
-    new_line->data->message = (message) ? strdup (message) : strdup ("");
+    new_line->data->tags_count = 0;
+    new_line->data->tags_array = NULL;
+    new_line->data->tags_flags = 0;
+    new_line->data->message = NULL;
+    new_line->data->message_no_color = NULL;
+    new_line->data->prefix = NULL;
+    new_line->data->prefix_no_color = NULL;
+    new_line->data->rows_id = 0;
+    new_line->data->rows = 0;
 
     if (buffer->type == GUI_BUFFER_TYPE_FORMATTED)
     {
         new_line->data->y = -1;
         new_line->data->date = date;
         new_line->data->date_printed = date_printed;
-        new_line->data->str_time = gui_chat_get_time_string (date);
-        gui_line_tags_alloc (new_line->data, tags);
+        new_line->data->str_time = NULL;
+        gui_line_data_set_message_tags_string (new_line->data,
+                                               (message) ? message : "",
+                                               tags);
         new_line->data->refresh_needed = 0;
-        new_line->data->prefix = (prefix) ?
-            (char *)string_shared_get (prefix) : ((date != 0) ? (char *)string_shared_get ("") : NULL);
-        new_line->data->prefix_length = (prefix) ?
-            gui_chat_strlen_screen (prefix) : 0;
+        gui_line_set_prefix (new_line->data,
+                             (prefix) ? prefix : ((date != 0) ? "" : NULL));
         new_line->data->notify_level = gui_line_get_notify_level (new_line);
         new_line->data->highlight = gui_line_get_highlight (new_line);
     }
@@ -1314,10 +2351,8 @@ gui_line_new (struct t_gui_buffer *buffer, int y, time_t date,
         new_line->data->date = 0;
         new_line->data->date_printed = 0;
         new_line->data->str_time = NULL;
-        new_line->data->tags_count = 0;
-        new_line->data->tags_array = NULL;
+        gui_line_set_message (new_line->data, (message) ? message : "");
         new_line->data->refresh_needed = 1;
-        new_line->data->prefix = NULL;
         new_line->data->prefix_length = 0;
         new_line->data->notify_level = 0;
         new_line->data->highlight = 0;
@@ -1414,9 +2449,7 @@ gui_line_hook_update (struct t_gui_line *line,
         if (error && !error[0] && (value >= 0))
         {
             line->data->date = (time_t)value;
-            if (line->data->str_time)
-                free (line->data->str_time);
-            line->data->str_time = gui_chat_get_time_string (line->data->date);
+            gui_line_set_str_time (line->data, NULL);
         }
     }
 
@@ -1432,11 +2465,7 @@ gui_line_hook_update (struct t_gui_line *line,
     ptr_value = hashtable_get (hashtable, "str_time");
     ptr_value2 = hashtable_get (hashtable2, "str_time");
     if (ptr_value2 && (!ptr_value || (strcmp (ptr_value, ptr_value2) != 0)))
-    {
-        if (line->data->str_time)
-            free (line->data->str_time);
-        line->data->str_time = (ptr_value2) ? strdup (ptr_value2) : NULL;
-    }
+        gui_line_set_str_time (line->data, ptr_value2);
 
     ptr_value = hashtable_get (hashtable, "tags");
     ptr_value2 = hashtable_get (hashtable2, "tags");
@@ -1475,22 +2504,13 @@ gui_line_hook_update (struct t_gui_line *line,
     ptr_value2 = hashtable_get (hashtable2, "prefix");
     if (ptr_value2 && (!ptr_value || (strcmp (ptr_value, ptr_value2) != 0)))
     {
-        if (line->data->prefix)
-            string_shared_free (line->data->prefix);
-        line->data->prefix = (char *)string_shared_get (
-            (ptr_value2) ? ptr_value2 : "");
-        line->data->prefix_length = (line->data->prefix) ?
-            gui_chat_strlen_screen (line->data->prefix) : 0;
+        gui_line_set_prefix (line->data, (ptr_value2) ? ptr_value2 : "");
     }
 
     ptr_value = hashtable_get (hashtable, "message");
     ptr_value2 = hashtable_get (hashtable2, "message");
     if (ptr_value2 && (!ptr_value || (strcmp (ptr_value, ptr_value2) != 0)))
-    {
-        if (line->data->message)
-            free (line->data->message);
-        line->data->message = (ptr_value2) ? strdup (ptr_value2) : NULL;
-    }
+        gui_line_set_message (line->data, ptr_value2);
 
     /* if tags were updated but not notify_level, adjust notify level */
     if (tags_updated && !notify_level_updated)
@@ -1651,9 +2671,12 @@ gui_line_add_y (struct t_gui_line *line)
         }
 
         /* replace ptr_line by line in list */
+        if (gui_filter_jobs)
+            gui_filter_job_cancel_buffer (ptr_line->data->buffer, 1);
         gui_line_free_data (ptr_line);
         ptr_line->data = line->data;
-        free (line);
+        gui_line_release (line);
+        gui_line_blocks_invalidate (ptr_line->data->buffer);
     }
     else
     {
@@ -1683,6 +2706,8 @@ gui_line_add_y (struct t_gui_line *line)
         }
         ptr_line = line;
 
+        gui_line_block_add_line (line->data->buffer->own_lines, line);
+
         line->data->buffer->own_lines->lines_count++;
     }
 
@@ -1712,13 +2737,12 @@ gui_line_add_y (struct t_gui_line *line)
 void
 gui_line_clear (struct t_gui_line *line)
 {
-    if (line->data->prefix)
-        string_shared_free (line->data->prefix);
-    line->data->prefix = (char *)string_shared_get ("");
+    if (gui_filter_jobs)
+        gui_filter_job_cancel_buffer (line->data->buffer, 1);
+
+    gui_line_set_prefix (line->data, "");
 
-    if (line->data->message)
-        free (line->data->message);
-    line->data->message = strdup ("");
+    gui_line_set_message (line->data, "");
 }
 
 /*
@@ -1893,15 +2917,17 @@ gui_line_hdata_line_data_update_cb (void *data,
     rc = 0;
     update_coords = 0;
 
+    /* line may be read by a filter job running in background */
+    if (gui_filter_jobs)
+        gui_filter_job_cancel_buffer (line_data->buffer, 1);
+
     if (hashtable_has_key (hashtable, "date"))
     {
         value = hashtable_get (hashtable, "date");
         if (value)
         {
             hdata_set (hdata, pointer, "date", value);
-            if (line_data->str_time)
-                free (line_data->str_time);
-            line_data->str_time = gui_chat_get_time_string (line_data->date);
+            gui_line_set_str_time (line_data, NULL);
             rc++;
             update_coords = 1;
         }
@@ -1928,9 +2954,7 @@ gui_line_hdata_line_data_update_cb (void *data,
     if (hashtable_has_key (hashtable, "prefix"))
     {
         value = hashtable_get (hashtable, "prefix");
-        hdata_set (hdata, pointer, "prefix", value);
-        line_data->prefix_length = (line_data->prefix) ?
-            gui_chat_strlen_screen (line_data->prefix) : 0;
+        gui_line_set_prefix (line_data, value);
         line_data->buffer->lines->prefix_max_length_refresh = 1;
         rc++;
         update_coords = 1;
@@ -1939,13 +2963,14 @@ gui_line_hdata_line_data_update_cb (void *data,
     if (hashtable_has_key (hashtable, "message"))
     {
         value = hashtable_get (hashtable, "message");
-        hdata_set (hdata, pointer, "message", value);
+        gui_line_set_message (line_data, value);
         rc++;
         update_coords = 1;
     }
 
     if (rc > 0)
     {
+        gui_line_blocks_invalidate (line_data->buffer);
         if (update_coords)
         {
             for (ptr_win = gui_windows; ptr_win; ptr_win = ptr_win->next_window)
@@ -1960,6 +2985,17 @@ gui_line_hdata_line_data_update_cb (void *data,
     return rc;
 }
 
+/*
+ * Callback to get string "str_time" of a line data in hdata (built on demand
+ * if the line has no custom time string).
+ */
+
+const char *
+gui_line_hdata_line_data_str_time_cb (void *pointer)
+{
+    return gui_line_get_str_time ((struct t_gui_line_data *)pointer);
+}
+
 /*
  * Returns hdata for line data.
  */
@@ -1983,6 +3019,8 @@ gui_line_hdata_line_data_cb (const void *pointer, void *data,
         HDATA_VAR(struct t_gui_line_data, date, TIME, 1, NULL, NULL);
         HDATA_VAR(struct t_gui_line_data, date_printed, TIME, 1, NULL, NULL);
         HDATA_VAR(struct t_gui_line_data, str_time, STRING, 0, NULL, NULL);
+        hdata_set_var_callback_string (hdata, "str_time",
+                                       &gui_line_hdata_line_data_str_time_cb);
         HDATA_VAR(struct t_gui_line_data, tags_count, INTEGER, 0, NULL, NULL);
         HDATA_VAR(struct t_gui_line_data, tags_array, SHARED_STRING, 1, "tags_count", NULL);
         HDATA_VAR(struct t_gui_line_data, displayed, CHAR, 0, NULL, NULL);
@@ -2026,7 +3064,8 @@ gui_line_add_to_infolist (struct t_infolist *infolist,
         return 0;
     if (!infolist_new_var_time (ptr_item, "date_printed", line->data->date_printed))
         return 0;
-    if (!infolist_new_var_string (ptr_item, "str_time", line->data->str_time))
+    if (!infolist_new_var_string (ptr_item, "str_time",
+                                  gui_line_get_str_time (line->data)))
         return 0;
 
     /* write tags */
@@ -2094,5 +3133,9 @@ gui_lines_print_log (struct t_gui_lines *lines)
         log_printf ("    buffer_max_length_refresh: %d",    lines->buffer_max_length_refresh);
         log_printf ("    prefix_max_length. . . . : %d",    lines->prefix_max_length);
         log_printf ("    prefix_max_length_refresh: %d",    lines->prefix_max_length_refresh);
+        log_printf ("    first_block. . . . . . . : 0x%lx", lines->first_block);
+        log_printf ("    last_block . . . . . . . : 0x%lx", lines->last_block);
+        log_printf ("    blocks_count . . . . . . : %d",    lines->blocks_count);
+        log_printf ("    blocks_refresh . . . . . : %d",    lines->blocks_refresh);
     }
 }
@@ -24,6 +24,28 @@
 #include <regex.h>
 
 struct t_infolist;
+struct t_slab;
+struct t_string_highlight;
+
+/* number of lines in a block (when lines are added at end of list) */
+#define GUI_LINE_BLOCK_SIZE 128
+
+/* flags for tags often checked in lines (see "tags_flags" in line data) */
+#define GUI_LINE_TAG_FLAG_NO_FILTER         (1 << 0)
+#define GUI_LINE_TAG_FLAG_NO_HIGHLIGHT      (1 << 1)
+#define GUI_LINE_TAG_FLAG_NOTIFY_NONE       (1 << 2)
+#define GUI_LINE_TAG_FLAG_NOTIFY_HIGHLIGHT  (1 << 3)
+#define GUI_LINE_TAG_FLAG_NOTIFY_PRIVATE    (1 << 4)
+#define GUI_LINE_TAG_FLAG_NOTIFY_MESSAGE    (1 << 5)
+#define GUI_LINE_TAG_FLAG_NICK              (1 << 6)
+#define GUI_LINE_TAG_FLAG_ACTION            (1 << 7)
+#define GUI_LINE_TAG_FLAGS_NOTIFY (GUI_LINE_TAG_FLAG_NOTIFY_NONE |        \
+                                   GUI_LINE_TAG_FLAG_NOTIFY_HIGHLIGHT |   \
+                                   GUI_LINE_TAG_FLAG_NOTIFY_PRIVATE |     \
+                                   GUI_LINE_TAG_FLAG_NOTIFY_MESSAGE)
+/* tags with a flag which are compared case sensitively */
+#define GUI_LINE_TAG_FLAGS_CASE (GUI_LINE_TAG_FLAG_NO_FILTER |            \
+                                 GUI_LINE_TAG_FLAG_NO_HIGHLIGHT)
 
 /* line structures */
 
@@ -33,25 +55,71 @@ struct t_gui_line_data
     int y;                             /* line position (for free buffer)   */
     time_t date;                       /* date/time of line (may be past)   */
     time_t date_printed;               /* date/time when weechat print it   */
-    char *str_time;                    /* time string (for display)         */
+    char *str_time;                    /* custom time string (for display), */
+                                       /* NULL = built with date of line    */
     int tags_count;                    /* number of tags for line           */
     char **tags_array;                 /* tags for line                     */
+    int tags_flags;                    /* flags for some tags of line       */
+                                       /* (GUI_LINE_TAG_FLAG_XXX)           */
     char displayed;                    /* 1 if line is displayed            */
     char notify_level;                 /* notify level for the line         */
     char highlight;                    /* 1 if line has highlight           */
     char refresh_needed;               /* 1 if refresh asked (free buffer)  */
+    int filters_hiding;                /* number of filters hiding the line */
     char *prefix;                      /* prefix for line (may be NULL)     */
     int prefix_length;                 /* prefix length (on screen)         */
+    char *prefix_no_color;             /* prefix without colors (shared)    */
     char *message;                     /* line content (after prefix)       */
+    char *message_no_color;            /* message without colors (same      */
+                                       /* pointer as message if no colors)  */
+    int rows_id;                       /* id of layout for "rows" (0 = not  */
+                                       /* computed), see gui_chat_get_rows_id*/
+    int rows;                          /* number of rows on screen for time,*/
+                                       /* prefix and message (cached)       */
 };
 
 struct t_gui_line
 {
     struct t_gui_line_data *data;      /* pointer to line data              */
+    struct t_gui_line_block *block;    /* block containing this line        */
     struct t_gui_line *prev_line;      /* link to previous line             */
     struct t_gui_line *next_line;      /* link to next line                 */
 };
 
+/* tags to match in lines, compiled (see function gui_line_tags_match_new) */
+
+struct t_gui_line_tag_mask
+{
+    const char *tag;                   /* tag (without "!"), may contain "*"*/
+    int negated;                       /* 1 if tag is negated ("!tag")      */
+    int any;                           /* 1 if tag is "*" (any line)        */
+    int wildcard;                      /* 1 if tag contains a "*"           */
+    int flag;                          /* flag for tag (0 if no flag)       */
+    int last;                          /* 1 if last tag of a group (tags    */
+                                       /* are combined with "+" in a group) */
+};
+
+struct t_gui_line_tags_match
+{
+    int masks_count;                   /* number of masks                   */
+    struct t_gui_line_tag_mask *masks; /* masks (all groups)                */
+};
+
+struct t_gui_line_block
+{
+    struct t_gui_lines *lines;         /* lines containing this block       */
+    struct t_gui_line *first_line;     /* first line in block               */
+    struct t_gui_line *last_line;      /* last line in block                */
+    int lines_count;                   /* number of lines in block          */
+    int lines_displayed;               /* number of lines displayed         */
+    int lines_no_date;                 /* number of lines with date == 0    */
+    int lines_highlight;               /* number of lines with highlight    */
+    time_t date_min;                   /* min date of lines (0 if unknown)  */
+    time_t date_max;                   /* max date of lines (0 if unknown)  */
+    struct t_gui_line_block *prev_block; /* link to previous block          */
+    struct t_gui_line_block *next_block; /* link to next block              */
+};
+
 struct t_gui_lines
 {
     struct t_gui_line *first_line;     /* pointer to first line             */
@@ -65,12 +133,34 @@ struct t_gui_lines
     int buffer_max_length_refresh;     /* refresh asked for buffer max len. */
     int prefix_max_length;             /* max length for prefix align       */
     int prefix_max_length_refresh;     /* refresh asked for prefix max len. */
+    struct t_gui_line_block *first_block; /* first block of lines           */
+    struct t_gui_line_block *last_block;  /* last block of lines            */
+    int blocks_count;                  /* number of blocks                  */
+    int blocks_refresh;                /* refresh asked for block counters  */
 };
 
+/* line variables */
+
+extern struct t_slab *gui_line_slab_lines;
+extern struct t_slab *gui_line_slab_lines_data;
+
 /* line functions */
 
 extern struct t_gui_lines *gui_lines_alloc ();
 extern void gui_lines_free (struct t_gui_lines *lines);
+extern struct t_gui_line *gui_line_alloc ();
+extern void gui_line_release (struct t_gui_line *line);
+extern void gui_line_data_set_message_tags (struct t_gui_line_data *line_data,
+                                            const char *message,
+                                            int tags_count, char **tags_array);
+extern char *gui_line_string_no_color (const char *string);
+extern void gui_line_set_prefix (struct t_gui_line_data *line_data,
+                                 const char *prefix);
+extern void gui_line_set_message (struct t_gui_line_data *line_data,
+                                  const char *message);
+extern const char *gui_line_get_str_time (struct t_gui_line_data *line_data);
+extern void gui_line_set_str_time (struct t_gui_line_data *line_data,
+                                   const char *str_time);
 extern void gui_line_tags_alloc (struct t_gui_line_data *line_data,
                                  const char *tags);
 extern void gui_line_tags_free (struct t_gui_line_data *line_data);
@@ -80,22 +170,53 @@ extern void gui_line_get_prefix_for_display (struct t_gui_line *line,
 extern int gui_line_get_align (struct t_gui_buffer *buffer,
                                struct t_gui_line *line,
                                int with_suffix, int first_line);
+extern void gui_line_blocks_invalidate (struct t_gui_buffer *buffer);
+extern void gui_lines_blocks_refresh (struct t_gui_lines *lines);
+extern void gui_line_block_count_line (struct t_gui_line_block *block,
+                                       struct t_gui_line *line, int inc);
+extern void gui_line_block_count_all (struct t_gui_line_block *block);
+extern struct t_gui_line_block *gui_line_block_new (struct t_gui_lines *lines,
+                                                    struct t_gui_line_block *prev_block);
+extern void gui_line_block_free (struct t_gui_lines *lines,
+                                 struct t_gui_line_block *block);
+extern void gui_line_block_split (struct t_gui_lines *lines,
+                                  struct t_gui_line_block *block);
+extern void gui_line_block_add_line (struct t_gui_lines *lines,
+                                     struct t_gui_line *line);
+extern void gui_line_block_remove_line (struct t_gui_lines *lines,
+                                        struct t_gui_line *line);
+extern int gui_line_block_displayed (struct t_gui_line_block *block);
+extern struct t_gui_line_block *gui_line_get_adjacent_block (struct t_gui_line *line,
+                                                             int direction);
 extern int gui_line_is_displayed (struct t_gui_line *line);
 extern struct t_gui_line *gui_line_get_first_displayed (struct t_gui_buffer *buffer);
 extern struct t_gui_line *gui_line_get_last_displayed (struct t_gui_buffer *buffer);
 extern struct t_gui_line *gui_line_get_prev_displayed (struct t_gui_line *line);
 extern struct t_gui_line *gui_line_get_next_displayed (struct t_gui_line *line);
+extern struct t_gui_line *gui_line_move_displayed (struct t_gui_line *line,
+                                                   long count,
+                                                   int only_with_date);
 extern int gui_line_search_text (struct t_gui_buffer *buffer,
                                  struct t_gui_line *line);
 extern int gui_line_match_regex (struct t_gui_line_data *line_data,
                                  regex_t *regex_prefix,
                                  regex_t *regex_message);
 extern int gui_line_has_tag_no_filter (struct t_gui_line_data *line_data);
+extern int gui_line_tag_get_flag (const char *tag);
+extern int gui_line_tag_get_line_flag (const char *tag);
+extern struct t_gui_line_tags_match *gui_line_tags_match_new (int tags_count,
+                                                              char ***tags_array);
+extern void gui_line_tags_match_free (struct t_gui_line_tags_match *tags_match);
+extern int gui_line_match_tags_compiled (struct t_gui_line_data *line_data,
+                                         struct t_gui_line_tags_match *tags_match);
 extern int gui_line_match_tags (struct t_gui_line_data *line_data,
                                 int tags_count, char ***tags_array);
 extern const char *gui_line_search_tag_starting_with (struct t_gui_line *line,
                                                       const char *tag);
 extern const char *gui_line_get_nick_tag (struct t_gui_line *line);
+extern struct t_string_highlight *gui_line_get_highlight_compiled (struct t_gui_buffer *buffer,
+                                                                  const char *highlight_words,
+                                                                  struct t_string_highlight **compiled);
 extern int gui_line_has_highlight (struct t_gui_line *line);
 extern int gui_line_has_offline_nick (struct t_gui_line *line);
 extern void gui_line_compute_buffer_max_length (struct t_gui_buffer *buffer,
@@ -103,6 +224,7 @@ extern void gui_line_compute_buffer_max_length (struct t_gui_buffer *buffer,
 extern void gui_line_compute_prefix_max_length (struct t_gui_lines *lines);
 extern void gui_line_mixed_free_buffer (struct t_gui_buffer *buffer);
 extern void gui_line_mixed_free_all (struct t_gui_buffer *buffer);
+extern void gui_line_data_free (struct t_gui_line_data *line_data);
 extern void gui_line_free_data (struct t_gui_line *line);
 extern void gui_line_free (struct t_gui_buffer *buffer,
                            struct t_gui_line *line);
@@ -128,6 +250,7 @@ extern struct t_hdata *gui_line_hdata_lines_cb (const void *pointer,
 extern struct t_hdata *gui_line_hdata_line_cb (const void *pointer,
                                                void *data,
                                                const char *hdata_name);
+extern const char *gui_line_hdata_line_data_str_time_cb (void *pointer);
 extern struct t_hdata *gui_line_hdata_line_data_cb (const void *pointer,
                                                     void *data,
                                                     const char *hdata_name);
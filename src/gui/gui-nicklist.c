@@ -108,7 +108,7 @@ gui_nicklist_send_hsignal (const char *signal, struct t_gui_buffer *buffer,
 
     hashtable_set (gui_nicklist_hsignal, "buffer", buffer);
     hashtable_set (gui_nicklist_hsignal, "parent_group",
-                   (group) ? group->parent : nick->group);
+                   (group) ? group->parent : ((nick) ? nick->group : NULL));
     if (group)
         hashtable_set (gui_nicklist_hsignal, "group", group);
     if (nick)
@@ -182,56 +182,96 @@ gui_nicklist_insert_group_sorted (struct t_gui_nick_group **groups,
 }
 
 /*
- * Searches for a group in nicklist (this function must not be called directly).
+ * Checks if a group is "from_group" or one of its children (at any level).
  *
- * Returns pointer to group found, NULL if not found.
+ * Returns:
+ *   1: group is from_group or one of its children
+ *   0: group is not in from_group
  */
 
-struct t_gui_nick_group *
-gui_nicklist_search_group_internal (struct t_gui_buffer *buffer,
-                                    struct t_gui_nick_group *from_group,
-                                    const char *name,
-                                    int skip_digits)
+int
+gui_nicklist_group_is_in_group (struct t_gui_nick_group *group,
+                                struct t_gui_nick_group *from_group)
 {
-    struct t_gui_nick_group *ptr_group;
-    const char *ptr_name;
+    while (group)
+    {
+        if (group == from_group)
+            return 1;
+        group = group->parent;
+    }
 
-    if (!buffer)
-        return NULL;
+    return 0;
+}
 
-    if (!from_group)
-        from_group = buffer->nicklist_root;
+/*
+ * Adds a group in index of groups.
+ *
+ * The key is the group name without digits and '|' at beginning (groups with
+ * same key are chained).
+ */
 
-    if (!from_group)
-        return NULL;
+void
+gui_nicklist_group_index_add (struct t_gui_buffer *buffer,
+                              struct t_gui_nick_group *group)
+{
+    const char *key;
+
+    key = gui_nicklist_get_group_start (group->name);
+    group->next_index_group = hashtable_get (buffer->nicklist_groups_index,
+                                             key);
+    hashtable_set (buffer->nicklist_groups_index, key, group);
+}
 
-    if (from_group->children)
+/*
+ * Removes a group from index of groups.
+ */
+
+void
+gui_nicklist_group_index_remove (struct t_gui_buffer *buffer,
+                                 struct t_gui_nick_group *group)
+{
+    struct t_gui_nick_group *ptr_group;
+    const char *key;
+
+    key = gui_nicklist_get_group_start (group->name);
+    ptr_group = hashtable_get (buffer->nicklist_groups_index, key);
+    if (ptr_group == group)
     {
-        ptr_group = gui_nicklist_search_group_internal (buffer,
-                                                        from_group->children,
-                                                        name,
-                                                        skip_digits);
-        if (ptr_group)
-            return ptr_group;
+        if (group->next_index_group)
+        {
+            hashtable_set (buffer->nicklist_groups_index, key,
+                           group->next_index_group);
+        }
+        else
+        {
+            hashtable_remove (buffer->nicklist_groups_index, key);
+        }
     }
-
-    ptr_group = from_group;
-    while (ptr_group)
+    else
     {
-        ptr_name = (skip_digits) ?
-            gui_nicklist_get_group_start (ptr_group->name) : ptr_group->name;
-        if (strcmp (ptr_name, name) == 0)
-            return ptr_group;
-        ptr_group = ptr_group->next_group;
+        while (ptr_group)
+        {
+            if (ptr_group->next_index_group == group)
+            {
+                ptr_group->next_index_group = group->next_index_group;
+                break;
+            }
+            ptr_group = ptr_group->next_index_group;
+        }
     }
-
-    /* group not found */
-    return NULL;
+    group->next_index_group = NULL;
 }
 
 /*
  * Searches for a group in nicklist.
  *
+ * If name begins with digits followed by '|', the full name of group must
+ * match, otherwise the name is compared to the group name without digits and
+ * '|' at beginning.
+ *
+ * If from_group is not NULL, the search is made only in this group and its
+ * children.
+ *
  * Returns pointer to group found, NULL if not found.
  */
 
@@ -240,12 +280,31 @@ gui_nicklist_search_group (struct t_gui_buffer *buffer,
                            struct t_gui_nick_group *from_group,
                            const char *name)
 {
+    struct t_gui_nick_group *ptr_group;
     const char *ptr_name;
 
+    if (!buffer || !name)
+        return NULL;
+
+    if (from_group == buffer->nicklist_root)
+        from_group = NULL;
+
     ptr_name = gui_nicklist_get_group_start (name);
 
-    return gui_nicklist_search_group_internal (buffer, from_group, name,
-                                               (ptr_name == name) ? 1 : 0);
+    for (ptr_group = hashtable_get (buffer->nicklist_groups_index, ptr_name);
+         ptr_group; ptr_group = ptr_group->next_index_group)
+    {
+        if ((ptr_name != name) && (strcmp (ptr_group->name, name) != 0))
+            continue;
+        if (!from_group || gui_nicklist_group_is_in_group (ptr_group,
+                                                           from_group))
+        {
+            return ptr_group;
+        }
+    }
+
+    /* group not found */
+    return NULL;
 }
 
 /*
@@ -279,6 +338,9 @@ gui_nicklist_add_group (struct t_gui_buffer *buffer,
     new_group->last_nick = NULL;
     new_group->prev_group = NULL;
     new_group->next_group = NULL;
+    new_group->next_index_group = NULL;
+
+    gui_nicklist_group_index_add (buffer, new_group);
 
     if (new_group->parent)
     {
@@ -369,49 +431,308 @@ gui_nicklist_insert_nick_sorted (struct t_gui_nick_group *group,
 }
 
 /*
- * Searches for a nick in nicklist.
+ * Merges two sorted lists of nicks (only pointers "next_nick" are set).
  *
- * Returns pointer to nick found, NULL if not found.
+ * Returns pointer to first nick of merged list.
  */
 
 struct t_gui_nick *
-gui_nicklist_search_nick (struct t_gui_buffer *buffer,
-                          struct t_gui_nick_group *from_group,
-                          const char *name)
+gui_nicklist_merge_nicks (struct t_gui_nick *nicks1, struct t_gui_nick *nicks2)
 {
-    struct t_gui_nick *ptr_nick;
+    struct t_gui_nick *nicks, **ptr_next;
+
+    nicks = NULL;
+    ptr_next = &nicks;
+
+    while (nicks1 && nicks2)
+    {
+        /* on equal names, keep the nick added first */
+        if (string_strcasecmp (nicks2->name, nicks1->name) < 0)
+        {
+            *ptr_next = nicks2;
+            nicks2 = nicks2->next_nick;
+        }
+        else
+        {
+            *ptr_next = nicks1;
+            nicks1 = nicks1->next_nick;
+        }
+        ptr_next = &((*ptr_next)->next_nick);
+    }
+    *ptr_next = (nicks1) ? nicks1 : nicks2;
+
+    return nicks;
+}
+
+/*
+ * Sorts a list of nicks with a merge sort (only pointers "next_nick" are
+ * set).
+ *
+ * Returns pointer to first nick of sorted list.
+ */
+
+struct t_gui_nick *
+gui_nicklist_sort_nicks_list (struct t_gui_nick *nicks)
+{
+    struct t_gui_nick *ptr_middle, *ptr_end, *nicks2;
+
+    if (!nicks || !nicks->next_nick)
+        return nicks;
+
+    /* split list in two halves */
+    ptr_middle = nicks;
+    ptr_end = nicks->next_nick;
+    while (ptr_end && ptr_end->next_nick)
+    {
+        ptr_middle = ptr_middle->next_nick;
+        ptr_end = ptr_end->next_nick->next_nick;
+    }
+    nicks2 = ptr_middle->next_nick;
+    ptr_middle->next_nick = NULL;
+
+    return gui_nicklist_merge_nicks (gui_nicklist_sort_nicks_list (nicks),
+                                     gui_nicklist_sort_nicks_list (nicks2));
+}
+
+/*
+ * Sorts nicks in a group and its subgroups.
+ */
+
+void
+gui_nicklist_sort_nicks (struct t_gui_nick_group *group)
+{
+    struct t_gui_nick *ptr_nick, *ptr_prev_nick;
     struct t_gui_nick_group *ptr_group;
 
-    if (!buffer && !from_group)
-        return NULL;
+    if (!group)
+        return;
+
+    group->nicks = gui_nicklist_sort_nicks_list (group->nicks);
+
+    /* rebuild pointers "prev_nick" and last nick of group */
+    ptr_prev_nick = NULL;
+    for (ptr_nick = group->nicks; ptr_nick; ptr_nick = ptr_nick->next_nick)
+    {
+        ptr_nick->prev_nick = ptr_prev_nick;
+        ptr_prev_nick = ptr_nick;
+    }
+    group->last_nick = ptr_prev_nick;
 
-    if (!from_group && !buffer->nicklist_root)
+    for (ptr_group = group->children; ptr_group;
+         ptr_group = ptr_group->next_group)
+    {
+        gui_nicklist_sort_nicks (ptr_group);
+    }
+}
+
+/*
+ * Gets key of a nick in index of nicks: the name of nick, or the key built by
+ * the nickcmp key callback of buffer (if set).
+ *
+ * The key is built in "key" if the nick is shorter than "size", otherwise it
+ * is allocated.
+ *
+ * Returns pointer to key, NULL if error.
+ *
+ * Note: result must be freed after use with function
+ * gui_nicklist_nick_index_key_free.
+ */
+
+const char *
+gui_nicklist_nick_index_key (struct t_gui_buffer *buffer, const char *name,
+                             char *key, int size)
+{
+    char *ptr_key;
+    int length;
+
+    if (!buffer->nickcmp_key_callback)
+        return name;
+
+    length = strlen (name);
+    ptr_key = (length < size) ? key : malloc (length + 1);
+    if (!ptr_key)
         return NULL;
 
-    for (ptr_nick = (from_group) ? from_group->nicks : buffer->nicklist_root->nicks;
-         ptr_nick; ptr_nick = ptr_nick->next_nick)
+    (buffer->nickcmp_key_callback) (buffer->nickcmp_callback_pointer,
+                                    buffer->nickcmp_callback_data,
+                                    buffer,
+                                    name,
+                                    ptr_key);
+
+    return ptr_key;
+}
+
+/*
+ * Frees a key returned by function gui_nicklist_nick_index_key.
+ */
+
+void
+gui_nicklist_nick_index_key_free (const char *ptr_key, const char *name,
+                                  const char *key)
+{
+    if (ptr_key && (ptr_key != name) && (ptr_key != key))
+        free ((char *)ptr_key);
+}
+
+/*
+ * Adds a nick in index of nicks.
+ *
+ * Nicks with same key are chained, the first nick added stays first in
+ * index.
+ */
+
+void
+gui_nicklist_nick_index_add (struct t_gui_buffer *buffer,
+                             struct t_gui_nick *nick)
+{
+    struct t_gui_nick *ptr_nick;
+    char str_key[128];
+    const char *ptr_key;
+
+    nick->next_index_nick = NULL;
+
+    ptr_key = gui_nicklist_nick_index_key (buffer, nick->name,
+                                           str_key, sizeof (str_key));
+    if (!ptr_key)
+        return;
+
+    ptr_nick = hashtable_get (buffer->nicklist_nicks_index, ptr_key);
+    if (ptr_nick)
+    {
+        while (ptr_nick->next_index_nick)
+        {
+            ptr_nick = ptr_nick->next_index_nick;
+        }
+        ptr_nick->next_index_nick = nick;
+    }
+    else
+    {
+        hashtable_set (buffer->nicklist_nicks_index, ptr_key, nick);
+    }
+
+    gui_nicklist_nick_index_key_free (ptr_key, nick->name, str_key);
+}
+
+/*
+ * Removes a nick from index of nicks.
+ */
+
+void
+gui_nicklist_nick_index_remove (struct t_gui_buffer *buffer,
+                                struct t_gui_nick *nick)
+{
+    struct t_gui_nick *ptr_nick;
+    char str_key[128];
+    const char *ptr_key;
+
+    ptr_key = gui_nicklist_nick_index_key (buffer, nick->name,
+                                           str_key, sizeof (str_key));
+    if (!ptr_key)
+        return;
+
+    ptr_nick = hashtable_get (buffer->nicklist_nicks_index, ptr_key);
+    if (ptr_nick == nick)
     {
-        if (buffer->nickcmp_callback)
+        if (nick->next_index_nick)
         {
-            if ((buffer->nickcmp_callback) (buffer->nickcmp_callback_pointer,
-                                            buffer->nickcmp_callback_data,
-                                            buffer,
-                                            ptr_nick->name,
-                                            name) == 0)
-                return ptr_nick;
+            hashtable_set (buffer->nicklist_nicks_index, ptr_key,
+                           nick->next_index_nick);
         }
         else
         {
-            if (strcmp (ptr_nick->name, name) == 0)
-                return ptr_nick;
+            hashtable_remove (buffer->nicklist_nicks_index, ptr_key);
         }
     }
+    else
+    {
+        while (ptr_nick)
+        {
+            if (ptr_nick->next_index_nick == nick)
+            {
+                ptr_nick->next_index_nick = nick->next_index_nick;
+                break;
+            }
+            ptr_nick = ptr_nick->next_index_nick;
+        }
+    }
+    nick->next_index_nick = NULL;
+
+    gui_nicklist_nick_index_key_free (ptr_key, nick->name, str_key);
+}
+
+/*
+ * Adds nicks of a group and its children in index of nicks.
+ */
+
+void
+gui_nicklist_nick_index_add_group (struct t_gui_buffer *buffer,
+                                   struct t_gui_nick_group *group)
+{
+    struct t_gui_nick *ptr_nick;
+    struct t_gui_nick_group *ptr_group;
+
+    for (ptr_nick = group->nicks; ptr_nick; ptr_nick = ptr_nick->next_nick)
+    {
+        gui_nicklist_nick_index_add (buffer, ptr_nick);
+    }
+
+    for (ptr_group = group->children; ptr_group;
+         ptr_group = ptr_group->next_group)
+    {
+        gui_nicklist_nick_index_add_group (buffer, ptr_group);
+    }
+}
+
+/*
+ * Builds the index of nicks again (called when the nickcmp key callback of
+ * buffer is set, because keys of nicks may have changed).
+ *
+ * Nicks are added in the order of a search in groups, so that the first nick
+ * found with a key is the same as with a search in all nicks.
+ */
+
+void
+gui_nicklist_nick_index_build (struct t_gui_buffer *buffer)
+{
+    if (!buffer || !buffer->nicklist_nicks_index)
+        return;
+
+    hashtable_remove_all (buffer->nicklist_nicks_index);
+
+    if (buffer->nicklist_root)
+        gui_nicklist_nick_index_add_group (buffer, buffer->nicklist_root);
+}
+
+/*
+ * Searches for a nick in a group and its children, comparing nicks with the
+ * nickcmp callback of buffer.
+ *
+ * Returns pointer to nick found, NULL if not found.
+ */
+
+struct t_gui_nick *
+gui_nicklist_search_nick_nickcmp (struct t_gui_buffer *buffer,
+                                  struct t_gui_nick_group *group,
+                                  const char *name)
+{
+    struct t_gui_nick *ptr_nick;
+    struct t_gui_nick_group *ptr_group;
+
+    for (ptr_nick = group->nicks; ptr_nick; ptr_nick = ptr_nick->next_nick)
+    {
+        if ((buffer->nickcmp_callback) (buffer->nickcmp_callback_pointer,
+                                        buffer->nickcmp_callback_data,
+                                        buffer,
+                                        ptr_nick->name,
+                                        name) == 0)
+            return ptr_nick;
+    }
 
     /* search nick in child groups */
-    for (ptr_group = (from_group) ? from_group->children : buffer->nicklist_root->children;
-         ptr_group; ptr_group = ptr_group->next_group)
+    for (ptr_group = group->children; ptr_group;
+         ptr_group = ptr_group->next_group)
     {
-        ptr_nick = gui_nicklist_search_nick (buffer, ptr_group, name);
+        ptr_nick = gui_nicklist_search_nick_nickcmp (buffer, ptr_group, name);
         if (ptr_nick)
             return ptr_nick;
     }
@@ -420,6 +741,62 @@ gui_nicklist_search_nick (struct t_gui_buffer *buffer,
     return NULL;
 }
 
+/*
+ * Searches for a nick in nicklist.
+ *
+ * If from_group is not NULL, the search is made only in this group and its
+ * children.
+ *
+ * The nick is searched in index of nicks (by name, or by the key returned by
+ * the nickcmp key callback of buffer). If the buffer has a nickcmp callback
+ * without key callback, all nicks are compared with the nickcmp callback.
+ *
+ * Returns pointer to nick found, NULL if not found.
+ */
+
+struct t_gui_nick *
+gui_nicklist_search_nick (struct t_gui_buffer *buffer,
+                          struct t_gui_nick_group *from_group,
+                          const char *name)
+{
+    struct t_gui_nick *ptr_nick;
+    char str_key[128];
+    const char *ptr_key;
+
+    if (!buffer || !name)
+        return NULL;
+
+    if (buffer->nickcmp_callback && !buffer->nickcmp_key_callback)
+    {
+        if (!from_group)
+            from_group = buffer->nicklist_root;
+        return (from_group) ?
+            gui_nicklist_search_nick_nickcmp (buffer, from_group, name) : NULL;
+    }
+
+    if (from_group == buffer->nicklist_root)
+        from_group = NULL;
+
+    ptr_key = gui_nicklist_nick_index_key (buffer, name,
+                                           str_key, sizeof (str_key));
+    if (!ptr_key)
+        return NULL;
+
+    for (ptr_nick = hashtable_get (buffer->nicklist_nicks_index, ptr_key);
+         ptr_nick; ptr_nick = ptr_nick->next_index_nick)
+    {
+        if (!from_group
+            || gui_nicklist_group_is_in_group (ptr_nick->group, from_group))
+        {
+            break;
+        }
+    }
+
+    gui_nicklist_nick_index_key_free (ptr_key, name, str_key);
+
+    return ptr_nick;
+}
+
 /*
  * Adds a nick to nicklist.
  *
@@ -448,8 +825,24 @@ gui_nicklist_add_nick (struct t_gui_buffer *buffer,
     new_nick->prefix = (prefix) ? (char *)string_shared_get (prefix) : NULL;
     new_nick->prefix_color = (prefix_color) ? (char *)string_shared_get (prefix_color) : NULL;
     new_nick->visible = visible;
+    new_nick->next_index_nick = NULL;
 
-    gui_nicklist_insert_nick_sorted (new_nick->group, new_nick);
+    if (buffer->nicklist_batch)
+    {
+        /* batch of nicks: add nick to the end, nicks are sorted later */
+        new_nick->prev_nick = (new_nick->group)->last_nick;
+        new_nick->next_nick = NULL;
+        if ((new_nick->group)->last_nick)
+            ((new_nick->group)->last_nick)->next_nick = new_nick;
+        else
+            (new_nick->group)->nicks = new_nick;
+        (new_nick->group)->last_nick = new_nick;
+    }
+    else
+    {
+        gui_nicklist_insert_nick_sorted (new_nick->group, new_nick);
+    }
+    gui_nicklist_nick_index_add (buffer, new_nick);
 
     buffer->nicklist_count++;
     buffer->nicklist_nicks_count++;
@@ -457,6 +850,9 @@ gui_nicklist_add_nick (struct t_gui_buffer *buffer,
     if (visible)
         buffer->nicklist_visible_count++;
 
+    if (buffer->nicklist_batch)
+        return new_nick;
+
     if (CONFIG_BOOLEAN(config_look_color_nick_offline))
         gui_buffer_ask_chat_refresh (buffer, 1);
 
@@ -466,6 +862,26 @@ gui_nicklist_add_nick (struct t_gui_buffer *buffer,
     return new_nick;
 }
 
+/*
+ * Ends a batch of nicks added in nicklist: sorts nicks and sends a single
+ * signal "nicklist_nicks_added" for all nicks added.
+ */
+
+void
+gui_nicklist_end_batch (struct t_gui_buffer *buffer)
+{
+    if (!buffer)
+        return;
+
+    gui_nicklist_sort_nicks (buffer->nicklist_root);
+
+    if (CONFIG_BOOLEAN(config_look_color_nick_offline))
+        gui_buffer_ask_chat_refresh (buffer, 1);
+
+    gui_nicklist_send_signal ("nicklist_nicks_added", buffer, NULL);
+    gui_nicklist_send_hsignal ("nicklist_nicks_added", buffer, NULL, NULL);
+}
+
 /*
  * Removes a nick from a group.
  */
@@ -484,7 +900,8 @@ gui_nicklist_remove_nick (struct t_gui_buffer *buffer,
     gui_nicklist_send_signal ("nicklist_nick_removing", buffer, nick_removed);
     gui_nicklist_send_hsignal ("nicklist_nick_removing", buffer, NULL, nick);
 
-    /* remove nick from list */
+    /* remove nick from index and list */
+    gui_nicklist_nick_index_remove (buffer, nick);
     if (nick->prev_nick)
         (nick->prev_nick)->next_nick = nick->next_nick;
     if (nick->next_nick)
@@ -554,6 +971,8 @@ gui_nicklist_remove_group (struct t_gui_buffer *buffer,
     gui_nicklist_send_signal ("nicklist_group_removing", buffer, group_removed);
     gui_nicklist_send_hsignal ("nicklist_group_removing", buffer, group, NULL);
 
+    gui_nicklist_group_index_remove (buffer, group);
+
     if (group->parent)
     {
         /* remove group from list */
@@ -616,6 +1035,10 @@ gui_nicklist_remove_all (struct t_gui_buffer *buffer)
             gui_nicklist_remove_nick (buffer, buffer->nicklist_root->nicks);
         }
     }
+
+    /* a batch of nicks can not continue in an empty nicklist */
+    if (buffer)
+        buffer->nicklist_batch = 0;
 }
 
 /*
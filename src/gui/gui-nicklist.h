@@ -36,6 +36,8 @@ struct t_gui_nick_group
     struct t_gui_nick *last_nick;      /* last nick for group               */
     struct t_gui_nick_group *prev_group; /* link to previous group          */
     struct t_gui_nick_group *next_group; /* link to next group              */
+    struct t_gui_nick_group *next_index_group; /* next group with same key  */
+                                       /* in index of groups                */
 };
 
 struct t_gui_nick
@@ -48,6 +50,7 @@ struct t_gui_nick
     int visible;                       /* 1 if nick is displayed            */
     struct t_gui_nick *prev_nick;      /* link to previous nick             */
     struct t_gui_nick *next_nick;      /* link to next nick                 */
+    struct t_gui_nick *next_index_nick; /* next nick with same key in index */
 };
 
 /* nicklist functions */
@@ -60,6 +63,7 @@ extern struct t_gui_nick_group *gui_nicklist_add_group (struct t_gui_buffer *buf
                                                         const char *name,
                                                         const char *color,
                                                         int visible);
+extern void gui_nicklist_nick_index_build (struct t_gui_buffer *buffer);
 extern struct t_gui_nick *gui_nicklist_search_nick (struct t_gui_buffer *buffer,
                                                     struct t_gui_nick_group *from_group,
                                                     const char *name);
@@ -70,6 +74,7 @@ extern struct t_gui_nick *gui_nicklist_add_nick (struct t_gui_buffer *buffer,
                                                  const char *prefix,
                                                  const char *prefix_color,
                                                  int visible);
+extern void gui_nicklist_end_batch (struct t_gui_buffer *buffer);
 extern void gui_nicklist_remove_group (struct t_gui_buffer *buffer,
                                        struct t_gui_nick_group *group);
 extern void gui_nicklist_remove_nick (struct t_gui_buffer *buffer,
@@ -189,7 +189,8 @@ gui_window_get_context_at_xy (struct t_gui_window *window,
         if ((win_x >= window->coords[win_y].time_x1)
             && (win_x <= window->coords[win_y].time_x2))
         {
-            *word = gui_color_decode ((*line)->data->str_time, NULL);
+            *word = gui_color_decode (gui_line_get_str_time ((*line)->data),
+                                      NULL);
         }
         else if ((win_x >= window->coords[win_y].buffer_x1)
                  && (win_x <= window->coords[win_y].buffer_x2))
@@ -272,6 +273,9 @@ gui_window_get_context_at_xy (struct t_gui_window *window,
 void
 gui_window_ask_refresh (int refresh)
 {
+    /* layout of lines may have changed (options, bars, sizes) */
+    gui_chat_rows_invalidate ();
+
     if (refresh > gui_window_refresh_needed)
         gui_window_refresh_needed = refresh;
 }
@@ -672,6 +676,21 @@ gui_window_new (struct t_gui_window *parent_window, struct t_gui_buffer *buffer,
     new_window->coords = NULL;
     new_window->coords_x_message = 0;
 
+    /* last line displayed */
+    new_window->chat_last_line = NULL;
+    new_window->chat_last_prefix_max_length = 0;
+    new_window->chat_last_buffer_max_length = 0;
+
+    /* layout of lines */
+    new_window->chat_rows_id = 0;
+    new_window->chat_rows_version = 0;
+    new_window->chat_rows_buffer = NULL;
+    new_window->chat_rows_width = 0;
+    new_window->chat_rows_zoomed = 0;
+    new_window->chat_rows_time_for_each_line = 0;
+    new_window->chat_rows_prefix_max_length = 0;
+    new_window->chat_rows_buffer_max_length = 0;
+
     /* tree */
     new_window->ptr_tree = ptr_leaf;
     ptr_leaf->window = new_window;
@@ -973,6 +992,31 @@ gui_window_coords_alloc (struct t_gui_window *window)
     window->coords_x_message = 0;
 }
 
+/*
+ * Scrolls coordinates of window by "count" lines up (when the chat window is
+ * scrolled to display new lines at bottom): lines at bottom are initialized.
+ */
+
+void
+gui_window_coords_scroll (struct t_gui_window *window, int count)
+{
+    int i;
+
+    if (!window || !window->coords || (count <= 0))
+        return;
+
+    if (count < window->coords_size)
+    {
+        memmove (window->coords, window->coords + count,
+                 (window->coords_size - count) * sizeof (window->coords[0]));
+    }
+    for (i = (count < window->coords_size) ? window->coords_size - count : 0;
+         i < window->coords_size; i++)
+    {
+        gui_window_coords_init_line (window, i);
+    }
+}
+
 /*
  * Deletes a window.
  */
@@ -1122,6 +1166,136 @@ gui_window_switch_by_buffer (struct t_gui_window *window, int buffer_number)
     }
 }
 
+/*
+ * Sets start line of scroll in a window.
+ */
+
+void
+gui_window_scroll_set_start_line (struct t_gui_window *window,
+                                  struct t_gui_line *line)
+{
+    window->scroll->start_line = line;
+    window->scroll->start_line_pos = 0;
+    window->scroll->first_line_displayed =
+        (window->scroll->start_line == gui_line_get_first_displayed (window->buffer));
+    gui_buffer_ask_chat_refresh (window->buffer, 2);
+}
+
+/*
+ * Checks if a date is reached when scrolling by time from an old date
+ * (time_letter is one of: "s", "m", "h", "d", "M", "y").
+ *
+ * Returns:
+ *   1: date is reached (scroll stops on this date)
+ *   0: date is not reached
+ *  -1: error
+ */
+
+int
+gui_window_scroll_date_reached (char time_letter, long number,
+                                time_t old_date, struct tm *old_line_date,
+                                time_t date)
+{
+    struct tm *date_tmp, line_date;
+    time_t diff_date;
+
+    date_tmp = localtime (&date);
+    if (!date_tmp)
+        return -1;
+    memcpy (&line_date, date_tmp, sizeof (struct tm));
+    diff_date = (old_date > date) ? old_date - date : date - old_date;
+
+    switch (time_letter)
+    {
+        case 's': /* seconds */
+            if (number == 0)
+            {
+                /* stop if line has different second */
+                if ((line_date.tm_sec != old_line_date->tm_sec)
+                    || (line_date.tm_min != old_line_date->tm_min)
+                    || (line_date.tm_hour != old_line_date->tm_hour)
+                    || (line_date.tm_mday != old_line_date->tm_mday)
+                    || (line_date.tm_mon != old_line_date->tm_mon)
+                    || (line_date.tm_year != old_line_date->tm_year))
+                    if (line_date.tm_sec != old_line_date->tm_sec)
+                        return 1;
+            }
+            else if (diff_date >= number)
+                return 1;
+            break;
+        case 'm': /* minutes */
+            if (number == 0)
+            {
+                /* stop if line has different minute */
+                if ((line_date.tm_min != old_line_date->tm_min)
+                    || (line_date.tm_hour != old_line_date->tm_hour)
+                    || (line_date.tm_mday != old_line_date->tm_mday)
+                    || (line_date.tm_mon != old_line_date->tm_mon)
+                    || (line_date.tm_year != old_line_date->tm_year))
+                    return 1;
+            }
+            else if (diff_date >= number * 60)
+                return 1;
+            break;
+        case 'h': /* hours */
+            if (number == 0)
+            {
+                /* stop if line has different hour */
+                if ((line_date.tm_hour != old_line_date->tm_hour)
+                    || (line_date.tm_mday != old_line_date->tm_mday)
+                    || (line_date.tm_mon != old_line_date->tm_mon)
+                    || (line_date.tm_year != old_line_date->tm_year))
+                    return 1;
+            }
+            else if (diff_date >= number * 60 * 60)
+                return 1;
+            break;
+        case 'd': /* days */
+            if (number == 0)
+            {
+                /* stop if line has different day */
+                if ((line_date.tm_mday != old_line_date->tm_mday)
+                    || (line_date.tm_mon != old_line_date->tm_mon)
+                    || (line_date.tm_year != old_line_date->tm_year))
+                    return 1;
+            }
+            else if (diff_date >= number * 60 * 60 * 24)
+                return 1;
+            break;
+        case 'M': /* months */
+            if (number == 0)
+            {
+                /* stop if line has different month */
+                if ((line_date.tm_mon != old_line_date->tm_mon)
+                    || (line_date.tm_year != old_line_date->tm_year))
+                    return 1;
+            }
+            /*
+             * we consider month is 30 days, who will notice
+             * I'm too lazy to code exact date diff ? ;)
+             */
+            else if (diff_date >= number * 60 * 60 * 24 * 30)
+                return 1;
+            break;
+        case 'y': /* years */
+            if (number == 0)
+            {
+                /* stop if line has different year */
+                if (line_date.tm_year != old_line_date->tm_year)
+                    return 1;
+            }
+            /*
+             * we consider year is 365 days, who will notice
+             * I'm too lazy to code exact date diff ? ;)
+             */
+            else if (diff_date >= number * 60 * 60 * 24 * 365)
+                return 1;
+            break;
+    }
+
+    return 0;
+}
+
 /*
  * Scrolls window by a number of messages or time.
  */
@@ -1129,13 +1303,14 @@ gui_window_switch_by_buffer (struct t_gui_window *window, int buffer_number)
 void
 gui_window_scroll (struct t_gui_window *window, char *scroll)
 {
-    int direction, stop, count_msg, scroll_from_end_free_buffer;
+    int direction, stop, scroll_from_end_free_buffer;
     char time_letter, saved_char;
-    time_t old_date, diff_date;
+    time_t old_date;
     char *pos, *error;
     long number;
     struct t_gui_line *ptr_line;
-    struct tm *date_tmp, line_date, old_line_date;
+    struct t_gui_line_block *ptr_block;
+    struct tm *date_tmp, old_line_date;
 
     if (!window || !window->buffer->lines->first_line)
         return;
@@ -1194,8 +1369,7 @@ gui_window_scroll (struct t_gui_window *window, char *scroll)
         return;
 
     /* do the scroll! */
-    stop = 0;
-    count_msg = 0;
+    old_date = 0;
     if (direction < 0)
     {
         /*
@@ -1212,7 +1386,7 @@ gui_window_scroll (struct t_gui_window *window, char *scroll)
                    || ((window->buffer->type == GUI_BUFFER_TYPE_FORMATTED)
                        && (ptr_line->data->date == 0))))
         {
-            ptr_line = ptr_line->prev_line;
+            ptr_line = gui_line_get_prev_displayed (ptr_line);
         }
     }
     else
@@ -1224,7 +1398,7 @@ gui_window_scroll (struct t_gui_window *window, char *scroll)
                    || ((window->buffer->type == GUI_BUFFER_TYPE_FORMATTED)
                        && (ptr_line->data->date == 0))))
         {
-            ptr_line = ptr_line->next_line;
+            ptr_line = gui_line_get_next_displayed (ptr_line);
         }
     }
 
@@ -1237,8 +1411,41 @@ gui_window_scroll (struct t_gui_window *window, char *scroll)
         memcpy (&old_line_date, date_tmp, sizeof (struct tm));
     }
 
+    if (time_letter == ' ')
+    {
+        /* scroll by number of messages: whole blocks of lines are skipped */
+        ptr_line = gui_line_move_displayed (
+            ptr_line,
+            (direction < 0) ? -number : number,
+            (window->buffer->type == GUI_BUFFER_TYPE_FORMATTED) ? 1 : 0);
+        if (ptr_line)
+        {
+            gui_window_scroll_set_start_line (window, ptr_line);
+            return;
+        }
+    }
+
     while (ptr_line)
     {
+        /*
+         * skip blocks of lines with dates that can not stop the scroll
+         * (the dates where scroll stops are outside a single interval of
+         * time around the old date, except for different second)
+         */
+        while ((ptr_block = gui_line_get_adjacent_block (ptr_line, direction))
+               && ((time_letter != 's') || (number != 0)
+                   || (ptr_block->date_min == ptr_block->date_max))
+               && (gui_window_scroll_date_reached (time_letter, number,
+                                                   old_date, &old_line_date,
+                                                   ptr_block->date_min) == 0)
+               && (gui_window_scroll_date_reached (time_letter, number,
+                                                   old_date, &old_line_date,
+                                                   ptr_block->date_max) == 0))
+        {
+            ptr_line = (direction < 0) ?
+                ptr_block->first_line : ptr_block->last_line;
+        }
+
         ptr_line = (direction < 0) ?
             gui_line_get_prev_displayed (ptr_line) : gui_line_get_next_displayed (ptr_line);
 
@@ -1246,117 +1453,14 @@ gui_window_scroll (struct t_gui_window *window, char *scroll)
             && ((window->buffer->type != GUI_BUFFER_TYPE_FORMATTED)
                 || (ptr_line->data->date != 0)))
         {
-            if (time_letter == ' ')
-            {
-                count_msg++;
-                if (count_msg >= number)
-                    stop = 1;
-            }
-            else
-            {
-                date_tmp = localtime (&(ptr_line->data->date));
-                if (!date_tmp)
-                    return;
-                memcpy (&line_date, date_tmp, sizeof (struct tm));
-                if (old_date > ptr_line->data->date)
-                    diff_date = old_date - ptr_line->data->date;
-                else
-                    diff_date = ptr_line->data->date - old_date;
-                switch (time_letter)
-                {
-                    case 's': /* seconds */
-                        if (number == 0)
-                        {
-                            /* stop if line has different second */
-                            if ((line_date.tm_sec != old_line_date.tm_sec)
-                                || (line_date.tm_min != old_line_date.tm_min)
-                                || (line_date.tm_hour != old_line_date.tm_hour)
-                                || (line_date.tm_mday != old_line_date.tm_mday)
-                                || (line_date.tm_mon != old_line_date.tm_mon)
-                                || (line_date.tm_year != old_line_date.tm_year))
-                                if (line_date.tm_sec != old_line_date.tm_sec)
-                                    stop = 1;
-                        }
-                        else if (diff_date >= number)
-                            stop = 1;
-                        break;
-                    case 'm': /* minutes */
-                        if (number == 0)
-                        {
-                            /* stop if line has different minute */
-                            if ((line_date.tm_min != old_line_date.tm_min)
-                                || (line_date.tm_hour != old_line_date.tm_hour)
-                                || (line_date.tm_mday != old_line_date.tm_mday)
-                                || (line_date.tm_mon != old_line_date.tm_mon)
-                                || (line_date.tm_year != old_line_date.tm_year))
-                                stop = 1;
-                        }
-                        else if (diff_date >= number * 60)
-                            stop = 1;
-                        break;
-                    case 'h': /* hours */
-                        if (number == 0)
-                        {
-                            /* stop if line has different hour */
-                            if ((line_date.tm_hour != old_line_date.tm_hour)
-                                || (line_date.tm_mday != old_line_date.tm_mday)
-                                || (line_date.tm_mon != old_line_date.tm_mon)
-                                || (line_date.tm_year != old_line_date.tm_year))
-                                stop = 1;
-                        }
-                        else if (diff_date >= number * 60 * 60)
-                            stop = 1;
-                        break;
-                    case 'd': /* days */
-                        if (number == 0)
-                        {
-                            /* stop if line has different day */
-                            if ((line_date.tm_mday != old_line_date.tm_mday)
-                                || (line_date.tm_mon != old_line_date.tm_mon)
-                                || (line_date.tm_year != old_line_date.tm_year))
-                                stop = 1;
-                        }
-                        else if (diff_date >= number * 60 * 60 * 24)
-                            stop = 1;
-                        break;
-                    case 'M': /* months */
-                        if (number == 0)
-                        {
-                            /* stop if line has different month */
-                            if ((line_date.tm_mon != old_line_date.tm_mon)
-                                || (line_date.tm_year != old_line_date.tm_year))
-                                stop = 1;
-                        }
-                        /*
-                         * we consider month is 30 days, who will notice
-                         * I'm too lazy to code exact date diff ? ;)
-                         */
-                        else if (diff_date >= number * 60 * 60 * 24 * 30)
-                            stop = 1;
-                        break;
-                    case 'y': /* years */
-                        if (number == 0)
-                        {
-                            /* stop if line has different year */
-                            if (line_date.tm_year != old_line_date.tm_year)
-                                stop = 1;
-                        }
-                        /*
-                         * we consider year is 365 days, who will notice
-                         * I'm too lazy to code exact date diff ? ;)
-                         */
-                        else if (diff_date >= number * 60 * 60 * 24 * 365)
-                            stop = 1;
-                        break;
-                }
-            }
+            stop = gui_window_scroll_date_reached (time_letter, number,
+                                                   old_date, &old_line_date,
+                                                   ptr_line->data->date);
+            if (stop < 0)
+                return;
             if (stop)
             {
-                window->scroll->start_line = ptr_line;
-                window->scroll->start_line_pos = 0;
-                window->scroll->first_line_displayed =
-                    (window->scroll->start_line == gui_line_get_first_displayed (window->buffer));
-                gui_buffer_ask_chat_refresh (window->buffer, 2);
+                gui_window_scroll_set_start_line (window, ptr_line);
                 return;
             }
         }
@@ -1450,6 +1554,7 @@ void
 gui_window_scroll_previous_highlight (struct t_gui_window *window)
 {
     struct t_gui_line *ptr_line;
+    struct t_gui_line_block *ptr_block;
 
     if (!window)
         return;
@@ -1472,6 +1577,12 @@ gui_window_scroll_previous_highlight (struct t_gui_window *window)
                     gui_buffer_ask_chat_refresh (window->buffer, 2);
                     return;
                 }
+                /* skip blocks of lines without highlight */
+                while ((ptr_block = gui_line_get_adjacent_block (ptr_line, -1))
+                       && (ptr_block->lines_highlight == 0))
+                {
+                    ptr_line = ptr_block->first_line;
+                }
                 ptr_line = ptr_line->prev_line;
             }
             /* no previous highlight, scroll to bottom */
@@ -1488,6 +1599,7 @@ void
 gui_window_scroll_next_highlight (struct t_gui_window *window)
 {
     struct t_gui_line *ptr_line;
+    struct t_gui_line_block *ptr_block;
 
     if (!window)
         return;
@@ -1510,6 +1622,12 @@ gui_window_scroll_next_highlight (struct t_gui_window *window)
                     gui_buffer_ask_chat_refresh (window->buffer, 2);
                     return;
                 }
+                /* skip blocks of lines without highlight */
+                while ((ptr_block = gui_line_get_adjacent_block (ptr_line, 1))
+                       && (ptr_block->lines_highlight == 0))
+                {
+                    ptr_line = ptr_block->last_line;
+                }
                 ptr_line = ptr_line->next_line;
             }
             /* no next highlight, scroll to bottom */
@@ -2029,6 +2147,17 @@ gui_window_print_log ()
         log_printf ("  coords_size . . . . : %d",    ptr_window->coords_size);
         log_printf ("  coords. . . . . . . : 0x%lx", ptr_window->coords);
         log_printf ("  coords_x_message. . : %d",    ptr_window->coords_x_message);
+        log_printf ("  chat_last_line. . . : 0x%lx", ptr_window->chat_last_line);
+        log_printf ("  chat_last_prefix_max_length: %d", ptr_window->chat_last_prefix_max_length);
+        log_printf ("  chat_last_buffer_max_length: %d", ptr_window->chat_last_buffer_max_length);
+        log_printf ("  chat_rows_id. . . . : %d",    ptr_window->chat_rows_id);
+        log_printf ("  chat_rows_version . : %d",    ptr_window->chat_rows_version);
+        log_printf ("  chat_rows_buffer. . : 0x%lx", ptr_window->chat_rows_buffer);
+        log_printf ("  chat_rows_width . . : %d",    ptr_window->chat_rows_width);
+        log_printf ("  chat_rows_zoomed. . : %d",    ptr_window->chat_rows_zoomed);
+        log_printf ("  chat_rows_time_for_each_line: %d", ptr_window->chat_rows_time_for_each_line);
+        log_printf ("  chat_rows_prefix_max_length: %d", ptr_window->chat_rows_prefix_max_length);
+        log_printf ("  chat_rows_buffer_max_length: %d", ptr_window->chat_rows_buffer_max_length);
         log_printf ("  ptr_tree. . . . . . : 0x%lx", ptr_window->ptr_tree);
         log_printf ("  prev_window . . . . : 0x%lx", ptr_window->prev_window);
         log_printf ("  next_window . . . . : 0x%lx", ptr_window->next_window);
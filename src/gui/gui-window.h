@@ -20,6 +20,8 @@
 #ifndef WEECHAT_GUI_WINDOW_H
 #define WEECHAT_GUI_WINDOW_H
 
+#include <time.h>
+
 struct t_infolist;
 struct t_gui_bar_window;
 struct t_gui_line_data;
@@ -78,6 +80,22 @@ struct t_gui_window
     struct t_gui_window_coords *coords;/* coords for window                 */
     int coords_x_message;              /* start X for messages              */
 
+    /* last line displayed (for a refresh of chat when lines are added) */
+    struct t_gui_line *chat_last_line; /* last line displayed at bottom of  */
+                                       /* chat (NULL if not at bottom)      */
+    int chat_last_prefix_max_length;   /* prefix/buffer max length when     */
+    int chat_last_buffer_max_length;   /* last line was displayed           */
+
+    /* layout of lines (for number of rows cached in lines) */
+    int chat_rows_id;                  /* id of layout (0 = not computed)   */
+    int chat_rows_version;             /* version of options for layout     */
+    struct t_gui_buffer *chat_rows_buffer; /* buffer displayed              */
+    int chat_rows_width;               /* width of chat area                */
+    int chat_rows_zoomed;              /* 1 if merged buffer is zoomed      */
+    int chat_rows_time_for_each_line;  /* 1 if time is displayed            */
+    int chat_rows_prefix_max_length;   /* prefix/buffer max length used     */
+    int chat_rows_buffer_max_length;   /* to align lines                    */
+
     /* tree */
     struct t_gui_window_tree *ptr_tree;/* pointer to leaf in windows tree   */
 
@@ -174,12 +192,19 @@ extern void gui_window_coords_remove_line (struct t_gui_window *window,
 extern void gui_window_coords_remove_line_data (struct t_gui_window *window,
                                                 struct t_gui_line_data *line_data);
 extern void gui_window_coords_alloc (struct t_gui_window *window);
+extern void gui_window_coords_scroll (struct t_gui_window *window, int count);
 extern void gui_window_free (struct t_gui_window *window);
 extern void gui_window_switch_previous (struct t_gui_window *window);
 extern void gui_window_switch_next (struct t_gui_window *window);
 extern void gui_window_switch_by_number (int number);
 extern void gui_window_switch_by_buffer (struct t_gui_window *window,
                                          int buffer_number);
+extern void gui_window_scroll_set_start_line (struct t_gui_window *window,
+                                              struct t_gui_line *line);
+extern int gui_window_scroll_date_reached (char time_letter, long number,
+                                           time_t old_date,
+                                           struct tm *old_line_date,
+                                           time_t date);
 extern void gui_window_scroll (struct t_gui_window *window, char *scroll);
 extern void gui_window_scroll_horiz (struct t_gui_window *window, char *scroll);
 extern void gui_window_scroll_previous_highlight (struct t_gui_window *window);
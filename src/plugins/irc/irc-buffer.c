@@ -30,6 +30,7 @@
 #include "irc-channel.h"
 #include "irc-command.h"
 #include "irc-config.h"
+#include "irc-nick.h"
 #include "irc-raw.h"
 #include "irc-server.h"
 
@@ -250,6 +251,35 @@ irc_buffer_nickcmp_cb (const void *pointer, void *data,
     }
 }
 
+/*
+ * Callback for building the key of a nick in index of nicks of nicklist: the
+ * nick in lower case, according to the "casemapping" of server (nicks equal
+ * with function irc_buffer_nickcmp_cb have same key).
+ *
+ * The key has same length as the nick.
+ */
+
+void
+irc_buffer_nickcmp_key_cb (const void *pointer, void *data,
+                           struct t_gui_buffer *buffer,
+                           const char *nick, char *key)
+{
+    struct t_irc_server *server;
+
+    /* make C compiler happy */
+    (void) data;
+
+    if (pointer)
+        server = (struct t_irc_server *)pointer;
+    else
+        irc_buffer_get_server_and_channel (buffer, &server, NULL);
+
+    /* default is RFC 1459 casemapping comparison (as in nickcmp callback) */
+    (void) irc_nick_index_key (
+        (server) ? server->casemapping : IRC_SERVER_CASEMAPPING_STRICT_RFC1459,
+        nick, key, strlen (nick) + 1);
+}
+
 /*
  * Searches for the server buffer with the lowest number.
  *
@@ -53,6 +53,9 @@ extern int irc_buffer_close_cb (const void *pointer, void *data,
 extern int irc_buffer_nickcmp_cb (const void *pointer, void *data,
                                   struct t_gui_buffer *buffer,
                                   const char *nick1, const char *nick2);
+extern void irc_buffer_nickcmp_key_cb (const void *pointer, void *data,
+                                       struct t_gui_buffer *buffer,
+                                       const char *nick, char *key);
 extern struct t_gui_buffer *irc_buffer_search_server_lowest_number ();
 extern struct t_gui_buffer *irc_buffer_search_private_lowest_number (struct t_irc_server *server);
 
@@ -355,6 +355,8 @@ irc_channel_create_buffer (struct t_irc_server *server,
                                         &irc_buffer_nickcmp_cb);
             weechat_buffer_set_pointer (ptr_buffer, "nickcmp_callback_pointer",
                                         server);
+            weechat_buffer_set_pointer (ptr_buffer, "nickcmp_key_callback",
+                                        &irc_buffer_nickcmp_key_cb);
         }
 
         /* set highlights settings on channel buffer */
@@ -478,6 +480,8 @@ irc_channel_new (struct t_irc_server *server, int channel_type,
     new_channel->nicks_count = 0;
     new_channel->nicks = NULL;
     new_channel->last_nick = NULL;
+    new_channel->nicks_index = NULL;
+    new_channel->nicks_index_casemapping = IRC_SERVER_CASEMAPPING_RFC1459;
     new_channel->nicks_speaking[0] = NULL;
     new_channel->nicks_speaking[1] = NULL;
     new_channel->nicks_speaking_time = NULL;
@@ -512,6 +516,33 @@ irc_channel_new (struct t_irc_server *server, int channel_type,
     return new_channel;
 }
 
+/*
+ * Builds again the index of nicks in nicklist of all channels of a server
+ * (called when the casemapping of server has changed, because keys of nicks
+ * depend on casemapping).
+ */
+
+void
+irc_channel_nicklist_index_build (struct t_irc_server *server)
+{
+    struct t_irc_channel *ptr_channel;
+
+    if (!server)
+        return;
+
+    for (ptr_channel = server->channels; ptr_channel;
+         ptr_channel = ptr_channel->next_channel)
+    {
+        if ((ptr_channel->type == IRC_CHANNEL_TYPE_CHANNEL)
+            && ptr_channel->buffer)
+        {
+            weechat_buffer_set_pointer (ptr_channel->buffer,
+                                        "nickcmp_key_callback",
+                                        &irc_buffer_nickcmp_key_cb);
+        }
+    }
+}
+
 /*
  * Adds groups in nicklist for a channel.
  */
@@ -1447,6 +1478,8 @@ irc_channel_free (struct t_irc_server *server, struct t_irc_channel *channel)
     irc_channel_nick_speaking_time_free_all (channel);
     if (channel->join_smart_filtered)
         weechat_hashtable_free (channel->join_smart_filtered);
+    if (channel->nicks_index)
+        weechat_hashtable_free (channel->nicks_index);
     if (channel->buffer_as_string)
         free (channel->buffer_as_string);
 
@@ -1696,6 +1729,12 @@ irc_channel_print_log (struct t_irc_channel *channel)
     weechat_log_printf ("       last_nick_speaking_time. : 0x%lx", channel->last_nick_speaking_time);
     weechat_log_printf ("       modelists. . . . . . . . : 0x%lx", channel->modelists);
     weechat_log_printf ("       last_modelist. . . . . . : 0x%lx", channel->last_modelist);
+    weechat_log_printf ("       nicks_index. . . . . . . : 0x%lx (%d items)",
+                        channel->nicks_index,
+                        weechat_hashtable_get_integer (channel->nicks_index,
+                                                       "items_count"));
+    weechat_log_printf ("       nicks_index_casemapping. : %d",
+                        channel->nicks_index_casemapping);
     weechat_log_printf ("       join_smart_filtered. . . : 0x%lx (hashtable: '%s')",
                         channel->join_smart_filtered,
                         weechat_hashtable_get_string (channel->join_smart_filtered,
@@ -66,6 +66,9 @@ struct t_irc_channel
     int nicks_count;                   /* # nicks on channel (0 if pv)      */
     struct t_irc_nick *nicks;          /* nicks on the channel              */
     struct t_irc_nick *last_nick;      /* last nick on the channel          */
+    struct t_hashtable *nicks_index;   /* nicks by name (lower case with    */
+                                       /* casemapping "nicks_index_casemap")*/
+    int nicks_index_casemapping;       /* casemapping used in "nicks_index" */
     struct t_weelist *nicks_speaking[2]; /* for smart completion: first     */
                                        /* list is nick speaking, second is  */
                                        /* speaking to me (highlight)        */
@@ -98,6 +101,7 @@ extern struct t_irc_channel *irc_channel_new (struct t_irc_server *server,
                                               const char *channel_name,
                                               int switch_to_channel,
                                               int auto_switch);
+extern void irc_channel_nicklist_index_build (struct t_irc_server *server);
 extern void irc_channel_add_nicklist_groups (struct t_irc_server *server,
                                              struct t_irc_channel *channel);
 extern void irc_channel_set_buffer_title (struct t_irc_channel *channel);
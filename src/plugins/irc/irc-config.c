@@ -2206,6 +2206,26 @@ irc_config_server_new_option (struct t_config_file *config_file,
                 callback_change_data,
                 NULL, NULL, NULL);
             break;
+        case IRC_SERVER_OPTION_ANTI_FLOOD_BURST:
+            new_option = weechat_config_new_option (
+                config_file, section,
+                option_name, "integer",
+                N_("anti-flood: number of messages from queues that can be "
+                   "sent at once to IRC server; then one message is allowed "
+                   "every N seconds, where N is the value of option "
+                   "anti_flood_prio_high (1 = no burst, one message every N "
+                   "seconds)"),
+                NULL, 1, 100,
+                default_value, value,
+                null_value_allowed,
+                callback_check_value,
+                callback_check_value_pointer,
+                callback_check_value_data,
+                callback_change,
+                callback_change_pointer,
+                callback_change_data,
+                NULL, NULL, NULL);
+            break;
         case IRC_SERVER_OPTION_AWAY_CHECK:
             new_option = weechat_config_new_option (
                 config_file, section,
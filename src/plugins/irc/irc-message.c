@@ -28,28 +28,23 @@
 #include "irc.h"
 #include "irc-channel.h"
 #include "irc-config.h"
+#include "irc-message.h"
 #include "irc-server.h"
 
 
+#define IRC_MESSAGE_SET_ITEM(__item, __start, __end)                    \
+    parsed->pos_##__item = (__start) - message;                         \
+    parsed->length_##__item = (__end) - (__start);
+
 /*
- * Parses an IRC message and returns:
- *   - tags (string)
- *   - message without tags (string)
- *   - nick (string)
- *   - host (string)
- *   - command (string)
- *   - channel (string)
- *   - arguments (string)
- *   - text (string)
- *   - pos_command (integer: command index in message)
- *   - pos_arguments (integer: arguments index in message)
- *   - pos_channel (integer: channel index in message)
- *   - pos_text (integer: text index in message)
+ * Parses an IRC message: position and length of items in message are stored
+ * in "parsed" (nothing is allocated, the message is not copied, so it must
+ * not be changed or freed while "parsed" is used).
  *
  * Example:
  *   @time=2015-06-27T16:40:35.000Z :nick!user@host PRIVMSG #weechat :hello!
  *
- * Result:
+ * Result (items):
  *               tags: "time=2015-06-27T16:40:35.000Z"
  *   msg_without_tags: ":nick!user@host PRIVMSG #weechat :hello!"
  *               nick: "nick"
@@ -65,44 +60,37 @@
  */
 
 void
-irc_message_parse (struct t_irc_server *server, const char *message,
-                   char **tags, char **message_without_tags, char **nick,
-                   char **host, char **command, char **channel,
-                   char **arguments, char **text,
-                   int *pos_command, int *pos_arguments, int *pos_channel,
-                   int *pos_text)
+irc_message_parse_to_struct (struct t_irc_server *server, const char *message,
+                             struct t_irc_message *parsed)
 {
-    const char *ptr_message, *pos, *pos2, *pos3, *pos4;
+    const char *ptr_message, *pos, *pos2, *pos3, *pos4, *end;
 
-    if (tags)
-        *tags = NULL;
-    if (message_without_tags)
-        *message_without_tags = NULL;
-    if (nick)
-        *nick = NULL;
-    if (host)
-        *host = NULL;
-    if (command)
-        *command = NULL;
-    if (channel)
-        *channel = NULL;
-    if (arguments)
-        *arguments = NULL;
-    if (text)
-        *text = NULL;
-    if (pos_command)
-        *pos_command = -1;
-    if (pos_arguments)
-        *pos_arguments = -1;
-    if (pos_channel)
-        *pos_channel = -1;
-    if (pos_text)
-        *pos_text = -1;
+    if (!parsed)
+        return;
+
+    parsed->message = message;
+    parsed->pos_tags = -1;
+    parsed->length_tags = 0;
+    parsed->pos_message_without_tags = -1;
+    parsed->length_message_without_tags = 0;
+    parsed->pos_nick = -1;
+    parsed->length_nick = 0;
+    parsed->pos_host = -1;
+    parsed->length_host = 0;
+    parsed->pos_command = -1;
+    parsed->length_command = 0;
+    parsed->pos_arguments = -1;
+    parsed->length_arguments = 0;
+    parsed->pos_channel = -1;
+    parsed->length_channel = 0;
+    parsed->pos_text = -1;
+    parsed->length_text = 0;
 
     if (!message)
         return;
 
     ptr_message = message;
+    end = message + strlen (message);
 
     /*
      * we will use this message as example:
@@ -120,11 +108,7 @@ irc_message_parse (struct t_irc_server *server, const char *message,
         pos = strchr (ptr_message, ' ');
         if (pos)
         {
-            if (tags)
-            {
-                *tags = weechat_strndup (ptr_message + 1,
-                                         pos - (ptr_message + 1));
-            }
+            IRC_MESSAGE_SET_ITEM(tags, ptr_message + 1, pos);
             ptr_message = pos + 1;
             while (ptr_message[0] == ' ')
             {
@@ -133,8 +117,7 @@ irc_message_parse (struct t_irc_server *server, const char *message,
         }
     }
 
-    if (message_without_tags)
-        *message_without_tags = strdup (ptr_message);
+    IRC_MESSAGE_SET_ITEM(message_without_tags, ptr_message, end);
 
     /* now we have: ptr_message --> ":nick!user@host PRIVMSG #weechat :hello!" */
     if (ptr_message[0] == ':')
@@ -148,18 +131,15 @@ irc_message_parse (struct t_irc_server *server, const char *message,
             pos2 = pos3;
         if (pos2 && (!pos || pos > pos2))
         {
-            if (nick)
-                *nick = weechat_strndup (ptr_message + 1, pos2 - (ptr_message + 1));
+            IRC_MESSAGE_SET_ITEM(nick, ptr_message + 1, pos2);
         }
         else if (pos)
         {
-            if (nick)
-                *nick = weechat_strndup (ptr_message + 1, pos - (ptr_message + 1));
+            IRC_MESSAGE_SET_ITEM(nick, ptr_message + 1, pos);
         }
         if (pos)
         {
-            if (host)
-                *host = weechat_strndup (ptr_message + 1, pos - (ptr_message + 1));
+            IRC_MESSAGE_SET_ITEM(host, ptr_message + 1, pos);
             ptr_message = pos + 1;
             while (ptr_message[0] == ' ')
             {
@@ -168,9 +148,8 @@ irc_message_parse (struct t_irc_server *server, const char *message,
         }
         else
         {
-            if (host)
-                *host = strdup (ptr_message + 1);
-            ptr_message += strlen (ptr_message);
+            IRC_MESSAGE_SET_ITEM(host, ptr_message + 1, end);
+            ptr_message = end;
         }
     }
 
@@ -180,20 +159,14 @@ irc_message_parse (struct t_irc_server *server, const char *message,
         pos = strchr (ptr_message, ' ');
         if (pos)
         {
-            if (command)
-                *command = weechat_strndup (ptr_message, pos - ptr_message);
-            if (pos_command)
-                *pos_command = ptr_message - message;
+            IRC_MESSAGE_SET_ITEM(command, ptr_message, pos);
             pos++;
             while (pos[0] == ' ')
             {
                 pos++;
             }
             /* now we have: pos --> "#weechat :hello!" */
-            if (arguments)
-                *arguments = strdup (pos);
-            if (pos_arguments)
-                *pos_arguments = pos - message;
+            IRC_MESSAGE_SET_ITEM(arguments, pos, end);
             if ((pos[0] == ':')
                 && ((strncmp (ptr_message, "JOIN ", 5) == 0)
                     || (strncmp (ptr_message, "PART ", 5) == 0)))
@@ -202,25 +175,14 @@ irc_message_parse (struct t_irc_server *server, const char *message,
             }
             if (pos[0] == ':')
             {
-                if (text)
-                    *text = strdup (pos + 1);
-                if (pos_text)
-                    *pos_text = pos - message + 1;
+                IRC_MESSAGE_SET_ITEM(text, pos + 1, end);
             }
             else
             {
                 if (irc_channel_is_channel (server, pos))
                 {
                     pos2 = strchr (pos, ' ');
-                    if (channel)
-                    {
-                        if (pos2)
-                            *channel = weechat_strndup (pos, pos2 - pos);
-                        else
-                            *channel = strdup (pos);
-                    }
-                    if (pos_channel)
-                        *pos_channel = pos - message;
+                    IRC_MESSAGE_SET_ITEM(channel, pos, (pos2) ? pos2 : end);
                     if (pos2)
                     {
                         while (pos2[0] == ' ')
@@ -229,21 +191,15 @@ irc_message_parse (struct t_irc_server *server, const char *message,
                         }
                         if (pos2[0] == ':')
                             pos2++;
-                        if (text)
-                            *text = strdup (pos2);
-                        if (pos_text)
-                            *pos_text = pos2 - message;
+                        IRC_MESSAGE_SET_ITEM(text, pos2, end);
                     }
                 }
                 else
                 {
                     pos2 = strchr (pos, ' ');
-                    if (nick && !*nick)
+                    if (parsed->pos_nick < 0)
                     {
-                        if (pos2)
-                            *nick = weechat_strndup (pos, pos2 - pos);
-                        else
-                            *nick = strdup (pos);
+                        IRC_MESSAGE_SET_ITEM(nick, pos, (pos2) ? pos2 : end);
                     }
                     if (pos2)
                     {
@@ -256,49 +212,23 @@ irc_message_parse (struct t_irc_server *server, const char *message,
                         if (irc_channel_is_channel (server, pos2))
                         {
                             pos4 = strchr (pos2, ' ');
-                            if (channel)
-                            {
-                                if (pos4)
-                                    *channel = weechat_strndup (pos2, pos4 - pos2);
-                                else
-                                    *channel = strdup (pos2);
-                            }
-                            if (pos_channel)
-                                *pos_channel = pos2 - message;
-                            if (pos4)
-                            {
-                                while (pos4[0] == ' ')
-                                {
-                                    pos4++;
-                                }
-                                if (pos4[0] == ':')
-                                    pos4++;
-                                if (text)
-                                    *text = strdup (pos4);
-                                if (pos_text)
-                                    *pos_text = pos4 - message;
-                            }
+                            IRC_MESSAGE_SET_ITEM(channel, pos2,
+                                                 (pos4) ? pos4 : end);
                         }
                         else
                         {
-                            if (channel)
-                                *channel = weechat_strndup (pos, pos3 - pos);
-                            if (pos_channel)
-                                *pos_channel = pos - message;
-                            pos4 = strchr (pos3, ' ');
-                            if (pos4)
+                            IRC_MESSAGE_SET_ITEM(channel, pos, pos3);
+                            pos4 = pos3;
+                        }
+                        if (pos4)
+                        {
+                            while (pos4[0] == ' ')
                             {
-                                while (pos4[0] == ' ')
-                                {
-                                    pos4++;
-                                }
-                                if (pos4[0] == ':')
-                                    pos4++;
-                                if (text)
-                                    *text = strdup (pos4);
-                                if (pos_text)
-                                    *pos_text = pos4 - message;
+                                pos4++;
                             }
+                            if (pos4[0] == ':')
+                                pos4++;
+                            IRC_MESSAGE_SET_ITEM(text, pos4, end);
                         }
                     }
                 }
@@ -306,14 +236,121 @@ irc_message_parse (struct t_irc_server *server, const char *message,
         }
         else
         {
-            if (command)
-                *command = strdup (ptr_message);
-            if (pos_command)
-                *pos_command = ptr_message - message;
+            IRC_MESSAGE_SET_ITEM(command, ptr_message, end);
         }
     }
 }
 
+/*
+ * Returns a copy of an item in a parsed IRC message (position and length
+ * are read in "parsed", for example: parsed->pos_nick, parsed->length_nick).
+ *
+ * Returns NULL if the item is not in message.
+ *
+ * Note: result must be freed after use.
+ */
+
+char *
+irc_message_get_item (struct t_irc_message *parsed, int pos, int length)
+{
+    char *item;
+
+    if (!parsed || !parsed->message || (pos < 0) || (length < 0))
+        return NULL;
+
+    item = malloc (length + 1);
+    if (!item)
+        return NULL;
+    memcpy (item, parsed->message + pos, length);
+    item[length] = '\0';
+
+    return item;
+}
+
+/*
+ * Parses an IRC message and returns:
+ *   - tags (string)
+ *   - message without tags (string)
+ *   - nick (string)
+ *   - host (string)
+ *   - command (string)
+ *   - channel (string)
+ *   - arguments (string)
+ *   - text (string)
+ *   - pos_command (integer: command index in message)
+ *   - pos_arguments (integer: arguments index in message)
+ *   - pos_channel (integer: channel index in message)
+ *   - pos_text (integer: text index in message)
+ *
+ * See function irc_message_parse_to_struct for an example.
+ *
+ * Note: strings returned must be freed after use.
+ */
+
+void
+irc_message_parse (struct t_irc_server *server, const char *message,
+                   char **tags, char **message_without_tags, char **nick,
+                   char **host, char **command, char **channel,
+                   char **arguments, char **text,
+                   int *pos_command, int *pos_arguments, int *pos_channel,
+                   int *pos_text)
+{
+    struct t_irc_message parsed;
+
+    irc_message_parse_to_struct (server, message, &parsed);
+
+    if (tags)
+    {
+        *tags = irc_message_get_item (&parsed, parsed.pos_tags,
+                                      parsed.length_tags);
+    }
+    if (message_without_tags)
+    {
+        *message_without_tags = irc_message_get_item (
+            &parsed,
+            parsed.pos_message_without_tags,
+            parsed.length_message_without_tags);
+    }
+    if (nick)
+    {
+        *nick = irc_message_get_item (&parsed, parsed.pos_nick,
+                                      parsed.length_nick);
+    }
+    if (host)
+    {
+        *host = irc_message_get_item (&parsed, parsed.pos_host,
+                                      parsed.length_host);
+    }
+    if (command)
+    {
+        *command = irc_message_get_item (&parsed, parsed.pos_command,
+                                         parsed.length_command);
+    }
+    if (channel)
+    {
+        *channel = irc_message_get_item (&parsed, parsed.pos_channel,
+                                         parsed.length_channel);
+    }
+    if (arguments)
+    {
+        *arguments = irc_message_get_item (&parsed, parsed.pos_arguments,
+                                           parsed.length_arguments);
+    }
+    if (text)
+    {
+        *text = irc_message_get_item (&parsed, parsed.pos_text,
+                                      parsed.length_text);
+    }
+    if (pos_command)
+        *pos_command = parsed.pos_command;
+    if (pos_arguments)
+        *pos_arguments = parsed.pos_arguments;
+    if (pos_channel)
+        *pos_channel = parsed.pos_channel;
+    if (pos_text)
+        *pos_text = parsed.pos_text;
+}
+
 /*
  * Parses an IRC message and returns hashtable with keys:
  *   - tags
@@ -336,15 +373,12 @@ struct t_hashtable *
 irc_message_parse_to_hashtable (struct t_irc_server *server,
                                 const char *message)
 {
-    char *tags,*message_without_tags, *nick, *host, *command, *channel;
-    char *arguments, *text, str_pos[32];
-    char empty_str[1] = { '\0' };
-    int pos_command, pos_arguments, pos_channel, pos_text;
+    struct t_irc_message parsed;
     struct t_hashtable *hashtable;
+    char *item, str_pos[32];
+    int length;
 
-    irc_message_parse (server, message, &tags, &message_without_tags, &nick,
-                       &host, &command, &channel, &arguments, &text,
-                       &pos_command, &pos_arguments, &pos_channel, &pos_text);
+    irc_message_parse_to_struct (server, message, &parsed);
 
     hashtable = weechat_hashtable_new (32,
                                        WEECHAT_HASHTABLE_STRING,
@@ -353,51 +387,150 @@ irc_message_parse_to_hashtable (struct t_irc_server *server,
     if (!hashtable)
         return NULL;
 
-    weechat_hashtable_set (hashtable, "tags",
-                           (tags) ? tags : empty_str);
-    weechat_hashtable_set (hashtable, "message_without_tags",
-                           (message_without_tags) ? message_without_tags : empty_str);
-    weechat_hashtable_set (hashtable, "nick",
-                           (nick) ? nick : empty_str);
-    weechat_hashtable_set (hashtable, "host",
-                           (host) ? host : empty_str);
-    weechat_hashtable_set (hashtable, "command",
-                           (command) ? command : empty_str);
-    weechat_hashtable_set (hashtable, "channel",
-                           (channel) ? channel : empty_str);
-    weechat_hashtable_set (hashtable, "arguments",
-                           (arguments) ? arguments : empty_str);
-    weechat_hashtable_set (hashtable, "text",
-                           (text) ? text : empty_str);
-    snprintf (str_pos, sizeof (str_pos), "%d", pos_command);
+    /* buffer used to copy each item (hashtable makes a copy of values) */
+    length = (message) ? strlen (message) : 0;
+    item = malloc (length + 1);
+    if (!item)
+    {
+        weechat_hashtable_free (hashtable);
+        return NULL;
+    }
+
+#define IRC_MESSAGE_HASHTABLE_SET_ITEM(__item)                          \
+    if (parsed.pos_##__item >= 0)                                       \
+    {                                                                   \
+        memcpy (item, message + parsed.pos_##__item,                    \
+                parsed.length_##__item);                                \
+        item[parsed.length_##__item] = '\0';                            \
+    }                                                                   \
+    else                                                                \
+    {                                                                   \
+        item[0] = '\0';                                                 \
+    }                                                                   \
+    weechat_hashtable_set (hashtable, #__item, item);
+
+    IRC_MESSAGE_HASHTABLE_SET_ITEM(tags);
+    IRC_MESSAGE_HASHTABLE_SET_ITEM(message_without_tags);
+    IRC_MESSAGE_HASHTABLE_SET_ITEM(nick);
+    IRC_MESSAGE_HASHTABLE_SET_ITEM(host);
+    IRC_MESSAGE_HASHTABLE_SET_ITEM(command);
+    IRC_MESSAGE_HASHTABLE_SET_ITEM(channel);
+    IRC_MESSAGE_HASHTABLE_SET_ITEM(arguments);
+    IRC_MESSAGE_HASHTABLE_SET_ITEM(text);
+
+#undef IRC_MESSAGE_HASHTABLE_SET_ITEM
+
+    snprintf (str_pos, sizeof (str_pos), "%d", parsed.pos_command);
     weechat_hashtable_set (hashtable, "pos_command", str_pos);
-    snprintf (str_pos, sizeof (str_pos), "%d", pos_arguments);
+    snprintf (str_pos, sizeof (str_pos), "%d", parsed.pos_arguments);
     weechat_hashtable_set (hashtable, "pos_arguments", str_pos);
-    snprintf (str_pos, sizeof (str_pos), "%d", pos_channel);
+    snprintf (str_pos, sizeof (str_pos), "%d", parsed.pos_channel);
     weechat_hashtable_set (hashtable, "pos_channel", str_pos);
-    snprintf (str_pos, sizeof (str_pos), "%d", pos_text);
+    snprintf (str_pos, sizeof (str_pos), "%d", parsed.pos_text);
     weechat_hashtable_set (hashtable, "pos_text", str_pos);
 
-    if (tags)
-        free (tags);
-    if (message_without_tags)
-        free (message_without_tags);
-    if (nick)
-        free (nick);
-    if (host)
-        free (host);
-    if (command)
-        free (command);
-    if (channel)
-        free (channel);
-    if (arguments)
-        free (arguments);
-    if (text)
-        free (text);
+    free (item);
 
     return hashtable;
 }
 
+/*
+ * Splits a string with arguments of an IRC message (separated by spaces),
+ * like two calls to weechat_string_split (with keep_eol = 0 for argv, and
+ * keep_eol = 1 + keep_trailing_spaces for argv_eol), but with a single
+ * memory block for both arrays and their strings.
+ *
+ * Returns the number of arguments; argv and argv_eol are set to NULL if
+ * there are no arguments.
+ *
+ * Note: argv must be freed after use with free() (this frees also argv_eol),
+ * argv_eol must not be freed.
+ */
+
+int
+irc_message_split_argv (const char *string, int keep_trailing_spaces,
+                        char ***argv, char ***argv_eol)
+{
+    const char *ptr_string, *ptr;
+    char **array, **array_eol, *ptr_args, *ptr_eol;
+    int argc, length, length_eol, i, pos;
+
+    if (argv)
+        *argv = NULL;
+    if (argv_eol)
+        *argv_eol = NULL;
+
+    if (!string || !argv || !argv_eol)
+        return 0;
+
+    /* skip leading spaces, compute length without trailing spaces */
+    ptr_string = string;
+    while (ptr_string[0] == ' ')
+    {
+        ptr_string++;
+    }
+    if (!ptr_string[0])
+        return 0;
+    length_eol = strlen (ptr_string);
+    length = length_eol;
+    while (ptr_string[length - 1] == ' ')
+    {
+        length--;
+    }
+    if (!keep_trailing_spaces)
+        length_eol = length;
+
+    /* count arguments (the string ends with a char which is not a space) */
+    argc = 1;
+    for (ptr = ptr_string; ptr < ptr_string + length; ptr++)
+    {
+        if ((ptr[0] == ' ') && (ptr[1] != ' '))
+            argc++;
+    }
+
+    /* block: argv, argv_eol, arguments, arguments with end of line */
+    array = malloc ((2 * (argc + 1) * sizeof (array[0]))
+                    + length + 1 + length_eol + 1);
+    if (!array)
+        return 0;
+    array_eol = array + argc + 1;
+    ptr_args = (char *)(array_eol + argc + 1);
+    ptr_eol = ptr_args + length + 1;
+    memcpy (ptr_args, ptr_string, length);
+    ptr_args[length] = '\0';
+    memcpy (ptr_eol, ptr_string, length_eol);
+    ptr_eol[length_eol] = '\0';
+
+    i = 0;
+    pos = 0;
+    while (pos < length)
+    {
+        array[i] = ptr_args + pos;
+        array_eol[i] = ptr_eol + pos;
+        i++;
+        while ((pos < length) && (ptr_args[pos] != ' '))
+        {
+            pos++;
+        }
+        if (pos < length)
+        {
+            ptr_args[pos] = '\0';
+            pos++;
+            while (ptr_args[pos] == ' ')
+            {
+                pos++;
+            }
+        }
+    }
+    array[i] = NULL;
+    array_eol[i] = NULL;
+
+    *argv = array;
+    *argv_eol = array_eol;
+
+    return argc;
+}
+
 /*
  * Encodes/decodes an IRC message using a charset.
  *
@@ -567,50 +700,36 @@ irc_message_replace_vars (struct t_irc_server *server,
 }
 
 /*
- * Adds a message + arguments in hashtable.
+ * Sends a split message (+ arguments) to the callback of split context.
+ *
+ * The message includes the tags (if any) and is ready to be sent to IRC
+ * server.
  */
 
 void
-irc_message_split_add (struct t_hashtable *hashtable, int number,
-                       const char *tags, const char *message,
-                       const char *arguments)
+irc_message_split_add (struct t_irc_message_split_context *context,
+                       const char *message, const char *arguments)
 {
-    char key[32], value[32], *buf;
-    int length;
+    if (!context->rc || !message)
+        return;
 
-    if (message)
-    {
-        length = ((tags) ? strlen (tags) : 0) + strlen (message) + 1;
-        buf = malloc (length);
-        if (buf)
-        {
-            snprintf (key, sizeof (key), "msg%d", number);
-            snprintf (buf, length, "%s%s",
-                      (tags) ? tags : "",
-                      message);
-            weechat_hashtable_set (hashtable, key, buf);
-            if (weechat_irc_plugin->debug >= 2)
-            {
-                weechat_printf (NULL,
-                                "irc_message_split_add >> %s='%s' (%d bytes)",
-                                key, buf, length - 1);
-            }
-            free (buf);
-        }
-    }
-    if (arguments)
+    context->number++;
+
+    if (weechat_irc_plugin->debug >= 2)
     {
-        snprintf (key, sizeof (key), "args%d", number);
-        weechat_hashtable_set (hashtable, key, arguments);
-        if (weechat_irc_plugin->debug >= 2)
+        weechat_printf (NULL,
+                        "irc_message_split_add >> msg%d='%s' (%d bytes)",
+                        context->number, message, (int)strlen (message));
+        if (arguments)
         {
             weechat_printf (NULL,
-                            "irc_message_split_add >> %s='%s'",
-                            key, arguments);
+                            "irc_message_split_add >> args%d='%s'",
+                            context->number, arguments);
         }
     }
-    snprintf (value, sizeof (value), "%d", number);
-    weechat_hashtable_set (hashtable, "count", value);
+
+    context->rc = (context->callback) (context->callback_data,
+                                       context->number, message, arguments);
 }
 
 /*
@@ -636,9 +755,13 @@ irc_message_split_add (struct t_hashtable *hashtable, int number,
  *     arguments: "is eating"
  *     suffix   : "\01"
  *
- * Messages added to hashtable are:
- *   host + command + target + prefix + XXX + suffix
- * (where XXX is part of "arguments")
+ * Messages sent to callback are:
+ *   tags + host + command + target + prefix + XXX + suffix
+ * (where XXX is part of "arguments").
+ *
+ * The boundaries of messages are found in a single pass on arguments (never
+ * in the middle of an UTF-8 char), without copy of arguments (the char after
+ * each part is temporarily replaced by '\0').
  *
  * Returns:
  *   1: OK
@@ -646,21 +769,20 @@ irc_message_split_add (struct t_hashtable *hashtable, int number,
  */
 
 int
-irc_message_split_string (struct t_hashtable *hashtable,
+irc_message_split_string (struct t_irc_message_split_context *context,
                           const char *tags,
                           const char *host,
                           const char *command,
                           const char *target,
                           const char *prefix,
-                          const char *arguments,
+                          char *arguments,
                           const char *suffix,
                           const char delimiter,
                           int max_length_host,
                           int max_length)
 {
-    const char *pos, *pos_max, *pos_next, *pos_last_delim;
-    char message[8192], *dup_arguments;
-    int number;
+    char *pos, *pos_max, *pos_next, *pos_last_delim, saved_char;
+    char message[8192];
 
     max_length -= 2;  /* by default: 512 - 2 = 510 bytes */
     if (max_length_host >= 0)
@@ -689,11 +811,10 @@ irc_message_split_string (struct t_hashtable *hashtable,
                         max_length);
     }
 
-    number = 1;
-
     if (!arguments || !arguments[0])
     {
-        snprintf (message, sizeof (message), "%s%s%s %s%s%s%s",
+        snprintf (message, sizeof (message), "%s%s%s%s %s%s%s%s",
+                  (tags) ? tags : "",
                   (host) ? host : "",
                   (host) ? " " : "",
                   command,
@@ -701,11 +822,11 @@ irc_message_split_string (struct t_hashtable *hashtable,
                   (target && target[0]) ? " " : "",
                   (prefix) ? prefix : "",
                   (suffix) ? suffix : "");
-        irc_message_split_add (hashtable, 1, tags, message, "");
+        irc_message_split_add (context, message, "");
         return 1;
     }
 
-    while (arguments && arguments[0])
+    while (context->rc && arguments && arguments[0])
     {
         pos = arguments;
         pos_max = pos + max_length;
@@ -714,30 +835,29 @@ irc_message_split_string (struct t_hashtable *hashtable,
         {
             if (pos[0] == delimiter)
                 pos_last_delim = pos;
-            pos_next = weechat_utf8_next_char (pos);
+            /* fast path for 7-bit chars */
+            pos_next = ((unsigned char)pos[0] < 0x80) ?
+                pos + 1 : (char *)weechat_utf8_next_char (pos);
             if (pos_next > pos_max)
                 break;
             pos = pos_next;
         }
         if (pos[0] && pos_last_delim)
             pos = pos_last_delim;
-        dup_arguments = weechat_strndup (arguments, pos - arguments);
-        if (dup_arguments)
-        {
-            snprintf (message, sizeof (message), "%s%s%s %s%s%s%s%s",
-                      (host) ? host : "",
-                      (host) ? " " : "",
-                      command,
-                      (target) ? target : "",
-                      (target && target[0]) ? " " : "",
-                      (prefix) ? prefix : "",
-                      dup_arguments,
-                      (suffix) ? suffix : "");
-            irc_message_split_add (hashtable, number, tags, message,
-                                   dup_arguments);
-            number++;
-            free (dup_arguments);
-        }
+        saved_char = pos[0];
+        pos[0] = '\0';
+        snprintf (message, sizeof (message), "%s%s%s%s %s%s%s%s%s",
+                  (tags) ? tags : "",
+                  (host) ? host : "",
+                  (host) ? " " : "",
+                  command,
+                  (target) ? target : "",
+                  (target && target[0]) ? " " : "",
+                  (prefix) ? prefix : "",
+                  arguments,
+                  (suffix) ? suffix : "");
+        irc_message_split_add (context, message, arguments);
+        pos[0] = saved_char;
         arguments = (pos == pos_last_delim) ? pos + 1 : pos;
     }
 
@@ -754,20 +874,18 @@ irc_message_split_string (struct t_hashtable *hashtable,
  */
 
 int
-irc_message_split_join (struct t_hashtable *hashtable,
+irc_message_split_join (struct t_irc_message_split_context *context,
                         const char *tags, const char *host,
                         const char *arguments,
                         int max_length)
 {
-    int number, channels_count, keys_count, length, length_no_channel;
+    int channels_count, keys_count, length, length_no_channel, length_tags;
     int length_to_add, index_channel;
     char **channels, **keys, *pos, *str;
     char msg_to_send[16384], keys_to_add[16384];
 
     max_length -= 2;  /* by default: 512 - 2 = 510 bytes */
 
-    number = 1;
-
     channels = NULL;
     channels_count = 0;
     keys = NULL;
@@ -793,14 +911,19 @@ irc_message_split_join (struct t_hashtable *hashtable,
         channels = weechat_string_split (arguments, ",", 0, 0, &channels_count);
     }
 
-    snprintf (msg_to_send, sizeof (msg_to_send), "%s%sJOIN",
+    /* tags are not counted in length of message */
+    snprintf (msg_to_send, sizeof (msg_to_send), "%s", (tags) ? tags : "");
+    length_tags = strlen (msg_to_send);
+
+    snprintf (msg_to_send + length_tags, sizeof (msg_to_send) - length_tags,
+              "%s%sJOIN",
               (host) ? host : "",
               (host) ? " " : "");
-    length = strlen (msg_to_send);
+    length = strlen (msg_to_send + length_tags);
     length_no_channel = length;
     keys_to_add[0] = '\0';
     index_channel = 0;
-    while (index_channel < channels_count)
+    while (context->rc && (index_channel < channels_count))
     {
         length_to_add = 1 + strlen (channels[index_channel]);
         if (index_channel < keys_count)
@@ -808,7 +931,7 @@ irc_message_split_join (struct t_hashtable *hashtable,
         if ((length + length_to_add < max_length)
             || (length == length_no_channel))
         {
-            if (length + length_to_add < (int)sizeof (msg_to_send))
+            if (length_tags + length + length_to_add < (int)sizeof (msg_to_send))
             {
                 strcat (msg_to_send, (length == length_no_channel) ? " " : ",");
                 strcat (msg_to_send, channels[index_channel]);
@@ -828,26 +951,23 @@ irc_message_split_join (struct t_hashtable *hashtable,
         else
         {
             strcat (msg_to_send, keys_to_add);
-            irc_message_split_add (hashtable, number,
-                                   tags,
-                                   msg_to_send,
-                                   msg_to_send + length_no_channel + 1);
-            number++;
-            snprintf (msg_to_send, sizeof (msg_to_send), "%s%sJOIN",
-                      (host) ? host : "",
-                      (host) ? " " : "");
-            length = strlen (msg_to_send);
+            irc_message_split_add (
+                context,
+                msg_to_send,
+                msg_to_send + length_tags + length_no_channel + 1);
+            msg_to_send[length_tags + length_no_channel] = '\0';
+            length = length_no_channel;
             keys_to_add[0] = '\0';
         }
     }
 
-    if (length > length_no_channel)
+    if (context->rc && (length > length_no_channel))
     {
         strcat (msg_to_send, keys_to_add);
-        irc_message_split_add (hashtable, number,
-                               tags,
-                               msg_to_send,
-                               msg_to_send + length_no_channel + 1);
+        irc_message_split_add (
+            context,
+            msg_to_send,
+            msg_to_send + length_tags + length_no_channel + 1);
     }
 
     if (channels)
@@ -868,7 +988,7 @@ irc_message_split_join (struct t_hashtable *hashtable,
  */
 
 int
-irc_message_split_privmsg_notice (struct t_hashtable *hashtable,
+irc_message_split_privmsg_notice (struct t_irc_message_split_context *context,
                                   char *tags, char *host, char *command,
                                   char *target, char *arguments,
                                   int max_length_host,
@@ -909,7 +1029,7 @@ irc_message_split_privmsg_notice (struct t_hashtable *hashtable,
     if (!prefix[0])
         strcpy (prefix, ":");
 
-    rc = irc_message_split_string (hashtable, tags, host, command, target,
+    rc = irc_message_split_string (context, tags, host, command, target,
                                    prefix, arguments, suffix,
                                    ' ', max_length_host, max_length);
 
@@ -925,7 +1045,7 @@ irc_message_split_privmsg_notice (struct t_hashtable *hashtable,
  */
 
 int
-irc_message_split_005 (struct t_hashtable *hashtable,
+irc_message_split_005 (struct t_irc_message_split_context *context,
                        char *tags, char *host, char *command, char *target,
                        char *arguments, int max_length)
 {
@@ -948,13 +1068,14 @@ irc_message_split_005 (struct t_hashtable *hashtable,
         pos[0] = '\0';
     }
 
-    return irc_message_split_string (hashtable, tags, host, command, target,
+    return irc_message_split_string (context, tags, host, command, target,
                                      NULL, arguments, suffix, ' ', -1,
                                      max_length);
 }
 
 /*
- * Splits an IRC message about to be sent to IRC server.
+ * Splits an IRC message about to be sent to IRC server, and calls a function
+ * for each message of split (in order).
  *
  * The maximum length of an IRC message is 510 bytes for user data + final
  * "\r\n", so full size is 512 bytes (the user data does not include the
@@ -967,29 +1088,40 @@ irc_message_split_005 (struct t_hashtable *hashtable,
  * The split takes care about type of message to do a split at best place in
  * message.
  *
- * The hashtable returned contains keys "msg1", "msg2", ..., "msgN" with split
- * of message (these messages do not include the final "\r\n").
+ * The callback is called with arguments:
+ *   - callback_data
+ *   - number of message (first is 1)
+ *   - message (with command and arguments, without the final "\r\n"), ready
+ *     to be sent to IRC server
+ *   - arguments only (no host/command here), NULL if message could not be
+ *     parsed
+ * It returns 1 to continue, 0 to stop the split.
  *
- * Hashtable contains "args1", "args2", ..., "argsN" with split of arguments
- * only (no host/command here).
- *
- * Each message ("msgN") in hashtable has command and arguments, and then is
- * ready to be sent to IRC server.
- *
- * Returns hashtable with split message.
+ * Strings given to callback are valid only during the call.
  *
- * Note: result must be freed after use.
+ * Returns number of messages given to callback.
  */
 
-struct t_hashtable *
-irc_message_split (struct t_irc_server *server, const char *message)
+int
+irc_message_split_map (struct t_irc_server *server, const char *message,
+                       t_irc_message_split_map *callback,
+                       void *callback_data)
 {
-    struct t_hashtable *hashtable;
+    struct t_irc_message_split_context context;
     char **argv, **argv_eol, *tags, *host, *command, *arguments, target[4096];
-    char *pos, monitor_action[3];
+    char monitor_action[3];
+    const char *pos, *ptr_message;
     int split_ok, argc, index_args, max_length_nick, max_length_host;
     int split_msg_max_length;
 
+    if (!callback)
+        return 0;
+
+    context.callback = callback;
+    context.callback_data = callback_data;
+    context.number = 0;
+    context.rc = 1;
+
     split_ok = 0;
     tags = NULL;
     host = NULL;
@@ -997,6 +1129,7 @@ irc_message_split (struct t_irc_server *server, const char *message)
     arguments = NULL;
     argv = NULL;
     argv_eol = NULL;
+    ptr_message = message;
 
     if (server)
     {
@@ -1022,13 +1155,6 @@ irc_message_split (struct t_irc_server *server, const char *message)
                         message, split_msg_max_length);
     }
 
-    hashtable = weechat_hashtable_new (32,
-                                       WEECHAT_HASHTABLE_STRING,
-                                       WEECHAT_HASHTABLE_STRING,
-                                       NULL, NULL);
-    if (!hashtable)
-        return NULL;
-
     if (!message || !message[0])
         goto end;
 
@@ -1038,12 +1164,11 @@ irc_message_split (struct t_irc_server *server, const char *message)
         if (pos)
         {
             tags = weechat_strndup (message, pos - message + 1);
-            message = pos + 1;
+            ptr_message = pos + 1;
         }
     }
 
-    argv = weechat_string_split (message, " ", 0, 0, &argc);
-    argv_eol = weechat_string_split (message, " ", 2, 0, NULL);
+    argc = irc_message_split_argv (ptr_message, 1, &argv, &argv_eol);
 
     if (argc < 2)
         goto end;
@@ -1080,7 +1205,7 @@ irc_message_split (struct t_irc_server *server, const char *message)
          * WALLOPS :some text here
          */
         split_ok = irc_message_split_string (
-            hashtable, tags, host, command, NULL, ":",
+            &context, tags, host, command, NULL, ":",
             (argv_eol[index_args][0] == ':') ?
             argv_eol[index_args] + 1 : argv_eol[index_args],
             NULL, ' ', max_length_host, split_msg_max_length);
@@ -1097,14 +1222,14 @@ irc_message_split (struct t_irc_server *server, const char *message)
             snprintf (monitor_action, sizeof (monitor_action),
                       "%c ", argv_eol[index_args][0]);
             split_ok = irc_message_split_string (
-                hashtable, tags, host, command, NULL, monitor_action,
+                &context, tags, host, command, NULL, monitor_action,
                 argv_eol[index_args] + 2, NULL, ',', max_length_host,
                 split_msg_max_length);
         }
         else
         {
             split_ok = irc_message_split_string (
-                hashtable, tags, host, command, NULL, ":",
+                &context, tags, host, command, NULL, ":",
                 (argv_eol[index_args][0] == ':') ?
                 argv_eol[index_args] + 1 : argv_eol[index_args],
                 NULL, ',', max_length_host, split_msg_max_length);
@@ -1113,10 +1238,10 @@ irc_message_split (struct t_irc_server *server, const char *message)
     else if (weechat_strcasecmp (command, "join") == 0)
     {
         /* JOIN #channel1,#channel2,#channel3 key1,key2 */
-        if ((int)strlen (message) > split_msg_max_length - 2)
+        if ((int)strlen (ptr_message) > split_msg_max_length - 2)
         {
             /* split join if it's too long */
-            split_ok = irc_message_split_join (hashtable, tags, host,
+            split_ok = irc_message_split_join (&context, tags, host,
                                                arguments, split_msg_max_length);
         }
     }
@@ -1130,7 +1255,7 @@ irc_message_split (struct t_irc_server *server, const char *message)
         if (index_args + 1 <= argc - 1)
         {
             split_ok = irc_message_split_privmsg_notice (
-                hashtable, tags, host, command, argv[index_args],
+                &context, tags, host, command, argv[index_args],
                 (argv_eol[index_args + 1][0] == ':') ?
                 argv_eol[index_args + 1] + 1 : argv_eol[index_args + 1],
                 max_length_host, split_msg_max_length);
@@ -1142,7 +1267,7 @@ irc_message_split (struct t_irc_server *server, const char *message)
         if (index_args + 1 <= argc - 1)
         {
             split_ok = irc_message_split_005 (
-                hashtable, tags, host, command, argv[index_args],
+                &context, tags, host, command, argv[index_args],
                 (argv_eol[index_args + 1][0] == ':') ?
                 argv_eol[index_args + 1] + 1 : argv_eol[index_args + 1],
                 split_msg_max_length);
@@ -1161,7 +1286,7 @@ irc_message_split (struct t_irc_server *server, const char *message)
                 snprintf (target, sizeof (target), "%s %s",
                           argv[index_args], argv[index_args + 1]);
                 split_ok = irc_message_split_string (
-                    hashtable, tags, host, command, target, ":",
+                    &context, tags, host, command, target, ":",
                     (argv_eol[index_args + 2][0] == ':') ?
                     argv_eol[index_args + 2] + 1 : argv_eol[index_args + 2],
                     NULL, ' ', -1, split_msg_max_length);
@@ -1174,7 +1299,7 @@ irc_message_split (struct t_irc_server *server, const char *message)
                               argv[index_args], argv[index_args + 1],
                               argv[index_args + 2]);
                     split_ok = irc_message_split_string (
-                        hashtable, tags, host, command, target, ":",
+                        &context, tags, host, command, target, ":",
                         (argv_eol[index_args + 3][0] == ':') ?
                         argv_eol[index_args + 3] + 1 : argv_eol[index_args + 3],
                         NULL, ' ', -1, split_msg_max_length);
@@ -1184,18 +1309,82 @@ irc_message_split (struct t_irc_server *server, const char *message)
     }
 
 end:
-    if (!split_ok
-        || (weechat_hashtable_get_integer (hashtable, "items_count") == 0))
-    {
-        irc_message_split_add (hashtable, 1, tags, message, arguments);
-    }
+    /* message not split: it is sent as-is */
+    if (!split_ok || (context.number == 0))
+        irc_message_split_add (&context, message, arguments);
 
     if (tags)
         free (tags);
     if (argv)
-        weechat_string_free_split (argv);
-    if (argv_eol)
-        weechat_string_free_split (argv_eol);
+        free (argv);
+
+    return context.number;
+}
+
+/*
+ * Callback called for each message of split: adds message and arguments in
+ * hashtable.
+ */
+
+int
+irc_message_split_hashtable_cb (void *data, int number, const char *message,
+                                const char *arguments)
+{
+    struct t_hashtable *hashtable;
+    char key[32], value[32];
+
+    hashtable = (struct t_hashtable *)data;
+
+    snprintf (key, sizeof (key), "msg%d", number);
+    weechat_hashtable_set (hashtable, key, message);
+    if (arguments)
+    {
+        snprintf (key, sizeof (key), "args%d", number);
+        weechat_hashtable_set (hashtable, key, arguments);
+    }
+    snprintf (value, sizeof (value), "%d", number);
+    weechat_hashtable_set (hashtable, "count", value);
+
+    return 1;
+}
+
+/*
+ * Splits an IRC message about to be sent to IRC server (see function
+ * irc_message_split_map).
+ *
+ * The hashtable returned contains keys "msg1", "msg2", ..., "msgN" with split
+ * of message (these messages do not include the final "\r\n").
+ *
+ * Hashtable contains "args1", "args2", ..., "argsN" with split of arguments
+ * only (no host/command here).
+ *
+ * Each message ("msgN") in hashtable has command and arguments, and then is
+ * ready to be sent to IRC server.
+ *
+ * Returns hashtable with split message.
+ *
+ * Note: result must be freed after use.
+ */
+
+struct t_hashtable *
+irc_message_split (struct t_irc_server *server, const char *message)
+{
+    struct t_hashtable *hashtable;
+
+    hashtable = weechat_hashtable_new (32,
+                                       WEECHAT_HASHTABLE_STRING,
+                                       WEECHAT_HASHTABLE_STRING,
+                                       NULL, NULL);
+    if (!hashtable)
+        return NULL;
+
+    /* no message (NULL): count is "1", as for a message not split */
+    if (irc_message_split_map (server, message,
+                               &irc_message_split_hashtable_cb,
+                               hashtable) == 0)
+    {
+        weechat_hashtable_set (hashtable, "count", "1");
+    }
 
     return hashtable;
 }
@@ -23,6 +23,56 @@
 struct t_irc_server;
 struct t_irc_channel;
 
+/*
+ * IRC message parsed: position and length of items in message (the message
+ * is not copied); position is -1 if the item is not in message
+ */
+
+struct t_irc_message
+{
+    const char *message;            /* message parsed                        */
+    int pos_tags;                   /* tags (without "@")                    */
+    int length_tags;
+    int pos_message_without_tags;   /* message without tags                  */
+    int length_message_without_tags;
+    int pos_nick;                   /* nick                                  */
+    int length_nick;
+    int pos_host;                   /* host (without ":")                    */
+    int length_host;
+    int pos_command;                /* command                               */
+    int length_command;
+    int pos_arguments;              /* arguments (until end of message)      */
+    int length_arguments;
+    int pos_channel;                /* channel                               */
+    int length_channel;
+    int pos_text;                   /* text (until end of message)           */
+    int length_text;
+};
+
+/*
+ * function called for each message of a split (see irc_message_split_map),
+ * returns 1 to continue, 0 to stop the split
+ */
+
+typedef int (t_irc_message_split_map)(void *data, int number,
+                                      const char *message,
+                                      const char *arguments);
+
+/* context of a split: callback and number of messages already sent to it */
+
+struct t_irc_message_split_context
+{
+    t_irc_message_split_map *callback; /* function called for each message  */
+    void *callback_data;            /* data sent to callback                 */
+    int number;                     /* number of messages sent to callback   */
+    int rc;                         /* 0 if callback has stopped the split   */
+};
+
+extern void irc_message_parse_to_struct (struct t_irc_server *server,
+                                         const char *message,
+                                         struct t_irc_message *parsed);
+extern char *irc_message_get_item (struct t_irc_message *parsed,
+                                   int pos, int length);
 extern void irc_message_parse (struct t_irc_server *server, const char *message,
                                char **tags, char **message_without_tags,
                                char **nick, char **host, char **command,
@@ -31,6 +81,9 @@ extern void irc_message_parse (struct t_irc_server *server, const char *message,
                                int *pos_channel, int *pos_text);
 extern struct t_hashtable *irc_message_parse_to_hashtable (struct t_irc_server *server,
                                                            const char *message);
+extern int irc_message_split_argv (const char *string,
+                                   int keep_trailing_spaces,
+                                   char ***argv, char ***argv_eol);
 extern char *irc_message_convert_charset (const char *message,
                                           int pos_start,
                                           const char *modifier,
@@ -40,6 +93,10 @@ extern const char *irc_message_get_address_from_host (const char *host);
 extern char *irc_message_replace_vars (struct t_irc_server *server,
                                        const char *channel_name,
                                        const char *string);
+extern int irc_message_split_map (struct t_irc_server *server,
+                                  const char *message,
+                                  t_irc_message_split_map *callback,
+                                  void *callback_data);
 extern struct t_hashtable *irc_message_split (struct t_irc_server *server,
                                               const char *message);
 
@@ -443,6 +443,147 @@ irc_nick_nicklist_set_color_all ()
     }
 }
 
+/*
+ * Builds the key of a nick in index of nicks: the nick in lower case,
+ * according to the casemapping (so that two nicks equal with function
+ * irc_server_strcasecmp have same key).
+ *
+ * The key is stored in "buffer" if it is large enough, otherwise it is
+ * allocated.
+ *
+ * Returns pointer to key (buffer or allocated string), NULL if error.
+ *
+ * Note: result must be freed after use if it is different from "buffer".
+ */
+
+char *
+irc_nick_index_key (int casemapping, const char *nickname,
+                    char *buffer, int size_buffer)
+{
+    char *key;
+    int i, length, range;
+
+    switch (casemapping)
+    {
+        case IRC_SERVER_CASEMAPPING_STRICT_RFC1459:
+            range = 29;
+            break;
+        case IRC_SERVER_CASEMAPPING_ASCII:
+            range = 26;
+            break;
+        default:
+            range = 30;
+            break;
+    }
+
+    length = strlen (nickname);
+    key = (length < size_buffer) ? buffer : malloc (length + 1);
+    if (!key)
+        return NULL;
+
+    for (i = 0; i < length; i++)
+    {
+        key[i] = ((nickname[i] >= 'A') && (nickname[i] < 'A' + range)) ?
+            nickname[i] + ('a' - 'A') : nickname[i];
+    }
+    key[length] = '\0';
+
+    return key;
+}
+
+/*
+ * Adds a nick in index of nicks.
+ */
+
+void
+irc_nick_index_add (struct t_irc_channel *channel, struct t_irc_nick *nick)
+{
+    char str_key[128], *key;
+
+    if (!channel->nicks_index)
+        return;
+
+    key = irc_nick_index_key (channel->nicks_index_casemapping, nick->name,
+                              str_key, sizeof (str_key));
+    if (!key)
+        return;
+
+    weechat_hashtable_set (channel->nicks_index, key, nick);
+
+    if (key != str_key)
+        free (key);
+}
+
+/*
+ * Removes a nick from index of nicks.
+ */
+
+void
+irc_nick_index_remove (struct t_irc_channel *channel, struct t_irc_nick *nick)
+{
+    char str_key[128], *key;
+
+    if (!channel->nicks_index)
+        return;
+
+    key = irc_nick_index_key (channel->nicks_index_casemapping, nick->name,
+                              str_key, sizeof (str_key));
+    if (!key)
+        return;
+
+    if (weechat_hashtable_get (channel->nicks_index, key) == nick)
+        weechat_hashtable_remove (channel->nicks_index, key);
+
+    if (key != str_key)
+        free (key);
+}
+
+/*
+ * Builds index of nicks for a channel, using casemapping of server (the index
+ * is built again if the casemapping of server has changed).
+ *
+ * Returns:
+ *   1: OK
+ *   0: error (the index is not available)
+ */
+
+int
+irc_nick_index_build (struct t_irc_server *server,
+                      struct t_irc_channel *channel)
+{
+    struct t_irc_nick *ptr_nick;
+    int casemapping;
+
+    casemapping = (server) ? server->casemapping : IRC_SERVER_CASEMAPPING_RFC1459;
+
+    if (channel->nicks_index)
+    {
+        if (channel->nicks_index_casemapping == casemapping)
+            return 1;
+        weechat_hashtable_remove_all (channel->nicks_index);
+    }
+    else
+    {
+        channel->nicks_index = weechat_hashtable_new (
+            32,
+            WEECHAT_HASHTABLE_STRING,
+            WEECHAT_HASHTABLE_POINTER,
+            NULL, NULL);
+        if (!channel->nicks_index)
+            return 0;
+    }
+
+    channel->nicks_index_casemapping = casemapping;
+
+    for (ptr_nick = channel->nicks; ptr_nick;
+         ptr_nick = ptr_nick->next_nick)
+    {
+        irc_nick_index_add (channel, ptr_nick);
+    }
+
+    return 1;
+}
+
 /*
  * Adds a new nick in channel.
  *
@@ -528,6 +669,8 @@ irc_nick_new (struct t_irc_server *server, struct t_irc_channel *channel,
     channel->last_nick = new_nick;
     new_nick->next_nick = NULL;
 
+    irc_nick_index_add (channel, new_nick);
+
     channel->nicks_count++;
 
     channel->nick_completion_reset = 1;
@@ -558,9 +701,11 @@ irc_nick_change (struct t_irc_server *server, struct t_irc_channel *channel,
         irc_channel_nick_speaking_rename (channel, nick->name, new_nick);
 
     /* change nickname */
+    irc_nick_index_remove (channel, nick);
     if (nick->name)
         free (nick->name);
     nick->name = strdup (new_nick);
+    irc_nick_index_add (channel, nick);
     if (nick->color)
         free (nick->color);
     if (nick_is_me)
@@ -618,6 +763,7 @@ irc_nick_free (struct t_irc_server *server, struct t_irc_channel *channel,
     irc_nick_nicklist_remove (server, channel, nick);
 
     /* remove nick */
+    irc_nick_index_remove (channel, nick);
     if (channel->last_nick == nick)
         channel->last_nick = nick->prev_nick;
     if (nick->prev_nick)
@@ -689,10 +835,29 @@ irc_nick_search (struct t_irc_server *server, struct t_irc_channel *channel,
                  const char *nickname)
 {
     struct t_irc_nick *ptr_nick;
+    char str_key[128], *key;
 
     if (!channel || !nickname)
         return NULL;
 
+    if (!channel->nicks)
+        return NULL;
+
+    /* search nick in index */
+    if (irc_nick_index_build (server, channel))
+    {
+        key = irc_nick_index_key (channel->nicks_index_casemapping, nickname,
+                                  str_key, sizeof (str_key));
+        if (key)
+        {
+            ptr_nick = weechat_hashtable_get (channel->nicks_index, key);
+            if (key != str_key)
+                free (key);
+            return ptr_nick;
+        }
+    }
+
+    /* index not available: search in list of nicks */
     for (ptr_nick = channel->nicks; ptr_nick;
          ptr_nick = ptr_nick->next_nick)
     {
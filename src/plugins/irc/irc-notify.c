@@ -314,6 +314,26 @@ irc_notify_build_message_with_nicks (struct t_irc_server *server,
     return message;
 }
 
+/*
+ * Callback called for each message of split of MONITOR message: sends the
+ * message to server.
+ */
+
+int
+irc_notify_send_monitor_split_cb (void *data, int number,
+                                  const char *message, const char *arguments)
+{
+    /* make C compiler happy */
+    (void) number;
+    (void) arguments;
+
+    irc_server_sendf ((struct t_irc_server *)data,
+                      IRC_SERVER_SEND_OUTQ_PRIO_LOW,
+                      NULL, "%s", message);
+
+    return 1;
+}
+
 /*
  * Sends the MONITOR message (after server connection or if the option
  * "irc.server.xxx.notify" is changed).
@@ -322,10 +342,8 @@ irc_notify_build_message_with_nicks (struct t_irc_server *server,
 void
 irc_notify_send_monitor (struct t_irc_server *server)
 {
-    struct t_hashtable *hashtable;
-    char *message, hash_key[32];
-    const char *str_message;
-    int num_nicks, number;
+    char *message;
+    int num_nicks;
 
     message = irc_notify_build_message_with_nicks (server,
                                                    "MONITOR + ",
@@ -333,24 +351,8 @@ irc_notify_send_monitor (struct t_irc_server *server)
                                                    &num_nicks);
     if (message && (num_nicks > 0))
     {
-        hashtable = irc_message_split (server, message);
-        if (hashtable)
-        {
-            number = 1;
-            while (1)
-            {
-                snprintf (hash_key, sizeof (hash_key), "msg%d", number);
-                str_message = weechat_hashtable_get (hashtable,
-                                                     hash_key);
-                if (!str_message)
-                    break;
-                irc_server_sendf (server,
-                                  IRC_SERVER_SEND_OUTQ_PRIO_LOW,
-                                  NULL, "%s", str_message);
-                number++;
-            }
-            weechat_hashtable_free (hashtable);
-        }
+        irc_message_split_map (server, message,
+                               &irc_notify_send_monitor_split_cb, server);
     }
     if (message)
         free (message);
@@ -965,6 +967,30 @@ irc_notify_hsignal_cb (const void *pointer, void *data, const char *signal,
     return WEECHAT_RC_OK;
 }
 
+/*
+ * Callback called for each message of split of ISON message: sends the
+ * message to server (with a redirection).
+ */
+
+int
+irc_notify_timer_ison_split_cb (void *data, int number, const char *message,
+                                const char *arguments)
+{
+    struct t_irc_server *server;
+
+    /* make C compiler happy */
+    (void) number;
+    (void) arguments;
+
+    server = (struct t_irc_server *)data;
+
+    irc_redirect_new (server, "ison", "notify", 1, NULL, 0, NULL);
+    irc_server_sendf (server, IRC_SERVER_SEND_OUTQ_PRIO_LOW,
+                      NULL, "%s", message);
+
+    return 1;
+}
+
 /*
  * Timer called to send "ison" command to servers.
  */
@@ -972,11 +998,9 @@ irc_notify_hsignal_cb (const void *pointer, void *data, const char *signal,
 int
 irc_notify_timer_ison_cb (const void *pointer, void *data, int remaining_calls)
 {
-    char *message, hash_key[32];
-    const char *str_message;
-    int num_nicks, number;
+    char *message;
+    int num_nicks;
     struct t_irc_server *ptr_server;
-    struct t_hashtable *hashtable;
 
     /* make C compiler happy */
     (void) pointer;
@@ -996,26 +1020,9 @@ irc_notify_timer_ison_cb (const void *pointer, void *data, int remaining_calls)
                                                            &num_nicks);
             if (message && (num_nicks > 0))
             {
-                hashtable = irc_message_split (ptr_server, message);
-                if (hashtable)
-                {
-                    number = 1;
-                    while (1)
-                    {
-                        snprintf (hash_key, sizeof (hash_key), "msg%d", number);
-                        str_message = weechat_hashtable_get (hashtable,
-                                                             hash_key);
-                        if (!str_message)
-                            break;
-                        irc_redirect_new (ptr_server, "ison", "notify", 1,
-                                          NULL, 0, NULL);
-                        irc_server_sendf (ptr_server,
-                                          IRC_SERVER_SEND_OUTQ_PRIO_LOW,
-                                          NULL, "%s", str_message);
-                        number++;
-                    }
-                    weechat_hashtable_free (hashtable);
-                }
+                irc_message_split_map (ptr_server, message,
+                                       &irc_notify_timer_ison_split_cb,
+                                       ptr_server);
             }
             if (message)
                 free (message);
@@ -22,6 +22,8 @@
 
 #include <time.h>
 
+struct t_irc_message;
+
 #define IRC_PROTOCOL_CALLBACK(__command)                                \
     int                                                                 \
     irc_protocol_cb_##__command (struct t_irc_server *server,           \
@@ -86,8 +88,10 @@ struct t_irc_protocol_msg
 extern const char *irc_protocol_tags (const char *command, const char *tags,
                                       const char *nick, const char *address);
 extern time_t irc_protocol_parse_time (const char *time);
+extern time_t irc_protocol_get_message_time (struct t_irc_message *parsed);
+extern struct t_irc_protocol_msg *irc_protocol_search_message (const char *command);
 extern void irc_protocol_recv_command (struct t_irc_server *server,
-                                       const char *irc_message,
+                                       struct t_irc_message *parsed,
                                        const char *msg_command,
                                        const char *msg_channel);
 
@@ -71,9 +71,6 @@
 struct t_irc_server *irc_servers = NULL;
 struct t_irc_server *last_irc_server = NULL;
 
-struct t_irc_message *irc_recv_msgq = NULL;
-struct t_irc_message *irc_msgq_last_msg = NULL;
-
 char *irc_server_sasl_fail_string[IRC_SERVER_NUM_SASL_FAIL] =
 { "continue", "reconnect", "disconnect" };
 
@@ -112,6 +109,7 @@ char *irc_server_options[IRC_SERVER_NUM_OPTIONS][2] =
   { "connection_timeout",   "60"                      },
   { "anti_flood_prio_high", "2"                       },
   { "anti_flood_prio_low",  "2"                       },
+  { "anti_flood_burst",     "5"                       },
   { "away_check",           "0"                       },
   { "away_check_max_nicks", "25"                      },
   { "msg_kick",             ""                        },
@@ -1304,10 +1302,15 @@ irc_server_alloc (const char *name)
     new_server->hook_fd = NULL;
     new_server->hook_timer_connection = NULL;
     new_server->hook_timer_sasl = NULL;
+    new_server->hook_timer_anti_flood = NULL;
     new_server->is_connected = 0;
     new_server->ssl_connected = 0;
     new_server->disconnected = 0;
-    new_server->unterminated_message = NULL;
+    new_server->recv_buffer = NULL;
+    new_server->recv_buffer_size = 0;
+    new_server->recv_buffer_length = 0;
+    new_server->recv_buffer_spare = NULL;
+    new_server->recv_buffer_spare_size = 0;
     new_server->nicks_count = 0;
     new_server->nicks_array = NULL;
     new_server->nick_first_tried = 0;
@@ -1351,14 +1354,22 @@ irc_server_alloc (const char *name)
         weechat_config_integer (irc_config_network_lag_check);
     new_server->lag_last_refresh = 0;
     new_server->cmd_list_regexp = NULL;
-    new_server->last_user_message = 0;
+    new_server->last_user_message.tv_sec = 0;
+    new_server->last_user_message.tv_usec = 0;
+    new_server->anti_flood_tokens = 0;
+    new_server->anti_flood_refill.tv_sec = 0;
+    new_server->anti_flood_refill.tv_usec = 0;
     new_server->last_away_check = 0;
     new_server->last_data_purge = 0;
     for (i = 0; i < IRC_SERVER_NUM_OUTQUEUES_PRIO; i++)
     {
         new_server->outqueue[i] = NULL;
         new_server->last_outqueue[i] = NULL;
+        new_server->outqueue_count[i] = 0;
+        new_server->outqueue_round[i] = 0;
     }
+    new_server->outqueue_latency = 0;
+    new_server->outqueue_latency_max = 0;
     new_server->redirects = NULL;
     new_server->last_redirect = NULL;
     new_server->notify_list = NULL;
@@ -1690,17 +1701,41 @@ irc_server_apply_command_line_options (struct t_irc_server *server,
     }
 }
 
+/*
+ * Checks if two targets of messages in out queue are the same (channel or
+ * nick, case insensitive).
+ *
+ * Returns:
+ *   1: same target
+ *   0: different targets
+ */
+
+int
+irc_server_outqueue_same_target (struct t_irc_server *server,
+                                 const char *target1, const char *target2)
+{
+    if (!target1 || !target2)
+        return (!target1 && !target2) ? 1 : 0;
+
+    return (irc_server_strcasecmp (server, target1, target2) == 0) ? 1 : 0;
+}
+
 /*
  * Adds a message in out queue.
+ *
+ * The message gets a "round" number for fair queuing: each target
+ * (channel/nick) has at most one message per round, so that many messages
+ * sent to one target do not delay messages sent to other targets.
  */
 
 void
 irc_server_outqueue_add (struct t_irc_server *server, int priority,
                          const char *command, const char *msg1,
                          const char *msg2, int modified, const char *tags,
-                         struct t_irc_redirect *redirect)
+                         struct t_irc_redirect *redirect, const char *target)
 {
-    struct t_irc_outqueue *new_outqueue;
+    struct t_irc_outqueue *new_outqueue, *ptr_outqueue;
+    int round;
 
     new_outqueue = malloc (sizeof (*new_outqueue));
     if (new_outqueue)
@@ -1711,6 +1746,23 @@ irc_server_outqueue_add (struct t_irc_server *server, int priority,
         new_outqueue->modified = modified;
         new_outqueue->tags = (tags) ? strdup (tags) : NULL;
         new_outqueue->redirect = redirect;
+        new_outqueue->target = (target) ? strdup (target) : NULL;
+        gettimeofday (&new_outqueue->time_queued, NULL);
+
+        /* message is sent after the last queued message for same target */
+        round = server->outqueue_round[priority] + 1;
+        for (ptr_outqueue = server->last_outqueue[priority]; ptr_outqueue;
+             ptr_outqueue = ptr_outqueue->prev_outqueue)
+        {
+            if (irc_server_outqueue_same_target (server, ptr_outqueue->target,
+                                                 target))
+            {
+                if (ptr_outqueue->round >= round)
+                    round = ptr_outqueue->round + 1;
+                break;
+            }
+        }
+        new_outqueue->round = round;
 
         new_outqueue->prev_outqueue = server->last_outqueue[priority];
         new_outqueue->next_outqueue = NULL;
@@ -1719,6 +1771,8 @@ irc_server_outqueue_add (struct t_irc_server *server, int priority,
         else
             server->outqueue[priority] = new_outqueue;
         server->last_outqueue[priority] = new_outqueue;
+
+        server->outqueue_count[priority]++;
     }
 }
 
@@ -1759,10 +1813,14 @@ irc_server_outqueue_free (struct t_irc_server *server,
         free (outqueue->message_after_mod);
     if (outqueue->tags)
         free (outqueue->tags);
+    if (outqueue->target)
+        free (outqueue->target);
     free (outqueue);
 
     /* set new head */
     server->outqueue[priority] = new_outqueue;
+
+    server->outqueue_count[priority]--;
 }
 
 /*
@@ -1833,8 +1891,9 @@ irc_server_free_data (struct t_irc_server *server)
         weechat_unhook (server->hook_timer_connection);
     if (server->hook_timer_sasl)
         weechat_unhook (server->hook_timer_sasl);
-    if (server->unterminated_message)
-        free (server->unterminated_message);
+    if (server->hook_timer_anti_flood)
+        weechat_unhook (server->hook_timer_anti_flood);
+    irc_server_recv_buffer_free (server);
     if (server->nicks_array)
         weechat_string_free_split (server->nicks_array);
     if (server->nick)
@@ -2276,96 +2335,324 @@ irc_server_get_tags_to_send (const char *tags)
 }
 
 /*
- * Sends a message from out queue.
+ * Refills the anti-flood tokens of server: one token is added every
+ * "anti_flood_prio_high" seconds, up to "anti_flood_burst" tokens.
  */
 
 void
-irc_server_outqueue_send (struct t_irc_server *server)
+irc_server_anti_flood_refill (struct t_irc_server *server,
+                              struct timeval *tv_now)
 {
-    time_t time_now;
-    char *pos, *tags_to_send;
-    int priority, anti_flood;
+    int anti_flood, burst;
+    long long diff, tokens;
+
+    anti_flood = IRC_SERVER_OPTION_INTEGER(
+        server, IRC_SERVER_OPTION_ANTI_FLOOD_PRIO_HIGH);
+    burst = IRC_SERVER_OPTION_INTEGER(
+        server, IRC_SERVER_OPTION_ANTI_FLOOD_BURST);
+
+    /* first use (or no anti-flood): the bucket is full */
+    if ((anti_flood == 0) || (server->anti_flood_refill.tv_sec == 0))
+    {
+        server->anti_flood_tokens = burst;
+        server->anti_flood_refill = *tv_now;
+        return;
+    }
 
-    time_now = time (NULL);
+    diff = weechat_util_timeval_diff (&server->anti_flood_refill, tv_now);
 
     /* detect if system clock has been changed (now lower than before) */
-    if (server->last_user_message > time_now)
-        server->last_user_message = time_now;
+    if (diff < 0)
+    {
+        server->anti_flood_refill = *tv_now;
+        return;
+    }
 
-    for (priority = 0; priority < IRC_SERVER_NUM_OUTQUEUES_PRIO; priority++)
+    tokens = diff / ((long long)anti_flood * 1000000);
+    if (server->anti_flood_tokens + tokens >= burst)
     {
-        switch (priority)
+        /* bucket is full: next token is counted from now */
+        server->anti_flood_tokens = burst;
+        server->anti_flood_refill = *tv_now;
+    }
+    else if (tokens > 0)
+    {
+        server->anti_flood_tokens += tokens;
+        weechat_util_timeval_add (&server->anti_flood_refill,
+                                  tokens * anti_flood * 1000000);
+    }
+}
+
+/*
+ * Returns the delay (in milliseconds) before a message with given priority
+ * can be sent to server (0 = message can be sent now).
+ *
+ * All queued messages share a token bucket: "anti_flood_burst" messages can
+ * be sent at once, then one message every "anti_flood_prio_high" seconds.
+ * Low priority messages also wait "anti_flood_prio_low" seconds after the
+ * last message sent.
+ */
+
+long long
+irc_server_anti_flood_delay (struct t_irc_server *server, int priority,
+                             struct timeval *tv_now)
+{
+    int anti_flood_high, anti_flood_low;
+    long long delay, delay_low;
+
+    anti_flood_high = IRC_SERVER_OPTION_INTEGER(
+        server, IRC_SERVER_OPTION_ANTI_FLOOD_PRIO_HIGH);
+    anti_flood_low = IRC_SERVER_OPTION_INTEGER(
+        server, IRC_SERVER_OPTION_ANTI_FLOOD_PRIO_LOW);
+
+    irc_server_anti_flood_refill (server, tv_now);
+
+    if ((priority == 0) && (anti_flood_high == 0))
+        return 0;
+    if ((priority > 0) && (anti_flood_low == 0))
+        return 0;
+
+    /* detect if system clock has been changed (now lower than before) */
+    if (weechat_util_timeval_cmp (&server->last_user_message, tv_now) > 0)
+        server->last_user_message = *tv_now;
+
+    delay = 0;
+
+    if (server->anti_flood_tokens <= 0)
+    {
+        /* wait for next token (rounded up to next millisecond) */
+        delay = (((long long)anti_flood_high * 1000000)
+                 - weechat_util_timeval_diff (&server->anti_flood_refill,
+                                              tv_now)
+                 + 999) / 1000;
+        if (delay < 1)
+            delay = 1;
+    }
+
+    if ((priority > 0) && (server->last_user_message.tv_sec > 0))
+    {
+        /* wait after last message sent (rounded up to next millisecond) */
+        delay_low = (((long long)anti_flood_low * 1000000)
+                     - weechat_util_timeval_diff (&server->last_user_message,
+                                                  tv_now)
+                     + 999) / 1000;
+        if (delay_low > delay)
+            delay = delay_low;
+    }
+
+    return delay;
+}
+
+/*
+ * Consumes an anti-flood token: called when a message from a queue
+ * (high or low priority) is sent to server.
+ */
+
+void
+irc_server_anti_flood_consume (struct t_irc_server *server,
+                               struct timeval *tv_now)
+{
+    if (server->anti_flood_tokens > 0)
+        server->anti_flood_tokens--;
+    server->last_user_message = *tv_now;
+}
+
+/*
+ * Gets next message to send in out queue: message with lowest round (first
+ * one in queue if many messages have same round).
+ *
+ * Returns pointer to message, NULL if queue is empty.
+ */
+
+struct t_irc_outqueue *
+irc_server_outqueue_get_next (struct t_irc_server *server, int priority)
+{
+    struct t_irc_outqueue *ptr_outqueue, *ptr_next;
+
+    ptr_next = server->outqueue[priority];
+    if (!ptr_next)
+        return NULL;
+
+    for (ptr_outqueue = ptr_next->next_outqueue; ptr_outqueue;
+         ptr_outqueue = ptr_outqueue->next_outqueue)
+    {
+        /* no message in queue has a round lower than the current one */
+        if (ptr_next->round <= server->outqueue_round[priority])
+            break;
+        if (ptr_outqueue->round < ptr_next->round)
+            ptr_next = ptr_outqueue;
+    }
+
+    return ptr_next;
+}
+
+/*
+ * Sends a message from out queue and removes it from queue.
+ */
+
+void
+irc_server_outqueue_send_msg (struct t_irc_server *server, int priority,
+                              struct t_irc_outqueue *outqueue,
+                              struct timeval *tv_now)
+{
+    char *pos, *tags_to_send;
+    long long latency;
+
+    if (outqueue->message_before_mod)
+    {
+        pos = strchr (outqueue->message_before_mod, '\r');
+        if (pos)
+            pos[0] = '\0';
+        irc_raw_print (server, IRC_RAW_FLAG_SEND,
+                       outqueue->message_before_mod);
+        if (pos)
+            pos[0] = '\r';
+    }
+    if (outqueue->message_after_mod)
+    {
+        pos = strchr (outqueue->message_after_mod, '\r');
+        if (pos)
+            pos[0] = '\0';
+        irc_raw_print (server, IRC_RAW_FLAG_SEND |
+                       ((outqueue->modified) ? IRC_RAW_FLAG_MODIFIED : 0),
+                       outqueue->message_after_mod);
+        if (pos)
+            pos[0] = '\r';
+
+        /* send signal with command that will be sent to server */
+        irc_server_send_signal (
+            server, "irc_out",
+            outqueue->command,
+            outqueue->message_after_mod,
+            NULL);
+        tags_to_send = irc_server_get_tags_to_send (outqueue->tags);
+        irc_server_send_signal (
+            server, "irc_outtags",
+            outqueue->command,
+            outqueue->message_after_mod,
+            (tags_to_send) ? tags_to_send : "");
+        if (tags_to_send)
+            free (tags_to_send);
+
+        /* send command */
+        irc_server_send (server, outqueue->message_after_mod,
+                         strlen (outqueue->message_after_mod));
+        irc_server_anti_flood_consume (server, tv_now);
+
+        /* start redirection if redirect is set */
+        if (outqueue->redirect)
         {
-            case 0:
-                anti_flood = IRC_SERVER_OPTION_INTEGER(
-                    server, IRC_SERVER_OPTION_ANTI_FLOOD_PRIO_HIGH);
-                break;
-            default:
-                anti_flood = IRC_SERVER_OPTION_INTEGER(
-                    server, IRC_SERVER_OPTION_ANTI_FLOOD_PRIO_LOW);
-                break;
+            irc_redirect_init_command (outqueue->redirect,
+                                       outqueue->message_after_mod);
         }
-        if (server->outqueue[priority]
-            && (time_now >= server->last_user_message + anti_flood))
-        {
-            if (server->outqueue[priority]->message_before_mod)
-            {
-                pos = strchr (server->outqueue[priority]->message_before_mod,
-                              '\r');
-                if (pos)
-                    pos[0] = '\0';
-                irc_raw_print (server, IRC_RAW_FLAG_SEND,
-                               server->outqueue[priority]->message_before_mod);
-                if (pos)
-                    pos[0] = '\r';
-            }
-            if (server->outqueue[priority]->message_after_mod)
-            {
-                pos = strchr (server->outqueue[priority]->message_after_mod,
-                              '\r');
-                if (pos)
-                    pos[0] = '\0';
-                irc_raw_print (server, IRC_RAW_FLAG_SEND |
-                               ((server->outqueue[priority]->modified) ? IRC_RAW_FLAG_MODIFIED : 0),
-                               server->outqueue[priority]->message_after_mod);
-                if (pos)
-                    pos[0] = '\r';
+    }
 
-                /* send signal with command that will be sent to server */
-                irc_server_send_signal (
-                    server, "irc_out",
-                    server->outqueue[priority]->command,
-                    server->outqueue[priority]->message_after_mod,
-                    NULL);
-                tags_to_send = irc_server_get_tags_to_send (
-                    server->outqueue[priority]->tags);
-                irc_server_send_signal (
-                    server, "irc_outtags",
-                    server->outqueue[priority]->command,
-                    server->outqueue[priority]->message_after_mod,
-                    (tags_to_send) ? tags_to_send : "");
-                if (tags_to_send)
-                    free (tags_to_send);
+    /* update stats: time spent by message in queue */
+    latency = weechat_util_timeval_diff (&outqueue->time_queued, tv_now) / 1000;
+    if (latency < 0)
+        latency = 0;
+    server->outqueue_latency = (int)latency;
+    if (server->outqueue_latency > server->outqueue_latency_max)
+        server->outqueue_latency_max = server->outqueue_latency;
 
-                /* send command */
-                irc_server_send (
-                    server, server->outqueue[priority]->message_after_mod,
-                    strlen (server->outqueue[priority]->message_after_mod));
-                server->last_user_message = time_now;
+    server->outqueue_round[priority] = outqueue->round;
 
-                /* start redirection if redirect is set */
-                if (server->outqueue[priority]->redirect)
-                {
-                    irc_redirect_init_command (
-                        server->outqueue[priority]->redirect,
-                        server->outqueue[priority]->message_after_mod);
-                }
+    irc_server_outqueue_free (server, priority, outqueue);
+}
+
+/*
+ * Callback for anti-flood timer: sends messages from out queue.
+ */
+
+int
+irc_server_timer_anti_flood_cb (const void *pointer, void *data,
+                                int remaining_calls)
+{
+    struct t_irc_server *server;
+
+    /* make C compiler happy */
+    (void) data;
+    (void) remaining_calls;
+
+    server = (struct t_irc_server *)pointer;
+
+    if (!server)
+        return WEECHAT_RC_ERROR;
+
+    server->hook_timer_anti_flood = NULL;
+
+    irc_server_outqueue_send (server);
+
+    return WEECHAT_RC_OK;
+}
+
+/*
+ * Schedules a timer to send next message of out queue as soon as anti-flood
+ * allows it (if some messages are queued).
+ */
+
+void
+irc_server_outqueue_schedule (struct t_irc_server *server,
+                              struct timeval *tv_now)
+{
+    int priority;
+    long long delay, min_delay;
+
+    if (server->hook_timer_anti_flood || !server->is_connected)
+        return;
+
+    min_delay = -1;
+    for (priority = 0; priority < IRC_SERVER_NUM_OUTQUEUES_PRIO; priority++)
+    {
+        if (!server->outqueue[priority])
+            continue;
+        delay = irc_server_anti_flood_delay (server, priority, tv_now);
+        if ((min_delay < 0) || (delay < min_delay))
+            min_delay = delay;
+    }
+
+    if (min_delay < 0)
+        return;
+
+    server->hook_timer_anti_flood = weechat_hook_timer (
+        (min_delay > 0) ? min_delay : 1, 0, 1,
+        &irc_server_timer_anti_flood_cb, server, NULL);
+}
+
+/*
+ * Sends messages from out queue (as many as allowed by anti-flood).
+ */
+
+void
+irc_server_outqueue_send (struct t_irc_server *server)
+{
+    struct timeval tv_now;
+    int priority, sent;
+
+    gettimeofday (&tv_now, NULL);
+
+    do
+    {
+        sent = 0;
+        for (priority = 0; priority < IRC_SERVER_NUM_OUTQUEUES_PRIO;
+             priority++)
+        {
+            if (server->outqueue[priority]
+                && (irc_server_anti_flood_delay (server, priority,
+                                                 &tv_now) == 0))
+            {
+                irc_server_outqueue_send_msg (
+                    server, priority,
+                    irc_server_outqueue_get_next (server, priority),
+                    &tv_now);
+                sent = 1;
+                break;
             }
-            irc_server_outqueue_free (server, priority,
-                                      server->outqueue[priority]);
-            break;
         }
     }
+    while (sent);
+
+    irc_server_outqueue_schedule (server, &tv_now);
 }
 
 /*
@@ -2392,9 +2679,9 @@ irc_server_send_one_msg (struct t_irc_server *server, int flags,
     const char *ptr_msg, *ptr_chan_nick;
     char *new_msg, *pos, *tags_to_send, *msg_encoded;
     char str_modifier[128], modifier_data[256];
-    int rc, queue_msg, add_to_queue, first_message, anti_flood;
+    int rc, queue_msg, add_to_queue, first_message, i;
     int pos_channel, pos_text, pos_encode;
-    time_t time_now;
+    struct timeval tv_now;
     struct t_irc_redirect *ptr_redirect;
 
     rc = 1;
@@ -2427,9 +2714,9 @@ irc_server_send_one_msg (struct t_irc_server *server, int flags,
             pos_encode = (pos_channel >= 0) ? pos_channel : pos_text;
         else
             pos_encode = pos_text;
+        ptr_chan_nick = (channel) ? channel : nick;
         if (pos_encode >= 0)
         {
-            ptr_chan_nick = (channel) ? channel : nick;
             if (ptr_chan_nick)
             {
                 snprintf (modifier_data, sizeof (modifier_data),
@@ -2462,11 +2749,7 @@ irc_server_send_one_msg (struct t_irc_server *server, int flags,
             snprintf (buffer, sizeof (buffer), "%s\r\n", ptr_msg);
 
             /* anti-flood: look whether we should queue outgoing message or not */
-            time_now = time (NULL);
-
-            /* detect if system clock has been changed (now lower than before) */
-            if (server->last_user_message > time_now)
-                server->last_user_message = time_now;
+            gettimeofday (&tv_now, NULL);
 
             /* get queue from flags */
             queue_msg = 0;
@@ -2475,25 +2758,28 @@ irc_server_send_one_msg (struct t_irc_server *server, int flags,
             else if (flags & IRC_SERVER_SEND_OUTQ_PRIO_LOW)
                 queue_msg = 2;
 
-            switch (queue_msg - 1)
-            {
-                case 0:
-                    anti_flood = IRC_SERVER_OPTION_INTEGER(
-                        server, IRC_SERVER_OPTION_ANTI_FLOOD_PRIO_HIGH);
-                    break;
-                default:
-                    anti_flood = IRC_SERVER_OPTION_INTEGER(
-                        server, IRC_SERVER_OPTION_ANTI_FLOOD_PRIO_LOW);
-                    break;
-            }
-
+            /*
+             * message is queued if there are messages with same or higher
+             * priority in queues, or if anti-flood does not allow to send
+             * the message now
+             */
             add_to_queue = 0;
-            if ((queue_msg > 0)
-                && (server->outqueue[queue_msg - 1]
-                    || ((anti_flood > 0)
-                        && (time_now - server->last_user_message < anti_flood))))
+            if (queue_msg > 0)
             {
-                add_to_queue = queue_msg;
+                for (i = 0; i < queue_msg; i++)
+                {
+                    if (server->outqueue[i])
+                    {
+                        add_to_queue = queue_msg;
+                        break;
+                    }
+                }
+                if (!add_to_queue
+                    && (irc_server_anti_flood_delay (server, queue_msg - 1,
+                                                     &tv_now) > 0))
+                {
+                    add_to_queue = queue_msg;
+                }
             }
 
             tags_to_send = irc_server_get_tags_to_send (tags);
@@ -2508,10 +2794,12 @@ irc_server_send_one_msg (struct t_irc_server *server, int flags,
                                          buffer,
                                          (new_msg) ? 1 : 0,
                                          tags_to_send,
-                                         ptr_redirect);
+                                         ptr_redirect,
+                                         ptr_chan_nick);
                 /* mark redirect as "used" */
                 if (ptr_redirect)
                     ptr_redirect->assigned_to_command = 1;
+                irc_server_outqueue_schedule (server, &tv_now);
             }
             else
             {
@@ -2541,7 +2829,7 @@ irc_server_send_one_msg (struct t_irc_server *server, int flags,
                 else
                 {
                     if (queue_msg > 0)
-                        server->last_user_message = time_now;
+                        irc_server_anti_flood_consume (server, &tv_now);
                 }
                 if (ptr_redirect)
                     irc_redirect_init_command (ptr_redirect, buffer);
@@ -2575,6 +2863,51 @@ irc_server_send_one_msg (struct t_irc_server *server, int flags,
     return rc;
 }
 
+/*
+ * Callback called for each message of split in irc_server_sendf: sends the
+ * message to server (and adds it in hashtable returned, if asked).
+ */
+
+int
+irc_server_sendf_split_cb (void *data, int number, const char *message,
+                           const char *arguments)
+{
+    struct t_irc_server_sendf_data *sendf_data;
+    char hash_key[32];
+
+    /* make C compiler happy */
+    (void) number;
+
+    sendf_data = (struct t_irc_server_sendf_data *)data;
+
+    sendf_data->rc = irc_server_send_one_msg (sendf_data->server,
+                                              sendf_data->flags,
+                                              message,
+                                              sendf_data->nick,
+                                              sendf_data->command,
+                                              sendf_data->channel,
+                                              sendf_data->tags);
+    if (!sendf_data->rc)
+        return 0;
+
+    if (sendf_data->ret_hashtable)
+    {
+        snprintf (hash_key, sizeof (hash_key),
+                  "msg%d", sendf_data->ret_number);
+        weechat_hashtable_set (sendf_data->ret_hashtable, hash_key, message);
+        if (arguments)
+        {
+            snprintf (hash_key, sizeof (hash_key),
+                      "args%d", sendf_data->ret_number);
+            weechat_hashtable_set (sendf_data->ret_hashtable,
+                                   hash_key, arguments);
+        }
+        sendf_data->ret_number++;
+    }
+
+    return 1;
+}
+
 /*
  * Sends formatted data to IRC server.
  *
@@ -2591,11 +2924,10 @@ struct t_hashtable *
 irc_server_sendf (struct t_irc_server *server, int flags, const char *tags,
                   const char *format, ...)
 {
-    char **items, hash_key[32], value[32], *nick, *command, *channel, *new_msg;
+    char **items, value[32], *nick, *command, *channel, *new_msg;
     char str_modifier[128];
-    const char *str_message, *str_args;
-    int i, items_count, number, ret_number, rc;
-    struct t_hashtable *hashtable, *ret_hashtable;
+    int i, items_count;
+    struct t_irc_server_sendf_data sendf_data;
 
     if (!server)
         return NULL;
@@ -2604,17 +2936,21 @@ irc_server_sendf (struct t_irc_server *server, int flags, const char *tags,
     if (!vbuffer)
         return NULL;
 
-    ret_hashtable = NULL;
-    ret_number = 1;
+    sendf_data.server = server;
+    sendf_data.flags = flags;
+    sendf_data.tags = tags;
+    sendf_data.ret_hashtable = NULL;
+    sendf_data.ret_number = 1;
+    sendf_data.rc = 1;
     if (flags & IRC_SERVER_SEND_RETURN_HASHTABLE)
     {
-        ret_hashtable = weechat_hashtable_new (32,
-                                               WEECHAT_HASHTABLE_STRING,
-                                               WEECHAT_HASHTABLE_STRING,
-                                               NULL, NULL);
+        sendf_data.ret_hashtable = weechat_hashtable_new (
+            32,
+            WEECHAT_HASHTABLE_STRING,
+            WEECHAT_HASHTABLE_STRING,
+            NULL, NULL);
     }
 
-    rc = 1;
     items = weechat_string_split (vbuffer, "\n", 0, 0, &items_count);
     for (i = 0; i < items_count; i++)
     {
@@ -2647,52 +2983,21 @@ irc_server_sendf (struct t_irc_server *server, int flags, const char *tags,
 
             /*
              * split message if needed (max is 512 bytes by default,
-             * including the final "\r\n")
+             * including the final "\r\n") and send each message
              */
-            hashtable = irc_message_split (server,
-                                           (new_msg) ? new_msg : items[i]);
-            if (hashtable)
+            sendf_data.nick = nick;
+            sendf_data.command = command;
+            sendf_data.channel = channel;
+            irc_message_split_map (server,
+                                   (new_msg) ? new_msg : items[i],
+                                   &irc_server_sendf_split_cb,
+                                   &sendf_data);
+            if (sendf_data.ret_hashtable)
             {
-                number = 1;
-                while (1)
-                {
-                    snprintf (hash_key, sizeof (hash_key), "msg%d", number);
-                    str_message = weechat_hashtable_get (hashtable, hash_key);
-                    if (!str_message)
-                        break;
-                    snprintf (hash_key, sizeof (hash_key), "args%d", number);
-                    str_args = weechat_hashtable_get (hashtable, hash_key);
-
-                    rc = irc_server_send_one_msg (server, flags, str_message,
-                                                  nick, command, channel, tags);
-                    if (!rc)
-                        break;
-
-                    if (ret_hashtable)
-                    {
-                        snprintf (hash_key, sizeof (hash_key),
-                                  "msg%d", ret_number);
-                        weechat_hashtable_set (ret_hashtable,
-                                               hash_key, str_message);
-                        if (str_args)
-                        {
-                            snprintf (hash_key, sizeof (hash_key),
-                                      "args%d", ret_number);
-                            weechat_hashtable_set (ret_hashtable,
-                                                   hash_key, str_args);
-                        }
-                        ret_number++;
-                    }
-                    number++;
-                }
-                if (ret_hashtable)
-                {
-                    snprintf (value, sizeof (value), "%d", ret_number - 1);
-                    weechat_hashtable_set (ret_hashtable, "count", value);
-                }
-                weechat_hashtable_free (hashtable);
-                if (!rc)
-                    break;
+                snprintf (value, sizeof (value), "%d",
+                          sendf_data.ret_number - 1);
+                weechat_hashtable_set (sendf_data.ret_hashtable,
+                                       "count", value);
             }
         }
         if (nick)
@@ -2703,365 +3008,435 @@ irc_server_sendf (struct t_irc_server *server, int flags, const char *tags,
             free (channel);
         if (new_msg)
             free (new_msg);
+        if (!sendf_data.rc)
+            break;
     }
     if (items)
         weechat_string_free_split (items);
 
     free (vbuffer);
 
-    return ret_hashtable;
+    return sendf_data.ret_hashtable;
 }
 
 /*
- * Adds a message to received messages queue (at the end).
+ * Allocates buffer for data received from a server, so that at least "size"
+ * bytes are free in buffer (plus one for the final '\0').
+ *
+ * If the server has no buffer, the spare buffer is used. The size of buffer
+ * is doubled until enough bytes are free.
+ *
+ * Returns:
+ *   1: OK
+ *   0: error (not enough memory)
  */
 
-void
-irc_server_msgq_add_msg (struct t_irc_server *server, const char *msg)
+int
+irc_server_recv_buffer_alloc (struct t_irc_server *server, int size)
 {
-    struct t_irc_message *message;
+    char *new_buffer;
+    int new_size;
 
-    if (!server->unterminated_message && !msg[0])
-        return;
+    if (!server || (size < 0))
+        return 0;
 
-    message = malloc (sizeof (*message));
-    if (!message)
-    {
-        weechat_printf (server->buffer,
-                        _("%s%s: not enough memory for received message"),
-                        weechat_prefix ("error"), IRC_PLUGIN_NAME);
-        return;
-    }
-    message->server = server;
-    if (server->unterminated_message)
+    if (!server->recv_buffer && server->recv_buffer_spare)
     {
-        message->data = malloc (strlen (server->unterminated_message) +
-                                strlen (msg) + 1);
-        if (!message->data)
-        {
-            weechat_printf (server->buffer,
-                            _("%s%s: not enough memory for received message"),
-                            weechat_prefix ("error"), IRC_PLUGIN_NAME);
-        }
-        else
-        {
-            strcpy (message->data, server->unterminated_message);
-            strcat (message->data, msg);
-        }
-        free (server->unterminated_message);
-        server->unterminated_message = NULL;
+        server->recv_buffer = server->recv_buffer_spare;
+        server->recv_buffer_size = server->recv_buffer_spare_size;
+        server->recv_buffer_length = 0;
+        server->recv_buffer[0] = '\0';
+        server->recv_buffer_spare = NULL;
+        server->recv_buffer_spare_size = 0;
     }
-    else
-        message->data = strdup (msg);
-
-    message->next_message = NULL;
 
-    if (irc_msgq_last_msg)
+    if (server->recv_buffer
+        && (server->recv_buffer_size - server->recv_buffer_length - 1 >= size))
     {
-        irc_msgq_last_msg->next_message = message;
-        irc_msgq_last_msg = message;
+        return 1;
     }
-    else
+
+    new_size = (server->recv_buffer_size > 0) ?
+        server->recv_buffer_size : IRC_SERVER_RECV_BUFFER_MIN_READ;
+    while (new_size - server->recv_buffer_length - 1 < size)
     {
-        irc_recv_msgq = message;
-        irc_msgq_last_msg = message;
+        new_size *= 2;
     }
+    new_buffer = realloc (server->recv_buffer, new_size);
+    if (!new_buffer)
+        return 0;
+    new_buffer[server->recv_buffer_length] = '\0';
+    server->recv_buffer = new_buffer;
+    server->recv_buffer_size = new_size;
+
+    return 1;
 }
 
 /*
- * Adds an unterminated message to queue.
+ * Frees buffers for data received from a server (any unterminated message
+ * is lost).
  */
 
 void
-irc_server_msgq_add_unterminated (struct t_irc_server *server,
-                                  const char *string)
+irc_server_recv_buffer_free (struct t_irc_server *server)
 {
-    char *unterminated_message2;
-
-    if (!string[0])
+    if (!server)
         return;
 
-    if (server->unterminated_message)
+    if (server->recv_buffer)
     {
-        unterminated_message2 =
-            realloc (server->unterminated_message,
-                     (strlen (server->unterminated_message) +
-                      strlen (string) + 1));
-        if (!unterminated_message2)
-        {
-            weechat_printf (server->buffer,
-                            _("%s%s: not enough memory for received message"),
-                            weechat_prefix ("error"), IRC_PLUGIN_NAME);
-            free (server->unterminated_message);
-            server->unterminated_message = NULL;
-            return;
-        }
-        server->unterminated_message = unterminated_message2;
-        strcat (server->unterminated_message, string);
+        free (server->recv_buffer);
+        server->recv_buffer = NULL;
     }
-    else
+    server->recv_buffer_size = 0;
+    server->recv_buffer_length = 0;
+    if (server->recv_buffer_spare)
     {
-        server->unterminated_message = strdup (string);
-        if (!server->unterminated_message)
-        {
-            weechat_printf (server->buffer,
-                            _("%s%s: not enough memory for received message"),
-                            weechat_prefix ("error"), IRC_PLUGIN_NAME);
-        }
+        free (server->recv_buffer_spare);
+        server->recv_buffer_spare = NULL;
     }
+    server->recv_buffer_spare_size = 0;
 }
 
 /*
- * Splits received buffer, creating queued messages.
+ * Adds data to the buffer of received data (after the unterminated message,
+ * if any).
+ *
+ * The messages are read by a call to function irc_server_msgq_flush.
  */
 
 void
 irc_server_msgq_add_buffer (struct t_irc_server *server, const char *buffer)
 {
-    char *pos_cr, *pos_lf;
+    int length;
+
+    if (!server || !buffer || !buffer[0])
+        return;
 
-    while (buffer[0])
+    length = strlen (buffer);
+    if (!irc_server_recv_buffer_alloc (server, length))
     {
-        pos_cr = strchr (buffer, '\r');
-        pos_lf = strchr (buffer, '\n');
+        weechat_printf (server->buffer,
+                        _("%s%s: not enough memory for received message"),
+                        weechat_prefix ("error"), IRC_PLUGIN_NAME);
+        return;
+    }
+    memcpy (server->recv_buffer + server->recv_buffer_length, buffer,
+            length + 1);
+    server->recv_buffer_length += length;
+}
 
-        if (!pos_cr && !pos_lf)
-        {
-            /* no CR/LF found => add to unterminated and return */
-            irc_server_msgq_add_unterminated (server, buffer);
-            return;
-        }
+/*
+ * Gets next message in received data: from *buffer to "end" (excluded).
+ *
+ * The message is terminated in place (the '\n' is replaced by '\0', and the
+ * '\r' are removed), and *buffer is set to the beginning of next message.
+ *
+ * Returns pointer to message, NULL if there is no complete message.
+ */
 
-        if (pos_cr && ((!pos_lf) || (pos_lf > pos_cr)))
-        {
-            /* found '\r' first => ignore this char */
-            pos_cr[0] = '\0';
-            irc_server_msgq_add_unterminated (server, buffer);
-            buffer = pos_cr + 1;
-        }
-        else
+char *
+irc_server_msgq_next_message (char **buffer, char *end)
+{
+    char *msg, *pos_lf, *pos_cr, *ptr_src;
+
+    if (!buffer || !*buffer || !end || (*buffer >= end))
+        return NULL;
+
+    msg = *buffer;
+    pos_lf = memchr (msg, '\n', end - msg);
+    if (!pos_lf)
+        return NULL;
+    pos_lf[0] = '\0';
+    *buffer = pos_lf + 1;
+
+    /* remove '\r' (usually there's only one, just before the '\n') */
+    pos_cr = memchr (msg, '\r', pos_lf - msg);
+    if (pos_cr)
+    {
+        for (ptr_src = pos_cr + 1; ptr_src < pos_lf; ptr_src++)
         {
-            /* found: '\n' first => terminate message */
-            pos_lf[0] = '\0';
-            irc_server_msgq_add_msg (server, buffer);
-            buffer = pos_lf + 1;
+            if (ptr_src[0] != '\r')
+            {
+                pos_cr[0] = ptr_src[0];
+                pos_cr++;
+            }
         }
+        pos_cr[0] = '\0';
     }
+
+    return msg;
 }
 
 /*
- * Flushes message queue.
+ * Reads a message received from a server: calls modifiers, then parses and
+ * executes the message.
  */
 
 void
-irc_server_msgq_flush ()
+irc_server_msgq_read_message (struct t_irc_server *server, char *ptr_data)
 {
-    struct t_irc_message *next;
-    char *ptr_data, *new_msg, *new_msg2, *ptr_msg, *ptr_msg2, *pos;
-    char *nick, *host, *command, *channel, *arguments;
-    char *msg_decoded, *msg_decoded_without_color;
+    struct t_irc_message parsed, parsed2;
+    char *new_msg, *new_msg2, *ptr_msg, *ptr_msg2, *pos;
+    char *command, *channel, *msg_decoded, *msg_decoded_without_color;
     char str_modifier[128], modifier_data[256];
-    int pos_channel, pos_text, pos_decode;
+    const char *arguments;
+    int pos_decode;
+
+    while (ptr_data[0] == ' ')
+    {
+        ptr_data++;
+    }
 
-    while (irc_recv_msgq)
+    if (ptr_data[0])
     {
-        if (irc_recv_msgq->data)
+        irc_raw_print (server, IRC_RAW_FLAG_RECV, ptr_data);
+
+        /*
+         * the message is parsed only once (it is parsed again only if
+         * changed by charset decoding or a modifier)
+         */
+        irc_message_parse_to_struct (server, ptr_data, &parsed);
+        if (parsed.pos_command >= 0)
+        {
+            snprintf (str_modifier, sizeof (str_modifier),
+                      "irc_in_%.*s",
+                      parsed.length_command, ptr_data + parsed.pos_command);
+        }
+        else
+        {
+            snprintf (str_modifier, sizeof (str_modifier), "irc_in_unknown");
+        }
+        new_msg = weechat_hook_modifier_exec (str_modifier, server->name,
+                                              ptr_data);
+
+        /* no changes in new message */
+        if (new_msg && (strcmp (ptr_data, new_msg) == 0))
         {
-            /* read message only if connection was not lost */
-            if (irc_recv_msgq->server->sock != -1)
+            free (new_msg);
+            new_msg = NULL;
+        }
+
+        /* message not dropped? */
+        if (!new_msg || new_msg[0])
+        {
+            /* use new message (returned by plugin) */
+            ptr_msg = (new_msg) ? new_msg : ptr_data;
+
+            while (ptr_msg && ptr_msg[0])
             {
-                ptr_data = irc_recv_msgq->data;
-                while (ptr_data[0] == ' ')
+                pos = strchr (ptr_msg, '\n');
+                if (pos)
+                    pos[0] = '\0';
+
+                if (new_msg)
                 {
-                    ptr_data++;
+                    irc_raw_print (server,
+                                   IRC_RAW_FLAG_RECV | IRC_RAW_FLAG_MODIFIED,
+                                   ptr_msg);
+                    irc_message_parse_to_struct (server, ptr_msg, &parsed);
                 }
 
-                if (ptr_data[0])
+                command = irc_message_get_item (&parsed, parsed.pos_command,
+                                                parsed.length_command);
+                channel = irc_message_get_item (&parsed, parsed.pos_channel,
+                                                parsed.length_channel);
+                arguments = (parsed.pos_arguments >= 0) ?
+                    ptr_msg + parsed.pos_arguments : NULL;
+
+                msg_decoded = NULL;
+                if (weechat_config_boolean (irc_config_network_channel_encode))
+                {
+                    pos_decode = (parsed.pos_channel >= 0) ?
+                        parsed.pos_channel : parsed.pos_text;
+                }
+                else
+                {
+                    pos_decode = parsed.pos_text;
+                }
+                if (pos_decode >= 0)
                 {
-                    irc_raw_print (irc_recv_msgq->server, IRC_RAW_FLAG_RECV,
-                                   ptr_data);
-
-                    irc_message_parse (irc_recv_msgq->server,
-                                       ptr_data, NULL, NULL, NULL, NULL,
-                                       &command, NULL, NULL, NULL, NULL, NULL,
-                                       NULL, NULL);
-                    snprintf (str_modifier, sizeof (str_modifier),
-                              "irc_in_%s",
-                              (command) ? command : "unknown");
-                    new_msg = weechat_hook_modifier_exec (
-                        str_modifier,
-                        irc_recv_msgq->server->name,
-                        ptr_data);
-                    if (command)
-                        free (command);
-
-                    /* no changes in new message */
-                    if (new_msg && (strcmp (ptr_data, new_msg) == 0))
+                    /* convert charset for message */
+                    if (channel && irc_channel_is_channel (server, channel))
                     {
-                        free (new_msg);
-                        new_msg = NULL;
+                        snprintf (modifier_data, sizeof (modifier_data),
+                                  "%s.%s.%s",
+                                  weechat_plugin->name,
+                                  server->name,
+                                  channel);
                     }
-
-                    /* message not dropped? */
-                    if (!new_msg || new_msg[0])
+                    else
                     {
-                        /* use new message (returned by plugin) */
-                        ptr_msg = (new_msg) ? new_msg : ptr_data;
-
-                        while (ptr_msg && ptr_msg[0])
+                        if ((parsed.pos_nick >= 0)
+                            && ((parsed.pos_host < 0)
+                                || (parsed.length_nick != parsed.length_host)
+                                || (memcmp (ptr_msg + parsed.pos_nick,
+                                            ptr_msg + parsed.pos_host,
+                                            parsed.length_nick) != 0)))
                         {
-                            pos = strchr (ptr_msg, '\n');
-                            if (pos)
-                                pos[0] = '\0';
-
-                            if (new_msg)
-                            {
-                                irc_raw_print (
-                                    irc_recv_msgq->server,
-                                    IRC_RAW_FLAG_RECV | IRC_RAW_FLAG_MODIFIED,
-                                    ptr_msg);
-                            }
-
-                            irc_message_parse (irc_recv_msgq->server, ptr_msg,
-                                               NULL, NULL, &nick, &host,
-                                               &command, &channel, &arguments,
-                                               NULL, NULL, NULL,
-                                               &pos_channel, &pos_text);
-
-                            msg_decoded = NULL;
-                            if (weechat_config_boolean (irc_config_network_channel_encode))
-                                pos_decode = (pos_channel >= 0) ? pos_channel : pos_text;
-                            else
-                                pos_decode = pos_text;
-                            if (pos_decode >= 0)
-                            {
-                                /* convert charset for message */
-                                if (channel
-                                    && irc_channel_is_channel (irc_recv_msgq->server,
-                                                               channel))
-                                {
-                                    snprintf (modifier_data, sizeof (modifier_data),
-                                              "%s.%s.%s",
-                                              weechat_plugin->name,
-                                              irc_recv_msgq->server->name,
-                                              channel);
-                                }
-                                else
-                                {
-                                    if (nick && (!host || (strcmp (nick, host) != 0)))
-                                    {
-                                        snprintf (modifier_data,
-                                                  sizeof (modifier_data),
-                                                  "%s.%s.%s",
-                                                  weechat_plugin->name,
-                                                  irc_recv_msgq->server->name,
-                                                  nick);
-                                    }
-                                    else
-                                    {
-                                        snprintf (modifier_data,
-                                                  sizeof (modifier_data),
-                                                  "%s.%s",
-                                                  weechat_plugin->name,
-                                                  irc_recv_msgq->server->name);
-                                    }
-                                }
-                                msg_decoded = irc_message_convert_charset (
-                                    ptr_msg, pos_decode,
-                                    "charset_decode", modifier_data);
-                            }
-
-                            /* replace WeeChat internal color codes by "?" */
-                            msg_decoded_without_color =
-                                weechat_string_remove_color (
-                                    (msg_decoded) ? msg_decoded : ptr_msg,
-                                    "?");
-
-                            /* call modifier after charset */
-                            ptr_msg2 = (msg_decoded_without_color) ?
-                                msg_decoded_without_color : ((msg_decoded) ? msg_decoded : ptr_msg);
-                            snprintf (str_modifier, sizeof (str_modifier),
-                                      "irc_in2_%s",
-                                      (command) ? command : "unknown");
-                            new_msg2 = weechat_hook_modifier_exec (
-                                str_modifier,
-                                irc_recv_msgq->server->name,
-                                ptr_msg2);
-                            if (new_msg2 && (strcmp (ptr_msg2, new_msg2) == 0))
-                            {
-                                free (new_msg2);
-                                new_msg2 = NULL;
-                            }
-
-                            /* message not dropped? */
-                            if (!new_msg2 || new_msg2[0])
-                            {
-                                /* use new message (returned by plugin) */
-                                if (new_msg2)
-                                    ptr_msg2 = new_msg2;
-
-                                /* parse and execute command */
-                                if (irc_redirect_message (irc_recv_msgq->server,
-                                                          ptr_msg2, command,
-                                                          arguments))
-                                {
-                                    /* message redirected, we'll not display it! */
-                                }
-                                else
-                                {
-                                    /* message not redirected, display it */
-                                    irc_protocol_recv_command (
-                                        irc_recv_msgq->server,
-                                        ptr_msg2,
-                                        command,
-                                        channel);
-                                }
-                            }
-
-                            if (new_msg2)
-                                free (new_msg2);
-                            if (nick)
-                                free (nick);
-                            if (host)
-                                free (host);
-                            if (command)
-                                free (command);
-                            if (channel)
-                                free (channel);
-                            if (arguments)
-                                free (arguments);
-                            if (msg_decoded)
-                                free (msg_decoded);
-                            if (msg_decoded_without_color)
-                                free (msg_decoded_without_color);
-
-                            if (pos)
-                            {
-                                pos[0] = '\n';
-                                ptr_msg = pos + 1;
-                            }
-                            else
-                                ptr_msg = NULL;
+                            snprintf (modifier_data,
+                                      sizeof (modifier_data),
+                                      "%s.%s.%.*s",
+                                      weechat_plugin->name,
+                                      server->name,
+                                      parsed.length_nick,
+                                      ptr_msg + parsed.pos_nick);
+                        }
+                        else
+                        {
+                            snprintf (modifier_data,
+                                      sizeof (modifier_data),
+                                      "%s.%s",
+                                      weechat_plugin->name,
+                                      server->name);
                         }
                     }
+                    msg_decoded = irc_message_convert_charset (
+                        ptr_msg, pos_decode,
+                        "charset_decode", modifier_data);
+                }
+
+                /* replace WeeChat internal color codes by "?" */
+                msg_decoded_without_color =
+                    weechat_string_remove_color (
+                        (msg_decoded) ? msg_decoded : ptr_msg,
+                        "?");
+
+                /* call modifier after charset */
+                ptr_msg2 = (msg_decoded_without_color) ?
+                    msg_decoded_without_color : ((msg_decoded) ? msg_decoded : ptr_msg);
+                snprintf (str_modifier, sizeof (str_modifier),
+                          "irc_in2_%s",
+                          (command) ? command : "unknown");
+                new_msg2 = weechat_hook_modifier_exec (str_modifier,
+                                                       server->name,
+                                                       ptr_msg2);
+                if (new_msg2 && (strcmp (ptr_msg2, new_msg2) == 0))
+                {
+                    free (new_msg2);
+                    new_msg2 = NULL;
+                }
+
+                /* message not dropped? */
+                if (!new_msg2 || new_msg2[0])
+                {
+                    /* use new message (returned by plugin) */
+                    if (new_msg2)
+                        ptr_msg2 = new_msg2;
+
+                    /* parse and execute command */
+                    if (irc_redirect_message (server, ptr_msg2, command,
+                                              arguments))
+                    {
+                        /* message redirected, we'll not display it! */
+                    }
                     else
                     {
-                        irc_raw_print (irc_recv_msgq->server,
-                                       IRC_RAW_FLAG_RECV | IRC_RAW_FLAG_MODIFIED,
-                                       _("(message dropped)"));
+                        /*
+                         * message not redirected, display it (positions of
+                         * items are the same if the message was not changed
+                         * by charset decoding or modifier "irc_in2_xxx")
+                         */
+                        if (strcmp (ptr_msg2, ptr_msg) == 0)
+                        {
+                            parsed2 = parsed;
+                            parsed2.message = ptr_msg2;
+                        }
+                        else
+                        {
+                            irc_message_parse_to_struct (server, ptr_msg2,
+                                                         &parsed2);
+                        }
+                        irc_protocol_recv_command (server, &parsed2,
+                                                   command, channel);
                     }
-                    if (new_msg)
-                        free (new_msg);
                 }
+
+                if (new_msg2)
+                    free (new_msg2);
+                if (command)
+                    free (command);
+                if (channel)
+                    free (channel);
+                if (msg_decoded)
+                    free (msg_decoded);
+                if (msg_decoded_without_color)
+                    free (msg_decoded_without_color);
+
+                if (pos)
+                {
+                    pos[0] = '\n';
+                    ptr_msg = pos + 1;
+                }
+                else
+                    ptr_msg = NULL;
             }
-            free (irc_recv_msgq->data);
         }
+        else
+        {
+            irc_raw_print (server,
+                           IRC_RAW_FLAG_RECV | IRC_RAW_FLAG_MODIFIED,
+                           _("(message dropped)"));
+        }
+        if (new_msg)
+            free (new_msg);
+    }
+}
 
-        next = irc_recv_msgq->next_message;
-        free (irc_recv_msgq);
-        irc_recv_msgq = next;
-        if (!irc_recv_msgq)
-            irc_msgq_last_msg = NULL;
+/*
+ * Reads messages received from a server: all complete messages in buffer
+ * are read, the unterminated message (if any) is kept in buffer.
+ *
+ * The messages are read directly in the buffer (they are not copied): the
+ * buffer is detached from server before reading them, so that data can be
+ * received (or the server disconnected) while messages are read.
+ */
+
+void
+irc_server_msgq_flush (struct t_irc_server *server)
+{
+    char *buffer, *ptr_buffer, *end, *msg;
+    int size, length;
+
+    if (!server || !server->recv_buffer)
+        return;
+
+    /* search end of last complete message */
+    length = server->recv_buffer_length;
+    while ((length > 0) && (server->recv_buffer[length - 1] != '\n'))
+    {
+        length--;
+    }
+    if (length == 0)
+        return;
+
+    /* detach buffer, keep unterminated message in the spare buffer */
+    buffer = server->recv_buffer;
+    size = server->recv_buffer_size;
+    end = buffer + length;
+    server->recv_buffer = NULL;
+    server->recv_buffer_size = 0;
+    server->recv_buffer_length = 0;
+    irc_server_msgq_add_buffer (server, end);
+
+    ptr_buffer = buffer;
+    while ((msg = irc_server_msgq_next_message (&ptr_buffer, end)))
+    {
+        /* read messages only if connection was not lost */
+        if (server->sock == -1)
+            break;
+        irc_server_msgq_read_message (server, msg);
+    }
+
+    /* buffer is kept as spare buffer if server is still connected */
+    if (server->recv_buffer_spare || (server->sock == -1))
+    {
+        free (buffer);
+    }
+    else
+    {
+        server->recv_buffer_spare = buffer;
+        server->recv_buffer_spare_size = size;
     }
 }
 
@@ -3073,8 +3448,8 @@ int
 irc_server_recv_cb (const void *pointer, void *data, int fd)
 {
     struct t_irc_server *server;
-    static char buffer[4096 + 2];
-    int num_read, msgq_flush, end_recv;
+    char *ptr_buffer;
+    int num_read, read_size, grow_size, msgq_flush, end_recv;
 
     /* make C compiler happy */
     (void) data;
@@ -3086,24 +3461,45 @@ irc_server_recv_cb (const void *pointer, void *data, int fd)
 
     msgq_flush = 0;
     end_recv = 0;
+    grow_size = 0;
 
     while (!end_recv)
     {
         end_recv = 1;
 
+        /* data is read directly in buffer, after the unterminated message */
+        if (!irc_server_recv_buffer_alloc (server,
+                                           IRC_SERVER_RECV_BUFFER_MIN_READ))
+        {
+            weechat_printf (server->buffer,
+                            _("%s%s: not enough memory for received message"),
+                            weechat_prefix ("error"), IRC_PLUGIN_NAME);
+            break;
+        }
+        ptr_buffer = server->recv_buffer + server->recv_buffer_length;
+        read_size = server->recv_buffer_size - server->recv_buffer_length - 1;
+
 #ifdef HAVE_GNUTLS
         if (server->ssl_connected)
-            num_read = gnutls_record_recv (server->gnutls_sess, buffer,
-                                           sizeof (buffer) - 2);
+            num_read = gnutls_record_recv (server->gnutls_sess, ptr_buffer,
+                                           read_size);
         else
 #endif /* HAVE_GNUTLS */
-            num_read = recv (server->sock, buffer, sizeof (buffer) - 2, 0);
+            num_read = recv (server->sock, ptr_buffer, read_size, 0);
 
         if (num_read > 0)
         {
-            buffer[num_read] = '\0';
-            irc_server_msgq_add_buffer (server, buffer);
+            server->recv_buffer_length += num_read;
+            server->recv_buffer[server->recv_buffer_length] = '\0';
             msgq_flush = 1;  /* the flush will be done after the loop */
+            /* buffer is full: next read will be done with a larger buffer */
+            if ((num_read == read_size)
+                && (read_size < IRC_SERVER_RECV_BUFFER_MAX_READ))
+            {
+                grow_size = read_size * 2;
+                if (grow_size > IRC_SERVER_RECV_BUFFER_MAX_READ)
+                    grow_size = IRC_SERVER_RECV_BUFFER_MAX_READ;
+            }
 #ifdef HAVE_GNUTLS
             if (server->ssl_connected
                 && (gnutls_record_check_pending (server->gnutls_sess) > 0))
@@ -3163,7 +3559,10 @@ irc_server_recv_cb (const void *pointer, void *data, int fd)
     }
 
     if (msgq_flush)
-        irc_server_msgq_flush ();
+        irc_server_msgq_flush (server);
+
+    if ((grow_size > 0) && (server->sock != -1))
+        irc_server_recv_buffer_alloc (server, grow_size);
 
     return WEECHAT_RC_OK;
 }
@@ -3508,6 +3907,12 @@ irc_server_close_connection (struct t_irc_server *server)
         server->hook_timer_sasl = NULL;
     }
 
+    if (server->hook_timer_anti_flood)
+    {
+        weechat_unhook (server->hook_timer_anti_flood);
+        server->hook_timer_anti_flood = NULL;
+    }
+
     if (server->hook_fd)
     {
         weechat_unhook (server->hook_fd);
@@ -3542,16 +3947,20 @@ irc_server_close_connection (struct t_irc_server *server)
     }
 
     /* free any pending message */
-    if (server->unterminated_message)
-    {
-        free (server->unterminated_message);
-        server->unterminated_message = NULL;
-    }
+    irc_server_recv_buffer_free (server);
     for (i = 0; i < IRC_SERVER_NUM_OUTQUEUES_PRIO; i++)
     {
         irc_server_outqueue_free_all (server, i);
+        server->outqueue_round[i] = 0;
     }
 
+    /* reset anti-flood (bucket is full on next connection) */
+    server->anti_flood_tokens = 0;
+    server->anti_flood_refill.tv_sec = 0;
+    server->anti_flood_refill.tv_usec = 0;
+    server->outqueue_latency = 0;
+    server->outqueue_latency_max = 0;
+
     /* remove all redirects */
     irc_redirect_free_all (server);
 
@@ -5574,6 +5983,7 @@ irc_server_hdata_server_cb (const void *pointer, void *data,
         WEECHAT_HDATA_VAR(struct t_irc_server, hook_fd, POINTER, 0, NULL, "hook");
         WEECHAT_HDATA_VAR(struct t_irc_server, hook_timer_connection, POINTER, 0, NULL, "hook");
         WEECHAT_HDATA_VAR(struct t_irc_server, hook_timer_sasl, POINTER, 0, NULL, "hook");
+        WEECHAT_HDATA_VAR(struct t_irc_server, hook_timer_anti_flood, POINTER, 0, NULL, "hook");
         WEECHAT_HDATA_VAR(struct t_irc_server, is_connected, INTEGER, 0, NULL, NULL);
         WEECHAT_HDATA_VAR(struct t_irc_server, ssl_connected, INTEGER, 0, NULL, NULL);
         WEECHAT_HDATA_VAR(struct t_irc_server, disconnected, INTEGER, 0, NULL, NULL);
@@ -5582,7 +5992,11 @@ irc_server_hdata_server_cb (const void *pointer, void *data,
         WEECHAT_HDATA_VAR(struct t_irc_server, tls_cert, OTHER, 0, NULL, NULL);
         WEECHAT_HDATA_VAR(struct t_irc_server, tls_cert_key, OTHER, 0, NULL, NULL);
 #endif /* HAVE_GNUTLS */
-        WEECHAT_HDATA_VAR(struct t_irc_server, unterminated_message, STRING, 0, NULL, NULL);
+        WEECHAT_HDATA_VAR(struct t_irc_server, recv_buffer, STRING, 0, NULL, NULL);
+        WEECHAT_HDATA_VAR(struct t_irc_server, recv_buffer_size, INTEGER, 0, NULL, NULL);
+        WEECHAT_HDATA_VAR(struct t_irc_server, recv_buffer_length, INTEGER, 0, NULL, NULL);
+        WEECHAT_HDATA_VAR(struct t_irc_server, recv_buffer_spare, POINTER, 0, NULL, NULL);
+        WEECHAT_HDATA_VAR(struct t_irc_server, recv_buffer_spare_size, INTEGER, 0, NULL, NULL);
         WEECHAT_HDATA_VAR(struct t_irc_server, nicks_count, INTEGER, 0, NULL, NULL);
         WEECHAT_HDATA_VAR(struct t_irc_server, nicks_array, STRING, 0, "nicks_count", NULL);
         WEECHAT_HDATA_VAR(struct t_irc_server, nick_first_tried, INTEGER, 0, NULL, NULL);
@@ -5616,11 +6030,17 @@ irc_server_hdata_server_cb (const void *pointer, void *data,
         WEECHAT_HDATA_VAR(struct t_irc_server, lag_next_check, TIME, 0, NULL, NULL);
         WEECHAT_HDATA_VAR(struct t_irc_server, lag_last_refresh, TIME, 0, NULL, NULL);
         WEECHAT_HDATA_VAR(struct t_irc_server, cmd_list_regexp, POINTER, 0, NULL, NULL);
-        WEECHAT_HDATA_VAR(struct t_irc_server, last_user_message, TIME, 0, NULL, NULL);
+        WEECHAT_HDATA_VAR(struct t_irc_server, last_user_message, OTHER, 0, NULL, NULL);
+        WEECHAT_HDATA_VAR(struct t_irc_server, anti_flood_tokens, INTEGER, 0, NULL, NULL);
+        WEECHAT_HDATA_VAR(struct t_irc_server, anti_flood_refill, OTHER, 0, NULL, NULL);
         WEECHAT_HDATA_VAR(struct t_irc_server, last_away_check, TIME, 0, NULL, NULL);
         WEECHAT_HDATA_VAR(struct t_irc_server, last_data_purge, TIME, 0, NULL, NULL);
         WEECHAT_HDATA_VAR(struct t_irc_server, outqueue, POINTER, 0, NULL, NULL);
         WEECHAT_HDATA_VAR(struct t_irc_server, last_outqueue, POINTER, 0, NULL, NULL);
+        WEECHAT_HDATA_VAR(struct t_irc_server, outqueue_count, INTEGER, 0, "2", NULL);
+        WEECHAT_HDATA_VAR(struct t_irc_server, outqueue_round, INTEGER, 0, "2", NULL);
+        WEECHAT_HDATA_VAR(struct t_irc_server, outqueue_latency, INTEGER, 0, NULL, NULL);
+        WEECHAT_HDATA_VAR(struct t_irc_server, outqueue_latency_max, INTEGER, 0, NULL, NULL);
         WEECHAT_HDATA_VAR(struct t_irc_server, redirects, POINTER, 0, NULL, "irc_redirect");
         WEECHAT_HDATA_VAR(struct t_irc_server, last_redirect, POINTER, 0, NULL, "irc_redirect");
         WEECHAT_HDATA_VAR(struct t_irc_server, notify_list, POINTER, 0, NULL, "irc_notify");
@@ -5773,6 +6193,9 @@ irc_server_add_to_infolist (struct t_infolist *infolist,
     if (!weechat_infolist_new_var_integer (ptr_item, "anti_flood_prio_low",
                                            IRC_SERVER_OPTION_INTEGER(server, IRC_SERVER_OPTION_ANTI_FLOOD_PRIO_LOW)))
         return 0;
+    if (!weechat_infolist_new_var_integer (ptr_item, "anti_flood_burst",
+                                           IRC_SERVER_OPTION_INTEGER(server, IRC_SERVER_OPTION_ANTI_FLOOD_BURST)))
+        return 0;
     if (!weechat_infolist_new_var_integer (ptr_item, "away_check",
                                            IRC_SERVER_OPTION_INTEGER(server, IRC_SERVER_OPTION_AWAY_CHECK)))
         return 0;
@@ -5808,7 +6231,7 @@ irc_server_add_to_infolist (struct t_infolist *infolist,
         return 0;
     if (!weechat_infolist_new_var_integer (ptr_item, "disconnected", server->disconnected))
         return 0;
-    if (!weechat_infolist_new_var_string (ptr_item, "unterminated_message", server->unterminated_message))
+    if (!weechat_infolist_new_var_string (ptr_item, "unterminated_message", server->recv_buffer))
         return 0;
     if (!weechat_infolist_new_var_string (ptr_item, "nick", server->nick))
         return 0;
@@ -5868,7 +6291,15 @@ irc_server_add_to_infolist (struct t_infolist *infolist,
         return 0;
     if (!weechat_infolist_new_var_time (ptr_item, "lag_last_refresh", server->lag_last_refresh))
         return 0;
-    if (!weechat_infolist_new_var_time (ptr_item, "last_user_message", server->last_user_message))
+    if (!weechat_infolist_new_var_time (ptr_item, "last_user_message", server->last_user_message.tv_sec))
+        return 0;
+    if (!weechat_infolist_new_var_integer (ptr_item, "outqueue_count_high", server->outqueue_count[0]))
+        return 0;
+    if (!weechat_infolist_new_var_integer (ptr_item, "outqueue_count_low", server->outqueue_count[1]))
+        return 0;
+    if (!weechat_infolist_new_var_integer (ptr_item, "outqueue_latency", server->outqueue_latency))
+        return 0;
+    if (!weechat_infolist_new_var_integer (ptr_item, "outqueue_latency_max", server->outqueue_latency_max))
         return 0;
     if (!weechat_infolist_new_var_time (ptr_item, "last_away_check", server->last_away_check))
         return 0;
@@ -6133,6 +6564,13 @@ irc_server_print_log ()
         else
             weechat_log_printf ("  anti_flood_prio_low. : %d",
                                 weechat_config_integer (ptr_server->options[IRC_SERVER_OPTION_ANTI_FLOOD_PRIO_LOW]));
+        /* anti_flood_burst */
+        if (weechat_config_option_is_null (ptr_server->options[IRC_SERVER_OPTION_ANTI_FLOOD_BURST]))
+            weechat_log_printf ("  anti_flood_burst . . : null (%d)",
+                                IRC_SERVER_OPTION_INTEGER(ptr_server, IRC_SERVER_OPTION_ANTI_FLOOD_BURST));
+        else
+            weechat_log_printf ("  anti_flood_burst . . : %d",
+                                weechat_config_integer (ptr_server->options[IRC_SERVER_OPTION_ANTI_FLOOD_BURST]));
         /* away_check */
         if (weechat_config_option_is_null (ptr_server->options[IRC_SERVER_OPTION_AWAY_CHECK]))
             weechat_log_printf ("  away_check . . . . . : null (%d)",
@@ -6187,13 +6625,19 @@ irc_server_print_log ()
         weechat_log_printf ("  hook_fd. . . . . . . : 0x%lx", ptr_server->hook_fd);
         weechat_log_printf ("  hook_timer_connection: 0x%lx", ptr_server->hook_timer_connection);
         weechat_log_printf ("  hook_timer_sasl. . . : 0x%lx", ptr_server->hook_timer_sasl);
+        weechat_log_printf ("  hook_timer_anti_flood: 0x%lx", ptr_server->hook_timer_anti_flood);
         weechat_log_printf ("  is_connected . . . . : %d",    ptr_server->is_connected);
         weechat_log_printf ("  ssl_connected. . . . : %d",    ptr_server->ssl_connected);
         weechat_log_printf ("  disconnected . . . . : %d",    ptr_server->disconnected);
 #ifdef HAVE_GNUTLS
         weechat_log_printf ("  gnutls_sess. . . . . : 0x%lx", ptr_server->gnutls_sess);
 #endif /* HAVE_GNUTLS */
-        weechat_log_printf ("  unterminated_message : '%s'",  ptr_server->unterminated_message);
+        weechat_log_printf ("  recv_buffer. . . . . : '%s'",  ptr_server->recv_buffer);
+        weechat_log_printf ("  recv_buffer_size . . : %d",    ptr_server->recv_buffer_size);
+        weechat_log_printf ("  recv_buffer_length . : %d",    ptr_server->recv_buffer_length);
+        weechat_log_printf ("  recv_buffer_spare. . : 0x%lx (size: %d)",
+                            ptr_server->recv_buffer_spare,
+                            ptr_server->recv_buffer_spare_size);
         weechat_log_printf ("  nicks_count. . . . . : %d",    ptr_server->nicks_count);
         weechat_log_printf ("  nicks_array. . . . . : 0x%lx", ptr_server->nicks_array);
         weechat_log_printf ("  nick_first_tried . . : %d",    ptr_server->nick_first_tried);
@@ -6235,14 +6679,24 @@ irc_server_print_log ()
         weechat_log_printf ("  lag_next_check . . . : %lld",  (long long)ptr_server->lag_next_check);
         weechat_log_printf ("  lag_last_refresh . . : %lld",  (long long)ptr_server->lag_last_refresh);
         weechat_log_printf ("  cmd_list_regexp. . . : 0x%lx", ptr_server->cmd_list_regexp);
-        weechat_log_printf ("  last_user_message. . : %lld",  (long long)ptr_server->last_user_message);
+        weechat_log_printf ("  last_user_message. . : tv_sec:%d, tv_usec:%d",
+                            ptr_server->last_user_message.tv_sec,
+                            ptr_server->last_user_message.tv_usec);
+        weechat_log_printf ("  anti_flood_tokens. . : %d",    ptr_server->anti_flood_tokens);
+        weechat_log_printf ("  anti_flood_refill. . : tv_sec:%d, tv_usec:%d",
+                            ptr_server->anti_flood_refill.tv_sec,
+                            ptr_server->anti_flood_refill.tv_usec);
         weechat_log_printf ("  last_away_check. . . : %lld",  (long long)ptr_server->last_away_check);
         weechat_log_printf ("  last_data_purge. . . : %lld",  (long long)ptr_server->last_data_purge);
         for (i = 0; i < IRC_SERVER_NUM_OUTQUEUES_PRIO; i++)
         {
             weechat_log_printf ("  outqueue[%02d] . . . . : 0x%lx", i, ptr_server->outqueue[i]);
             weechat_log_printf ("  last_outqueue[%02d]. . : 0x%lx", i, ptr_server->last_outqueue[i]);
+            weechat_log_printf ("  outqueue_count[%02d]. : %d",   i, ptr_server->outqueue_count[i]);
+            weechat_log_printf ("  outqueue_round[%02d]. : %d",   i, ptr_server->outqueue_round[i]);
         }
+        weechat_log_printf ("  outqueue_latency . . : %d",    ptr_server->outqueue_latency);
+        weechat_log_printf ("  outqueue_latency_max : %d",    ptr_server->outqueue_latency_max);
         weechat_log_printf ("  redirects. . . . . . : 0x%lx", ptr_server->redirects);
         weechat_log_printf ("  last_redirect. . . . : 0x%lx", ptr_server->last_redirect);
         weechat_log_printf ("  notify_list. . . . . : 0x%lx", ptr_server->notify_list);
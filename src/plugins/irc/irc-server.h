@@ -78,6 +78,7 @@ enum t_irc_server_option
     IRC_SERVER_OPTION_CONNECTION_TIMEOUT,   /* timeout for connection        */
     IRC_SERVER_OPTION_ANTI_FLOOD_PRIO_HIGH, /* anti-flood (high priority)    */
     IRC_SERVER_OPTION_ANTI_FLOOD_PRIO_LOW,  /* anti-flood (low priority)     */
+    IRC_SERVER_OPTION_ANTI_FLOOD_BURST,     /* anti-flood: msgs sent at once */
     IRC_SERVER_OPTION_AWAY_CHECK,           /* delay between away checks     */
     IRC_SERVER_OPTION_AWAY_CHECK_MAX_NICKS, /* max nicks for away check      */
     IRC_SERVER_OPTION_MSG_KICK,             /* default kick message          */
@@ -125,6 +126,10 @@ enum t_irc_server_option
 /* version strings */
 #define IRC_SERVER_VERSION_CAP "302"
 
+/* buffer for received data (the size is doubled when a read fills it) */
+#define IRC_SERVER_RECV_BUFFER_MIN_READ  4096
+#define IRC_SERVER_RECV_BUFFER_MAX_READ  (128 * 1024)
+
 /* casemapping (string comparisons for nicks/channels) */
 enum t_irc_server_casemapping
 {
@@ -145,10 +150,28 @@ struct t_irc_outqueue
     int modified;                         /* msg was modified by modifier(s) */
     char *tags;                           /* tags (used by Relay plugin)     */
     struct t_irc_redirect *redirect;      /* command redirection             */
+    char *target;                         /* target (channel/nick) or NULL   */
+    int round;                            /* round (fair queuing by target)  */
+    struct timeval time_queued;           /* time when msg was queued        */
     struct t_irc_outqueue *next_outqueue; /* link to next msg in queue       */
     struct t_irc_outqueue *prev_outqueue; /* link to prev msg in queue       */
 };
 
+/* data for messages sent by irc_server_sendf (after split) */
+
+struct t_irc_server_sendf_data
+{
+    struct t_irc_server *server;          /* server                          */
+    int flags;                            /* flags for irc_server_sendf      */
+    const char *tags;                     /* tags (used by Relay plugin)     */
+    const char *nick;                     /* nick in message                 */
+    const char *command;                  /* IRC command                     */
+    const char *channel;                  /* channel in message              */
+    struct t_hashtable *ret_hashtable;    /* messages sent (if asked)        */
+    int ret_number;                       /* number of next msg in hashtable */
+    int rc;                               /* 0 if a message was not sent     */
+};
+
 struct t_irc_server
 {
     /* user choices */
@@ -175,6 +198,7 @@ struct t_irc_server
     struct t_hook *hook_fd;         /* hook for server socket                */
     struct t_hook *hook_timer_connection; /* timer for connection            */
     struct t_hook *hook_timer_sasl; /* timer for SASL authentication         */
+    struct t_hook *hook_timer_anti_flood; /* timer to send queued messages   */
     int is_connected;               /* 1 if WeeChat is connected to server   */
     int ssl_connected;              /* = 1 if connected with SSL             */
     int disconnected;               /* 1 if server has been disconnected     */
@@ -183,7 +207,13 @@ struct t_irc_server
     gnutls_x509_crt_t tls_cert;     /* certificate used if ssl_cert is set   */
     gnutls_x509_privkey_t tls_cert_key; /* key used if ssl_cert is set       */
 #endif /* HAVE_GNUTLS */
-    char *unterminated_message;     /* beginning of a message in input buf   */
+    char *recv_buffer;              /* received data: after messages are     */
+                                    /* read, beginning of a message          */
+    int recv_buffer_size;           /* allocated size of recv_buffer         */
+    int recv_buffer_length;         /* length of data in recv_buffer         */
+    char *recv_buffer_spare;        /* spare buffer (swapped with            */
+                                    /* recv_buffer when messages are read)   */
+    int recv_buffer_spare_size;     /* allocated size of recv_buffer_spare   */
     int nicks_count;                /* number of nicknames                   */
     char **nicks_array;             /* nicknames (after split)               */
     int nick_first_tried;           /* first nick tried in list of nicks     */
@@ -221,12 +251,19 @@ struct t_irc_server
     time_t lag_next_check;          /* time for next check                   */
     time_t lag_last_refresh;        /* last refresh of lag item              */
     regex_t *cmd_list_regexp;       /* compiled Regular Expression for /list */
-    time_t last_user_message;       /* time of last user message (anti flood)*/
+    struct timeval last_user_message; /* last user message (anti flood)      */
+    int anti_flood_tokens;          /* msgs that can be sent now (anti flood)*/
+    struct timeval anti_flood_refill; /* last refill of anti-flood tokens    */
     time_t last_away_check;         /* time of last away check on server     */
     time_t last_data_purge;         /* time of last purge (some hashtables)  */
     struct t_irc_outqueue *outqueue[2];      /* queue for outgoing messages  */
                                              /* with 2 priorities (high/low) */
     struct t_irc_outqueue *last_outqueue[2]; /* last outgoing message        */
+    int outqueue_count[2];                   /* number of msgs in queues     */
+    int outqueue_round[2];                   /* round of last msg sent       */
+    int outqueue_latency;                    /* time spent in queue by last  */
+                                             /* msg sent (in milliseconds)   */
+    int outqueue_latency_max;                /* max time spent in queue (ms) */
     struct t_irc_redirect *redirects;        /* command redirections         */
     struct t_irc_redirect *last_redirect;    /* last command redirection     */
     struct t_irc_notify *notify_list;        /* list of notify               */
@@ -243,15 +280,6 @@ struct t_irc_server
     struct t_irc_server *next_server;     /* link to next server             */
 };
 
-/* IRC messages */
-
-struct t_irc_message
-{
-    struct t_irc_server *server;        /* server pointer for received msg   */
-    char *data;                         /* message content                   */
-    struct t_irc_message *next_message; /* link to next message              */
-};
-
 /* digest algorithms for fingerprint */
 
 #ifdef HAVE_GNUTLS
@@ -270,7 +298,6 @@ extern struct t_irc_server *irc_servers;
 extern const int gnutls_cert_type_prio[];
 extern const int gnutls_prot_prio[];
 #endif /* HAVE_GNUTLS */
-extern struct t_irc_message *irc_recv_msgq, *irc_msgq_last_msg;
 extern char *irc_server_sasl_fail_string[];
 extern char *irc_server_options[][2];
 
@@ -333,9 +360,13 @@ extern struct t_hashtable *irc_server_sendf (struct t_irc_server *server,
                                              int flags,
                                              const char *tags,
                                              const char *format, ...);
+extern int irc_server_recv_buffer_alloc (struct t_irc_server *server,
+                                         int size);
+extern void irc_server_recv_buffer_free (struct t_irc_server *server);
 extern void irc_server_msgq_add_buffer (struct t_irc_server *server,
                                         const char *buffer);
-extern void irc_server_msgq_flush ();
+extern char *irc_server_msgq_next_message (char **buffer, char *end);
+extern void irc_server_msgq_flush (struct t_irc_server *server);
 extern void irc_server_set_buffer_title (struct t_irc_server *server);
 extern struct t_gui_buffer *irc_server_create_buffer (struct t_irc_server *server);
 #ifdef HAVE_GNUTLS
@@ -350,8 +381,23 @@ extern int irc_server_timer_sasl_cb (const void *pointer, void *data,
                                      int remaining_calls);
 extern int irc_server_timer_cb (const void *pointer, void *data,
                                 int remaining_calls);
+extern void irc_server_outqueue_add (struct t_irc_server *server,
+                                     int priority, const char *command,
+                                     const char *msg1, const char *msg2,
+                                     int modified, const char *tags,
+                                     struct t_irc_redirect *redirect,
+                                     const char *target);
+extern void irc_server_outqueue_free (struct t_irc_server *server,
+                                      int priority,
+                                      struct t_irc_outqueue *outqueue);
 extern void irc_server_outqueue_free_all (struct t_irc_server *server,
                                           int priority);
+extern long long irc_server_anti_flood_delay (struct t_irc_server *server,
+                                              int priority,
+                                              struct timeval *tv_now);
+extern struct t_irc_outqueue *irc_server_outqueue_get_next (struct t_irc_server *server,
+                                                            int priority);
+extern void irc_server_outqueue_send (struct t_irc_server *server);
 extern int irc_server_get_channel_count (struct t_irc_server *server);
 extern int irc_server_get_pv_count (struct t_irc_server *server);
 extern void irc_server_set_away (struct t_irc_server *server, const char *nick,
@@ -413,7 +413,7 @@ irc_upgrade_read_cb (const void *pointer, void *data,
                     irc_upgrade_current_server->disconnected = weechat_infolist_integer (infolist, "disconnected");
                     str = weechat_infolist_string (infolist, "unterminated_message");
                     if (str)
-                        irc_upgrade_current_server->unterminated_message = strdup (str);
+                        irc_server_msgq_add_buffer (irc_upgrade_current_server, str);
                     str = weechat_infolist_string (infolist, "nick");
                     if (str)
                         irc_server_set_nick (irc_upgrade_current_server, str);
@@ -522,7 +522,8 @@ irc_upgrade_read_cb (const void *pointer, void *data,
                         memcpy (&(irc_upgrade_current_server->lag_check_time), buf, size);
                     irc_upgrade_current_server->lag_next_check = weechat_infolist_time (infolist, "lag_next_check");
                     irc_upgrade_current_server->lag_last_refresh = weechat_infolist_time (infolist, "lag_last_refresh");
-                    irc_upgrade_current_server->last_user_message = weechat_infolist_time (infolist, "last_user_message");
+                    irc_upgrade_current_server->last_user_message.tv_sec = weechat_infolist_time (infolist, "last_user_message");
+                    irc_upgrade_current_server->last_user_message.tv_usec = 0;
                     irc_upgrade_current_server->last_away_check = weechat_infolist_time (infolist, "last_away_check");
                     irc_upgrade_current_server->last_data_purge = weechat_infolist_time (infolist, "last_data_purge");
                 }
@@ -829,6 +830,7 @@ irc_upgrade_load ()
 {
     int rc;
     struct t_upgrade_file *upgrade_file;
+    struct t_irc_server *ptr_server;
 
     irc_upgrade_set_buffer_callbacks ();
 
@@ -841,5 +843,12 @@ irc_upgrade_load ()
 
     weechat_upgrade_close (upgrade_file);
 
+    /* index of nicks in nicklists uses the casemapping of servers */
+    for (ptr_server = irc_servers; ptr_server;
+         ptr_server = ptr_server->next_server)
+    {
+        irc_channel_nicklist_index_build (ptr_server);
+    }
+
     return rc;
 }
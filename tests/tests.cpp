@@ -68,12 +68,15 @@ IMPORT_TEST_GROUP(CoreHook);
 IMPORT_TEST_GROUP(CoreInfolist);
 IMPORT_TEST_GROUP(CoreList);
 IMPORT_TEST_GROUP(CoreSecure);
+IMPORT_TEST_GROUP(CoreSlab);
 IMPORT_TEST_GROUP(CoreString);
 IMPORT_TEST_GROUP(CoreUrl);
 IMPORT_TEST_GROUP(CoreUtf8);
 IMPORT_TEST_GROUP(CoreUtil);
+IMPORT_TEST_GROUP(CoreWorker);
 /* GUI */
 IMPORT_TEST_GROUP(GuiLine);
+IMPORT_TEST_GROUP(GuiNicklist);
 /* scripts */
 IMPORT_TEST_GROUP(Scripts);
 
@@ -221,6 +221,109 @@ TEST(CoreEval, EvalCondition)
     hashtable_free (options);
 }
 
+/*
+ * Tests functions:
+ *   eval_compile_condition
+ *   eval_node_free
+ *   eval_cache_free_all
+ */
+
+TEST(CoreEval, EvalConditionCache)
+{
+    struct t_hashtable *pointers, *extra_vars, *options;
+    struct t_eval_node *node;
+    char *value, str_expr[64];
+    int i;
+
+    pointers = NULL;
+
+    extra_vars = hashtable_new (32,
+                                WEECHAT_HASHTABLE_STRING,
+                                WEECHAT_HASHTABLE_STRING,
+                                NULL, NULL);
+    CHECK(extra_vars);
+
+    options = hashtable_new (32,
+                             WEECHAT_HASHTABLE_STRING,
+                             WEECHAT_HASHTABLE_STRING,
+                             NULL, NULL);
+    CHECK(options);
+    hashtable_set (options, "type", "condition");
+
+    /* compiled conditions */
+    POINTERS_EQUAL(NULL, eval_compile_condition (NULL, "${"));
+    POINTERS_EQUAL(NULL, eval_compile_condition ("abc", NULL));
+    POINTERS_EQUAL(NULL, eval_compile_condition ("abc", ""));
+
+    node = eval_compile_condition ("  abc  ", "${");
+    CHECK(node);
+    LONGS_EQUAL(EVAL_NODE_TEXT, node->type);
+    STRCMP_EQUAL("abc", node->text);
+    eval_node_free (node);
+
+    node = eval_compile_condition ("a\\${b}", "${");
+    CHECK(node);
+    LONGS_EQUAL(EVAL_NODE_VARS, node->type);
+    eval_node_free (node);
+
+    node = eval_compile_condition ("(${a} == 1) && (b || (c))", "${");
+    CHECK(node);
+    LONGS_EQUAL(EVAL_NODE_LOGICAL, node->type);
+    LONGS_EQUAL(EVAL_LOGICAL_OP_AND, node->op);
+    LONGS_EQUAL(EVAL_NODE_COMPARE, node->left->type);
+    LONGS_EQUAL(EVAL_COMPARE_EQUAL, node->left->op);
+    LONGS_EQUAL(EVAL_NODE_VARS, node->left->left->type);
+    STRCMP_EQUAL("${a}", node->left->left->text);
+    LONGS_EQUAL(EVAL_NODE_TEXT, node->left->right->type);
+    LONGS_EQUAL(EVAL_NODE_LOGICAL, node->right->type);
+    LONGS_EQUAL(EVAL_LOGICAL_OP_OR, node->right->op);
+    STRCMP_EQUAL("c", node->right->right->text);
+    eval_node_free (node);
+
+    node = eval_compile_condition ("(abc", "${");
+    CHECK(node);
+    LONGS_EQUAL(EVAL_NODE_INVALID, node->type);
+    eval_node_free (node);
+
+    node = eval_compile_condition ("(a) b", "${");
+    CHECK(node);
+    LONGS_EQUAL(EVAL_NODE_DYNAMIC, node->type);
+    STRCMP_EQUAL("(a) b", node->text);
+    eval_node_free (node);
+
+    /* same condition evaluated with different variables */
+    eval_cache_free_all ();
+    hashtable_set (extra_vars, "test", "1");
+    WEE_CHECK_EVAL("1", "${test} == 1 && (${test} > 0)");
+    LONGS_EQUAL(1, eval_cache_count);
+    hashtable_set (extra_vars, "test", "2");
+    WEE_CHECK_EVAL("0", "${test} == 1 && (${test} > 0)");
+    hashtable_set (extra_vars, "test", "-1");
+    WEE_CHECK_EVAL("0", "${test} == 1 && (${test} > 0)");
+    LONGS_EQUAL(1, eval_cache_count);
+
+    /* text after parentheses is parsed on each evaluation */
+    hashtable_set (extra_vars, "test", "1 ==");
+    WEE_CHECK_EVAL("1", "(${test}) 1");
+    hashtable_set (extra_vars, "test", "abc");
+    WEE_CHECK_EVAL("1", "(${test}) 1");
+    LONGS_EQUAL(2, eval_cache_count);
+
+    /* the number of compiled conditions in cache is limited */
+    for (i = 0; i < EVAL_CACHE_MAX + 10; i++)
+    {
+        snprintf (str_expr, sizeof (str_expr), "%d == %d", i, i);
+        WEE_CHECK_EVAL("1", str_expr);
+    }
+    LONGS_EQUAL(EVAL_CACHE_MAX, eval_cache_count);
+
+    eval_cache_free_all ();
+    LONGS_EQUAL(0, eval_cache_count);
+
+    hashtable_free (extra_vars);
+    hashtable_free (options);
+}
+
 /*
  * Tests functions:
  *   eval_expression (expression)
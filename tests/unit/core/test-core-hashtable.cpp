@@ -23,6 +23,7 @@
 
 extern "C"
 {
+#include <stdio.h>
 #include <string.h>
 #include "src/core/wee-hashtable.h"
 #include "src/plugins/plugin.h"
@@ -30,6 +31,7 @@ extern "C"
 
 #define HASHTABLE_TEST_KEY      "test"
 #define HASHTABLE_TEST_KEY_HASH 5849825121ULL
+#define HASHTABLE_TEST_KEY_HASH_FNV1A 18007334074686647077ULL
 #define HASHTABLE_TEST_VALUE    "this is a value"
 
 TEST_GROUP(CoreHashtable)
@@ -49,6 +51,22 @@ TEST(CoreHashtable, HashDbj2)
     CHECK(hash == HASHTABLE_TEST_KEY_HASH);
 }
 
+/*
+ * Tests functions:
+ *   hashtable_hash_key_fnv1a
+ */
+
+TEST(CoreHashtable, HashFnv1a)
+{
+    unsigned long long hash;
+
+    hash = hashtable_hash_key_fnv1a ("");
+    CHECK(hash == 14695981039346656037ULL);
+
+    hash = hashtable_hash_key_fnv1a (HASHTABLE_TEST_KEY);
+    CHECK(hash == HASHTABLE_TEST_KEY_HASH_FNV1A);
+}
+
 /*
  * Test callback hashing a key.
  *
@@ -283,17 +301,17 @@ TEST(CoreHashtable, SetGetRemove)
      *   +-----+
      *   |   1 |
      *   +-----+
-     *   |   2 | --> "extensible"
+     *   |   2 | --> "weechat"
      *   +-----+
-     *   |   3 | --> "fast" --> "light"
+     *   |   3 | --> "chat"
      *   +-----+
-     *   |   4 |
+     *   |   4 | --> "extensible"
      *   +-----+
-     *   |   5 | --> "chat"
+     *   |   5 |
      *   +-----+
      *   |   6 | --> "client"
      *   +-----+
-     *   |   7 | --> "weechat"
+     *   |   7 | --> "fast" --> "light"
      *   +-----+
      */
     hashtable = hashtable_new (8,
@@ -306,23 +324,23 @@ TEST(CoreHashtable, SetGetRemove)
 
     item = hashtable_set (hashtable, "weechat", NULL);
     CHECK(item);
-    POINTERS_EQUAL(item, hashtable->htable[7]);
+    POINTERS_EQUAL(item, hashtable->htable[2]);
 
     item = hashtable_set (hashtable, "fast", NULL);
     CHECK(item);
-    POINTERS_EQUAL(item, hashtable->htable[3]);
+    POINTERS_EQUAL(item, hashtable->htable[7]);
 
     item = hashtable_set (hashtable, "light", NULL);
     CHECK(item);
-    POINTERS_EQUAL(item, hashtable->htable[3]->next_item);
+    POINTERS_EQUAL(item, hashtable->htable[7]->next_item);
 
     item = hashtable_set (hashtable, "extensible", NULL);
     CHECK(item);
-    POINTERS_EQUAL(item, hashtable->htable[2]);
+    POINTERS_EQUAL(item, hashtable->htable[4]);
 
     item = hashtable_set (hashtable, "chat", NULL);
     CHECK(item);
-    POINTERS_EQUAL(item, hashtable->htable[5]);
+    POINTERS_EQUAL(item, hashtable->htable[3]);
 
     item = hashtable_set (hashtable, "client", NULL);
     CHECK(item);
@@ -332,6 +350,81 @@ TEST(CoreHashtable, SetGetRemove)
     hashtable_free (hashtable);
 }
 
+/*
+ * Tests functions:
+ *   hashtable_resize
+ *   hashtable_set (with automatic resize)
+ */
+
+TEST(CoreHashtable, Resize)
+{
+    struct t_hashtable *hashtable;
+    struct t_hashtable_item *items[64], *item;
+    char key[32];
+    int i, count;
+
+    hashtable = hashtable_new (4,
+                               WEECHAT_HASHTABLE_STRING,
+                               WEECHAT_HASHTABLE_INTEGER,
+                               NULL,
+                               NULL);
+    CHECK(hashtable);
+
+    LONGS_EQUAL(0, hashtable_resize (NULL, 8));
+    LONGS_EQUAL(0, hashtable_resize (hashtable, 0));
+    LONGS_EQUAL(0, hashtable_resize (hashtable, 4));
+
+    /* add 64 items: htable is enlarged (load factor is 1) */
+    for (i = 0; i < 64; i++)
+    {
+        snprintf (key, sizeof (key), "key%d", i);
+        items[i] = hashtable_set (hashtable, key, &i);
+        CHECK(items[i]);
+        LONGS_EQUAL(i + 1, hashtable->items_count);
+        CHECK(hashtable->items_count
+              <= hashtable->size * HASHTABLE_MAX_LOAD_FACTOR);
+    }
+    LONGS_EQUAL(64, hashtable->size);
+    LONGS_EQUAL(64, hashtable_get_integer (hashtable, "size"));
+
+    /* items are not reallocated and can all be found */
+    for (i = 0; i < 64; i++)
+    {
+        snprintf (key, sizeof (key), "key%d", i);
+        item = hashtable_get_item (hashtable, key, NULL);
+        POINTERS_EQUAL(items[i], item);
+        LONGS_EQUAL(i, *((int *)item->value));
+    }
+
+    /* count items and check that linked lists are sorted */
+    count = 0;
+    for (i = 0; i < hashtable->size; i++)
+    {
+        for (item = hashtable->htable[i]; item; item = item->next_item)
+        {
+            if (item->next_item)
+            {
+                CHECK(strcmp ((const char *)item->key,
+                              (const char *)item->next_item->key) < 0);
+                POINTERS_EQUAL(item, item->next_item->prev_item);
+            }
+            count++;
+        }
+    }
+    LONGS_EQUAL(64, count);
+
+    /* shrink htable: items are still found */
+    LONGS_EQUAL(1, hashtable_resize (hashtable, 3));
+    LONGS_EQUAL(3, hashtable->size);
+    for (i = 0; i < 64; i++)
+    {
+        snprintf (key, sizeof (key), "key%d", i);
+        POINTERS_EQUAL(items[i], hashtable_get_item (hashtable, key, NULL));
+    }
+
+    hashtable_free (hashtable);
+}
+
 /*
  * Tests functions:
  *   hashtable_map
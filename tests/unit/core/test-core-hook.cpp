@@ -24,11 +24,14 @@
 extern "C"
 {
 #include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
 #include "src/core/wee-hook.h"
 #include "src/core/wee-string.h"
 #include "src/gui/gui-buffer.h"
 #include "src/gui/gui-chat.h"
 #include "src/gui/gui-line.h"
+#include "src/plugins/plugin.h"
 }
 
 #define TEST_BUFFER_NAME "test"
@@ -87,14 +90,88 @@ TEST(CoreHook, Connect)
     /* TODO: write tests */
 }
 
+int test_fd_calls = 0;
+
+int
+test_fd_cb (const void *pointer, void *data, int fd)
+{
+    char buf[64];
+
+    /* make C++ compiler happy */
+    (void) pointer;
+    (void) data;
+
+    if (read (fd, buf, sizeof (buf)) > 0)
+        test_fd_calls++;
+
+    return WEECHAT_RC_OK;
+}
+
 /*
  * Tests functions:
  *   hook_fd
+ *   hook_fd_set_flags
+ *   hook_fd_exec
  */
 
 TEST(CoreHook, Fd)
 {
-    /* TODO: write tests */
+    struct t_hook *hook;
+    int fds[2];
+
+    LONGS_EQUAL(0, pipe (fds));
+
+    POINTERS_EQUAL(NULL, hook_fd (NULL, -1, 1, 0, 0, &test_fd_cb, NULL, NULL));
+
+    hook = hook_fd (NULL, fds[0], 1, 0, 0, &test_fd_cb, NULL, NULL);
+    CHECK(hook);
+    LONGS_EQUAL(fds[0], HOOK_FD(hook, fd));
+    LONGS_EQUAL(HOOK_FD_FLAG_READ, HOOK_FD(hook, flags));
+
+    /* fd already hooked */
+    POINTERS_EQUAL(NULL, hook_fd (NULL, fds[0], 1, 0, 0, &test_fd_cb,
+                                  NULL, NULL));
+
+    /* data available on fd: callback is called */
+    test_fd_calls = 0;
+    LONGS_EQUAL(4, write (fds[1], "test", 4));
+    hook_fd_exec ();
+    LONGS_EQUAL(1, test_fd_calls);
+
+    /* no read flag: callback is not called */
+    hook_fd_set_flags (hook, 0);
+    LONGS_EQUAL(0, HOOK_FD(hook, flags));
+    test_fd_calls = 0;
+    LONGS_EQUAL(4, write (fds[1], "test", 4));
+    hook_fd_exec ();
+    LONGS_EQUAL(0, test_fd_calls);
+
+    /* read flag set again: callback is called */
+    hook_fd_set_flags (hook, HOOK_FD_FLAG_READ);
+    hook_fd_exec ();
+    LONGS_EQUAL(1, test_fd_calls);
+
+    /* hook deleted during hook execution: fd can be hooked again */
+    hook_exec_start ();
+    unhook (hook);
+    POINTERS_EQUAL(NULL, hook_fd_search (fds[0]));
+    hook = hook_fd (NULL, fds[0], 1, 0, 0, &test_fd_cb, NULL, NULL);
+    CHECK(hook);
+    POINTERS_EQUAL(hook, hook_fd_search (fds[0]));
+    hook_exec_end ();
+
+    /* new hook still receives events after the old hook is freed */
+    POINTERS_EQUAL(hook, hook_fd_search (fds[0]));
+    test_fd_calls = 0;
+    LONGS_EQUAL(4, write (fds[1], "test", 4));
+    hook_fd_exec ();
+    LONGS_EQUAL(1, test_fd_calls);
+
+    unhook (hook);
+    POINTERS_EQUAL(NULL, hook_fd_search (fds[0]));
+
+    close (fds[0]);
+    close (fds[1]);
 }
 
 /*
@@ -368,22 +445,161 @@ TEST(CoreHook, Process)
     /* TODO: write tests */
 }
 
+char test_signal_calls[256];
+
+int
+test_signal_cb (const void *pointer, void *data, const char *signal,
+                const char *type_data, void *signal_data)
+{
+    /* make C++ compiler happy */
+    (void) data;
+    (void) signal;
+    (void) type_data;
+    (void) signal_data;
+
+    strcat (test_signal_calls, (const char *)pointer);
+
+    return (strcmp ((const char *)pointer, "E") == 0) ?
+        WEECHAT_RC_OK_EAT : WEECHAT_RC_OK;
+}
+
 /*
  * Tests functions:
  *   hook_signal
+ *   hook_signal_send
+ *   hook_stats_reset
  */
 
 TEST(CoreHook, Signal)
 {
-    /* TODO: write tests */
+    struct t_hook *hook_a, *hook_b, *hook_c, *hook_d, *hook_e;
+
+    hook_a = hook_signal (NULL, "test_signal", &test_signal_cb, "A", NULL);
+    hook_b = hook_signal (NULL, "test_sig*", &test_signal_cb, "B", NULL);
+    hook_c = hook_signal (NULL, "2000|TEST_SIGNAL", &test_signal_cb, "C",
+                          NULL);
+    hook_d = hook_signal (NULL, "test_other", &test_signal_cb, "D", NULL);
+    CHECK(hook_a);
+    CHECK(hook_b);
+    CHECK(hook_c);
+    CHECK(hook_d);
+    LONGS_EQUAL(2000, hook_c->priority);
+    STRCMP_EQUAL("TEST_SIGNAL", HOOK_SIGNAL(hook_c, signal));
+
+    /* exact names (case insensitive) and masks, sorted by priority */
+    test_signal_calls[0] = '\0';
+    LONGS_EQUAL(WEECHAT_RC_OK,
+                hook_signal_send ("test_signal", WEECHAT_HOOK_SIGNAL_STRING,
+                                  NULL));
+    STRCMP_EQUAL("CAB", test_signal_calls);
+
+    test_signal_calls[0] = '\0';
+    hook_signal_send ("test_sig", WEECHAT_HOOK_SIGNAL_STRING, NULL);
+    STRCMP_EQUAL("B", test_signal_calls);
+
+    test_signal_calls[0] = '\0';
+    hook_signal_send ("test_other", WEECHAT_HOOK_SIGNAL_STRING, NULL);
+    STRCMP_EQUAL("D", test_signal_calls);
+
+    test_signal_calls[0] = '\0';
+    hook_signal_send ("test_unknown", WEECHAT_HOOK_SIGNAL_STRING, NULL);
+    STRCMP_EQUAL("", test_signal_calls);
+
+    /* signal eaten by a callback: next callbacks are not called */
+    hook_e = hook_signal (NULL, "1500|test_*", &test_signal_cb, "E", NULL);
+    CHECK(hook_e);
+    test_signal_calls[0] = '\0';
+    LONGS_EQUAL(WEECHAT_RC_OK_EAT,
+                hook_signal_send ("test_signal", WEECHAT_HOOK_SIGNAL_STRING,
+                                  NULL));
+    STRCMP_EQUAL("CE", test_signal_calls);
+    unhook (hook_e);
+
+    /* unhooked signals are not called any more */
+    unhook (hook_c);
+    test_signal_calls[0] = '\0';
+    hook_signal_send ("test_signal", WEECHAT_HOOK_SIGNAL_STRING, NULL);
+    STRCMP_EQUAL("AB", test_signal_calls);
+
+    /* statistics on callbacks (disabled by default) */
+    LONGS_EQUAL(0, hook_a->stats_calls);
+    hook_stats_enabled = 1;
+    hook_signal_send ("test_signal", WEECHAT_HOOK_SIGNAL_STRING, NULL);
+    hook_signal_send ("test_sig", WEECHAT_HOOK_SIGNAL_STRING, NULL);
+    hook_stats_enabled = 0;
+    LONGS_EQUAL(1, hook_a->stats_calls);
+    LONGS_EQUAL(2, hook_b->stats_calls);
+    LONGS_EQUAL(0, hook_d->stats_calls);
+    CHECK(hook_b->stats_time_max <= hook_b->stats_time_total);
+    hook_stats_reset ();
+    LONGS_EQUAL(0, hook_a->stats_calls);
+    LONGS_EQUAL(0, hook_b->stats_calls);
+    LONGS_EQUAL(0, hook_b->stats_time_total);
+
+    unhook (hook_a);
+    unhook (hook_b);
+    unhook (hook_d);
+    test_signal_calls[0] = '\0';
+    hook_signal_send ("test_signal", WEECHAT_HOOK_SIGNAL_STRING, NULL);
+    STRCMP_EQUAL("", test_signal_calls);
+}
+
+int test_timer_calls = 0;
+
+int
+test_timer_cb (const void *pointer, void *data, int remaining_calls)
+{
+    /* make C++ compiler happy */
+    (void) pointer;
+    (void) data;
+    (void) remaining_calls;
+
+    test_timer_calls++;
+
+    return WEECHAT_RC_OK;
 }
 
 /*
  * Tests functions:
  *   hook_timer
+ *   hook_timer_get_time_to_next
+ *   hook_timer_exec
  */
 
 TEST(CoreHook, Timer)
 {
-    /* TODO: write tests */
+    struct t_hook *hook1, *hook2, *hook3;
+    int timeout;
+
+    hook1 = hook_timer (NULL, 60000, 0, 0, &test_timer_cb, NULL, NULL);
+    hook2 = hook_timer (NULL, 500, 0, 0, &test_timer_cb, NULL, NULL);
+    hook3 = hook_timer (NULL, 30000, 0, 1, &test_timer_cb, NULL, NULL);
+    CHECK(hook1);
+    CHECK(hook2);
+    CHECK(hook3);
+    CHECK(HOOK_TIMER(hook1, heap_index) >= 0);
+    CHECK(HOOK_TIMER(hook2, heap_index) >= 0);
+    CHECK(HOOK_TIMER(hook3, heap_index) >= 0);
+
+    /* next timeout is the one of hook2 (at most 500ms) */
+    timeout = hook_timer_get_time_to_next ();
+    CHECK((timeout >= 1) && (timeout <= 500));
+
+    /* force execution of hook3 (only one call) */
+    test_timer_calls = 0;
+    gettimeofday (&HOOK_TIMER(hook3, next_exec), NULL);
+    HOOK_TIMER(hook3, next_exec).tv_sec -= 10;
+    hook_timer_heap_update (hook3);
+    hook_timer_exec ();
+    LONGS_EQUAL(1, test_timer_calls);
+    LONGS_EQUAL(0, hook_valid (hook3));
+
+    /* hook2 is still the next timer, then hook1 */
+    timeout = hook_timer_get_time_to_next ();
+    CHECK((timeout >= 1) && (timeout <= 500));
+    unhook (hook2);
+    timeout = hook_timer_get_time_to_next ();
+    CHECK((timeout >= 1) && (timeout <= 2000));
+
+    unhook (hook1);
 }
@@ -0,0 +1,114 @@
+/*
+ * test-core-slab.cpp - test slab allocator functions
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This file is part of WeeChat, the extensible chat client.
+ *
+ * WeeChat is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WeeChat is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WeeChat.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "CppUTest/TestHarness.h"
+
+extern "C"
+{
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "src/core/wee-slab.h"
+}
+
+TEST_GROUP(CoreSlab)
+{
+};
+
+/*
+ * Tests functions:
+ *   slab_new
+ *   slab_free
+ */
+
+TEST(CoreSlab, NewFree)
+{
+    struct t_slab *slab;
+
+    POINTERS_EQUAL(NULL, slab_new (NULL, 16));
+    POINTERS_EQUAL(NULL, slab_new ("test", 0));
+    POINTERS_EQUAL(NULL, slab_new ("test", SLAB_CHUNK_SIZE));
+
+    slab = slab_new ("test", 20);
+    CHECK(slab);
+    STRCMP_EQUAL("test", slab->name);
+    CHECK(slab->object_size >= 20);
+    LONGS_EQUAL(0, slab->object_size % sizeof (void *));
+    CHECK(slab->objects_per_chunk > 0);
+    LONGS_EQUAL(0, slab->chunks_count);
+    LONGS_EQUAL(0, slab->objects_count);
+    POINTERS_EQUAL(NULL, slab->chunks_avail);
+    POINTERS_EQUAL(NULL, slab->chunks_full);
+
+    slab_free (slab);
+    slab_free (NULL);
+}
+
+/*
+ * Tests functions:
+ *   slab_alloc
+ *   slab_release
+ */
+
+TEST(CoreSlab, AllocRelease)
+{
+    struct t_slab *slab;
+    void **objects;
+    int i, count;
+
+    POINTERS_EQUAL(NULL, slab_alloc (NULL));
+    slab_release (NULL);
+
+    slab = slab_new ("test", 64);
+    CHECK(slab);
+
+    /* allocate enough objects to fill 3 chunks */
+    count = slab->objects_per_chunk * 3;
+    objects = (void **)malloc (count * sizeof (*objects));
+    for (i = 0; i < count; i++)
+    {
+        objects[i] = slab_alloc (slab);
+        CHECK(objects[i]);
+        LONGS_EQUAL(0, (uintptr_t)objects[i] % sizeof (void *));
+        memset (objects[i], 0xAA, 64);
+    }
+    LONGS_EQUAL(3, slab->chunks_count);
+    LONGS_EQUAL(count, slab->objects_count);
+    POINTERS_EQUAL(NULL, slab->chunks_avail);
+
+    /* released object is reused */
+    slab_release (objects[10]);
+    LONGS_EQUAL(count - 1, slab->objects_count);
+    CHECK(slab->chunks_avail);
+    POINTERS_EQUAL(objects[10], slab_alloc (slab));
+    LONGS_EQUAL(count, slab->objects_count);
+
+    /* release all objects: empty chunks are freed, except the last one */
+    for (i = 0; i < count; i++)
+    {
+        slab_release (objects[i]);
+    }
+    LONGS_EQUAL(0, slab->objects_count);
+    LONGS_EQUAL(1, slab->chunks_count);
+
+    free (objects);
+    slab_free (slab);
+}
@@ -821,6 +821,9 @@ TEST(CoreString, Regex)
 /*
  * Tests functions:
  *   string_has_highlight
+ *   string_highlight_compile
+ *   string_highlight_free
+ *   string_has_highlight_compiled
  *   string_has_highlight_regex_compiled
  *   string_has_highlight_regex
  */
@@ -828,6 +831,7 @@ TEST(CoreString, Regex)
 TEST(CoreString, Highlight)
 {
     regex_t regex;
+    struct t_string_highlight *highlight;
 
     /* check highlight with a string */
     WEE_HAS_HL_STR(0, NULL, NULL);
@@ -847,6 +851,49 @@ TEST(CoreString, Highlight)
     WEE_HAS_HL_STR(1, "test\u00A0:here", "test");  /* unbreakable space */
     WEE_HAS_HL_STR(1, "this is a test here", "test");
     WEE_HAS_HL_STR(1, "this is a test here", "abc,test");
+    WEE_HAS_HL_STR(1, "this is a TEST here", "abc,test");
+    WEE_HAS_HL_STR(0, "this is a TEST here", "abc,(?-i)test");
+    WEE_HAS_HL_STR(1, "this is a test here", "(?-i)abc,test");
+    WEE_HAS_HL_STR(0, "tested", "test");
+    WEE_HAS_HL_STR(1, "tested", "test*");
+    WEE_HAS_HL_STR(0, "tested", "*test");
+    WEE_HAS_HL_STR(1, "a retest", "*test");
+    WEE_HAS_HL_STR(1, "retested", "*test*");
+    WEE_HAS_HL_STR(0, "abc", "*,**");
+    WEE_HAS_HL_STR(1, "é test", "É,TEST");
+    WEE_HAS_HL_STR(0, "É test", "é");
+    WEE_HAS_HL_STR(1, "É test", "É");
+    /* matches of a word do not overlap */
+    WEE_HAS_HL_STR(0, "ba a a", "a a");
+    WEE_HAS_HL_STR(1, "ba a a", "a a,a");
+
+    /* check highlight with compiled words */
+    POINTERS_EQUAL(NULL, string_highlight_compile (NULL));
+    LONGS_EQUAL(0, string_has_highlight_compiled ("test", NULL));
+    highlight = string_highlight_compile ("");
+    CHECK(highlight);
+    LONGS_EQUAL(0, highlight->num_words);
+    LONGS_EQUAL(0, string_has_highlight_compiled ("test", highlight));
+    string_highlight_free (highlight);
+    highlight = string_highlight_compile ("abc,(?-i)Def,*ghi*,*");
+    CHECK(highlight);
+    STRCMP_EQUAL("abc,(?-i)Def,*ghi*,*", highlight->highlight_words);
+    LONGS_EQUAL(3, highlight->num_words);
+    STRCMP_EQUAL("abc", highlight->words[0].word);
+    LONGS_EQUAL(1, highlight->words[0].case_insensitive);
+    STRCMP_EQUAL("Def", highlight->words[1].word);
+    LONGS_EQUAL(0, highlight->words[1].case_insensitive);
+    STRCMP_EQUAL("ghi", highlight->words[2].word);
+    LONGS_EQUAL(1, highlight->words[2].wildcard_start);
+    LONGS_EQUAL(1, highlight->words[2].wildcard_end);
+    LONGS_EQUAL(0, string_has_highlight_compiled (NULL, highlight));
+    LONGS_EQUAL(0, string_has_highlight_compiled ("", highlight));
+    LONGS_EQUAL(1, string_has_highlight_compiled ("ABC here", highlight));
+    LONGS_EQUAL(1, string_has_highlight_compiled ("here: Def", highlight));
+    LONGS_EQUAL(0, string_has_highlight_compiled ("here: def", highlight));
+    LONGS_EQUAL(1, string_has_highlight_compiled ("xGHIx", highlight));
+    LONGS_EQUAL(0, string_has_highlight_compiled ("abcdef", highlight));
+    string_highlight_free (highlight);
 
     /*
      * check highlight with a regex, each call of macro
@@ -43,6 +43,33 @@ TEST_GROUP(CoreUtf8)
 {
 };
 
+/*
+ * Tests functions:
+ *   utf8_ascii_length
+ */
+
+TEST(CoreUtf8, AsciiLength)
+{
+    const char *str_ascii = "abcdefghijklmnopqrstuvwxyz";
+    const char *str_8bits = "abcdefghijklmnopqrst\xc3\xabuvwxyz";
+
+    LONGS_EQUAL(0, utf8_ascii_length (NULL, 0));
+    LONGS_EQUAL(0, utf8_ascii_length (NULL, 10));
+    LONGS_EQUAL(0, utf8_ascii_length ("", 0));
+    LONGS_EQUAL(0, utf8_ascii_length ("abc", -1));
+    LONGS_EQUAL(0, utf8_ascii_length ("\xc3\xab", 2));
+    LONGS_EQUAL(1, utf8_ascii_length ("a\xc3\xab", 3));
+    LONGS_EQUAL(3, utf8_ascii_length ("abc", 3));
+    LONGS_EQUAL(2, utf8_ascii_length ("abc", 2));
+    LONGS_EQUAL(8, utf8_ascii_length (str_ascii, 8));
+    LONGS_EQUAL(9, utf8_ascii_length (str_ascii, 9));
+    LONGS_EQUAL(26, utf8_ascii_length (str_ascii, 26));
+    LONGS_EQUAL(16, utf8_ascii_length (str_ascii, 16));
+    LONGS_EQUAL(7, utf8_ascii_length (str_8bits + 13, 20));
+    LONGS_EQUAL(20, utf8_ascii_length (str_8bits, strlen (str_8bits)));
+    LONGS_EQUAL(15, utf8_ascii_length (str_8bits, 15));
+}
+
 /*
  * Tests functions:
  *   utf8_has_8bits
@@ -52,12 +79,26 @@ TEST_GROUP(CoreUtf8)
 TEST(CoreUtf8, Validity)
 {
     char *error;
+    const char *str_long_invalid = "abcdefghijklmnop\xc3\xab qrstuvwxyz\xfe abc";
 
     /* check 8 bits */
     LONGS_EQUAL(0, utf8_has_8bits (NULL));
     LONGS_EQUAL(0, utf8_has_8bits (""));
     LONGS_EQUAL(0, utf8_has_8bits ("abc"));
     LONGS_EQUAL(1, utf8_has_8bits ("no\xc3\xabl"));
+    LONGS_EQUAL(0, utf8_has_8bits ("abcdefghijklmnopqrstuvwxyz"));
+    LONGS_EQUAL(1, utf8_has_8bits ("abcdefghijklmnopqrstuvwxy\xc3\xab"));
+
+    /* check validity of long strings (7-bit chars skipped by blocks) */
+    LONGS_EQUAL(1, utf8_is_valid ("abcdefghijklmnop\xc3\xab qrstuvwxyz",
+                                  -1, &error));
+    POINTERS_EQUAL(NULL, error);
+    LONGS_EQUAL(0, utf8_is_valid (str_long_invalid, -1, &error));
+    POINTERS_EQUAL(str_long_invalid + 29, error);
+    LONGS_EQUAL(1, utf8_is_valid (str_long_invalid, 28, &error));
+    POINTERS_EQUAL(NULL, error);
+    LONGS_EQUAL(0, utf8_is_valid (str_long_invalid, 29, &error));
+    POINTERS_EQUAL(str_long_invalid + 29, error);
 
     /* check validity */
     LONGS_EQUAL(1, utf8_is_valid (NULL, -1, NULL));
@@ -370,6 +411,9 @@ TEST(CoreUtf8, Size)
     LONGS_EQUAL(1, utf8_strlen ("€"));
     LONGS_EQUAL(1, utf8_strlen (cjk_yellow));
     LONGS_EQUAL(1, utf8_strlen (han_char));
+    LONGS_EQUAL(26, utf8_strlen ("abcdefghijklmnopqrstuvwxyz"));
+    LONGS_EQUAL(26, utf8_strlen ("abcdefghijklmnopqrstuvwxy\xc3\xab"));
+    LONGS_EQUAL(29, utf8_strlen ("no\xc3\xabl abcdefghijklmnopq\xe2\x82\xacrstuvw"));
 
     /* length of string (in chars, for max N bytes) */
     LONGS_EQUAL(0, utf8_strnlen (NULL, 0));
@@ -387,6 +431,10 @@ TEST(CoreUtf8, Size)
     LONGS_EQUAL(1, utf8_strlen_screen ("€"));
     LONGS_EQUAL(1, utf8_strlen_screen ("\x7f"));
     LONGS_EQUAL(2, utf8_strlen_screen (cjk_yellow));
+    LONGS_EQUAL(26, utf8_strlen_screen ("abcdefghijklmnopqrstuvwxyz"));
+    LONGS_EQUAL(26, utf8_strlen_screen ("abcdefghijklmnopqrstuvwxy\xc3\xab"));
+    LONGS_EQUAL(28, utf8_strlen_screen ("abcdefghijklmnopqrstuvwxy\xe2\x82\xac"
+                                        "\xe2\xbb\xa9"));
 }
 
 /*
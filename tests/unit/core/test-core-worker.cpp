@@ -0,0 +1,178 @@
+/*
+ * test-core-worker.cpp - test worker threads functions
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This file is part of WeeChat, the extensible chat client.
+ *
+ * WeeChat is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WeeChat is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WeeChat.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "CppUTest/TestHarness.h"
+
+extern "C"
+{
+#include <string.h>
+#include "src/core/wee-worker.h"
+}
+
+struct t_test_worker_data
+{
+    int value;
+    int result;
+    int done;
+};
+
+TEST_GROUP(CoreWorker)
+{
+};
+
+/*
+ * Callback for job run: computes the square of value.
+ */
+
+void
+test_worker_run_cb (struct t_worker_job *job, void *data)
+{
+    struct t_test_worker_data *ptr_data;
+
+    /* make C compiler happy */
+    (void) job;
+
+    ptr_data = (struct t_test_worker_data *)data;
+    ptr_data->result = ptr_data->value * ptr_data->value;
+}
+
+/*
+ * Callback for job run: loops until the job is canceled.
+ */
+
+void
+test_worker_run_loop_cb (struct t_worker_job *job, void *data)
+{
+    /* make C compiler happy */
+    (void) data;
+
+    while (!worker_job_is_canceled (job))
+    {
+    }
+}
+
+/*
+ * Callback for job done.
+ */
+
+void
+test_worker_done_cb (struct t_worker_job *job, void *data)
+{
+    /* make C compiler happy */
+    (void) job;
+
+    ((struct t_test_worker_data *)data)->done++;
+}
+
+/*
+ * Tests functions:
+ *   worker_set_threads
+ *   worker_job_submit
+ *   worker_wait
+ */
+
+TEST(CoreWorker, Submit)
+{
+    struct t_test_worker_data data[100];
+    int i;
+
+    memset (data, 0, sizeof (data));
+
+    /* no threads: job is not submitted */
+    LONGS_EQUAL(0, worker_threads_count);
+    POINTERS_EQUAL(NULL, worker_job_submit (&test_worker_run_cb,
+                                            &test_worker_done_cb,
+                                            &data[0]));
+
+    worker_set_threads (4);
+    LONGS_EQUAL(4, worker_threads_count);
+
+    POINTERS_EQUAL(NULL, worker_job_submit (NULL, &test_worker_done_cb,
+                                            &data[0]));
+    POINTERS_EQUAL(NULL, worker_job_submit (&test_worker_run_cb, NULL,
+                                            &data[0]));
+
+    for (i = 0; i < 100; i++)
+    {
+        data[i].value = i;
+        CHECK(worker_job_submit (&test_worker_run_cb, &test_worker_done_cb,
+                                 &data[i]));
+    }
+    worker_wait ();
+    for (i = 0; i < 100; i++)
+    {
+        LONGS_EQUAL(i * i, data[i].result);
+        LONGS_EQUAL(1, data[i].done);
+    }
+
+    /* jobs in queue are run when threads are stopped */
+    memset (data, 0, sizeof (data));
+    for (i = 0; i < 100; i++)
+    {
+        data[i].value = i;
+        CHECK(worker_job_submit (&test_worker_run_cb, &test_worker_done_cb,
+                                 &data[i]));
+    }
+    worker_set_threads (0);
+    LONGS_EQUAL(0, worker_threads_count);
+    for (i = 0; i < 100; i++)
+    {
+        LONGS_EQUAL(i * i, data[i].result);
+        LONGS_EQUAL(1, data[i].done);
+    }
+}
+
+/*
+ * Tests functions:
+ *   worker_job_is_canceled
+ *   worker_job_cancel
+ */
+
+TEST(CoreWorker, Cancel)
+{
+    struct t_test_worker_data data[2];
+    struct t_worker_job *job1, *job2;
+
+    memset (data, 0, sizeof (data));
+
+    worker_set_threads (1);
+    LONGS_EQUAL(1, worker_threads_count);
+
+    /* job1 is running until canceled, so job2 is still in queue */
+    job1 = worker_job_submit (&test_worker_run_loop_cb, &test_worker_done_cb,
+                              &data[0]);
+    CHECK(job1);
+    job2 = worker_job_submit (&test_worker_run_cb, &test_worker_done_cb,
+                              &data[1]);
+    CHECK(job2);
+
+    data[1].value = 2;
+    worker_job_cancel (job2);
+    worker_job_cancel (job1);
+    worker_wait ();
+
+    LONGS_EQUAL(0, data[0].done);
+    LONGS_EQUAL(0, data[1].result);
+    LONGS_EQUAL(0, data[1].done);
+
+    worker_set_threads (0);
+    LONGS_EQUAL(0, worker_threads_count);
+}
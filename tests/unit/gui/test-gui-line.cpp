@@ -23,18 +23,36 @@
 
 extern "C"
 {
+#include <string.h>
+#include "src/core/wee-config.h"
+#include "src/core/wee-hdata.h"
+#include "src/core/wee-hook.h"
 #include "src/core/wee-string.h"
+#include "src/core/wee-worker.h"
+#include "src/gui/gui-buffer.h"
+#include "src/gui/gui-chat.h"
+#include "src/gui/gui-filter.h"
 #include "src/gui/gui-line.h"
 }
 
 #define WEE_LINE_MATCH_TAGS(__result, __line_tags, __tags)              \
     gui_line_tags_alloc (&line_data, __line_tags);                      \
     tags_array = string_split_tags (__tags, &tags_count);               \
+    tags_match = gui_line_tags_match_new (tags_count, tags_array);      \
     LONGS_EQUAL(__result, gui_line_match_tags (&line_data, tags_count,  \
                                                tags_array));            \
+    LONGS_EQUAL(__result, gui_line_match_tags_compiled (&line_data,     \
+                                                        tags_match));   \
+    gui_line_tags_match_free (tags_match);                              \
     gui_line_tags_free (&line_data);                                    \
     string_free_split_tags (tags_array);
 
+#define WEE_LINE_TAGS_FLAGS(__result, __line_tags)                      \
+    gui_line_tags_alloc (&line_data, __line_tags);                      \
+    LONGS_EQUAL(__result, line_data.tags_flags);                        \
+    gui_line_tags_free (&line_data);                                    \
+    LONGS_EQUAL(0, line_data.tags_flags);
+
 TEST_GROUP(GuiLine)
 {
 };
@@ -42,14 +60,20 @@ TEST_GROUP(GuiLine)
 /*
  * Tests functions:
  *   gui_line_match_tags
+ *   gui_line_tags_match_new
+ *   gui_line_tags_match_free
+ *   gui_line_match_tags_compiled
  */
 
 TEST(GuiLine, LineMatchTags)
 {
     struct t_gui_line_data line_data;
+    struct t_gui_line_tags_match *tags_match;
     char ***tags_array;
     int tags_count;
 
+    memset (&line_data, 0, sizeof (line_data));
+
     /* line without tags */
     WEE_LINE_MATCH_TAGS(0, NULL, NULL);
     WEE_LINE_MATCH_TAGS(0, NULL, "irc_join");
@@ -78,4 +102,795 @@ TEST(GuiLine, LineMatchTags)
     WEE_LINE_MATCH_TAGS(1, "irc_join,nick_test", "nick_test,irc_quit");
     WEE_LINE_MATCH_TAGS(1, "irc_join,nick_test", "!irc_quit,!irc_302,!irc_notice");
     WEE_LINE_MATCH_TAGS(1, "irc_join,nick_test", "!irc_quit+!irc_302+!irc_notice");
+
+    /* tags with wildcards or different case */
+    WEE_LINE_MATCH_TAGS(0, "irc_join,nick_test", "irc_quit+nick_*");
+    WEE_LINE_MATCH_TAGS(0, "irc_join,nick_test", "!nick_*");
+    WEE_LINE_MATCH_TAGS(1, "irc_join,nick_test", "irc_join+nick_*");
+    WEE_LINE_MATCH_TAGS(1, "irc_join,nick_test", "*_join");
+    WEE_LINE_MATCH_TAGS(1, "irc_join,nick_test", "IRC_JOIN");
+    WEE_LINE_MATCH_TAGS(1, "IRC_JOIN,nick_test", "irc_join");
+
+    /* tags with a flag */
+    WEE_LINE_MATCH_TAGS(0, "irc_privmsg,notify_message", "notify_private");
+    WEE_LINE_MATCH_TAGS(0, "irc_privmsg,notify_message", "!notify_message");
+    WEE_LINE_MATCH_TAGS(0, "irc_privmsg,no_highlight", "irc_privmsg+!no_highlight");
+    WEE_LINE_MATCH_TAGS(1, "irc_privmsg,notify_message", "notify_message");
+    WEE_LINE_MATCH_TAGS(1, "irc_privmsg,notify_message", "NOTIFY_MESSAGE");
+    WEE_LINE_MATCH_TAGS(1, "irc_privmsg,Notify_Message", "notify_message");
+    WEE_LINE_MATCH_TAGS(1, "irc_privmsg,notify_message", "notify_*");
+    WEE_LINE_MATCH_TAGS(1, "irc_privmsg,notify_message", "notify_private,notify_message");
+    WEE_LINE_MATCH_TAGS(1, "irc_privmsg", "irc_privmsg+!no_highlight");
+    WEE_LINE_MATCH_TAGS(1, "irc_privmsg,no_filter", "NO_FILTER");
+    WEE_LINE_MATCH_TAGS(1, "irc_privmsg,No_Filter", "no_filter");
+}
+
+/*
+ * Tests functions:
+ *   gui_line_tag_get_flag
+ *   gui_line_tag_get_line_flag
+ *   gui_line_set_message
+ */
+
+TEST(GuiLine, LineTagsFlags)
+{
+    struct t_gui_line_data line_data;
+
+    memset (&line_data, 0, sizeof (line_data));
+
+    LONGS_EQUAL(0, gui_line_tag_get_flag (NULL));
+    LONGS_EQUAL(0, gui_line_tag_get_flag (""));
+    LONGS_EQUAL(0, gui_line_tag_get_flag ("irc_privmsg"));
+    LONGS_EQUAL(0, gui_line_tag_get_flag ("notify_"));
+    LONGS_EQUAL(GUI_LINE_TAG_FLAG_NO_FILTER,
+                gui_line_tag_get_flag ("no_filter"));
+    LONGS_EQUAL(GUI_LINE_TAG_FLAG_NO_HIGHLIGHT,
+                gui_line_tag_get_flag ("no_highlight"));
+    LONGS_EQUAL(0, gui_line_tag_get_flag ("No_Filter"));
+    LONGS_EQUAL(0, gui_line_tag_get_flag ("NO_HIGHLIGHT"));
+    LONGS_EQUAL(GUI_LINE_TAG_FLAG_NOTIFY_NONE,
+                gui_line_tag_get_flag ("notify_none"));
+    LONGS_EQUAL(GUI_LINE_TAG_FLAG_NOTIFY_HIGHLIGHT,
+                gui_line_tag_get_flag ("notify_highlight"));
+    LONGS_EQUAL(GUI_LINE_TAG_FLAG_NOTIFY_PRIVATE,
+                gui_line_tag_get_flag ("Notify_Private"));
+    LONGS_EQUAL(GUI_LINE_TAG_FLAG_NOTIFY_MESSAGE,
+                gui_line_tag_get_flag ("NOTIFY_MESSAGE"));
+
+    LONGS_EQUAL(0, gui_line_tag_get_line_flag ("irc_privmsg"));
+    LONGS_EQUAL(0, gui_line_tag_get_line_flag ("nick"));
+    LONGS_EQUAL(0, gui_line_tag_get_line_flag ("action"));
+    LONGS_EQUAL(GUI_LINE_TAG_FLAG_NICK,
+                gui_line_tag_get_line_flag ("nick_test"));
+    LONGS_EQUAL(GUI_LINE_TAG_FLAG_ACTION,
+                gui_line_tag_get_line_flag ("irc_action"));
+    LONGS_EQUAL(GUI_LINE_TAG_FLAG_NOTIFY_NONE,
+                gui_line_tag_get_line_flag ("notify_none"));
+
+    WEE_LINE_TAGS_FLAGS(0, NULL);
+    WEE_LINE_TAGS_FLAGS(0, "irc_privmsg,log1");
+    WEE_LINE_TAGS_FLAGS(GUI_LINE_TAG_FLAG_NICK
+                        | GUI_LINE_TAG_FLAG_NOTIFY_MESSAGE,
+                        "irc_privmsg,notify_message,nick_test,log1");
+    WEE_LINE_TAGS_FLAGS(GUI_LINE_TAG_FLAG_NICK
+                        | GUI_LINE_TAG_FLAG_ACTION
+                        | GUI_LINE_TAG_FLAG_NO_HIGHLIGHT,
+                        "irc_privmsg,irc_action,no_highlight,nick_test");
+    WEE_LINE_TAGS_FLAGS(GUI_LINE_TAG_FLAG_NO_FILTER
+                        | GUI_LINE_TAG_FLAG_NOTIFY_NONE
+                        | GUI_LINE_TAG_FLAG_NOTIFY_PRIVATE,
+                        "no_filter,notify_private,notify_none");
+    WEE_LINE_TAGS_FLAGS(GUI_LINE_TAG_FLAG_NOTIFY_NONE,
+                        "No_Filter,NO_HIGHLIGHT,Notify_None");
+
+    /* tag "no_filter" is case sensitive */
+    gui_line_tags_alloc (&line_data, "irc_privmsg,no_filter");
+    LONGS_EQUAL(1, gui_line_has_tag_no_filter (&line_data));
+    gui_line_tags_free (&line_data);
+    gui_line_tags_alloc (&line_data, "irc_privmsg,No_Filter");
+    LONGS_EQUAL(0, gui_line_has_tag_no_filter (&line_data));
+    gui_line_tags_free (&line_data);
+
+    /* flags are kept when the message is changed */
+    gui_line_set_message (&line_data, "test");
+    gui_line_tags_alloc (&line_data, "irc_privmsg,notify_private");
+    LONGS_EQUAL(GUI_LINE_TAG_FLAG_NOTIFY_PRIVATE, line_data.tags_flags);
+    gui_line_set_message (&line_data, "test2");
+    LONGS_EQUAL(GUI_LINE_TAG_FLAG_NOTIFY_PRIVATE, line_data.tags_flags);
+    STRCMP_EQUAL("test2", line_data.message);
+    gui_line_tags_free (&line_data);
+    LONGS_EQUAL(0, line_data.tags_flags);
+    STRCMP_EQUAL("test2", line_data.message);
+    gui_line_set_message (&line_data, NULL);
+}
+
+/*
+ * Tests functions:
+ *   gui_chat_get_time_string_cached
+ *   gui_line_get_str_time
+ *   gui_line_set_str_time
+ */
+
+TEST(GuiLine, LineStrTime)
+{
+    struct t_gui_line_data line_data;
+    struct t_hdata *hdata;
+    const char *ptr_default;
+
+    memset (&line_data, 0, sizeof (line_data));
+
+    POINTERS_EQUAL(NULL, gui_line_get_str_time (NULL));
+
+    /* no date: no time string */
+    POINTERS_EQUAL(NULL, gui_line_get_str_time (&line_data));
+
+    /* default time string, shared by lines with same date */
+    line_data.date = 1533792000;
+    ptr_default = gui_line_get_str_time (&line_data);
+    CHECK(ptr_default);
+    POINTERS_EQUAL(gui_chat_get_time_string_cached (1533792000), ptr_default);
+    POINTERS_EQUAL(NULL, line_data.str_time);
+
+    /* same as default time string: nothing stored in line */
+    gui_line_set_str_time (&line_data, ptr_default);
+    POINTERS_EQUAL(NULL, line_data.str_time);
+
+    /* custom time string */
+    gui_line_set_str_time (&line_data, "custom");
+    STRCMP_EQUAL("custom", line_data.str_time);
+    STRCMP_EQUAL("custom", gui_line_get_str_time (&line_data));
+
+    /* back to default time string */
+    gui_line_set_str_time (&line_data, NULL);
+    POINTERS_EQUAL(NULL, line_data.str_time);
+    CHECK(gui_line_get_str_time (&line_data));
+
+    /* time string in hdata: built on demand */
+    hdata = hook_hdata_get (NULL, "line_data");
+    CHECK(hdata);
+    STRCMP_EQUAL(ptr_default, hdata_string (hdata, &line_data, "str_time"));
+    gui_line_set_str_time (&line_data, "custom");
+    STRCMP_EQUAL("custom", hdata_string (hdata, &line_data, "str_time"));
+    gui_line_set_str_time (&line_data, NULL);
+}
+
+/*
+ * Tests invalidation of number of rows cached in lines, in functions:
+ *   gui_line_set_message
+ *   gui_line_set_str_time
+ *   gui_line_tags_alloc
+ *   gui_line_tags_free
+ */
+
+TEST(GuiLine, LineRowsInvalidate)
+{
+    struct t_gui_line_data line_data;
+
+    memset (&line_data, 0, sizeof (line_data));
+
+    line_data.rows_id = 1;
+    line_data.rows = 3;
+    gui_line_set_message (&line_data, "test");
+    STRCMP_EQUAL("test", line_data.message);
+    LONGS_EQUAL(0, line_data.rows_id);
+
+    line_data.rows_id = 1;
+    gui_line_tags_alloc (&line_data, "tag1,tag2");
+    LONGS_EQUAL(2, line_data.tags_count);
+    LONGS_EQUAL(0, line_data.rows_id);
+
+    line_data.rows_id = 1;
+    gui_line_tags_free (&line_data);
+    LONGS_EQUAL(0, line_data.tags_count);
+    LONGS_EQUAL(0, line_data.rows_id);
+
+    line_data.rows_id = 1;
+    gui_line_set_str_time (&line_data, "custom");
+    LONGS_EQUAL(0, line_data.rows_id);
+    gui_line_set_str_time (&line_data, NULL);
+
+    gui_line_set_message (&line_data, NULL);
+    POINTERS_EQUAL(NULL, line_data.message);
+}
+
+/*
+ * Tests functions:
+ *   gui_line_string_no_color
+ *   gui_line_set_prefix
+ *   gui_line_set_message
+ */
+
+TEST(GuiLine, LineNoColor)
+{
+    struct t_gui_line_data line_data;
+    char *str;
+
+    memset (&line_data, 0, sizeof (line_data));
+
+    POINTERS_EQUAL(NULL, gui_line_string_no_color (NULL));
+    str = gui_line_string_no_color ("test \x19" "01red");
+    STRCMP_EQUAL("test red", str);
+    free (str);
+
+    /* message without colors: same pointer as message */
+    gui_line_set_message (&line_data, "test");
+    STRCMP_EQUAL("test", line_data.message);
+    POINTERS_EQUAL(line_data.message, line_data.message_no_color);
+
+    /* message with colors */
+    gui_line_set_message (&line_data, "\x19" "01test \x1A" "\x01" "bold");
+    STRCMP_EQUAL("test bold", line_data.message_no_color);
+
+    /* tags changed: message without colors is kept */
+    str = line_data.message_no_color;
+    gui_line_tags_alloc (&line_data, "tag1,tag2");
+    POINTERS_EQUAL(str, line_data.message_no_color);
+    STRCMP_EQUAL("test bold", line_data.message_no_color);
+    gui_line_tags_free (&line_data);
+
+    gui_line_set_message (&line_data, NULL);
+    POINTERS_EQUAL(NULL, line_data.message);
+    POINTERS_EQUAL(NULL, line_data.message_no_color);
+
+    /* prefix */
+    line_data.rows_id = 1;
+    gui_line_set_prefix (&line_data, "\x19" "01nick");
+    STRCMP_EQUAL("\x19" "01nick", line_data.prefix);
+    STRCMP_EQUAL("nick", line_data.prefix_no_color);
+    LONGS_EQUAL(4, line_data.prefix_length);
+    LONGS_EQUAL(0, line_data.rows_id);
+    gui_line_set_prefix (&line_data, line_data.prefix);
+    STRCMP_EQUAL("nick", line_data.prefix_no_color);
+    gui_line_set_prefix (&line_data, NULL);
+    POINTERS_EQUAL(NULL, line_data.prefix);
+    POINTERS_EQUAL(NULL, line_data.prefix_no_color);
+    LONGS_EQUAL(0, line_data.prefix_length);
+}
+
+/*
+ * Checks that blocks of lines are consistent with the list of lines.
+ */
+
+void
+test_gui_line_check_blocks (struct t_gui_lines *lines)
+{
+    struct t_gui_line_block *ptr_block;
+    struct t_gui_line *ptr_line;
+    int count, blocks_count;
+
+    gui_lines_blocks_refresh (lines);
+
+    count = 0;
+    blocks_count = 0;
+    ptr_line = lines->first_line;
+    for (ptr_block = lines->first_block; ptr_block;
+         ptr_block = ptr_block->next_block)
+    {
+        blocks_count++;
+        POINTERS_EQUAL(lines, ptr_block->lines);
+        POINTERS_EQUAL(ptr_line, ptr_block->first_line);
+        CHECK(ptr_block->lines_count > 0);
+        CHECK(ptr_block->lines_count <= GUI_LINE_BLOCK_SIZE * 2);
+        while (ptr_line && (ptr_line->block == ptr_block))
+        {
+            count++;
+            if (ptr_line == ptr_block->last_line)
+                break;
+            ptr_line = ptr_line->next_line;
+        }
+        POINTERS_EQUAL(ptr_block->last_line, ptr_line);
+        ptr_line = ptr_line->next_line;
+    }
+    POINTERS_EQUAL(NULL, ptr_line);
+    LONGS_EQUAL(lines->lines_count, count);
+    LONGS_EQUAL(lines->blocks_count, blocks_count);
+}
+
+/*
+ * Moves "count" displayed lines from a line, reading all lines.
+ */
+
+struct t_gui_line *
+test_gui_line_move_displayed (struct t_gui_line *line, int count)
+{
+    while (line && (count > 0))
+    {
+        line = gui_line_get_next_displayed (line);
+        count--;
+    }
+    while (line && (count < 0))
+    {
+        line = gui_line_get_prev_displayed (line);
+        count++;
+    }
+    return line;
+}
+
+/*
+ * Tests functions:
+ *   gui_line_block_add_line
+ *   gui_line_block_remove_line
+ *   gui_line_get_next_displayed
+ *   gui_line_get_prev_displayed
+ *   gui_line_move_displayed
+ */
+
+TEST(GuiLine, LineBlocks)
+{
+    struct t_gui_buffer *buffer;
+    struct t_gui_line *ptr_line, *ptr_line100, *ptr_line900;
+    int i;
+
+    buffer = gui_buffer_new (NULL, "test_lines", NULL, NULL, NULL,
+                             NULL, NULL, NULL);
+    CHECK(buffer);
+
+    for (i = 0; i < 1000; i++)
+    {
+        gui_chat_printf_date_tags (buffer, 0, NULL, "line %d", i);
+    }
+    LONGS_EQUAL(1000, buffer->own_lines->lines_count);
+    CHECK(buffer->own_lines->blocks_count > 1);
+    test_gui_line_check_blocks (buffer->own_lines);
+
+    ptr_line = buffer->own_lines->first_line;
+    for (i = 0; i < 100; i++)
+    {
+        ptr_line = ptr_line->next_line;
+    }
+    ptr_line100 = ptr_line;
+    for (i = 100; i < 900; i++)
+    {
+        ptr_line = ptr_line->next_line;
+    }
+    ptr_line900 = ptr_line;
+    STRCMP_EQUAL("line 100", ptr_line100->data->message);
+    STRCMP_EQUAL("line 900", ptr_line900->data->message);
+
+    /* move with all lines displayed */
+    POINTERS_EQUAL(ptr_line900,
+                   gui_line_move_displayed (ptr_line100, 800, 1));
+    POINTERS_EQUAL(ptr_line100,
+                   gui_line_move_displayed (ptr_line900, -800, 1));
+    POINTERS_EQUAL(NULL,
+                   gui_line_move_displayed (ptr_line100, 900, 1));
+    POINTERS_EQUAL(buffer->own_lines->last_line,
+                   gui_line_move_displayed (ptr_line100, 899, 1));
+
+    /* hide lines 101 to 899 */
+    for (ptr_line = ptr_line100->next_line; ptr_line != ptr_line900;
+         ptr_line = ptr_line->next_line)
+    {
+        ptr_line->data->displayed = 0;
+    }
+    gui_line_blocks_invalidate (buffer);
+    POINTERS_EQUAL(ptr_line900, gui_line_get_next_displayed (ptr_line100));
+    POINTERS_EQUAL(ptr_line100, gui_line_get_prev_displayed (ptr_line900));
+    for (i = -150; i <= 150; i += 7)
+    {
+        POINTERS_EQUAL(test_gui_line_move_displayed (ptr_line100, i),
+                       gui_line_move_displayed (ptr_line100, i, 1));
+        POINTERS_EQUAL(test_gui_line_move_displayed (ptr_line900, i),
+                       gui_line_move_displayed (ptr_line900, i, 1));
+    }
+
+    /* remove lines */
+    for (i = 0; i < 300; i++)
+    {
+        gui_line_free (buffer, buffer->own_lines->first_line);
+    }
+    LONGS_EQUAL(700, buffer->own_lines->lines_count);
+    test_gui_line_check_blocks (buffer->own_lines);
+    POINTERS_EQUAL(ptr_line900,
+                   gui_line_get_first_displayed (buffer));
+
+    gui_buffer_close (buffer);
+}
+
+/*
+ * Checks that counters in blocks of lines are the same as counters computed
+ * with all lines of each block.
+ */
+
+void
+test_gui_line_check_blocks_counters (struct t_gui_lines *lines)
+{
+    struct t_gui_line_block *ptr_block;
+    struct t_gui_line *ptr_line;
+    int count, displayed;
+    time_t date_min, date_max;
+
+    for (ptr_block = lines->first_block; ptr_block;
+         ptr_block = ptr_block->next_block)
+    {
+        count = 0;
+        displayed = 0;
+        date_min = 0;
+        date_max = 0;
+        for (ptr_line = ptr_block->first_line; ptr_line;
+             ptr_line = ptr_line->next_line)
+        {
+            count++;
+            if (ptr_line->data->displayed)
+                displayed++;
+            if ((date_min == 0) || (ptr_line->data->date < date_min))
+                date_min = ptr_line->data->date;
+            if ((date_max == 0) || (ptr_line->data->date > date_max))
+                date_max = ptr_line->data->date;
+            if (ptr_line == ptr_block->last_line)
+                break;
+        }
+        LONGS_EQUAL(count, ptr_block->lines_count);
+        LONGS_EQUAL(displayed, ptr_block->lines_displayed);
+        LONGS_EQUAL(date_min, ptr_block->date_min);
+        LONGS_EQUAL(date_max, ptr_block->date_max);
+    }
+}
+
+/*
+ * Adds a line with a "y" and a date in a buffer with free content.
+ */
+
+struct t_gui_line *
+test_gui_line_add_y (struct t_gui_buffer *buffer, int y, int displayed)
+{
+    struct t_gui_line *new_line;
+
+    new_line = gui_line_new (buffer, y, 0, 0, NULL, NULL, "test");
+    if (!new_line)
+        return NULL;
+    new_line->data->date = 1000000 + y;
+    new_line->data->displayed = displayed;
+    gui_line_add_y (new_line);
+
+    return new_line;
+}
+
+/*
+ * Tests functions:
+ *   gui_line_add_y (insert lines in a full block)
+ *   gui_line_block_split
+ *   gui_line_blocks_invalidate
+ */
+
+TEST(GuiLine, LineBlocksSplit)
+{
+    struct t_gui_buffer *buffer, *buffer2;
+    struct t_gui_line_block *ptr_block;
+    int i, blocks_count;
+
+    buffer = gui_buffer_new (NULL, "test_lines_split", NULL, NULL, NULL,
+                             NULL, NULL, NULL);
+    CHECK(buffer);
+    gui_buffer_set (buffer, "type", "free");
+    LONGS_EQUAL(GUI_BUFFER_TYPE_FREE, buffer->type);
+
+    /* two full blocks, with lines y = 0, 4, 8, ... */
+    for (i = 0; i < GUI_LINE_BLOCK_SIZE * 2; i++)
+    {
+        CHECK(test_gui_line_add_y (buffer, i * 4, 1));
+    }
+    LONGS_EQUAL(GUI_LINE_BLOCK_SIZE * 2, buffer->own_lines->lines_count);
+    LONGS_EQUAL(2, buffer->own_lines->blocks_count);
+    LONGS_EQUAL(GUI_LINE_BLOCK_SIZE,
+                buffer->own_lines->first_block->lines_count);
+    LONGS_EQUAL(1000000, buffer->own_lines->first_block->date_min);
+    LONGS_EQUAL(1000000 + ((GUI_LINE_BLOCK_SIZE - 1) * 4),
+                buffer->own_lines->first_block->date_max);
+
+    /*
+     * insert lines (some hidden) in the middle of first block, until the
+     * block is split
+     */
+    blocks_count = buffer->own_lines->blocks_count;
+    for (i = 0; i < GUI_LINE_BLOCK_SIZE - 1; i++)
+    {
+        CHECK(test_gui_line_add_y (buffer, (i * 4) + 1, i % 2));
+        CHECK(test_gui_line_add_y (buffer, (i * 4) + 2, 1));
+    }
+    LONGS_EQUAL((GUI_LINE_BLOCK_SIZE * 4) - 2,
+                buffer->own_lines->lines_count);
+    CHECK(buffer->own_lines->blocks_count > blocks_count);
+    LONGS_EQUAL(0, buffer->own_lines->blocks_refresh);
+    test_gui_line_check_blocks (buffer->own_lines);
+    test_gui_line_check_blocks_counters (buffer->own_lines);
+    for (ptr_block = buffer->own_lines->first_block; ptr_block;
+         ptr_block = ptr_block->next_block)
+    {
+        CHECK(ptr_block->date_min <= ptr_block->date_max);
+        if (ptr_block->next_block)
+            CHECK(ptr_block->date_max < ptr_block->next_block->date_min);
+    }
+
+    /* replace a line: only blocks of this buffer are invalidated */
+    buffer2 = gui_buffer_new (NULL, "test_lines_split2", NULL, NULL, NULL,
+                              NULL, NULL, NULL);
+    CHECK(buffer2);
+    CHECK(test_gui_line_add_y (buffer, 4, 0));
+    LONGS_EQUAL(1, buffer->own_lines->blocks_refresh);
+    LONGS_EQUAL(0, buffer2->own_lines->blocks_refresh);
+    test_gui_line_check_blocks (buffer->own_lines);
+    LONGS_EQUAL(0, buffer->own_lines->blocks_refresh);
+    test_gui_line_check_blocks_counters (buffer->own_lines);
+
+    gui_buffer_close (buffer2);
+    gui_buffer_close (buffer);
+}
+
+/*
+ * Checks that lines of a buffer are displayed according to the string
+ * "displayed" (one char per line: '1' = displayed, '0' = hidden), and that
+ * number of hidden lines is consistent.
+ */
+
+void
+test_gui_line_check_displayed (struct t_gui_buffer *buffer,
+                               const char *displayed)
+{
+    struct t_gui_line *ptr_line;
+    int i, hidden;
+
+    i = 0;
+    hidden = 0;
+    for (ptr_line = buffer->own_lines->first_line; ptr_line;
+         ptr_line = ptr_line->next_line)
+    {
+        LONGS_EQUAL(displayed[i] - '0', ptr_line->data->displayed);
+        if (!ptr_line->data->displayed)
+            hidden++;
+        i++;
+    }
+    LONGS_EQUAL(strlen (displayed), i);
+    LONGS_EQUAL(hidden, buffer->own_lines->lines_hidden);
+}
+
+/*
+ * Tests functions:
+ *   gui_line_has_highlight
+ */
+
+TEST(GuiLine, LineHasHighlight)
+{
+    struct t_gui_buffer *buffer;
+
+    buffer = gui_buffer_new (NULL, "test_highlight", NULL, NULL, NULL,
+                             NULL, NULL, NULL);
+    CHECK(buffer);
+    gui_buffer_set (buffer, "highlight_words", "alice");
+
+    gui_chat_printf_date_tags (buffer, 0, "irc_privmsg", "hello alice");
+    LONGS_EQUAL(1, gui_line_has_highlight (buffer->own_lines->last_line));
+
+    /* tag "no_highlight" is case sensitive */
+    gui_chat_printf_date_tags (buffer, 0, "irc_privmsg,no_highlight",
+                               "hello alice");
+    LONGS_EQUAL(0, gui_line_has_highlight (buffer->own_lines->last_line));
+    gui_chat_printf_date_tags (buffer, 0, "irc_privmsg,No_Highlight",
+                               "hello alice");
+    LONGS_EQUAL(1, gui_line_has_highlight (buffer->own_lines->last_line));
+
+    /* nick at beginning of action is skipped (last tag "nick_xxx" is used) */
+    gui_chat_printf_date_tags (buffer, 0, "irc_action,nick_alice",
+                               "alice waves");
+    LONGS_EQUAL(0, gui_line_has_highlight (buffer->own_lines->last_line));
+    gui_chat_printf_date_tags (buffer, 0, "irc_action,nick_bob,nick_alice",
+                               "alice waves");
+    LONGS_EQUAL(0, gui_line_has_highlight (buffer->own_lines->last_line));
+    gui_chat_printf_date_tags (buffer, 0, "irc_action,nick_alice,nick_bob",
+                               "alice waves");
+    LONGS_EQUAL(1, gui_line_has_highlight (buffer->own_lines->last_line));
+
+    gui_buffer_close (buffer);
+}
+
+/*
+ * Tests functions:
+ *   gui_filter_buffer
+ *   gui_filter_buffer_apply_filter
+ *   gui_filter_all_buffers
+ */
+
+TEST(GuiLine, LineFilters)
+{
+    struct t_gui_buffer *buffer;
+    struct t_gui_filter *filter1, *filter2;
+
+    buffer = gui_buffer_new (NULL, "test_filters", NULL, NULL, NULL,
+                             NULL, NULL, NULL);
+    CHECK(buffer);
+
+    gui_chat_printf_date_tags (buffer, 0, NULL, "line 1");
+    gui_chat_printf_date_tags (buffer, 0, "tag1", "line 2");
+    gui_chat_printf_date_tags (buffer, 0, "tag2", "line 3");
+    gui_chat_printf_date_tags (buffer, 0, "tag1,tag2", "line 4");
+    gui_chat_printf_date_tags (buffer, 0, "tag1,no_filter", "line 5");
+    test_gui_line_check_displayed (buffer, "11111");
+
+    /* add filters: they are applied one by one */
+    filter1 = gui_filter_new (1, "test_filter1", "core.test_filters",
+                              "tag1", "*");
+    CHECK(filter1);
+    gui_filter_all_buffers (filter1);
+    test_gui_line_check_displayed (buffer, "10101");
+    filter2 = gui_filter_new (1, "test_filter2", "core.test_filters",
+                              "tag2", "*");
+    CHECK(filter2);
+    gui_filter_all_buffers (filter2);
+    test_gui_line_check_displayed (buffer, "10001");
+    LONGS_EQUAL(2, buffer->own_lines->last_line->prev_line->data->filters_hiding);
+
+    /* disable/enable filters */
+    filter1->enabled = 0;
+    gui_filter_all_buffers (filter1);
+    test_gui_line_check_displayed (buffer, "11001");
+    filter2->enabled = 0;
+    gui_filter_all_buffers (filter2);
+    test_gui_line_check_displayed (buffer, "11111");
+    filter2->enabled = 1;
+    gui_filter_all_buffers (filter2);
+    test_gui_line_check_displayed (buffer, "11001");
+    filter1->enabled = 1;
+    gui_filter_all_buffers (filter1);
+    test_gui_line_check_displayed (buffer, "10001");
+
+    /* same state without any change */
+    gui_filter_all_buffers (filter1);
+    test_gui_line_check_displayed (buffer, "10001");
+
+    /* full filtering gives same result */
+    gui_filter_all_buffers (NULL);
+    test_gui_line_check_displayed (buffer, "10001");
+
+    /* new lines are filtered */
+    gui_chat_printf_date_tags (buffer, 0, "tag2", "line 6");
+    test_gui_line_check_displayed (buffer, "100010");
+
+    /* filters disabled in buffer, then enabled again */
+    buffer->filter = 0;
+    gui_filter_buffer (buffer, NULL);
+    test_gui_line_check_displayed (buffer, "111111");
+    filter1->enabled = 0;
+    gui_filter_all_buffers (filter1);
+    test_gui_line_check_displayed (buffer, "111111");
+    buffer->filter = 1;
+    gui_filter_buffer (buffer, NULL);
+    test_gui_line_check_displayed (buffer, "110010");
+
+    /* rename buffer: filters are not matching any more */
+    gui_buffer_set (buffer, "name", "test_filters2");
+    test_gui_line_check_displayed (buffer, "111111");
+    gui_buffer_set (buffer, "name", "test_filters");
+    test_gui_line_check_displayed (buffer, "110010");
+
+    filter2->enabled = 0;
+    gui_filter_all_buffers (filter2);
+    test_gui_line_check_displayed (buffer, "111111");
+
+    gui_filter_free (filter1);
+    gui_filter_free (filter2);
+    gui_buffer_close (buffer);
+}
+
+/*
+ * Checks number of filters hiding each line of a buffer (computed with all
+ * filters applied), and the number of hidden lines.
+ */
+
+void
+test_gui_line_check_filters_hiding (struct t_gui_buffer *buffer)
+{
+    struct t_gui_line *ptr_line;
+    struct t_gui_filter *ptr_filter;
+    int count, hidden;
+
+    hidden = 0;
+    for (ptr_line = buffer->own_lines->first_line; ptr_line;
+         ptr_line = ptr_line->next_line)
+    {
+        count = 0;
+        for (ptr_filter = gui_filters; ptr_filter;
+             ptr_filter = ptr_filter->next_filter)
+        {
+            if (ptr_filter->applied
+                && string_match_list (buffer->full_name,
+                                      (const char **)ptr_filter->buffers, 0)
+                && gui_filter_hides_line (ptr_filter, ptr_line->data))
+            {
+                count++;
+            }
+        }
+        LONGS_EQUAL(count, ptr_line->data->filters_hiding);
+        LONGS_EQUAL((count == 0) ? 1 : 0, ptr_line->data->displayed);
+        if (count > 0)
+            hidden++;
+    }
+    LONGS_EQUAL(hidden, buffer->own_lines->lines_hidden);
+}
+
+/*
+ * Tests functions:
+ *   gui_filter_job_start
+ *   gui_filter_job_keep_line_data
+ *   gui_filter_job_cancel_buffer
+ */
+
+TEST(GuiLine, LineFiltersJob)
+{
+    struct t_gui_buffer *buffer;
+    struct t_gui_filter *filter1, *filter2;
+    struct t_gui_line *ptr_line;
+    int i;
+
+    config_file_option_set (config_history_max_buffer_lines_number,
+                            "10000", 1);
+
+    buffer = gui_buffer_new (NULL, "test_filters_job", NULL, NULL, NULL,
+                             NULL, NULL, NULL);
+    CHECK(buffer);
+
+    for (i = 0; i < GUI_FILTER_JOB_MIN_LINES + 1000; i++)
+    {
+        gui_chat_printf_date_tags (buffer, 0,
+                                   (i % 3 == 0) ? "tag1" : NULL,
+                                   "line %d", i);
+    }
+
+    filter1 = gui_filter_new (1, "test_filter_job1", "core.test_filters_job",
+                              "tag1", "*");
+    CHECK(filter1);
+    gui_filter_all_buffers (filter1);
+    filter2 = gui_filter_new (1, "test_filter_job2", "core.test_filters_job",
+                              "*", "^line 1");
+    CHECK(filter2);
+    gui_filter_all_buffers (filter2);
+    test_gui_line_check_filters_hiding (buffer);
+
+    worker_set_threads (4);
+
+    /* filter all lines in worker threads, remove first lines during job */
+    gui_filter_all_buffers (NULL);
+    CHECK(gui_filter_jobs);
+    gui_line_free (buffer, buffer->own_lines->first_line);
+    gui_line_free (buffer, buffer->own_lines->first_line);
+    CHECK(gui_filter_jobs);
+    worker_wait ();
+    POINTERS_EQUAL(NULL, gui_filter_jobs);
+    test_gui_line_check_filters_hiding (buffer);
+
+    /* disable a filter during job: job is started again */
+    gui_filter_buffer (buffer, NULL);
+    CHECK(gui_filter_jobs);
+    filter1->enabled = 0;
+    gui_filter_all_buffers (filter1);
+    CHECK(gui_filter_jobs);
+    worker_wait ();
+    POINTERS_EQUAL(NULL, gui_filter_jobs);
+    test_gui_line_check_filters_hiding (buffer);
+
+    /* remove a line in the middle of buffer: job is canceled */
+    filter1->enabled = 1;
+    gui_filter_all_buffers (filter1);
+    gui_filter_buffer (buffer, NULL);
+    CHECK(gui_filter_jobs);
+    ptr_line = buffer->own_lines->first_line;
+    for (i = 0; i < 100; i++)
+    {
+        ptr_line = ptr_line->next_line;
+    }
+    gui_line_free (buffer, ptr_line);
+    POINTERS_EQUAL(NULL, gui_filter_jobs);
+    test_gui_line_check_filters_hiding (buffer);
+
+    /* close buffer during job */
+    gui_filter_buffer (buffer, NULL);
+    CHECK(gui_filter_jobs);
+    gui_buffer_close (buffer);
+    POINTERS_EQUAL(NULL, gui_filter_jobs);
+
+    worker_set_threads (0);
+
+    gui_filter_free (filter1);
+    gui_filter_free (filter2);
+
+    config_file_option_reset (config_history_max_buffer_lines_number, 1);
 }
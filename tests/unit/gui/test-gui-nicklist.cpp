@@ -0,0 +1,384 @@
+/*
+ * test-gui-nicklist.cpp - test nicklist functions
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This file is part of WeeChat, the extensible chat client.
+ *
+ * WeeChat is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WeeChat is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WeeChat.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "CppUTest/TestHarness.h"
+
+extern "C"
+{
+#include <string.h>
+#include "src/core/wee-hashtable.h"
+#include "src/core/wee-string.h"
+#include "src/gui/gui-buffer.h"
+#include "src/gui/gui-nicklist.h"
+}
+
+TEST_GROUP(GuiNicklist)
+{
+};
+
+/*
+ * Compares two nicks (case-insensitive, like IRC casemapping "rfc1459").
+ */
+
+int
+test_gui_nicklist_nickcmp_cb (const void *pointer, void *data,
+                              struct t_gui_buffer *buffer,
+                              const char *nick1, const char *nick2)
+{
+    /* make C++ compiler happy */
+    (void) pointer;
+    (void) data;
+    (void) buffer;
+
+    return string_strcasecmp_range (nick1, nick2, 29);
+}
+
+/*
+ * Compares two nicks (case-insensitive, like IRC casemapping "ascii").
+ */
+
+int
+test_gui_nicklist_nickcmp_ascii_cb (const void *pointer, void *data,
+                                    struct t_gui_buffer *buffer,
+                                    const char *nick1, const char *nick2)
+{
+    /* make C++ compiler happy */
+    (void) pointer;
+    (void) data;
+    (void) buffer;
+
+    return string_strcasecmp_range (nick1, nick2, 26);
+}
+
+/*
+ * Builds the key of a nick (lower case, like IRC casemapping "rfc1459").
+ */
+
+void
+test_gui_nicklist_nickcmp_key_cb (const void *pointer, void *data,
+                                  struct t_gui_buffer *buffer,
+                                  const char *nick, char *key)
+{
+    /* make C++ compiler happy */
+    (void) pointer;
+    (void) data;
+    (void) buffer;
+
+    while (nick[0])
+    {
+        key[0] = ((nick[0] >= 'A') && (nick[0] < 'A' + 29)) ?
+            nick[0] + ('a' - 'A') : nick[0];
+        nick++;
+        key++;
+    }
+    key[0] = '\0';
+}
+
+/*
+ * Tests functions:
+ *   gui_nicklist_search_group
+ *   gui_nicklist_add_group
+ *   gui_nicklist_remove_group
+ */
+
+TEST(GuiNicklist, SearchGroup)
+{
+    struct t_gui_buffer *buffer;
+    struct t_gui_nick_group *group_op, *group_voice, *group_sub;
+
+    buffer = gui_buffer_new (NULL, "test_nicklist", NULL, NULL, NULL,
+                             NULL, NULL, NULL);
+    CHECK(buffer);
+
+    POINTERS_EQUAL(NULL, gui_nicklist_search_group (NULL, NULL, "op"));
+    POINTERS_EQUAL(NULL, gui_nicklist_search_group (buffer, NULL, NULL));
+    POINTERS_EQUAL(NULL, gui_nicklist_search_group (buffer, NULL, "op"));
+    POINTERS_EQUAL(buffer->nicklist_root,
+                   gui_nicklist_search_group (buffer, NULL, "root"));
+
+    group_op = gui_nicklist_add_group (buffer, NULL, "000|op", NULL, 1);
+    CHECK(group_op);
+    group_voice = gui_nicklist_add_group (buffer, NULL, "001|voice", NULL, 1);
+    CHECK(group_voice);
+    group_sub = gui_nicklist_add_group (buffer, group_voice, "sub", NULL, 1);
+    CHECK(group_sub);
+
+    /* group already exists */
+    POINTERS_EQUAL(NULL, gui_nicklist_add_group (buffer, NULL, "000|op",
+                                                 NULL, 1));
+    POINTERS_EQUAL(NULL, gui_nicklist_add_group (buffer, NULL, "op",
+                                                 NULL, 1));
+
+    POINTERS_EQUAL(group_op, gui_nicklist_search_group (buffer, NULL, "op"));
+    POINTERS_EQUAL(group_op, gui_nicklist_search_group (buffer, NULL,
+                                                        "000|op"));
+    POINTERS_EQUAL(NULL, gui_nicklist_search_group (buffer, NULL, "001|op"));
+    POINTERS_EQUAL(NULL, gui_nicklist_search_group (buffer, NULL, "OP"));
+    POINTERS_EQUAL(group_voice, gui_nicklist_search_group (buffer, NULL,
+                                                           "voice"));
+    POINTERS_EQUAL(group_sub, gui_nicklist_search_group (buffer, NULL,
+                                                         "sub"));
+
+    /* search from a group */
+    POINTERS_EQUAL(group_sub, gui_nicklist_search_group (buffer, group_voice,
+                                                         "sub"));
+    POINTERS_EQUAL(NULL, gui_nicklist_search_group (buffer, group_op, "sub"));
+
+    gui_nicklist_remove_group (buffer, group_voice);
+    POINTERS_EQUAL(NULL, gui_nicklist_search_group (buffer, NULL, "voice"));
+    POINTERS_EQUAL(NULL, gui_nicklist_search_group (buffer, NULL, "sub"));
+    POINTERS_EQUAL(group_op, gui_nicklist_search_group (buffer, NULL, "op"));
+
+    gui_buffer_close (buffer);
+}
+
+/*
+ * Tests functions:
+ *   gui_nicklist_search_nick
+ *   gui_nicklist_add_nick
+ *   gui_nicklist_remove_nick
+ */
+
+TEST(GuiNicklist, SearchNick)
+{
+    struct t_gui_buffer *buffer;
+    struct t_gui_nick_group *group_op, *group_voice;
+    struct t_gui_nick *nick_op, *nick_voice, *nick_x1, *nick_x2;
+
+    buffer = gui_buffer_new (NULL, "test_nicklist", NULL, NULL, NULL,
+                             NULL, NULL, NULL);
+    CHECK(buffer);
+
+    group_op = gui_nicklist_add_group (buffer, NULL, "000|op", NULL, 1);
+    group_voice = gui_nicklist_add_group (buffer, NULL, "001|voice", NULL, 1);
+
+    POINTERS_EQUAL(NULL, gui_nicklist_search_nick (NULL, NULL, "Alice"));
+    POINTERS_EQUAL(NULL, gui_nicklist_search_nick (buffer, NULL, NULL));
+    POINTERS_EQUAL(NULL, gui_nicklist_search_nick (buffer, NULL, "Alice"));
+
+    nick_op = gui_nicklist_add_nick (buffer, group_op, "Alice", NULL,
+                                     "@", NULL, 1);
+    CHECK(nick_op);
+    nick_voice = gui_nicklist_add_nick (buffer, group_voice, "bob", NULL,
+                                        "+", NULL, 1);
+    CHECK(nick_voice);
+
+    /* without nickcmp callback: case-sensitive search */
+    POINTERS_EQUAL(nick_op, gui_nicklist_search_nick (buffer, NULL, "Alice"));
+    POINTERS_EQUAL(NULL, gui_nicklist_search_nick (buffer, NULL, "alice"));
+    POINTERS_EQUAL(nick_voice, gui_nicklist_search_nick (buffer, NULL, "bob"));
+    POINTERS_EQUAL(nick_op, gui_nicklist_search_nick (buffer, group_op,
+                                                      "Alice"));
+    POINTERS_EQUAL(NULL, gui_nicklist_search_nick (buffer, group_voice,
+                                                   "Alice"));
+
+    /* nicks equal with casemapping "rfc1459" */
+    nick_x1 = gui_nicklist_add_nick (buffer, NULL, "[x]", NULL, NULL, NULL, 1);
+    CHECK(nick_x1);
+    nick_x2 = gui_nicklist_add_nick (buffer, NULL, "{x}", NULL, NULL, NULL, 1);
+    CHECK(nick_x2);
+    POINTERS_EQUAL(nick_x1, gui_nicklist_search_nick (buffer, NULL, "[x]"));
+    POINTERS_EQUAL(nick_x2, gui_nicklist_search_nick (buffer, NULL, "{x}"));
+    POINTERS_EQUAL(NULL, gui_nicklist_search_nick (buffer, NULL, "{X}"));
+    gui_nicklist_remove_nick (buffer, nick_x1);
+    POINTERS_EQUAL(NULL, gui_nicklist_search_nick (buffer, NULL, "[x]"));
+    POINTERS_EQUAL(nick_x2, gui_nicklist_search_nick (buffer, NULL, "{x}"));
+
+    /* with nickcmp callback: case-insensitive search */
+    gui_buffer_set_pointer (buffer, "nickcmp_callback",
+                            (void *)&test_gui_nicklist_nickcmp_cb);
+    POINTERS_EQUAL(nick_op, gui_nicklist_search_nick (buffer, NULL, "ALICE"));
+    POINTERS_EQUAL(nick_voice, gui_nicklist_search_nick (buffer, NULL, "Bob"));
+    POINTERS_EQUAL(nick_x2, gui_nicklist_search_nick (buffer, NULL, "[X]"));
+    POINTERS_EQUAL(NULL, gui_nicklist_add_nick (buffer, NULL, "alice", NULL,
+                                                NULL, NULL, 1));
+
+    /* with another nickcmp callback: only this callback is used */
+    gui_buffer_set_pointer (buffer, "nickcmp_callback",
+                            (void *)&test_gui_nicklist_nickcmp_ascii_cb);
+    POINTERS_EQUAL(nick_op, gui_nicklist_search_nick (buffer, NULL, "ALICE"));
+    POINTERS_EQUAL(nick_x2, gui_nicklist_search_nick (buffer, NULL, "{X}"));
+    POINTERS_EQUAL(NULL, gui_nicklist_search_nick (buffer, NULL, "[X]"));
+    POINTERS_EQUAL(NULL, gui_nicklist_search_nick (buffer, group_voice,
+                                                   "ALICE"));
+    gui_buffer_set_pointer (buffer, "nickcmp_callback",
+                            (void *)&test_gui_nicklist_nickcmp_cb);
+
+    gui_nicklist_remove_nick (buffer, nick_op);
+    POINTERS_EQUAL(NULL, gui_nicklist_search_nick (buffer, NULL, "Alice"));
+    gui_nicklist_remove_group (buffer, group_voice);
+    POINTERS_EQUAL(NULL, gui_nicklist_search_nick (buffer, NULL, "bob"));
+    LONGS_EQUAL(1, buffer->nicklist_nicks_count);
+
+    gui_nicklist_remove_all (buffer);
+    POINTERS_EQUAL(NULL, gui_nicklist_search_nick (buffer, NULL, "{x}"));
+    LONGS_EQUAL(0, buffer->nicklist_nicks_index->items_count);
+
+    gui_buffer_close (buffer);
+}
+
+/*
+ * Tests functions:
+ *   gui_nicklist_search_nick (with buffer property "nickcmp_key_callback")
+ *   gui_nicklist_nick_index_build
+ */
+
+TEST(GuiNicklist, SearchNickKey)
+{
+    struct t_gui_buffer *buffer;
+    struct t_gui_nick_group *group_op, *group_voice;
+    struct t_gui_nick *nick_op, *nick_voice, *nick_x1, *nick_x2, *nick_long;
+    char long_nick[512];
+
+    buffer = gui_buffer_new (NULL, "test_nicklist", NULL, NULL, NULL,
+                             NULL, NULL, NULL);
+    CHECK(buffer);
+
+    group_op = gui_nicklist_add_group (buffer, NULL, "000|op", NULL, 1);
+    group_voice = gui_nicklist_add_group (buffer, NULL, "001|voice", NULL, 1);
+
+    nick_op = gui_nicklist_add_nick (buffer, group_op, "Alice", NULL,
+                                     "@", NULL, 1);
+    CHECK(nick_op);
+    nick_voice = gui_nicklist_add_nick (buffer, group_voice, "bob", NULL,
+                                        "+", NULL, 1);
+    CHECK(nick_voice);
+    nick_x1 = gui_nicklist_add_nick (buffer, NULL, "[x]", NULL, NULL, NULL, 1);
+    CHECK(nick_x1);
+    nick_x2 = gui_nicklist_add_nick (buffer, NULL, "{x}", NULL, NULL, NULL, 1);
+    CHECK(nick_x2);
+    memset (long_nick, 'N', sizeof (long_nick) - 1);
+    long_nick[sizeof (long_nick) - 1] = '\0';
+    nick_long = gui_nicklist_add_nick (buffer, NULL, long_nick, NULL,
+                                       NULL, NULL, 1);
+    CHECK(nick_long);
+
+    /* set key callback: index is rebuilt with the keys */
+    gui_buffer_set_pointer (buffer, "nickcmp_callback",
+                            (void *)&test_gui_nicklist_nickcmp_cb);
+    gui_buffer_set_pointer (buffer, "nickcmp_key_callback",
+                            (void *)&test_gui_nicklist_nickcmp_key_cb);
+    POINTERS_EQUAL(&test_gui_nicklist_nickcmp_key_cb,
+                   buffer->nickcmp_key_callback);
+    LONGS_EQUAL(4, buffer->nicklist_nicks_index->items_count);
+
+    POINTERS_EQUAL(nick_op, gui_nicklist_search_nick (buffer, NULL, "ALICE"));
+    POINTERS_EQUAL(nick_voice, gui_nicklist_search_nick (buffer, NULL, "Bob"));
+    POINTERS_EQUAL(nick_op, gui_nicklist_search_nick (buffer, group_op,
+                                                      "alice"));
+    POINTERS_EQUAL(NULL, gui_nicklist_search_nick (buffer, group_voice,
+                                                   "ALICE"));
+    long_nick[0] = 'n';
+    POINTERS_EQUAL(nick_long, gui_nicklist_search_nick (buffer, NULL,
+                                                        long_nick));
+
+    /* "[x]" and "{x}" have same key: first nick is returned */
+    POINTERS_EQUAL(nick_x1, gui_nicklist_search_nick (buffer, NULL, "{X}"));
+    POINTERS_EQUAL(nick_x1, gui_nicklist_search_nick (buffer, NULL, "[x]"));
+    gui_nicklist_remove_nick (buffer, nick_x1);
+    POINTERS_EQUAL(nick_x2, gui_nicklist_search_nick (buffer, NULL, "[X]"));
+    gui_nicklist_remove_nick (buffer, nick_x2);
+    POINTERS_EQUAL(NULL, gui_nicklist_search_nick (buffer, NULL, "{x}"));
+
+    /* remove key callback: index is rebuilt with the names */
+    gui_buffer_set_pointer (buffer, "nickcmp_callback", NULL);
+    gui_buffer_set_pointer (buffer, "nickcmp_key_callback", NULL);
+    POINTERS_EQUAL(NULL, gui_nicklist_search_nick (buffer, NULL, "ALICE"));
+    POINTERS_EQUAL(nick_op, gui_nicklist_search_nick (buffer, NULL, "Alice"));
+
+    gui_nicklist_remove_nick (buffer, nick_op);
+    gui_nicklist_remove_nick (buffer, nick_voice);
+    gui_nicklist_remove_nick (buffer, nick_long);
+    LONGS_EQUAL(0, buffer->nicklist_nicks_index->items_count);
+
+    gui_buffer_close (buffer);
+}
+
+/*
+ * Tests functions:
+ *   gui_nicklist_add_nick (with buffer property "nicklist_batch")
+ *   gui_nicklist_end_batch
+ */
+
+TEST(GuiNicklist, Batch)
+{
+    struct t_gui_buffer *buffer;
+    struct t_gui_nick_group *group;
+    struct t_gui_nick *ptr_nick;
+    const char *nicks[] = { "dave", "Bob", "erin", "alice", "Carol", "bob2",
+                            "alice", NULL };
+    const char *sorted[] = { "alice", "Bob", "bob2", "Carol", "dave", "erin",
+                             NULL };
+    int i;
+
+    buffer = gui_buffer_new (NULL, "test_nicklist", NULL, NULL, NULL,
+                             NULL, NULL, NULL);
+    CHECK(buffer);
+
+    group = gui_nicklist_add_group (buffer, NULL, "001|normal", NULL, 1);
+    CHECK(group);
+
+    gui_buffer_set (buffer, "nicklist_batch", "1");
+    LONGS_EQUAL(1, gui_buffer_get_integer (buffer, "nicklist_batch"));
+
+    for (i = 0; nicks[i]; i++)
+    {
+        gui_nicklist_add_nick (buffer, group, nicks[i], NULL, NULL, NULL, 1);
+    }
+    LONGS_EQUAL(6, buffer->nicklist_nicks_count);
+    CHECK(gui_nicklist_search_nick (buffer, NULL, "erin"));
+
+    /* nicks are not sorted during the batch */
+    STRCMP_EQUAL("dave", group->nicks->name);
+    STRCMP_EQUAL("bob2", group->last_nick->name);
+
+    gui_buffer_set (buffer, "nicklist_batch", "0");
+    LONGS_EQUAL(0, buffer->nicklist_batch);
+
+    /* nicks are sorted at the end of batch */
+    ptr_nick = group->nicks;
+    POINTERS_EQUAL(NULL, ptr_nick->prev_nick);
+    for (i = 0; sorted[i]; i++)
+    {
+        CHECK(ptr_nick);
+        STRCMP_EQUAL(sorted[i], ptr_nick->name);
+        if (ptr_nick->next_nick)
+            POINTERS_EQUAL(ptr_nick, ptr_nick->next_nick->prev_nick);
+        else
+            POINTERS_EQUAL(ptr_nick, group->last_nick);
+        ptr_nick = ptr_nick->next_nick;
+    }
+    POINTERS_EQUAL(NULL, ptr_nick);
+
+    /* nick added after the batch is inserted at its sorted position */
+    ptr_nick = gui_nicklist_add_nick (buffer, group, "bobby", NULL, NULL,
+                                      NULL, 1);
+    CHECK(ptr_nick);
+    STRCMP_EQUAL("bob2", ptr_nick->prev_nick->name);
+    STRCMP_EQUAL("Carol", ptr_nick->next_nick->name);
+
+    /* batch is ended when all nicks are removed */
+    gui_buffer_set (buffer, "nicklist_batch", "1");
+    gui_nicklist_remove_all (buffer);
+    LONGS_EQUAL(0, buffer->nicklist_batch);
+
+    gui_buffer_close (buffer);
+}
@@ -0,0 +1,369 @@
+/*
+ * test-irc-message.cpp - test IRC message functions
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This file is part of WeeChat, the extensible chat client.
+ *
+ * WeeChat is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WeeChat is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WeeChat.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "CppUTest/TestHarness.h"
+
+extern "C"
+{
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "src/core/wee-hashtable.h"
+#include "src/core/wee-string.h"
+#include "src/core/wee-utf8.h"
+#include "src/plugins/irc/irc-message.h"
+}
+
+#define WEE_CHECK_ITEM(__expected, __item)                              \
+    item = irc_message_get_item (&parsed, parsed.pos_##__item,          \
+                                 parsed.length_##__item);               \
+    if (__expected == NULL)                                             \
+    {                                                                   \
+        POINTERS_EQUAL(NULL, item);                                     \
+    }                                                                   \
+    else                                                                \
+    {                                                                   \
+        STRCMP_EQUAL(__expected, item);                                 \
+    }                                                                   \
+    if (item)                                                           \
+        free (item);
+
+#define WEE_CHECK_PARSE(__msg, __tags, __msg_without_tags, __nick,      \
+                        __host, __command, __channel, __arguments,      \
+                        __text, __pos_command, __pos_arguments,         \
+                        __pos_channel, __pos_text)                      \
+    irc_message_parse_to_struct (NULL, __msg, &parsed);                 \
+    POINTERS_EQUAL(__msg, parsed.message);                              \
+    WEE_CHECK_ITEM(__tags, tags);                                       \
+    WEE_CHECK_ITEM(__msg_without_tags, message_without_tags);           \
+    WEE_CHECK_ITEM(__nick, nick);                                       \
+    WEE_CHECK_ITEM(__host, host);                                       \
+    WEE_CHECK_ITEM(__command, command);                                 \
+    WEE_CHECK_ITEM(__channel, channel);                                 \
+    WEE_CHECK_ITEM(__arguments, arguments);                             \
+    WEE_CHECK_ITEM(__text, text);                                       \
+    LONGS_EQUAL(__pos_command, parsed.pos_command);                     \
+    LONGS_EQUAL(__pos_arguments, parsed.pos_arguments);                 \
+    LONGS_EQUAL(__pos_channel, parsed.pos_channel);                     \
+    LONGS_EQUAL(__pos_text, parsed.pos_text);
+
+#define WEE_CHECK_SPLIT_ARGV(__string, __keep_trailing_spaces)          \
+    argc = irc_message_split_argv (__string, __keep_trailing_spaces,    \
+                                   &argv, &argv_eol);                   \
+    argv2 = string_split (__string, " ", 0, 0, &argc2);                 \
+    argv_eol2 = string_split (__string, " ",                            \
+                              1 + __keep_trailing_spaces, 0, NULL);     \
+    LONGS_EQUAL(argc2, argc);                                           \
+    if (!argv2)                                                         \
+    {                                                                   \
+        POINTERS_EQUAL(NULL, argv);                                     \
+        POINTERS_EQUAL(NULL, argv_eol);                                 \
+    }                                                                   \
+    else                                                                \
+    {                                                                   \
+        for (i = 0; i <= argc; i++)                                     \
+        {                                                               \
+            STRCMP_EQUAL(argv2[i], argv[i]);                            \
+            STRCMP_EQUAL(argv_eol2[i], argv_eol[i]);                    \
+        }                                                               \
+    }                                                                   \
+    if (argv)                                                           \
+        free (argv);                                                    \
+    string_free_split (argv2);                                          \
+    string_free_split (argv_eol2);
+
+TEST_GROUP(IrcMessage)
+{
+};
+
+/*
+ * Tests functions:
+ *   irc_message_parse_to_struct
+ *   irc_message_get_item
+ */
+
+TEST(IrcMessage, ParseToStruct)
+{
+    struct t_irc_message parsed;
+    char *item;
+
+    WEE_CHECK_PARSE(NULL,
+                    NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                    -1, -1, -1, -1);
+    WEE_CHECK_PARSE("",
+                    NULL, "", NULL, NULL, NULL, NULL, NULL, NULL,
+                    -1, -1, -1, -1);
+    WEE_CHECK_PARSE("AUTHENTICATE *",
+                    NULL, "AUTHENTICATE *", "*", NULL, "AUTHENTICATE", NULL,
+                    "*", NULL,
+                    0, 13, -1, -1);
+    WEE_CHECK_PARSE(":irc.example.com 001 alice :Welcome",
+                    NULL, ":irc.example.com 001 alice :Welcome",
+                    "irc.example.com", "irc.example.com", "001", "alice",
+                    "alice :Welcome", "Welcome",
+                    17, 21, 21, 28);
+    WEE_CHECK_PARSE(":nick!user@host JOIN :#weechat",
+                    NULL, ":nick!user@host JOIN :#weechat",
+                    "nick", "nick!user@host", "JOIN", "#weechat",
+                    ":#weechat", NULL,
+                    16, 21, 22, -1);
+    WEE_CHECK_PARSE(":nick!user@host KICK #weechat bob :bye",
+                    NULL, ":nick!user@host KICK #weechat bob :bye",
+                    "nick", "nick!user@host", "KICK", "#weechat",
+                    "#weechat bob :bye", "bob :bye",
+                    16, 21, 21, 30);
+    WEE_CHECK_PARSE(":irc 353 alice = #weechat :alice @bob",
+                    NULL, ":irc 353 alice = #weechat :alice @bob",
+                    "irc", "irc", "353", "alice",
+                    "alice = #weechat :alice @bob", "= #weechat :alice @bob",
+                    5, 9, 9, 15);
+    WEE_CHECK_PARSE(":irc 324 alice #weechat +nt",
+                    NULL, ":irc 324 alice #weechat +nt",
+                    "irc", "irc", "324", "#weechat",
+                    "alice #weechat +nt", "+nt",
+                    5, 9, 15, 24);
+    WEE_CHECK_PARSE("@time=2015-06-27T16:40:35.000Z "
+                    ":nick!user@host PRIVMSG #weechat :hello!",
+                    "time=2015-06-27T16:40:35.000Z",
+                    ":nick!user@host PRIVMSG #weechat :hello!",
+                    "nick", "nick!user@host", "PRIVMSG", "#weechat",
+                    "#weechat :hello!", "hello!",
+                    47, 55, 55, 65);
+    WEE_CHECK_PARSE("@tag",
+                    NULL, "@tag", NULL, NULL, "@tag", NULL, NULL, NULL,
+                    0, -1, -1, -1);
+    WEE_CHECK_PARSE(":nick@host",
+                    NULL, ":nick@host", "nick", "nick@host", NULL, NULL,
+                    NULL, NULL,
+                    -1, -1, -1, -1);
+}
+
+/*
+ * Tests functions:
+ *   irc_message_parse
+ */
+
+TEST(IrcMessage, Parse)
+{
+    char *tags, *msg_without_tags, *nick, *host, *command, *channel;
+    char *arguments, *text;
+    int pos_command, pos_arguments, pos_channel, pos_text;
+
+    irc_message_parse (NULL,
+                       "@time=2015-06-27T16:40:35.000Z "
+                       ":nick!user@host PRIVMSG #weechat :hello!",
+                       &tags, &msg_without_tags, &nick, &host, &command,
+                       &channel, &arguments, &text, &pos_command,
+                       &pos_arguments, &pos_channel, &pos_text);
+    STRCMP_EQUAL("time=2015-06-27T16:40:35.000Z", tags);
+    STRCMP_EQUAL(":nick!user@host PRIVMSG #weechat :hello!",
+                 msg_without_tags);
+    STRCMP_EQUAL("nick", nick);
+    STRCMP_EQUAL("nick!user@host", host);
+    STRCMP_EQUAL("PRIVMSG", command);
+    STRCMP_EQUAL("#weechat", channel);
+    STRCMP_EQUAL("#weechat :hello!", arguments);
+    STRCMP_EQUAL("hello!", text);
+    LONGS_EQUAL(47, pos_command);
+    LONGS_EQUAL(55, pos_arguments);
+    LONGS_EQUAL(55, pos_channel);
+    LONGS_EQUAL(65, pos_text);
+    free (tags);
+    free (msg_without_tags);
+    free (nick);
+    free (host);
+    free (command);
+    free (channel);
+    free (arguments);
+    free (text);
+
+    irc_message_parse (NULL, "PING", &tags, NULL, &nick, NULL, &command,
+                       &channel, NULL, &text, NULL, NULL, NULL, &pos_text);
+    POINTERS_EQUAL(NULL, tags);
+    POINTERS_EQUAL(NULL, nick);
+    STRCMP_EQUAL("PING", command);
+    POINTERS_EQUAL(NULL, channel);
+    POINTERS_EQUAL(NULL, text);
+    LONGS_EQUAL(-1, pos_text);
+    free (command);
+}
+
+/*
+ * Tests functions:
+ *   irc_message_split_argv
+ */
+
+TEST(IrcMessage, SplitArgv)
+{
+    char **argv, **argv_eol, **argv2, **argv_eol2;
+    int argc, argc2, i;
+
+    argc = irc_message_split_argv ("test", 0, NULL, NULL);
+    LONGS_EQUAL(0, argc);
+
+    WEE_CHECK_SPLIT_ARGV(NULL, 0);
+    WEE_CHECK_SPLIT_ARGV("", 0);
+    WEE_CHECK_SPLIT_ARGV("   ", 0);
+    WEE_CHECK_SPLIT_ARGV("   ", 1);
+    WEE_CHECK_SPLIT_ARGV("PING", 0);
+    WEE_CHECK_SPLIT_ARGV(":nick!user@host PRIVMSG #test :hello  world  ",
+                         0);
+    WEE_CHECK_SPLIT_ARGV(":nick!user@host PRIVMSG #test :hello  world  ",
+                         1);
+    WEE_CHECK_SPLIT_ARGV("  :irc 353 alice = #test :a b  c ", 0);
+    WEE_CHECK_SPLIT_ARGV("  :irc 353 alice = #test :a b  c ", 1);
+}
+
+/* messages received by callback of irc_message_split_map */
+
+struct t_test_split
+{
+    int count;                          /* number of calls to callback      */
+    int stop_after;                     /* stop after N messages (0 = none) */
+    char messages[8][1024];             /* messages received                */
+    char arguments[8][1024];            /* arguments received               */
+};
+
+int
+test_irc_message_split_cb (void *data, int number, const char *message,
+                           const char *arguments)
+{
+    struct t_test_split *split;
+
+    split = (struct t_test_split *)data;
+
+    LONGS_EQUAL(split->count + 1, number);
+    if (split->count < 8)
+    {
+        snprintf (split->messages[split->count],
+                  sizeof (split->messages[split->count]), "%s", message);
+        snprintf (split->arguments[split->count],
+                  sizeof (split->arguments[split->count]), "%s",
+                  (arguments) ? arguments : "(null)");
+    }
+    split->count++;
+
+    return ((split->stop_after > 0)
+            && (split->count >= split->stop_after)) ? 0 : 1;
+}
+
+/*
+ * Tests functions:
+ *   irc_message_split_map
+ */
+
+TEST(IrcMessage, SplitMap)
+{
+    struct t_test_split split;
+    char message[1024];
+    int i, length;
+
+    LONGS_EQUAL(0, irc_message_split_map (NULL, "PING :x", NULL, NULL));
+
+    /* message not split */
+    memset (&split, 0, sizeof (split));
+    LONGS_EQUAL(1, irc_message_split_map (NULL, "PRIVMSG #test :hello",
+                                          &test_irc_message_split_cb,
+                                          &split));
+    LONGS_EQUAL(1, split.count);
+    STRCMP_EQUAL("PRIVMSG #test :hello", split.messages[0]);
+    STRCMP_EQUAL("hello", split.arguments[0]);
+
+    /* tags are kept in message */
+    memset (&split, 0, sizeof (split));
+    LONGS_EQUAL(1, irc_message_split_map (NULL, "@time=x PRIVMSG #test hello",
+                                          &test_irc_message_split_cb,
+                                          &split));
+    STRCMP_EQUAL("@time=x PRIVMSG #test :hello", split.messages[0]);
+    STRCMP_EQUAL("hello", split.arguments[0]);
+
+    /* unknown command: message is sent as-is */
+    memset (&split, 0, sizeof (split));
+    LONGS_EQUAL(1, irc_message_split_map (NULL, "@t NICK",
+                                          &test_irc_message_split_cb,
+                                          &split));
+    STRCMP_EQUAL("@t NICK", split.messages[0]);
+    STRCMP_EQUAL("(null)", split.arguments[0]);
+
+    /*
+     * 300 UTF-8 chars of 2 bytes: max 416 bytes of text by message
+     * (510 - 82 (host) - 8 ("PRIVMSG ") - 2 ("#c") - 2 (" :"))
+     */
+    length = snprintf (message, sizeof (message), "PRIVMSG #c :");
+    for (i = 0; i < 300; i++)
+    {
+        length += snprintf (message + length, sizeof (message) - length,
+                            "\xc3\xa9");
+    }
+    memset (&split, 0, sizeof (split));
+    LONGS_EQUAL(2, irc_message_split_map (NULL, message,
+                                          &test_irc_message_split_cb,
+                                          &split));
+    LONGS_EQUAL(416, strlen (split.arguments[0]));
+    LONGS_EQUAL(184, strlen (split.arguments[1]));
+    for (i = 0; i < 2; i++)
+    {
+        CHECK(utf8_is_valid (split.messages[i], -1, NULL));
+        CHECK(strncmp (split.messages[i], "PRIVMSG #c :\xc3\xa9", 14) == 0);
+    }
+
+    /* callback stops the split after first message */
+    memset (&split, 0, sizeof (split));
+    split.stop_after = 1;
+    LONGS_EQUAL(1, irc_message_split_map (NULL, message,
+                                          &test_irc_message_split_cb,
+                                          &split));
+    LONGS_EQUAL(1, split.count);
+}
+
+/*
+ * Tests functions:
+ *   irc_message_split
+ */
+
+TEST(IrcMessage, Split)
+{
+    struct t_hashtable *hashtable;
+
+    /* NULL message: count is "1", without message */
+    hashtable = irc_message_split (NULL, NULL);
+    CHECK(hashtable);
+    LONGS_EQUAL(1, hashtable->items_count);
+    STRCMP_EQUAL("1", (const char *)hashtable_get (hashtable, "count"));
+    hashtable_free (hashtable);
+
+    /* empty message: count is "1", with empty message */
+    hashtable = irc_message_split (NULL, "");
+    CHECK(hashtable);
+    LONGS_EQUAL(2, hashtable->items_count);
+    STRCMP_EQUAL("1", (const char *)hashtable_get (hashtable, "count"));
+    STRCMP_EQUAL("", (const char *)hashtable_get (hashtable, "msg1"));
+    hashtable_free (hashtable);
+
+    /* message not split */
+    hashtable = irc_message_split (NULL, "PRIVMSG #test :hello");
+    CHECK(hashtable);
+    STRCMP_EQUAL("1", (const char *)hashtable_get (hashtable, "count"));
+    STRCMP_EQUAL("PRIVMSG #test :hello",
+                 (const char *)hashtable_get (hashtable, "msg1"));
+    STRCMP_EQUAL("hello", (const char *)hashtable_get (hashtable, "args1"));
+    hashtable_free (hashtable);
+}
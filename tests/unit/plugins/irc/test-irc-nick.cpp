@@ -0,0 +1,171 @@
+/*
+ * test-irc-nick.cpp - test IRC nick functions
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This file is part of WeeChat, the extensible chat client.
+ *
+ * WeeChat is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WeeChat is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WeeChat.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "CppUTest/TestHarness.h"
+
+extern "C"
+{
+#include <stdio.h>
+#include "src/plugins/weechat-plugin.h"
+#include "src/plugins/irc/irc.h"
+#include "src/plugins/irc/irc-server.h"
+#include "src/plugins/irc/irc-channel.h"
+#include "src/plugins/irc/irc-message.h"
+#include "src/plugins/irc/irc-nick.h"
+#include "src/plugins/irc/irc-protocol.h"
+}
+
+TEST_GROUP(IrcNick)
+{
+    struct t_irc_server *server;
+    struct t_irc_channel *channel;
+
+    void setup()
+    {
+        server = irc_server_alloc ("test_nick");
+        channel = irc_channel_new (server, IRC_CHANNEL_TYPE_CHANNEL,
+                                   "#test", 0, 0);
+    }
+
+    void teardown()
+    {
+        if (channel)
+        {
+            irc_nick_free_all (server, channel);
+            weechat_buffer_close (channel->buffer);
+        }
+        irc_server_free (server);
+    }
+};
+
+/*
+ * Tests functions:
+ *   irc_nick_search (with casemapping of server)
+ */
+
+TEST(IrcNick, SearchCasemapping)
+{
+    struct t_irc_nick *nick;
+
+    CHECK(server);
+    CHECK(channel);
+
+    nick = irc_nick_new (server, channel, "nick[a]", NULL, NULL, 0, NULL,
+                         NULL);
+    CHECK(nick);
+
+    POINTERS_EQUAL(NULL, irc_nick_search (server, channel, NULL));
+    POINTERS_EQUAL(NULL, irc_nick_search (server, channel, "nick"));
+
+    /* rfc1459: "[]" are lower case of "{}" */
+    LONGS_EQUAL(IRC_SERVER_CASEMAPPING_RFC1459, server->casemapping);
+    POINTERS_EQUAL(nick, irc_nick_search (server, channel, "nick[a]"));
+    POINTERS_EQUAL(nick, irc_nick_search (server, channel, "NICK[A]"));
+    POINTERS_EQUAL(nick, irc_nick_search (server, channel, "NICK{A}"));
+    POINTERS_EQUAL(nick, irc_nick_search (server, channel, "nick{a}"));
+
+    /* ascii: only letters are case insensitive */
+    irc_nick_free (server, channel, nick);
+    server->casemapping = IRC_SERVER_CASEMAPPING_ASCII;
+    nick = irc_nick_new (server, channel, "nick[a]", NULL, NULL, 0, NULL,
+                         NULL);
+    CHECK(nick);
+    POINTERS_EQUAL(nick, irc_nick_search (server, channel, "nick[a]"));
+    POINTERS_EQUAL(nick, irc_nick_search (server, channel, "NICK[A]"));
+    POINTERS_EQUAL(NULL, irc_nick_search (server, channel, "NICK{A}"));
+    POINTERS_EQUAL(NULL, irc_nick_search (server, channel, "nick{a}"));
+}
+
+/*
+ * Tests functions:
+ *   irc_nick_search (after irc_nick_change)
+ */
+
+TEST(IrcNick, SearchAfterChange)
+{
+    struct t_irc_nick *nick1, *nick2;
+
+    CHECK(server);
+    CHECK(channel);
+
+    nick1 = irc_nick_new (server, channel, "alice", NULL, NULL, 0, NULL,
+                          NULL);
+    nick2 = irc_nick_new (server, channel, "bob", NULL, NULL, 0, NULL, NULL);
+    CHECK(nick1);
+    CHECK(nick2);
+    POINTERS_EQUAL(nick1, irc_nick_search (server, channel, "Alice"));
+
+    irc_nick_change (server, channel, nick1, "Carol[1]");
+    STRCMP_EQUAL("Carol[1]", nick1->name);
+    POINTERS_EQUAL(NULL, irc_nick_search (server, channel, "alice"));
+    POINTERS_EQUAL(nick1, irc_nick_search (server, channel, "carol{1}"));
+    POINTERS_EQUAL(nick2, irc_nick_search (server, channel, "BOB"));
+
+    /* change case only: the nick is still found */
+    irc_nick_change (server, channel, nick1, "CAROL[1]");
+    POINTERS_EQUAL(nick1, irc_nick_search (server, channel, "carol[1]"));
+
+    irc_nick_free (server, channel, nick1);
+    POINTERS_EQUAL(NULL, irc_nick_search (server, channel, "carol[1]"));
+    POINTERS_EQUAL(nick2, irc_nick_search (server, channel, "bob"));
+}
+
+/*
+ * Tests functions:
+ *   irc_nick_search (after a change of casemapping in message 005)
+ */
+
+TEST(IrcNick, SearchAfterCasemappingChange)
+{
+    struct t_irc_nick *nick;
+    struct t_irc_message parsed;
+
+    CHECK(server);
+    CHECK(channel);
+
+    nick = irc_nick_new (server, channel, "nick[a]", NULL, NULL, 0, NULL,
+                         NULL);
+    CHECK(nick);
+
+    /* index is built with casemapping rfc1459 */
+    POINTERS_EQUAL(nick, irc_nick_search (server, channel, "NICK{A}"));
+    LONGS_EQUAL(IRC_SERVER_CASEMAPPING_RFC1459,
+                channel->nicks_index_casemapping);
+    CHECK(weechat_nicklist_search_nick (channel->buffer, NULL, "NICK{A}"));
+
+    /* server announces casemapping ascii: index is built again */
+    irc_message_parse_to_struct (
+        server,
+        ":server 005 alice CASEMAPPING=ascii :are supported by this server",
+        &parsed);
+    irc_protocol_recv_command (server, &parsed, "005", NULL);
+    LONGS_EQUAL(IRC_SERVER_CASEMAPPING_ASCII, server->casemapping);
+    POINTERS_EQUAL(NULL, irc_nick_search (server, channel, "NICK{A}"));
+    LONGS_EQUAL(IRC_SERVER_CASEMAPPING_ASCII,
+                channel->nicks_index_casemapping);
+    POINTERS_EQUAL(nick, irc_nick_search (server, channel, "NICK[A]"));
+
+    /* index of nicks in nicklist of buffer follows the casemapping */
+    POINTERS_EQUAL(NULL,
+                   weechat_nicklist_search_nick (channel->buffer, NULL,
+                                                 "NICK{A}"));
+    CHECK(weechat_nicklist_search_nick (channel->buffer, NULL, "NICK[A]"));
+}
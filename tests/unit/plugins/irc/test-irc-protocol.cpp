@@ -23,6 +23,7 @@
 
 extern "C"
 {
+#include "src/plugins/irc/irc-message.h"
 #include "src/plugins/irc/irc-protocol.h"
 }
 
@@ -57,3 +58,92 @@ TEST(IrcProtocol, ParseTime)
     LONGS_EQUAL(1547386699, irc_protocol_parse_time ("1547386699.123"));
     LONGS_EQUAL(1547386699, irc_protocol_parse_time ("1547386699"));
 }
+
+/*
+ * Tests functions:
+ *   irc_protocol_get_message_time
+ */
+
+TEST(IrcProtocol, GetMessageTime)
+{
+    struct t_irc_message parsed;
+
+    LONGS_EQUAL(0, irc_protocol_get_message_time (NULL));
+
+    irc_message_parse_to_struct (NULL, ":nick!user@host PRIVMSG #test :hi",
+                                 &parsed);
+    LONGS_EQUAL(0, irc_protocol_get_message_time (&parsed));
+
+    irc_message_parse_to_struct (NULL, "@time :nick!user@host PRIVMSG #test",
+                                 &parsed);
+    LONGS_EQUAL(0, irc_protocol_get_message_time (&parsed));
+
+    irc_message_parse_to_struct (
+        NULL,
+        "@time=2019-01-13T13:38:19.123Z :nick!user@host PRIVMSG #test :hi",
+        &parsed);
+    LONGS_EQUAL(1547386699, irc_protocol_get_message_time (&parsed));
+
+    irc_message_parse_to_struct (
+        NULL,
+        "@tag1=a;time=1547386699;times=1;tag2 :nick!user@host PRIVMSG #test",
+        &parsed);
+    LONGS_EQUAL(1547386699, irc_protocol_get_message_time (&parsed));
+
+    /* last tag "time" is used */
+    irc_message_parse_to_struct (
+        NULL,
+        "@time=1547386000;time=1547386699 :nick!user@host PRIVMSG #test",
+        &parsed);
+    LONGS_EQUAL(1547386699, irc_protocol_get_message_time (&parsed));
+}
+
+/*
+ * Tests functions:
+ *   irc_protocol_search_message
+ */
+
+TEST(IrcProtocol, SearchMessage)
+{
+    struct t_irc_protocol_msg *ptr_msg;
+
+    POINTERS_EQUAL(NULL, irc_protocol_search_message (NULL));
+    POINTERS_EQUAL(NULL, irc_protocol_search_message (""));
+    POINTERS_EQUAL(NULL, irc_protocol_search_message ("xyz"));
+    POINTERS_EQUAL(NULL, irc_protocol_search_message ("joinx"));
+    POINTERS_EQUAL(NULL, irc_protocol_search_message ("000"));
+    POINTERS_EQUAL(NULL, irc_protocol_search_message ("999"));
+    POINTERS_EQUAL(NULL, irc_protocol_search_message ("01"));
+    POINTERS_EQUAL(NULL, irc_protocol_search_message ("0010"));
+    POINTERS_EQUAL(NULL, irc_protocol_search_message ("1a2"));
+
+    /* first and last names */
+    ptr_msg = irc_protocol_search_message ("account");
+    CHECK(ptr_msg);
+    STRCMP_EQUAL("account", ptr_msg->name);
+    ptr_msg = irc_protocol_search_message ("wallops");
+    CHECK(ptr_msg);
+    STRCMP_EQUAL("wallops", ptr_msg->name);
+
+    /* case-insensitive search on names */
+    ptr_msg = irc_protocol_search_message ("PRIVMSG");
+    CHECK(ptr_msg);
+    STRCMP_EQUAL("privmsg", ptr_msg->name);
+    LONGS_EQUAL(1, ptr_msg->decode_color);
+    LONGS_EQUAL(1, ptr_msg->keep_trailing_spaces);
+    ptr_msg = irc_protocol_search_message ("Topic");
+    CHECK(ptr_msg);
+    STRCMP_EQUAL("topic", ptr_msg->name);
+    LONGS_EQUAL(0, ptr_msg->decode_color);
+
+    /* numeric commands */
+    ptr_msg = irc_protocol_search_message ("001");
+    CHECK(ptr_msg);
+    STRCMP_EQUAL("001", ptr_msg->name);
+    ptr_msg = irc_protocol_search_message ("353");
+    CHECK(ptr_msg);
+    STRCMP_EQUAL("353", ptr_msg->name);
+    ptr_msg = irc_protocol_search_message ("975");
+    CHECK(ptr_msg);
+    STRCMP_EQUAL("975", ptr_msg->name);
+}
@@ -0,0 +1,242 @@
+/*
+ * test-irc-server.cpp - test IRC server functions
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This file is part of WeeChat, the extensible chat client.
+ *
+ * WeeChat is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WeeChat is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WeeChat.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "CppUTest/TestHarness.h"
+
+extern "C"
+{
+#include <stdio.h>
+#include <string.h>
+#include "src/plugins/weechat-plugin.h"
+#include "src/plugins/irc/irc.h"
+#include "src/plugins/irc/irc-server.h"
+}
+
+TEST_GROUP(IrcServer)
+{
+};
+
+/*
+ * Tests functions:
+ *   irc_server_msgq_next_message
+ */
+
+TEST(IrcServer, MsgqNextMessage)
+{
+    char buffer[128], *ptr_buffer, *end;
+
+    POINTERS_EQUAL(NULL, irc_server_msgq_next_message (NULL, NULL));
+
+    strcpy (buffer, "PING :abc\r\n:n!u@h PRIVMSG #c :te\rst\r\n\r\nunterminated");
+    ptr_buffer = buffer;
+    end = strrchr (buffer, '\n') + 1;
+    POINTERS_EQUAL(NULL, irc_server_msgq_next_message (&ptr_buffer, NULL));
+    STRCMP_EQUAL("PING :abc",
+                 irc_server_msgq_next_message (&ptr_buffer, end));
+    STRCMP_EQUAL(":n!u@h PRIVMSG #c :test",
+                 irc_server_msgq_next_message (&ptr_buffer, end));
+    STRCMP_EQUAL("", irc_server_msgq_next_message (&ptr_buffer, end));
+    POINTERS_EQUAL(end, ptr_buffer);
+    POINTERS_EQUAL(NULL, irc_server_msgq_next_message (&ptr_buffer, end));
+    STRCMP_EQUAL("unterminated", end);
+
+    /* no '\n' before end */
+    strcpy (buffer, "PING :abc");
+    ptr_buffer = buffer;
+    POINTERS_EQUAL(NULL,
+                   irc_server_msgq_next_message (&ptr_buffer,
+                                                 buffer + strlen (buffer)));
+    POINTERS_EQUAL(buffer, ptr_buffer);
+}
+
+/*
+ * Tests functions:
+ *   irc_server_recv_buffer_alloc
+ *   irc_server_recv_buffer_free
+ *   irc_server_msgq_add_buffer
+ *   irc_server_msgq_flush
+ */
+
+TEST(IrcServer, RecvBuffer)
+{
+    struct t_irc_server *server;
+    int size;
+
+    server = irc_server_alloc ("test_recv_buffer");
+    CHECK(server);
+    POINTERS_EQUAL(NULL, server->recv_buffer);
+    LONGS_EQUAL(0, server->recv_buffer_size);
+    LONGS_EQUAL(0, server->recv_buffer_length);
+
+    irc_server_msgq_add_buffer (server, NULL);
+    irc_server_msgq_add_buffer (server, "");
+    POINTERS_EQUAL(NULL, server->recv_buffer);
+
+    irc_server_msgq_add_buffer (server, "PING :abc\r\n:irc 001 ");
+    STRCMP_EQUAL("PING :abc\r\n:irc 001 ", server->recv_buffer);
+    LONGS_EQUAL(20, server->recv_buffer_length);
+    LONGS_EQUAL(IRC_SERVER_RECV_BUFFER_MIN_READ, server->recv_buffer_size);
+
+    /* not connected: messages are not read, unterminated message is kept */
+    irc_server_msgq_flush (server);
+    STRCMP_EQUAL(":irc 001 ", server->recv_buffer);
+    LONGS_EQUAL(9, server->recv_buffer_length);
+    POINTERS_EQUAL(NULL, server->recv_buffer_spare);
+
+    irc_server_msgq_add_buffer (server, "alice :Welcome");
+    STRCMP_EQUAL(":irc 001 alice :Welcome", server->recv_buffer);
+    LONGS_EQUAL(23, server->recv_buffer_length);
+
+    /* no complete message: nothing is changed */
+    irc_server_msgq_flush (server);
+    STRCMP_EQUAL(":irc 001 alice :Welcome", server->recv_buffer);
+
+    /* buffer is enlarged, data is kept */
+    size = server->recv_buffer_size;
+    LONGS_EQUAL(0, irc_server_recv_buffer_alloc (server, -1));
+    LONGS_EQUAL(1, irc_server_recv_buffer_alloc (server, 16));
+    LONGS_EQUAL(size, server->recv_buffer_size);
+    LONGS_EQUAL(1, irc_server_recv_buffer_alloc (server, size * 3));
+    LONGS_EQUAL(size * 4, server->recv_buffer_size);
+    STRCMP_EQUAL(":irc 001 alice :Welcome", server->recv_buffer);
+    LONGS_EQUAL(23, server->recv_buffer_length);
+
+    irc_server_recv_buffer_free (server);
+    POINTERS_EQUAL(NULL, server->recv_buffer);
+    LONGS_EQUAL(0, server->recv_buffer_size);
+    LONGS_EQUAL(0, server->recv_buffer_length);
+
+    irc_server_free (server);
+}
+
+/*
+ * Tests functions:
+ *   irc_server_outqueue_add
+ *   irc_server_outqueue_get_next
+ *   irc_server_outqueue_free
+ */
+
+TEST(IrcServer, OutqueueFairQueuing)
+{
+    struct t_irc_server *server;
+    struct t_irc_outqueue *ptr_outqueue;
+    struct t_hdata *hdata;
+    const char *targets[] = { "#a", "#b", NULL, "#A", "#a", "#c", NULL };
+    const char *expected[] = { "#a", "#b", NULL, "#c", "#A", NULL, "#a" };
+    char message[64];
+    int i;
+
+    server = irc_server_alloc ("test_outqueue");
+    CHECK(server);
+    POINTERS_EQUAL(NULL, irc_server_outqueue_get_next (server, 0));
+
+    for (i = 0; i < 7; i++)
+    {
+        snprintf (message, sizeof (message), "PRIVMSG %s :msg %d\r\n",
+                  (targets[i]) ? targets[i] : "*", i);
+        irc_server_outqueue_add (server, 0, "privmsg", NULL, message, 0, NULL,
+                                 NULL, targets[i]);
+    }
+    LONGS_EQUAL(7, server->outqueue_count[0]);
+    LONGS_EQUAL(0, server->outqueue_count[1]);
+
+    /* counters of the two queues are arrays in hdata */
+    hdata = weechat_hdata_get ("irc_server");
+    CHECK(hdata);
+    LONGS_EQUAL(7, weechat_hdata_integer (hdata, server, "0|outqueue_count"));
+    LONGS_EQUAL(0, weechat_hdata_integer (hdata, server, "1|outqueue_count"));
+
+    /* one message per target in each round, in order of arrival */
+    for (i = 0; i < 7; i++)
+    {
+        ptr_outqueue = irc_server_outqueue_get_next (server, 0);
+        CHECK(ptr_outqueue);
+        if (expected[i])
+            STRCMP_EQUAL(expected[i], ptr_outqueue->target);
+        else
+            POINTERS_EQUAL(NULL, ptr_outqueue->target);
+        server->outqueue_round[0] = ptr_outqueue->round;
+        irc_server_outqueue_free (server, 0, ptr_outqueue);
+        LONGS_EQUAL(6 - i, server->outqueue_count[0]);
+    }
+    POINTERS_EQUAL(NULL, server->outqueue[0]);
+    POINTERS_EQUAL(NULL, server->last_outqueue[0]);
+
+    irc_server_free (server);
+}
+
+/*
+ * Tests functions:
+ *   irc_server_anti_flood_delay
+ */
+
+TEST(IrcServer, AntiFloodDelay)
+{
+    struct t_irc_server *server;
+    struct timeval tv_now;
+
+    server = irc_server_alloc ("test_anti_flood");
+    CHECK(server);
+
+    /* default: burst of 5 messages, then one message every 2 seconds */
+    tv_now.tv_sec = 1000000;
+    tv_now.tv_usec = 0;
+    LONGS_EQUAL(0, irc_server_anti_flood_delay (server, 0, &tv_now));
+    LONGS_EQUAL(5, server->anti_flood_tokens);
+
+    /* no token: wait for next one */
+    server->anti_flood_tokens = 0;
+    LONGS_EQUAL(2000, irc_server_anti_flood_delay (server, 0, &tv_now));
+    tv_now.tv_sec += 1;
+    tv_now.tv_usec = 500000;
+    LONGS_EQUAL(500, irc_server_anti_flood_delay (server, 0, &tv_now));
+    tv_now.tv_usec = 999999;
+    LONGS_EQUAL(1, irc_server_anti_flood_delay (server, 0, &tv_now));
+    tv_now.tv_sec += 1;
+    tv_now.tv_usec = 0;
+    LONGS_EQUAL(0, irc_server_anti_flood_delay (server, 0, &tv_now));
+    LONGS_EQUAL(1, server->anti_flood_tokens);
+
+    /* bucket is never filled above the burst */
+    tv_now.tv_sec += 3600;
+    LONGS_EQUAL(0, irc_server_anti_flood_delay (server, 0, &tv_now));
+    LONGS_EQUAL(5, server->anti_flood_tokens);
+
+    /* low priority: wait 2 seconds after last message sent */
+    server->last_user_message = tv_now;
+    tv_now.tv_usec = 250000;
+    LONGS_EQUAL(0, irc_server_anti_flood_delay (server, 0, &tv_now));
+    LONGS_EQUAL(1750, irc_server_anti_flood_delay (server, 1, &tv_now));
+
+    /* low priority: delay is computed with microseconds */
+    tv_now.tv_usec = 900000;
+    server->last_user_message = tv_now;
+    tv_now.tv_sec += 1;
+    tv_now.tv_usec = 100000;
+    LONGS_EQUAL(1800, irc_server_anti_flood_delay (server, 1, &tv_now));
+    tv_now.tv_sec += 1;
+    tv_now.tv_usec = 899500;
+    LONGS_EQUAL(1, irc_server_anti_flood_delay (server, 1, &tv_now));
+    tv_now.tv_usec = 900000;
+    LONGS_EQUAL(0, irc_server_anti_flood_delay (server, 1, &tv_now));
+
+    irc_server_free (server);
+}